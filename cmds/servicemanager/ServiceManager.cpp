@@ -141,165 +141,210 @@ static std::string getAidlInstanceName(const vintf::ManifestInstance& instance)
     return instance.package() + "." + instance.interface() + "/" + instance.instance();
 }
 
+struct VintfInstance {
+    // the manifest which declares it (first, if several do)
+    const char* description;
+    // from the first manifest which declares it
+    std::optional<std::string> updatableViaApex;
+    // from the last manifest which declares it
+    std::optional<std::string> accessor;
+    std::optional<std::string> ip;
+    std::optional<uint64_t> port;
+};
+
+// The VINTF manifests are needed for most calls (e.g. every getService checks
+// whether the service has an accessor), so rather than searching them every
+// time, they are indexed by name.
+struct VintfIndex {
+    // the manifests this was built from
+    std::vector<std::shared_ptr<const vintf::HalManifest>> manifests;
+
+    // by {package}.{iface}/{instance}
+    std::map<std::string, VintfInstance> aidlInstances;
+    // by {package}/{instance}
+    std::map<std::string, VintfInstance> nativeInstances;
+    // instances of {package}.{iface}, as listed by each manifest in turn
+    std::map<std::string, std::vector<std::string>> aidlInstancesByInterface;
+    // instances of {package}, as listed by each manifest in turn
+    std::map<std::string, std::vector<std::string>> nativeInstancesByPackage;
+    // names of instances which are updatable via each APEX
+    std::map<std::string, std::vector<std::string>> namesByApex;
+
+    void add(const ManifestWithDescription& mwd) {
+        std::map<std::string, std::set<std::string>> aidlByInterface;
+        std::map<std::string, std::set<std::string>> nativeByPackage;
+        std::set<std::string> seenAidl;
+        std::set<std::string> seenNative;
+
+        mwd.manifest->forEachInstance([&](const auto& manifestInstance) {
+            bool isAidl = manifestInstance.format() == vintf::HalFormat::AIDL;
+            if (!isAidl && manifestInstance.format() != vintf::HalFormat::NATIVE) return true;
+
+            std::string name = isAidl ? getAidlInstanceName(manifestInstance)
+                                      : getNativeInstanceName(manifestInstance);
+            if (manifestInstance.updatableViaApex().has_value()) {
+                namesByApex[*manifestInstance.updatableViaApex()].push_back(name);
+            }
+
+            if (isAidl) {
+                aidlByInterface[manifestInstance.package() + "." + manifestInstance.interface()]
+                        .insert(manifestInstance.instance());
+            } else {
+                nativeByPackage[manifestInstance.package()].insert(manifestInstance.instance());
+            }
+
+            // only the first declaration in each manifest counts
+            if (!(isAidl ? seenAidl : seenNative).insert(name).second) return true;
+
+            auto it = (isAidl ? aidlInstances : nativeInstances)
+                              .try_emplace(name,
+                                           VintfInstance{
+                                                   .description = mwd.description,
+                                                   .updatableViaApex =
+                                                           manifestInstance.updatableViaApex(),
+                                           })
+                              .first;
+            if (isAidl) {
+                it->second.accessor = manifestInstance.accessor();
+                it->second.ip = manifestInstance.ip();
+                it->second.port = manifestInstance.port();
+            }
+            return true; // continue (libvintf uses opposite convention)
+        });
+
+        for (const auto& [iface, instances] : aidlByInterface) {
+            auto& all = aidlInstancesByInterface[iface];
+            all.insert(all.end(), instances.begin(), instances.end());
+        }
+        for (const auto& [package, instances] : nativeByPackage) {
+            auto& all = nativeInstancesByPackage[package];
+            all.insert(all.end(), instances.begin(), instances.end());
+        }
+    }
+};
+
+// libvintf returns different manifest objects when they change (e.g. when an
+// APEX with VINTF fragments is activated), and then the index is rebuilt.
+// servicemanager is single-threaded, so this doesn't need a lock.
+static const VintfIndex& getVintfIndex() {
+    [[clang::no_destroy]] static VintfIndex gIndex;
+
+    std::vector<ManifestWithDescription> manifests = GetManifestsWithDescription();
+    bool upToDate = manifests.size() == gIndex.manifests.size();
+    for (size_t i = 0; upToDate && i < manifests.size(); i++) {
+        upToDate = manifests[i].manifest == gIndex.manifests[i];
+    }
+    if (upToDate) return gIndex;
+
+    gIndex = VintfIndex{};
+    for (const ManifestWithDescription& mwd : manifests) {
+        gIndex.manifests.push_back(mwd.manifest);
+    }
+    forEachManifest([&](const ManifestWithDescription& mwd) {
+        gIndex.add(mwd);
+        return false; // continue
+    });
+    ALOGI("Indexed %zu AIDL and %zu native VINTF instances", gIndex.aidlInstances.size(),
+          gIndex.nativeInstances.size());
+    return gIndex;
+}
+
 static bool isVintfDeclared(const Access::CallingContext& ctx, const std::string& name) {
+    const VintfIndex& index = getVintfIndex();
+
     NativeName nname;
     if (NativeName::fill(name, &nname)) {
-        bool found = forEachManifest([&](const ManifestWithDescription& mwd) {
-            if (mwd.manifest->hasNativeInstance(nname.package, nname.instance)) {
-                ALOGI("%s Found %s in %s VINTF manifest.", ctx.toDebugString().c_str(),
-                      name.c_str(), mwd.description);
-                return true; // break
-            }
-            return false; // continue
-        });
-        if (!found) {
-            ALOGI("%s Could not find %s in the VINTF manifest.", ctx.toDebugString().c_str(),
-                  name.c_str());
+        if (auto it = index.nativeInstances.find(name); it != index.nativeInstances.end()) {
+            ALOGI("%s Found %s in %s VINTF manifest.", ctx.toDebugString().c_str(), name.c_str(),
+                  it->second.description);
+            return true;
         }
-        return found;
+        ALOGI("%s Could not find %s in the VINTF manifest.", ctx.toDebugString().c_str(),
+              name.c_str());
+        return false;
     }
 
     AidlName aname;
     if (!AidlName::fill(name, &aname, true)) return false;
 
-    bool found = forEachManifest([&](const ManifestWithDescription& mwd) {
-        if (mwd.manifest->hasAidlInstance(aname.package, aname.iface, aname.instance)) {
-            ALOGI("%s Found %s in %s VINTF manifest.", ctx.toDebugString().c_str(), name.c_str(),
-                  mwd.description);
-            return true; // break
-        }
-        return false;  // continue
-    });
+    if (auto it = index.aidlInstances.find(name); it != index.aidlInstances.end()) {
+        ALOGI("%s Found %s in %s VINTF manifest.", ctx.toDebugString().c_str(), name.c_str(),
+              it->second.description);
+        return true;
+    }
 
-    if (!found) {
-        std::set<std::string> instances;
-        forEachManifest([&](const ManifestWithDescription& mwd) {
-            std::set<std::string> res = mwd.manifest->getAidlInstances(aname.package, aname.iface);
-            instances.insert(res.begin(), res.end());
-            return true;
-        });
+    std::set<std::string> instances;
+    if (auto it = index.aidlInstancesByInterface.find(aname.package + "." + aname.iface);
+        it != index.aidlInstancesByInterface.end()) {
+        instances.insert(it->second.begin(), it->second.end());
+    }
 
-        std::string available;
-        if (instances.empty()) {
-            available = "No alternative instances declared in VINTF";
-        } else {
-            // for logging only. We can't return this information to the client
-            // because they may not have permissions to find or list those
-            // instances
-            available = "VINTF declared instances: " + base::Join(instances, ", ");
-        }
-        // Although it is tested, explicitly rebuilding qualified name, in case it
-        // becomes something unexpected.
-        ALOGI("%s Could not find %s.%s/%s in the VINTF manifest. %s.", ctx.toDebugString().c_str(),
-              aname.package.c_str(), aname.iface.c_str(), aname.instance.c_str(),
-              available.c_str());
+    std::string available;
+    if (instances.empty()) {
+        available = "No alternative instances declared in VINTF";
+    } else {
+        // for logging only. We can't return this information to the client
+        // because they may not have permissions to find or list those
+        // instances
+        available = "VINTF declared instances: " + base::Join(instances, ", ");
     }
+    // Although it is tested, explicitly rebuilding qualified name, in case it
+    // becomes something unexpected.
+    ALOGI("%s Could not find %s.%s/%s in the VINTF manifest. %s.", ctx.toDebugString().c_str(),
+          aname.package.c_str(), aname.iface.c_str(), aname.instance.c_str(), available.c_str());
 
-    return found;
+    return false;
 }
 
 static std::optional<std::string> getVintfUpdatableApex(const std::string& name) {
+    const VintfIndex& index = getVintfIndex();
+
     NativeName nname;
     if (NativeName::fill(name, &nname)) {
-        std::optional<std::string> updatableViaApex;
-
-        forEachManifest([&](const ManifestWithDescription& mwd) {
-            bool cont = mwd.manifest->forEachInstance([&](const auto& manifestInstance) {
-                if (manifestInstance.format() != vintf::HalFormat::NATIVE) return true;
-                if (manifestInstance.package() != nname.package) return true;
-                if (manifestInstance.instance() != nname.instance) return true;
-                updatableViaApex = manifestInstance.updatableViaApex();
-                return false; // break (libvintf uses opposite convention)
-            });
-            return !cont;
-        });
-
-        return updatableViaApex;
+        auto it = index.nativeInstances.find(name);
+        if (it == index.nativeInstances.end()) return std::nullopt;
+        return it->second.updatableViaApex;
     }
 
     AidlName aname;
     if (!AidlName::fill(name, &aname, true)) return std::nullopt;
 
-    std::optional<std::string> updatableViaApex;
-
-    forEachManifest([&](const ManifestWithDescription& mwd) {
-        bool cont = mwd.manifest->forEachInstance([&](const auto& manifestInstance) {
-            if (manifestInstance.format() != vintf::HalFormat::AIDL) return true;
-            if (manifestInstance.package() != aname.package) return true;
-            if (manifestInstance.interface() != aname.iface) return true;
-            if (manifestInstance.instance() != aname.instance) return true;
-            updatableViaApex = manifestInstance.updatableViaApex();
-            return false; // break (libvintf uses opposite convention)
-        });
-        return !cont;
-    });
-
-    return updatableViaApex;
+    auto it = index.aidlInstances.find(name);
+    if (it == index.aidlInstances.end()) return std::nullopt;
+    return it->second.updatableViaApex;
 }
 
 static std::vector<std::string> getVintfUpdatableNames(const std::string& apexName) {
-    std::vector<std::string> names;
-
-    forEachManifest([&](const ManifestWithDescription& mwd) {
-        mwd.manifest->forEachInstance([&](const auto& manifestInstance) {
-            if (manifestInstance.updatableViaApex().has_value() &&
-                manifestInstance.updatableViaApex().value() == apexName) {
-                if (manifestInstance.format() == vintf::HalFormat::NATIVE) {
-                    names.push_back(getNativeInstanceName(manifestInstance));
-                } else if (manifestInstance.format() == vintf::HalFormat::AIDL) {
-                    names.push_back(getAidlInstanceName(manifestInstance));
-                }
-            }
-            return true; // continue (libvintf uses opposite convention)
-        });
-        return false; // continue
-    });
+    const VintfIndex& index = getVintfIndex();
 
-    return names;
+    auto it = index.namesByApex.find(apexName);
+    if (it == index.namesByApex.end()) return {};
+    return it->second;
 }
 
 static std::optional<std::string> getVintfAccessorName(const std::string& name) {
     AidlName aname;
     if (!AidlName::fill(name, &aname, false)) return std::nullopt;
 
-    std::optional<std::string> accessor;
-    forEachManifest([&](const ManifestWithDescription& mwd) {
-        mwd.manifest->forEachInstance([&](const auto& manifestInstance) {
-            if (manifestInstance.format() != vintf::HalFormat::AIDL) return true;
-            if (manifestInstance.package() != aname.package) return true;
-            if (manifestInstance.interface() != aname.iface) return true;
-            if (manifestInstance.instance() != aname.instance) return true;
-            accessor = manifestInstance.accessor();
-            return false; // break (libvintf uses opposite convention)
-        });
-        return false; // continue
-    });
-    return accessor;
+    const VintfIndex& index = getVintfIndex();
+    auto it = index.aidlInstances.find(name);
+    if (it == index.aidlInstances.end()) return std::nullopt;
+    return it->second.accessor;
 }
 
 static std::optional<ConnectionInfo> getVintfConnectionInfo(const std::string& name) {
     AidlName aname;
     if (!AidlName::fill(name, &aname, true)) return std::nullopt;
 
-    std::optional<std::string> ip;
-    std::optional<uint64_t> port;
-    forEachManifest([&](const ManifestWithDescription& mwd) {
-        mwd.manifest->forEachInstance([&](const auto& manifestInstance) {
-            if (manifestInstance.format() != vintf::HalFormat::AIDL) return true;
-            if (manifestInstance.package() != aname.package) return true;
-            if (manifestInstance.interface() != aname.iface) return true;
-            if (manifestInstance.instance() != aname.instance) return true;
-            ip = manifestInstance.ip();
-            port = manifestInstance.port();
-            return false; // break (libvintf uses opposite convention)
-        });
-        return false; // continue
-    });
+    const VintfIndex& index = getVintfIndex();
+    auto it = index.aidlInstances.find(name);
+    if (it == index.aidlInstances.end()) return std::nullopt;
 
-    if (ip.has_value() && port.has_value()) {
+    const VintfInstance& instance = it->second;
+    if (instance.ip.has_value() && instance.port.has_value()) {
         ConnectionInfo info;
-        info.ipAddress = *ip;
-        info.port = *port;
+        info.ipAddress = *instance.ip;
+        info.port = *instance.port;
         return std::make_optional<ConnectionInfo>(info);
     } else {
         return std::nullopt;
@@ -307,18 +352,15 @@ static std::optional<ConnectionInfo> getVintfConnectionInfo(const std::string& n
 }
 
 static std::vector<std::string> getVintfInstances(const std::string& interface) {
+    const VintfIndex& index = getVintfIndex();
+
     size_t lastDot = interface.rfind('.');
     if (lastDot == std::string::npos) {
         // This might be a package for native instance.
-        std::vector<std::string> ret;
-        (void)forEachManifest([&](const ManifestWithDescription& mwd) {
-            auto instances = mwd.manifest->getNativeInstances(interface);
-            ret.insert(ret.end(), instances.begin(), instances.end());
-            return false; // continue
-        });
         // If found, return it without error log.
-        if (!ret.empty()) {
-            return ret;
+        if (auto it = index.nativeInstancesByPackage.find(interface);
+            it != index.nativeInstancesByPackage.end()) {
+            return it->second;
         }
 
         ALOGE("VINTF interfaces require names in Java package format (e.g. some.package.foo.IFoo) "
@@ -326,17 +368,10 @@ static std::vector<std::string> getVintfInstances(const std::string& interface)
               interface.c_str());
         return {};
     }
-    const std::string package = interface.substr(0, lastDot);
-    const std::string iface = interface.substr(lastDot+1);
 
-    std::vector<std::string> ret;
-    (void)forEachManifest([&](const ManifestWithDescription& mwd) {
-        auto instances = mwd.manifest->getAidlInstances(package, iface);
-        ret.insert(ret.end(), instances.begin(), instances.end());
-        return false;  // continue
-    });
-
-    return ret;
+    auto it = index.aidlInstancesByInterface.find(interface);
+    if (it == index.aidlInstancesByInterface.end()) return {};
+    return it->second;
 }
 
 static bool meetsDeclarationRequirements(const Access::CallingContext& ctx,
@@ -495,6 +530,19 @@ bool isValidServiceName(const std::string& name) {
     return true;
 }
 
+Status ServiceManager::getServices(const std::vector<std::string>& names,
+                                   std::vector<os::Service>* outServices) {
+    SM_PERFETTO_TRACE_FUNC();
+
+    outServices->clear();
+    outServices->reserve(names.size());
+    for (const std::string& name : names) {
+        outServices->push_back(tryGetService(name, false));
+    }
+    // returns ok regardless of result, like checkService
+    return Status::ok();
+}
+
 Status ServiceManager::addService(const std::string& name, const sp<IBinder>& binder, bool allowIsolated, int32_t dumpPriority) {
     SM_PERFETTO_TRACE_FUNC(PERFETTO_TE_PROTO_FIELDS(
             PERFETTO_TE_PROTO_FIELD_CSTR(kProtoServiceName, name.c_str())));
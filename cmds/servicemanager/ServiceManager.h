@@ -67,6 +67,8 @@ public:
                                           const sp<IClientCallback>& cb) override;
     binder::Status tryUnregisterService(const std::string& name, const sp<IBinder>& binder) override;
     binder::Status getServiceDebugInfo(std::vector<ServiceDebugInfo>* outReturn) override;
+    binder::Status getServices(const std::vector<std::string>& names,
+                               std::vector<os::Service>* outServices) override;
     void binderDied(const wp<IBinder>& who) override;
     void handleClientCallbacks();
 
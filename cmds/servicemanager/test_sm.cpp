@@ -212,6 +212,44 @@ TEST(GetService, NonExistant) {
     EXPECT_EQ(nullptr, outBinder);
 }
 
+TEST(GetServices, HappyHappy) {
+    auto sm = getPermissiveServiceManager();
+    sp<IBinder> foo = getBinder();
+    sp<IBinder> bar = getBinder();
+
+    EXPECT_TRUE(sm->addService("foo", foo, false /*allowIsolated*/,
+        IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+    EXPECT_TRUE(sm->addService("bar", bar, false /*allowIsolated*/,
+        IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+
+    std::vector<Service> out;
+    EXPECT_TRUE(sm->getServices({"foo", "baz", "bar"}, &out).isOk());
+    ASSERT_EQ(3u, out.size());
+    EXPECT_EQ(foo, out[0].get<Service::Tag::binder>());
+    EXPECT_EQ(nullptr, out[1].get<Service::Tag::binder>());
+    EXPECT_EQ(bar, out[2].get<Service::Tag::binder>());
+}
+
+TEST(GetServices, NoPermissionsForGettingService) {
+    std::unique_ptr<MockAccess> access = std::make_unique<NiceMock<MockAccess>>();
+
+    EXPECT_CALL(*access, getCallingContext()).WillRepeatedly(Return(Access::CallingContext{}));
+    EXPECT_CALL(*access, canAdd(_, _)).WillOnce(Return(true));
+    EXPECT_CALL(*access, canFind(_, "foo")).WillRepeatedly(Return(false));
+    EXPECT_CALL(*access, canFind(_, "bar")).WillRepeatedly(Return(true));
+
+    sp<ServiceManager> sm = sp<NiceMock<MockServiceManager>>::make(std::move(access));
+
+    EXPECT_TRUE(sm->addService("foo", getBinder(), false /*allowIsolated*/,
+        IServiceManager::DUMP_FLAG_PRIORITY_DEFAULT).isOk());
+
+    std::vector<Service> out;
+    EXPECT_TRUE(sm->getServices({"foo", "bar"}, &out).isOk());
+    ASSERT_EQ(2u, out.size());
+    EXPECT_EQ(nullptr, out[0].get<Service::Tag::binder>());
+    EXPECT_EQ(nullptr, out[1].get<Service::Tag::binder>());
+}
+
 TEST(GetService, NoPermissionsForGettingService) {
     std::unique_ptr<MockAccess> access = std::make_unique<NiceMock<MockAccess>>();
 
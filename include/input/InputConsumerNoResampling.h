@@ -175,6 +175,14 @@ private:
     nsecs_t popConsumeTime(uint32_t seq);
 
     // Event reading and processing
+    /**
+     * The maximum number of messages read from the InputChannel at once.
+     */
+    static constexpr size_t RECEIVE_BUFFER_SIZE = 16;
+    /**
+     * Reused by readAllMessages, so that the messages are not zeroed for every read.
+     */
+    std::vector<InputMessage> mReceiveBuffer;
     /**
      * Read all of the available events from the InputChannel
      */
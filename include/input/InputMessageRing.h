@@ -0,0 +1,102 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <android-base/result.h>
+#include <android-base/unique_fd.h>
+#include <utils/Errors.h>
+
+namespace android {
+
+struct InputMessage;
+struct InputMessageRingHeader;
+
+/**
+ * A single-producer, single-consumer ring of InputMessages in shared memory.
+ *
+ * An InputChannel may carry one of these so that the messages sent to the consumer don't have to
+ * be copied through the socket, which also lets many more messages be pending than the socket
+ * buffer would allow. Messages are stored with their actual size, so that a ring holds as many
+ * small messages as possible.
+ *
+ * The ring lives in a sealed memfd, which is mapped by both processes. Neither side trusts the
+ * position written by the other beyond checking it against its own copy.
+ */
+class InputMessageRing {
+public:
+    /**
+     * Creates a ring in a new memfd, for the side that writes to it.
+     */
+    static android::base::Result<std::unique_ptr<InputMessageRing>> create(
+            const std::string& name);
+
+    /**
+     * Maps the ring in the given memfd. Fails if the memfd is not a sealed ring.
+     */
+    static android::base::Result<std::unique_ptr<InputMessageRing>> map(
+            android::base::unique_fd fd, bool isProducer);
+
+    ~InputMessageRing();
+
+    int getFd() const { return mFd.get(); }
+    bool isProducer() const { return mIsProducer; }
+
+    /**
+     * Writes a message to the ring, as InputChannel::sendMessages would: the message should have
+     * been sanitized with InputMessage::getSanitizedCopy.
+     *
+     * Return OK on success, and sets |outWakeConsumer| if the consumer may have drained the ring
+     * and be waiting for a new message.
+     * Return WOULD_BLOCK if the ring is full.
+     * Return DEAD_OBJECT if the consumer corrupted the ring.
+     */
+    status_t write(const InputMessage& msg, bool* outWakeConsumer);
+
+    /**
+     * Reads the next message from the ring.
+     *
+     * Return OK on success.
+     * Return WOULD_BLOCK if the ring is empty.
+     * Return BAD_VALUE if the message is not valid.
+     */
+    status_t read(InputMessage* outMsg);
+
+    /**
+     * Tells whether there may be a message to read. Only meaningful for the consumer.
+     */
+    bool hasMessages() const;
+
+private:
+    // Size of the data area. Must be a power of two.
+    static constexpr uint64_t DATA_SIZE = 64 * 1024;
+
+    InputMessageRing(android::base::unique_fd fd, void* memory, bool isProducer);
+
+    const android::base::unique_fd mFd;
+    InputMessageRingHeader* const mHeader;
+    uint8_t* const mData;
+    const bool mIsProducer;
+    // The position of this side, as a free-running byte count: the write position for the
+    // producer, and the read position for the consumer.
+    uint64_t mPosition = 0;
+};
+
+} // namespace android
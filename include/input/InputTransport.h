@@ -28,8 +28,10 @@
  * The InputConsumer is used by the application to receive events from the input dispatcher.
  */
 
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <android-base/chrono_utils.h>
 #include <android-base/result.h>
@@ -38,6 +40,7 @@
 #include <android/os/InputChannelCore.h>
 #include <binder/IBinder.h>
 #include <input/Input.h>
+#include <input/InputMessageRing.h>
 #include <input/InputVerifier.h>
 #include <sys/stat.h>
 #include <ui/Transform.h>
@@ -249,6 +252,17 @@ public:
                                          std::unique_ptr<InputChannel>& outServerChannel,
                                          std::unique_ptr<InputChannel>& outClientChannel);
 
+    /**
+     * Like openInputChannelPair, except that if |useSharedMemoryRing| is set, the messages sent
+     * by the server channel go through an InputMessageRing instead of the socket. The socket is
+     * then only used to wake up the client when the ring is no longer empty, and for the messages
+     * sent by the client.
+     */
+    static status_t openInputChannelPair(const std::string& name,
+                                         std::unique_ptr<InputChannel>& outServerChannel,
+                                         std::unique_ptr<InputChannel>& outClientChannel,
+                                         bool useSharedMemoryRing);
+
     inline std::string getName() const { return name; }
     inline int getFd() const { return fd.get(); }
 
@@ -265,6 +279,18 @@ public:
      */
     virtual status_t sendMessage(const InputMessage* msg);
 
+    /* Send several messages to the other endpoint, in order, with a single syscall.
+     *
+     * Unlike sendMessage, the messages are sent as they are, so they should have been sanitized
+     * with InputMessage::getSanitizedCopy.
+     *
+     * The messages are sent until one of them can't be sent, and the number of messages that
+     * were sent is returned in |outSent|. The status is that of the first message which couldn't
+     * be sent, as returned by sendMessage, or OK if all of them were sent. For a channel with an
+     * InputMessageRing, DEAD_OBJECT may also be returned after all of them were sent.
+     */
+    virtual status_t sendMessages(std::span<const InputMessage> messages, size_t* outSent);
+
     /* Receive a message sent by the other endpoint.
      *
      * If there is no message present, try again after poll() indicates that the fd
@@ -277,6 +303,14 @@ public:
      */
     virtual android::base::Result<InputMessage> receiveMessage();
 
+    /* Receive the messages present in the channel, up to the size of |outMessages|, with a
+     * single syscall.
+     *
+     * Return the number of messages that were received, which is at least one.
+     * Otherwise, return the same errors as receiveMessage.
+     */
+    virtual android::base::Result<size_t> receiveMessages(std::span<InputMessage> outMessages);
+
     /* Tells whether there is a message in the channel available to be received.
      *
      * This is only a performance hint and may return false negative results. Clients should not
@@ -329,6 +363,19 @@ protected:
 private:
     static std::unique_ptr<InputChannel> create(const std::string& name,
                                                 android::base::unique_fd fd, sp<IBinder> token);
+
+    // Set if the messages of this channel, or of its peer, go through shared memory.
+    std::unique_ptr<InputMessageRing> mRing;
+
+    bool isRingProducer() const { return mRing != nullptr && mRing->isProducer(); }
+    bool isRingConsumer() const { return mRing != nullptr && !mRing->isProducer(); }
+    android::base::unique_fd dupRingFd() const;
+
+    std::string sendMessageTraceName(const InputMessage& msg) const;
+    status_t sendMessagesToRing(std::span<const InputMessage> messages, size_t* outSent);
+    android::base::Result<size_t> receiveMessagesFromRing(std::span<InputMessage> outMessages);
+    status_t sendDoorbell();
+    status_t receiveDoorbell();
 };
 
 /*
@@ -415,6 +462,22 @@ public:
      */
     status_t publishTouchModeEvent(uint32_t seq, int32_t eventId, bool isInTouchMode);
 
+    /* Defers sending the events that are published until endBatch is called, so that they are
+     * sent with a single syscall.
+     *
+     * While batching, the publish methods return OK once the event is validated, and the result
+     * of sending it is reported by endBatch instead.
+     */
+    void beginBatch();
+
+    /* Sends the events published since beginBatch, in order, and stops batching.
+     *
+     * The number of events that were sent is returned in |outSent|. Returns the status of the
+     * first event which couldn't be sent, as the publish methods would have returned it when not
+     * batching, or OK if all of them were sent.
+     */
+    status_t endBatch(size_t* outSent);
+
     struct Finished {
         uint32_t seq;
         bool handled;
@@ -452,6 +515,13 @@ public:
 private:
     std::shared_ptr<InputChannel> mChannel;
     InputVerifier mInputVerifier;
+
+    bool mBatching = false;
+    // The sanitized messages deferred since beginBatch. The capacity is kept between batches,
+    // unless a batch grew unusually large.
+    std::vector<InputMessage> mBatch;
+
+    status_t sendMessage(const InputMessage& msg);
 };
 
 } // namespace android
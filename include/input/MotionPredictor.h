@@ -128,6 +128,9 @@ private:
     std::unique_ptr<TfLiteMotionPredictorModel> mModel;
 
     std::unique_ptr<TfLiteMotionPredictorBuffers> mBuffers;
+    // The generation of mBuffers that the model's current output was computed from. The model is
+    // deterministic, so it only needs to be invoked again once the buffers have changed.
+    std::optional<uint64_t> mModelOutputGeneration;
     std::optional<MotionEvent> mLastEvent;
 
     std::unique_ptr<JerkTracker> mJerkTracker;
@@ -82,8 +82,13 @@ public:
     // Returns the timestamp of the last sample.
     int64_t lastTimestamp() const { return mTimestamp; }
 
+    // Returns a counter that changes whenever the contents of the buffers change, so that the
+    // output of a model invoked on them can be reused until then.
+    uint64_t generation() const { return mGeneration; }
+
 private:
     int64_t mTimestamp = 0;
+    uint64_t mGeneration = 0;
 
     RingBuffer<float> mInputR;
     RingBuffer<float> mInputPhi;
@@ -163,6 +168,18 @@ private:
     const TfLiteTensor* mOutputPhi = nullptr;
     const TfLiteTensor* mOutputPressure = nullptr;
 
+    // The buffers of the tensors above, bound when the tensors are attached so that they don't
+    // have to be looked up and checked on every access.
+    std::span<float> mInputRBuffer;
+    std::span<float> mInputPhiBuffer;
+    std::span<float> mInputPressureBuffer;
+    std::span<float> mInputTiltBuffer;
+    std::span<float> mInputOrientationBuffer;
+
+    std::span<const float> mOutputRBuffer;
+    std::span<const float> mOutputPhiBuffer;
+    std::span<const float> mOutputPressureBuffer;
+
     std::unique_ptr<android::base::MappedFile> mFlatBuffer;
     std::unique_ptr<tflite::ErrorReporter> mErrorReporter;
     std::unique_ptr<tflite::FlatBufferModel> mModel;
@@ -21,6 +21,7 @@
 #include <input/RingBuffer.h>
 #include <utils/BitSet.h>
 #include <utils/Timers.h>
+#include <array>
 #include <map>
 #include <set>
 
@@ -175,6 +176,23 @@ protected:
     // protected const field.
     static constexpr uint32_t HISTORY_SIZE = 20;
 
+    /**
+     * The movements of a pointer as separate arrays of times and positions, newest first, so that
+     * the strategies can process them with vector instructions. The arrays are padded with zeros
+     * up to a multiple of the vector width.
+     */
+    struct MovementSamples {
+        static constexpr size_t CAPACITY = (HISTORY_SIZE + 3) & ~3u;
+
+        size_t count = 0;
+        // Time relative to the newest movement, in seconds. Zero or negative.
+        alignas(16) std::array<float, CAPACITY> times;
+        alignas(16) std::array<float, CAPACITY> positions;
+    };
+
+    static void getMovementSamples(const RingBuffer<Movement>& movements,
+                                   MovementSamples& outSamples);
+
     /**
      * Duration, in nanoseconds, since the latest movement where a movement may be considered for
      * velocity calculation.
@@ -220,14 +238,12 @@ private:
     // changes in direction.
     static const nsecs_t HORIZON = 100 * 1000000; // 100 ms
 
-    float chooseWeight(int32_t pointerId, uint32_t index) const;
+    float chooseWeight(const RingBuffer<Movement>& movements, uint32_t index) const;
     /**
      * An optimized least-squares solver for degree 2 and no weight (i.e. `Weighting.NONE`).
-     * The provided container of movements shall NOT be empty, and shall have the movements in
-     * chronological order.
+     * The provided samples shall NOT be empty.
      */
-    std::optional<float> solveUnweightedLeastSquaresDeg2(
-            const RingBuffer<Movement>& movements) const;
+    std::optional<float> solveUnweightedLeastSquaresDeg2(const MovementSamples& samples) const;
 
     const uint32_t mDegree;
     const Weighting mWeighting;
@@ -101,6 +101,8 @@ bool BinderCacheWithInvalidation::isClientSideCachingEnabled(const std::string&
               serviceName.c_str());
         return false;
     }
+    // Only long-lived services are cached, since a cached binder keeps e.g. a
+    // lazy service running as long as this process.
     for (const char* name : kStaticCachableList) {
         if (name == serviceName) {
             return true;
@@ -109,21 +111,125 @@ bool BinderCacheWithInvalidation::isClientSideCachingEnabled(const std::string&
     return false;
 }
 
+std::optional<uint64_t> BinderCacheWithInvalidation::prepareItem(const std::string& key) {
+    if (!isClientSideCachingEnabled(key)) {
+        return std::nullopt;
+    }
+
+    std::unique_lock<std::mutex> lock(mCacheMutex);
+    if (auto it = mWatches.find(key); it != mWatches.end()) {
+        if (!it->second.ready) return std::nullopt;
+        return it->second.generation;
+    }
+
+    // Watches are only removed once ready, so this stays valid.
+    Watch& watch = mWatches[key];
+    watch.generation = ++mLastGeneration;
+    watch.callback = sp<RegistrationInvalidation>::make(weak_from_this());
+    sp<RegistrationInvalidation> callback = watch.callback;
+    lock.unlock();
+
+    binder::Status status = mServiceManager->registerForNotifications(key, callback);
+
+    lock.lock();
+    if (!status.isOk()) {
+        // e.g. isolated processes can't register for notifications
+        ALOGI("Only invalidating %s on death, failed to register for notifications: %s",
+              key.c_str(), status.toString8().c_str());
+        watch.callback = nullptr;
+    }
+    watch.ready = true;
+    return watch.generation;
+}
+
+void BinderCacheWithInvalidation::releaseItem(const std::string& key) {
+    sp<RegistrationInvalidation> callback;
+    {
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+        if (mCache.count(key) != 0) return;
+        callback = takeWatchLocked(key);
+    }
+    unregister(key, callback);
+}
+
+sp<BinderCacheWithInvalidation::RegistrationInvalidation>
+BinderCacheWithInvalidation::takeWatchLocked(const std::string& key) {
+    auto it = mWatches.find(key);
+    if (it == mWatches.end() || !it->second.ready) return nullptr;
+    sp<RegistrationInvalidation> callback = std::move(it->second.callback);
+    mWatches.erase(it);
+    return callback;
+}
+
+void BinderCacheWithInvalidation::unregister(const std::string& key,
+                                             const sp<RegistrationInvalidation>& callback) {
+    if (callback == nullptr) return;
+    binder::Status status = mServiceManager->unregisterForNotifications(key, callback);
+    if (!status.isOk()) {
+        ALOGW("Failed to unregister for notifications of %s: %s", key.c_str(),
+              status.toString8().c_str());
+    }
+}
+
+void BinderCacheWithInvalidation::onRegistration(const std::string& key,
+                                                 const sp<IBinder>& service,
+                                                 const RegistrationInvalidation* callback) {
+    sp<RegistrationInvalidation> toUnregister;
+    {
+        std::lock_guard<std::mutex> lock(mCacheMutex);
+        // ignore notifications still in flight for a previous watch
+        auto watch = mWatches.find(key);
+        if (watch == mWatches.end() || watch->second.callback.get() != callback) return;
+        watch->second.generation = ++mLastGeneration;
+        watch->second.latest = service;
+
+        if (auto it = mCache.find(key); it != mCache.end() && it->second.service != service) {
+            if (it->second.service->localBinder() == nullptr) {
+                it->second.service->unlinkToDeath(it->second.deathRecipient);
+            }
+            mCache.erase(it);
+            mInvalidations++;
+            toUnregister = takeWatchLocked(key);
+        }
+    }
+    unregister(key, toUnregister);
+}
+
+std::string BinderCacheWithInvalidation::dump() const {
+    std::lock_guard<std::mutex> lock(mCacheMutex);
+    std::string ret = "Service cache: " + std::to_string(mHits.load()) + " hits, " +
+            std::to_string(mMisses.load()) + " misses, " + std::to_string(mInvalidations.load()) +
+            " invalidations, " + std::to_string(mWatches.size()) + " names watched\n";
+    for (const auto& [name, entry] : mCache) {
+        (void)entry;
+        ret += "  " + name + "\n";
+    }
+    return ret;
+}
+
 binder::Status BackendUnifiedServiceManager::updateCache(const std::string& serviceName,
-                                                         const os::Service& service) {
-    if (!kUseCache) {
+                                                         const os::Service& service,
+                                                         std::optional<uint64_t> generation) {
+    if (!generation.has_value()) {
         return binder::Status::ok();
     }
     if (service.getTag() == os::Service::Tag::binder) {
         sp<IBinder> binder = service.get<os::Service::Tag::binder>();
-        if (binder && mCacheForGetService->isClientSideCachingEnabled(serviceName) &&
-            binder->isBinderAlive()) {
-            return mCacheForGetService->setItem(serviceName, binder);
+        if (binder && binder->isBinderAlive()) {
+            return mCacheForGetService->setItem(serviceName, binder, *generation);
         }
     }
+    mCacheForGetService->releaseItem(serviceName);
     return binder::Status::ok();
 }
 
+std::optional<uint64_t> BackendUnifiedServiceManager::prepareCache(const std::string& serviceName) {
+    if (!kUseCache) {
+        return std::nullopt;
+    }
+    return mCacheForGetService->prepareItem(serviceName);
+}
+
 bool BackendUnifiedServiceManager::returnIfCached(const std::string& serviceName,
                                                   os::Service* _out) {
     if (!kUseCache) {
@@ -131,22 +237,27 @@ bool BackendUnifiedServiceManager::returnIfCached(const std::string& serviceName
     }
     sp<IBinder> item = mCacheForGetService->getItem(serviceName);
     // TODO(b/363177618): Enable caching for binders which are always null.
-    if (item != nullptr && item->isBinderAlive()) {
+    bool hit = item != nullptr && item->isBinderAlive();
+    mCacheForGetService->recordLookup(hit);
+    if (hit) {
         *_out = os::Service::make<os::Service::Tag::binder>(item);
-        return true;
     }
-    return false;
+    return hit;
 }
 
 BackendUnifiedServiceManager::BackendUnifiedServiceManager(const sp<AidlServiceManager>& impl)
       : mTheRealServiceManager(impl) {
-    mCacheForGetService = std::make_shared<BinderCacheWithInvalidation>();
+    mCacheForGetService = std::make_shared<BinderCacheWithInvalidation>(impl);
 }
 
 sp<AidlServiceManager> BackendUnifiedServiceManager::getImpl() {
     return mTheRealServiceManager;
 }
 
+std::string BackendUnifiedServiceManager::dumpCache() const {
+    return mCacheForGetService->dump();
+}
+
 binder::Status BackendUnifiedServiceManager::getService(const ::std::string& name,
                                                         sp<IBinder>* _aidl_return) {
     os::Service service;
@@ -160,13 +271,14 @@ binder::Status BackendUnifiedServiceManager::getService2(const ::std::string& na
     if (returnIfCached(name, _out)) {
         return binder::Status::ok();
     }
+    std::optional<uint64_t> generation = prepareCache(name);
     os::Service service;
     binder::Status status = mTheRealServiceManager->getService2(name, &service);
 
     if (status.isOk()) {
         status = toBinderService(name, service, _out);
         if (status.isOk()) {
-            return updateCache(name, service);
+            return updateCache(name, service, generation);
         }
     }
     return status;
@@ -178,17 +290,69 @@ binder::Status BackendUnifiedServiceManager::checkService(const ::std::string& n
     if (returnIfCached(name, _out)) {
         return binder::Status::ok();
     }
+    std::optional<uint64_t> generation = prepareCache(name);
 
     binder::Status status = mTheRealServiceManager->checkService(name, &service);
     if (status.isOk()) {
         status = toBinderService(name, service, _out);
         if (status.isOk()) {
-            return updateCache(name, service);
+            return updateCache(name, service, generation);
         }
     }
     return status;
 }
 
+binder::Status BackendUnifiedServiceManager::getServices(const ::std::vector<::std::string>& names,
+                                                         ::std::vector<os::Service>* _out) {
+    _out->assign(names.size(), os::Service::make<os::Service::Tag::binder>(nullptr));
+
+    // only ask servicemanager for the services which aren't cached
+    std::vector<size_t> missing;
+    std::vector<std::string> missingNames;
+    for (size_t i = 0; i < names.size(); i++) {
+        if (!returnIfCached(names[i], &(*_out)[i])) {
+            missing.push_back(i);
+            missingNames.push_back(names[i]);
+        }
+    }
+    if (missing.empty()) {
+        return binder::Status::ok();
+    }
+
+    std::vector<std::optional<uint64_t>> generations;
+    generations.reserve(missing.size());
+    for (const std::string& name : missingNames) {
+        generations.push_back(prepareCache(name));
+    }
+
+    std::vector<os::Service> services;
+    binder::Status status = mTheRealServiceManager->getServices(missingNames, &services);
+    if (status.exceptionCode() == binder::Status::EX_TRANSACTION_FAILED &&
+        status.transactionError() == UNKNOWN_TRANSACTION) {
+        // servicemanager predates getServices
+        services.resize(missingNames.size());
+        for (size_t i = 0; i < missingNames.size(); i++) {
+            status = mTheRealServiceManager->checkService(missingNames[i], &services[i]);
+            if (!status.isOk()) return status;
+        }
+    } else if (!status.isOk()) {
+        return status;
+    }
+    if (services.size() != missingNames.size()) {
+        ALOGE("getServices returned %zu services for %zu names", services.size(),
+              missingNames.size());
+        return binder::Status::fromStatusT(BAD_VALUE);
+    }
+
+    for (size_t i = 0; i < missing.size(); i++) {
+        status = toBinderService(missingNames[i], services[i], &(*_out)[missing[i]]);
+        if (!status.isOk()) return status;
+        status = updateCache(missingNames[i], services[i], generations[i]);
+        if (!status.isOk()) return status;
+    }
+    return binder::Status::ok();
+}
+
 binder::Status BackendUnifiedServiceManager::toBinderService(const ::std::string& name,
                                                              const os::Service& in,
                                                              os::Service* _out) {
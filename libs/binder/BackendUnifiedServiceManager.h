@@ -15,11 +15,14 @@
  */
 #pragma once
 
+#include <android/os/BnServiceCallback.h>
 #include <android/os/BnServiceManager.h>
 #include <android/os/IServiceManager.h>
 #include <binder/IPCThreadState.h>
+#include <atomic>
 #include <map>
 #include <memory>
+#include <optional>
 
 namespace android {
 
@@ -43,12 +46,44 @@ class BinderCacheWithInvalidation
         std::weak_ptr<BinderCacheWithInvalidation> mCache;
         std::string mKey;
     };
+    // A cachable service may be registered again with a different binder
+    // while the old one is still alive, so the cache also listens for
+    // registrations. Each watched name has its own callback, so that it can
+    // be unregistered without affecting a later watch of the same name.
+    class RegistrationInvalidation : public os::BnServiceCallback {
+    public:
+        explicit RegistrationInvalidation(std::weak_ptr<BinderCacheWithInvalidation> cache)
+              : mCache(cache) {}
+
+        binder::Status onRegistration(const std::string& name,
+                                      const sp<IBinder>& service) override {
+            if (std::shared_ptr<BinderCacheWithInvalidation> cache = mCache.lock()) {
+                cache->onRegistration(name, service, this);
+            }
+            return binder::Status::ok();
+        }
+
+    private:
+        std::weak_ptr<BinderCacheWithInvalidation> mCache;
+    };
     struct Entry {
         sp<IBinder> service;
         sp<BinderInvalidation> deathRecipient;
     };
+    struct Watch {
+        // false while registering for notifications
+        bool ready = false;
+        // changed for every registration of the name, and never reused
+        uint64_t generation = 0;
+        wp<IBinder> latest;
+        // null if registering for notifications failed, in which case the
+        // name is only invalidated on death
+        sp<RegistrationInvalidation> callback;
+    };
 
 public:
+    explicit BinderCacheWithInvalidation(const sp<os::IServiceManager>& sm) : mServiceManager(sm) {}
+
     sp<IBinder> getItem(const std::string& key) const {
         std::lock_guard<std::mutex> lock(mCacheMutex);
 
@@ -59,21 +94,28 @@ public:
     }
 
     bool removeItem(const std::string& key, const sp<IBinder>& who) {
-        std::lock_guard<std::mutex> lock(mCacheMutex);
-        if (auto it = mCache.find(key); it != mCache.end()) {
-            if (it->second.service == who) {
-                status_t result = who->unlinkToDeath(it->second.deathRecipient);
-                if (result != DEAD_OBJECT) {
-                    ALOGW("Unlinking to dead binder resulted in: %d", result);
-                }
-                mCache.erase(key);
-                return true;
+        sp<RegistrationInvalidation> callback;
+        {
+            std::lock_guard<std::mutex> lock(mCacheMutex);
+            auto it = mCache.find(key);
+            if (it == mCache.end() || it->second.service != who) {
+                return false;
             }
+            status_t result = who->unlinkToDeath(it->second.deathRecipient);
+            if (result != DEAD_OBJECT) {
+                ALOGW("Unlinking to dead binder resulted in: %d", result);
+            }
+            mCache.erase(key);
+            mInvalidations++;
+            callback = takeWatchLocked(key);
         }
-        return false;
+        unregister(key, callback);
+        return true;
     }
 
-    binder::Status setItem(const std::string& key, const sp<IBinder>& item) {
+    // 'generation' is from prepareItem, and is checked so that a binder
+    // which was replaced while it was being looked up isn't cached.
+    binder::Status setItem(const std::string& key, const sp<IBinder>& item, uint64_t generation) {
         sp<BinderInvalidation> deathRecipient =
                 sp<BinderInvalidation>::make(shared_from_this(), key);
 
@@ -87,16 +129,51 @@ public:
             }
         }
         std::lock_guard<std::mutex> lock(mCacheMutex);
+        // The watch is gone if the name was invalidated during the lookup.
+        auto watch = mWatches.find(key);
+        if (watch == mWatches.end() ||
+            (watch->second.generation != generation &&
+             watch->second.latest.unsafe_get() != item.get())) {
+            if (item->localBinder() == nullptr) item->unlinkToDeath(deathRecipient);
+            return binder::Status::ok();
+        }
         Entry entry = {.service = item, .deathRecipient = deathRecipient};
         mCache[key] = entry;
         return binder::Status::ok();
     }
 
+    // Must be called before looking up a service which isn't cached. Returns
+    // std::nullopt if the result of the lookup can't be cached, otherwise
+    // the generation to pass to setItem along with it.
+    std::optional<uint64_t> prepareItem(const std::string& key);
+
+    // Stops watching 'key', e.g. because the lookup after prepareItem didn't
+    // find anything to cache.
+    void releaseItem(const std::string& key);
+
+    void recordLookup(bool hit) { (hit ? mHits : mMisses)++; }
+
+    std::string dump() const;
+
     bool isClientSideCachingEnabled(const std::string& serviceName);
 
 private:
+    void onRegistration(const std::string& key, const sp<IBinder>& service,
+                        const RegistrationInvalidation* callback);
+    // Removes the watch for 'key' if it is ready, returning the callback to
+    // unregister (without mCacheMutex held).
+    sp<RegistrationInvalidation> takeWatchLocked(const std::string& key);
+    void unregister(const std::string& key, const sp<RegistrationInvalidation>& callback);
+
+    const sp<os::IServiceManager> mServiceManager;
     std::map<std::string, Entry> mCache;
+    std::map<std::string, Watch> mWatches;
+    uint64_t mLastGeneration = 0;
     mutable std::mutex mCacheMutex;
+
+    std::atomic<uint64_t> mHits = 0;
+    std::atomic<uint64_t> mMisses = 0;
+    std::atomic<uint64_t> mInvalidations = 0;
 };
 
 class BackendUnifiedServiceManager : public android::os::BnServiceManager {
@@ -104,6 +181,7 @@ public:
     explicit BackendUnifiedServiceManager(const sp<os::IServiceManager>& impl);
 
     sp<os::IServiceManager> getImpl();
+    std::string dumpCache() const;
     binder::Status getService(const ::std::string& name, sp<IBinder>* _aidl_return) override;
     binder::Status getService2(const ::std::string& name, os::Service* out) override;
     binder::Status checkService(const ::std::string& name, os::Service* out) override;
@@ -129,6 +207,8 @@ public:
     binder::Status tryUnregisterService(const ::std::string& name,
                                         const sp<IBinder>& service) override;
     binder::Status getServiceDebugInfo(::std::vector<os::ServiceDebugInfo>* _aidl_return) override;
+    binder::Status getServices(const ::std::vector<::std::string>& names,
+                               ::std::vector<os::Service>* _aidl_return) override;
 
     // for legacy ABI
     const String16& getInterfaceDescriptor() const override {
@@ -140,7 +220,9 @@ private:
     sp<os::IServiceManager> mTheRealServiceManager;
     binder::Status toBinderService(const ::std::string& name, const os::Service& in,
                                    os::Service* _out);
-    binder::Status updateCache(const std::string& serviceName, const os::Service& service);
+    binder::Status updateCache(const std::string& serviceName, const os::Service& service,
+                               std::optional<uint64_t> generation);
+    std::optional<uint64_t> prepareCache(const std::string& serviceName);
     bool returnIfCached(const std::string& serviceName, os::Service* _out);
 };
 
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "BinderBatch"
+
+#include <binder/BinderBatch.h>
+
+#include <binder/IPCThreadState.h>
+#include <log/log.h>
+
+namespace android {
+
+BinderBatch::BinderBatch() : mThreadState(IPCThreadState::self()) {
+    mThreadState->beginOnewayBatch();
+}
+
+BinderBatch::~BinderBatch() {
+    LOG_ALWAYS_FATAL_IF(mThreadState != IPCThreadState::selfOrNull(),
+                        "BinderBatch destroyed on a different thread than it was created on");
+    if (status_t status = mThreadState->endOnewayBatch(); status != OK) {
+        ALOGW("Unflushed batched oneway transaction failed: %s", statusToString(status).c_str());
+    }
+}
+
+status_t BinderBatch::flush() {
+    return mThreadState->flushOnewayBatch();
+}
+
+} // namespace android
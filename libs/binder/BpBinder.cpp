@@ -367,6 +367,26 @@ status_t BpBinder::dump(int fd, const Vector<String16>& args)
     return err;
 }
 
+status_t BpBinder::checkStability(uint32_t code, bool privateVendor) {
+    // user transactions require a given stability level
+    if (code >= FIRST_CALL_TRANSACTION && code <= LAST_CALL_TRANSACTION) {
+        using android::internal::Stability;
+
+        int16_t stability = Stability::getRepr(this);
+        Stability::Level required = privateVendor ? Stability::VENDOR
+            : Stability::getLocalLevel();
+
+        if (!Stability::check(stability, required)) [[unlikely]] {
+            ALOGE("Cannot do a user transaction on a %s binder (%s) in a %s context.",
+                  Stability::levelString(stability).c_str(),
+                  String8(getInterfaceDescriptor()).c_str(),
+                  Stability::levelString(required).c_str());
+            return BAD_TYPE;
+        }
+    }
+    return OK;
+}
+
 // NOLINTNEXTLINE(google-default-arguments)
 status_t BpBinder::transact(
     uint32_t code, const Parcel& data, Parcel* reply, uint32_t flags)
@@ -377,22 +397,7 @@ status_t BpBinder::transact(
         // don't send userspace flags to the kernel
         flags = flags & ~static_cast<uint32_t>(FLAG_PRIVATE_VENDOR);
 
-        // user transactions require a given stability level
-        if (code >= FIRST_CALL_TRANSACTION && code <= LAST_CALL_TRANSACTION) {
-            using android::internal::Stability;
-
-            int16_t stability = Stability::getRepr(this);
-            Stability::Level required = privateVendor ? Stability::VENDOR
-                : Stability::getLocalLevel();
-
-            if (!Stability::check(stability, required)) [[unlikely]] {
-                ALOGE("Cannot do a user transaction on a %s binder (%s) in a %s context.",
-                      Stability::levelString(stability).c_str(),
-                      String8(getInterfaceDescriptor()).c_str(),
-                      Stability::levelString(required).c_str());
-                return BAD_TYPE;
-            }
-        }
+        if (status_t status = checkStability(code, privateVendor); status != OK) return status;
 
         status_t status;
         if (isRpcBinder()) [[unlikely]] {
@@ -420,6 +425,51 @@ status_t BpBinder::transact(
     return DEAD_OBJECT;
 }
 
+namespace {
+// A transaction which was already completed when it was started.
+class CompletedTransaction : public PendingTransaction {
+public:
+    bool isReady() override { return true; }
+    status_t waitForReply(Parcel* reply) override {
+        reply->setDataSize(0);
+        if (status_t status = reply->appendFrom(&mReply, 0, mReply.dataSize()); status != OK) {
+            return status;
+        }
+        reply->setDataPosition(0);
+        return OK;
+    }
+
+    Parcel* reply() { return &mReply; }
+
+private:
+    Parcel mReply;
+};
+} // namespace
+
+status_t BpBinder::transactAsync(uint32_t code, const Parcel& data, uint32_t flags,
+                                 std::unique_ptr<PendingTransaction>* pending) {
+    if (isRpcBinder() && !(flags & FLAG_ONEWAY) && mAlive) {
+        bool privateVendor = flags & FLAG_PRIVATE_VENDOR;
+        flags = flags & ~static_cast<uint32_t>(FLAG_PRIVATE_VENDOR);
+
+        if (status_t status = checkStability(code, privateVendor); status != OK) return status;
+
+        status_t status =
+                rpcSession()->transactAsync(sp<IBinder>::fromExisting(this), code, data, flags,
+                                            pending);
+        if (status == DEAD_OBJECT) mAlive = 0;
+        return status;
+    }
+
+    // The kernel driver only returns a reply to the thread which sent the
+    // transaction, so there is nothing to gain from splitting it.
+    auto completed = std::make_unique<CompletedTransaction>();
+    status_t status = transact(code, data, completed->reply(), flags);
+    if (status != OK) return status;
+    *pending = std::move(completed);
+    return OK;
+}
+
 // NOLINTNEXTLINE(google-default-arguments)
 status_t BpBinder::linkToDeath(
     const sp<DeathRecipient>& recipient, void* cookie, uint32_t flags)
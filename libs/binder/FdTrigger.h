@@ -57,6 +57,14 @@ public:
     [[nodiscard]] status_t triggerablePoll(const android::RpcTransportFd& transportFd,
                                            int16_t event);
 
+#ifndef BINDER_RPC_SINGLE_THREADED
+    /**
+     * The read end of the pipe, which gets POLLHUP once trigger() is called. For transports
+     * that wait on the trigger themselves rather than through triggerablePoll.
+     */
+    [[nodiscard]] binder::borrowed_fd readFd() const { return mRead; }
+#endif
+
 private:
 #ifdef BINDER_RPC_SINGLE_THREADED
     bool mTriggered = false;
@@ -35,6 +35,7 @@
 #include <sys/resource.h>
 #include <unistd.h>
 
+#include "ParcelBufferPool.h"
 #include "Utils.h"
 #include "binder_module.h"
 
@@ -599,6 +600,10 @@ int32_t IPCThreadState::getLastTransactionBinderFlags() const
     return mLastTransactionBinderFlags;
 }
 
+IPCThreadState::ParcelBufferPoolStats IPCThreadState::getParcelBufferPoolStats() const {
+    return mParcelBufferPool->stats();
+}
+
 void IPCThreadState::setCallRestriction(ProcessState::CallRestriction restriction) {
     mCallRestriction = restriction;
 }
@@ -638,6 +643,62 @@ void IPCThreadState::flushCommands()
     }
 }
 
+void IPCThreadState::beginOnewayBatch()
+{
+    mOnewayBatchDepth++;
+}
+
+status_t IPCThreadState::flushOnewayBatch()
+{
+    status_t result = NO_ERROR;
+    // Results come back in the order the transactions were queued, ahead of
+    // results for anything written to mOut after them.
+    size_t pending = mOnewayBatchPending;
+    mOnewayBatchPending = 0;
+    while (pending > 0) {
+        pending--;
+        status_t err = waitForResponse(nullptr, nullptr);
+        if (result == NO_ERROR) result = err;
+    }
+    // As with a regular transaction whose parcel goes away after a failed
+    // send, the data is not kept around for a retry once sending fails.
+    if (mOut.dataSize() == 0 || result != NO_ERROR) mOnewayBatchData.clear();
+    return result;
+}
+
+status_t IPCThreadState::endOnewayBatch()
+{
+    LOG_ALWAYS_FATAL_IF(mOnewayBatchDepth == 0, "endOnewayBatch() without beginOnewayBatch()");
+    if (--mOnewayBatchDepth > 0) return NO_ERROR;
+    return flushOnewayBatch();
+}
+
+status_t IPCThreadState::queueOnewayTransaction(uint32_t flags, int32_t handle, uint32_t code,
+                                                const Parcel& data)
+{
+    // Bounds the memory held by a batch, and the number of results the
+    // flush has to read back.
+    constexpr size_t kMaxOnewayBatchSize = 64;
+    if (mOnewayBatchData.size() >= kMaxOnewayBatchSize) {
+        status_t err = flushOnewayBatch();
+        if (err != NO_ERROR) return (mLastError = err);
+    }
+
+    // The driver reads the data when mOut is sent, after the caller may have
+    // destroyed `data`. Copying also takes references on any objects in it.
+    auto copy = std::make_unique<Parcel>();
+    if (data.mDeallocZero) copy->markSensitive();
+    status_t err = copy->appendFrom(&data, 0, data.dataSize());
+    if (err != NO_ERROR) return (mLastError = err);
+
+    err = writeTransactionData(BC_TRANSACTION, flags, handle, code, *copy, nullptr);
+    if (err != NO_ERROR) return (mLastError = err);
+
+    mOnewayBatchData.push_back(std::move(copy));
+    mOnewayBatchPending++;
+    return NO_ERROR;
+}
+
 bool IPCThreadState::flushIfNeeded()
 {
     if (mIsLooper || mServingStackPointer != nullptr || mIsFlushing) {
@@ -866,6 +927,9 @@ status_t IPCThreadState::transact(int32_t handle,
 
     LOG_ONEWAY(">>>> SEND from pid %d uid %d %s", getpid(), getuid(),
         (flags & TF_ONE_WAY) == 0 ? "READ REPLY" : "ONE WAY");
+    if ((flags & TF_ONE_WAY) != 0 && mOnewayBatchDepth > 0) {
+        return queueOnewayTransaction(flags, handle, code, data);
+    }
     err = writeTransactionData(BC_TRANSACTION, flags, handle, code, data, nullptr);
 
     if (err != NO_ERROR) {
@@ -1022,6 +1086,7 @@ status_t IPCThreadState::removeFrozenStateChangeCallback(int32_t handle, BpBinde
 
 IPCThreadState::IPCThreadState()
       : mProcess(ProcessState::self()),
+        mParcelBufferPool(std::make_unique<ParcelBufferPool>()),
         mServingStackPointer(nullptr),
         mServingStackPointerGuard(nullptr),
         mWorkSource(kUnsetWorkSource),
@@ -1030,7 +1095,9 @@ IPCThreadState::IPCThreadState()
         mIsFlushing(false),
         mStrictModePolicy(0),
         mLastTransactionBinderFlags(0),
-        mCallRestriction(mProcess->mCallRestriction) {
+        mCallRestriction(mProcess->mCallRestriction),
+        mOnewayBatchDepth(0),
+        mOnewayBatchPending(0) {
     pthread_setspecific(gTLS, this);
     clearCaller();
     mHasExplicitIdentity = false;
@@ -1057,6 +1124,12 @@ status_t IPCThreadState::waitForResponse(Parcel *reply, status_t *acquireResult)
     uint32_t cmd;
     int32_t err;
 
+    if (mOnewayBatchPending > 0) {
+        // Read the results of batched oneway transactions, which the driver
+        // sends before the result being waited for.
+        (void)flushOnewayBatch();
+    }
+
     while (1) {
         if ((err=talkWithDriver()) < NO_ERROR) break;
         err = mIn.errorCheck();
@@ -23,6 +23,7 @@
 
 #include <inttypes.h>
 #include <unistd.h>
+#include <algorithm>
 #include <chrono>
 #include <condition_variable>
 
@@ -85,6 +86,15 @@ const String16& IServiceManager::getInterfaceDescriptor() const {
 IServiceManager::IServiceManager() {}
 IServiceManager::~IServiceManager() {}
 
+std::vector<sp<IBinder>> IServiceManager::checkServices(const std::vector<String16>& names) const {
+    std::vector<sp<IBinder>> ret;
+    ret.reserve(names.size());
+    for (const String16& name : names) {
+        ret.push_back(checkService(name));
+    }
+    return ret;
+}
+
 // From the old libbinder IServiceManager interface to IServiceManager.
 class CppBackendShim : public IServiceManager {
 public:
@@ -313,6 +323,10 @@ void setDefaultServiceManager(const sp<IServiceManager>& sm) {
     }
 }
 
+std::string dumpServiceCache() {
+    return getBackendUnifiedServiceManager()->dumpCache();
+}
+
 sp<IServiceManager> getServiceManagerShimFromAidlServiceManagerForTests(
         const sp<AidlServiceManager>& sm) {
     return sp<CppBackendShim>::make(sp<BackendUnifiedServiceManager>::make(sm));
@@ -63,6 +63,7 @@
 // is conditional on BINDER_WITH_KERNEL_IPC.
 #ifdef BINDER_WITH_KERNEL_IPC
 #include <linux/sched.h>
+#include "ParcelBufferPool.h"
 #include "binder_module.h"
 #else  // BINDER_WITH_KERNEL_IPC
 // Needed by {read,write}Pointer
@@ -117,6 +118,14 @@ constexpr size_t kMaxFds = 1024;
 // Maximum size of a blob to transfer in-place.
 [[maybe_unused]] static const size_t BLOB_INPLACE_LIMIT = 16 * 1024;
 
+// Minimum size of a byte array to reference instead of copying into an RPC
+// Parcel. Below this, an extra iovec costs more than the copy.
+constexpr size_t kMinExternalSegmentSize = 4 * 1024;
+
+// Maximum number of external segments per Parcel. Each segment needs up to
+// three iovecs when sending, which must stay well below IOV_MAX.
+constexpr size_t kMaxExternalSegments = 128;
+
 #if defined(__BIONIC__)
 static void FdTag(int fd, const void* old_addr, const void* new_addr) {
     if (android_fdsan_exchange_owner_tag) {
@@ -419,13 +428,21 @@ size_t Parcel::dataSize() const
     return (mDataSize > mDataPos ? mDataSize : mDataPos);
 }
 
+size_t Parcel::externalDataSize() const
+{
+    if (const auto* rpcFields = maybeRpcFields(); rpcFields && rpcFields->mExternalData) {
+        return rpcFields->mExternalData->size;
+    }
+    return 0;
+}
+
 size_t Parcel::dataBufferSize() const {
     return mDataSize;
 }
 
 size_t Parcel::dataAvail() const
 {
-    size_t result = dataSize() - dataPosition();
+    size_t result = dataSize() + externalDataSize() - dataPosition();
     if (result > INT32_MAX) {
         LOG_ALWAYS_FATAL("result too big: %zu", result);
     }
@@ -434,7 +451,7 @@ size_t Parcel::dataAvail() const
 
 size_t Parcel::dataPosition() const
 {
-    return mDataPos;
+    return mDataPos + externalDataSizeBefore(mDataPos);
 }
 
 size_t Parcel::dataCapacity() const
@@ -467,7 +484,7 @@ void Parcel::setDataPosition(size_t pos) const
         LOG_ALWAYS_FATAL("pos too big: %zu", pos);
     }
 
-    mDataPos = pos;
+    mDataPos = externalToDataPosition(pos);
     if (const auto* kernelFields = maybeKernelFields()) {
         kernelFields->mNextObjectHint = 0;
         kernelFields->mObjectsSorted = false;
@@ -515,6 +532,10 @@ status_t Parcel::appendFrom(const Parcel* parcel, size_t offset, size_t len) {
         ALOGE("Cannot append Parcels from different sessions");
         return BAD_TYPE;
     }
+    if (isForRpc() && (maybeRpcFields()->mExternalData || parcel->maybeRpcFields()->mExternalData)) {
+        ALOGE("Cannot append Parcels which reference external data");
+        return INVALID_OPERATION;
+    }
 
     status_t err;
     const uint8_t* data = parcel->mData;
@@ -688,7 +709,30 @@ int Parcel::compareData(const Parcel& other) {
     if (size != other.dataSize()) {
         return size < other.dataSize() ? -1 : 1;
     }
-    return memcmp(data(), other.data(), size);
+    if (int result = memcmp(data(), other.data(), size); result != 0) return result;
+
+    const auto* external = maybeRpcFields() ? maybeRpcFields()->mExternalData.get() : nullptr;
+    const auto* otherExternal =
+            other.maybeRpcFields() ? other.maybeRpcFields()->mExternalData.get() : nullptr;
+    size_t segments = external ? external->segments.size() : 0;
+    size_t otherSegments = otherExternal ? otherExternal->segments.size() : 0;
+    if (segments != otherSegments) {
+        return segments < otherSegments ? -1 : 1;
+    }
+    for (size_t i = 0; i < segments; i++) {
+        const auto& segment = external->segments[i];
+        const auto& otherSegment = otherExternal->segments[i];
+        if (segment.position != otherSegment.position) {
+            return segment.position < otherSegment.position ? -1 : 1;
+        }
+        if (segment.size != otherSegment.size) {
+            return segment.size < otherSegment.size ? -1 : 1;
+        }
+        if (int result = memcmp(segment.data, otherSegment.data, segment.size); result != 0) {
+            return result;
+        }
+    }
+    return 0;
 }
 
 status_t Parcel::compareDataInRange(size_t thisOffset, const Parcel& other, size_t otherOffset,
@@ -1433,6 +1477,31 @@ status_t Parcel::writeByteArray(size_t len, const uint8_t *val) {
     return ret;
 }
 
+status_t Parcel::writeByteArrayReference(size_t len, const uint8_t* val) {
+    auto* rpcFields = maybeRpcFields();
+    if (rpcFields == nullptr || val == nullptr || len < kMinExternalSegmentSize ||
+        len > INT32_MAX || mDataPos != mDataSize ||
+        (rpcFields->mExternalData &&
+         rpcFields->mExternalData->segments.size() >= kMaxExternalSegments)) {
+        return writeByteArray(len, val);
+    }
+
+    if (status_t status = writeInt32(static_cast<int32_t>(len)); status != OK) return status;
+
+    if (rpcFields->mExternalData == nullptr) {
+        rpcFields->mExternalData = std::make_unique<RpcFields::ExternalData>();
+    }
+    const size_t padded = pad_size(len);
+    rpcFields->mExternalData->segments.push_back({
+            .position = mDataPos,
+            .data = val,
+            .size = len,
+            .padding = padded - len,
+    });
+    rpcFields->mExternalData->size += padded;
+    return OK;
+}
+
 status_t Parcel::writeBool(bool val)
 {
     return writeInt32(int32_t(val));
@@ -2946,7 +3015,7 @@ void Parcel::freeDataNoInit()
             if (mDeallocZero) {
                 zeroMemory(mData, mDataSize);
             }
-            free(mData);
+            releaseData(mData, mDataCapacity);
         }
         auto* kernelFields = maybeKernelFields();
         if (kernelFields && kernelFields->mObjects) free(kernelFields->mObjects);
@@ -2977,18 +3046,59 @@ status_t Parcel::growData(size_t len)
             : continueWrite(std::max(newSize, (size_t) 128));
 }
 
-static uint8_t* reallocZeroFree(uint8_t* data, size_t oldCapacity, size_t newCapacity, bool zero) {
-    if (!zero) {
-        return (uint8_t*)realloc(data, newCapacity);
+#ifdef BINDER_WITH_KERNEL_IPC
+static ParcelBufferPool* threadBufferPool() {
+    IPCThreadState* st = IPCThreadState::selfOrNull();
+    return st ? st->mParcelBufferPool.get() : nullptr;
+}
+#endif // BINDER_WITH_KERNEL_IPC
+
+uint8_t* Parcel::allocateData(size_t* capacity) {
+#ifdef BINDER_WITH_KERNEL_IPC
+    if (ParcelBufferPool* pool = threadBufferPool()) {
+        return pool->allocate(capacity);
+    }
+#endif // BINDER_WITH_KERNEL_IPC
+    return (uint8_t*)malloc(*capacity);
+}
+
+void Parcel::releaseData(uint8_t* data, size_t capacity) {
+#ifdef BINDER_WITH_KERNEL_IPC
+    if (ParcelBufferPool* pool = threadBufferPool()) {
+        pool->release(data, capacity);
+        return;
+    }
+#else  // BINDER_WITH_KERNEL_IPC
+    (void)capacity;
+#endif // BINDER_WITH_KERNEL_IPC
+    free(data);
+}
+
+uint8_t* Parcel::reallocateData(uint8_t* data, size_t oldCapacity, size_t* newCapacity,
+                                bool zero) {
+    if (*newCapacity == 0) {
+        if (zero && data) zeroMemory(data, oldCapacity);
+        releaseData(data, oldCapacity);
+        return nullptr;
+    }
+
+    bool pooled = false;
+#ifdef BINDER_WITH_KERNEL_IPC
+    pooled = ParcelBufferPool::isPooledSize(*newCapacity) && threadBufferPool() != nullptr;
+#endif // BINDER_WITH_KERNEL_IPC
+    if (!zero && !pooled) {
+        return (uint8_t*)realloc(data, *newCapacity);
     }
-    uint8_t* newData = (uint8_t*)malloc(newCapacity);
+    uint8_t* newData = allocateData(newCapacity);
     if (!newData) {
         return nullptr;
     }
 
-    memcpy(newData, data, std::min(oldCapacity, newCapacity));
-    zeroMemory(data, oldCapacity);
-    free(data);
+    if (data) {
+        memcpy(newData, data, std::min(oldCapacity, *newCapacity));
+        if (zero) zeroMemory(data, oldCapacity);
+        releaseData(data, oldCapacity);
+    }
     return newData;
 }
 
@@ -3007,8 +3117,9 @@ status_t Parcel::restartWrite(size_t desired)
 
     releaseObjects();
 
-    uint8_t* data = reallocZeroFree(mData, mDataCapacity, desired, mDeallocZero);
-    if (!data && desired > mDataCapacity) {
+    const size_t requested = desired;
+    uint8_t* data = reallocateData(mData, mDataCapacity, &desired, mDeallocZero);
+    if (!data && requested > mDataCapacity) {
         LOG_ALWAYS_FATAL("out of memory");
         mError = NO_MEMORY;
         return NO_MEMORY;
@@ -3044,6 +3155,7 @@ status_t Parcel::restartWrite(size_t desired)
     } else if (auto* rpcFields = maybeRpcFields()) {
         rpcFields->mObjectPositions.clear();
         rpcFields->mFds.reset();
+        rpcFields->mExternalData.reset();
     }
     mAllowFds = true;
 
@@ -3106,6 +3218,14 @@ status_t Parcel::continueWrite(size_t desired)
                 }
             }
         }
+
+        if (rpcFields && rpcFields->mExternalData) {
+            auto& segments = rpcFields->mExternalData->segments;
+            while (!segments.empty() && segments.back().position > desired) {
+                rpcFields->mExternalData->size -= segments.back().size + segments.back().padding;
+                segments.pop_back();
+            }
+        }
     }
 
     if (mOwner) {
@@ -3117,7 +3237,8 @@ status_t Parcel::continueWrite(size_t desired)
 
         // If there is a different owner, we need to take
         // posession.
-        uint8_t* data = (uint8_t*)malloc(desired);
+        size_t capacity = desired;
+        uint8_t* data = allocateData(&capacity);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -3127,7 +3248,7 @@ status_t Parcel::continueWrite(size_t desired)
         if (kernelFields && objectsSize) {
             objects = (binder_size_t*)calloc(objectsSize, sizeof(binder_size_t));
             if (!objects) {
-                free(data);
+                releaseData(data, capacity);
 
                 mError = NO_MEMORY;
                 return NO_MEMORY;
@@ -3142,7 +3263,7 @@ status_t Parcel::continueWrite(size_t desired)
         }
         if (rpcFields) {
             if (status_t status = truncateRpcObjects(objectsSize); status != OK) {
-                free(data);
+                releaseData(data, capacity);
                 return status;
             }
         }
@@ -3172,14 +3293,14 @@ status_t Parcel::continueWrite(size_t desired)
                kernelFields ? kernelFields->mObjectsSize : 0);
         mOwner = nullptr;
 
-        LOG_ALLOC("Parcel %p: taking ownership of %zu capacity", this, desired);
-        gParcelGlobalAllocSize += desired;
+        LOG_ALLOC("Parcel %p: taking ownership of %zu capacity", this, capacity);
+        gParcelGlobalAllocSize += capacity;
         gParcelGlobalAllocCount++;
 
         mData = data;
         mDataSize = (mDataSize < desired) ? mDataSize : desired;
         ALOGV("continueWrite Setting data size of %p to %zu", this, mDataSize);
-        mDataCapacity = desired;
+        mDataCapacity = capacity;
         if (kernelFields) {
             kernelFields->mObjects = objects;
             kernelFields->mObjectsSize = kernelFields->mObjectsCapacity = objectsSize;
@@ -3230,14 +3351,15 @@ status_t Parcel::continueWrite(size_t desired)
 
         // We own the data, so we can just do a realloc().
         if (desired > mDataCapacity) {
-            uint8_t* data = reallocZeroFree(mData, mDataCapacity, desired, mDeallocZero);
+            size_t capacity = desired;
+            uint8_t* data = reallocateData(mData, mDataCapacity, &capacity, mDeallocZero);
             if (data) {
                 LOG_ALLOC("Parcel %p: continue from %zu to %zu capacity", this, mDataCapacity,
-                        desired);
-                gParcelGlobalAllocSize += desired;
+                        capacity);
+                gParcelGlobalAllocSize += capacity;
                 gParcelGlobalAllocSize -= mDataCapacity;
                 mData = data;
-                mDataCapacity = desired;
+                mDataCapacity = capacity;
             } else {
                 mError = NO_MEMORY;
                 return NO_MEMORY;
@@ -3255,7 +3377,8 @@ status_t Parcel::continueWrite(size_t desired)
 
     } else {
         // This is the first data.  Easy!
-        uint8_t* data = (uint8_t*)malloc(desired);
+        size_t capacity = desired;
+        uint8_t* data = allocateData(&capacity);
         if (!data) {
             mError = NO_MEMORY;
             return NO_MEMORY;
@@ -3269,20 +3392,50 @@ status_t Parcel::continueWrite(size_t desired)
                   kernelFields ? kernelFields->mObjectsCapacity : 0, desired);
         }
 
-        LOG_ALLOC("Parcel %p: allocating with %zu capacity", this, desired);
-        gParcelGlobalAllocSize += desired;
+        LOG_ALLOC("Parcel %p: allocating with %zu capacity", this, capacity);
+        gParcelGlobalAllocSize += capacity;
         gParcelGlobalAllocCount++;
 
         mData = data;
         mDataSize = mDataPos = 0;
         ALOGV("continueWrite Setting data size of %p to %zu", this, mDataSize);
         ALOGV("continueWrite Setting data pos of %p to %zu", this, mDataPos);
-        mDataCapacity = desired;
+        mDataCapacity = capacity;
     }
 
     return NO_ERROR;
 }
 
+size_t Parcel::externalDataSizeBefore(size_t pos) const {
+    const auto* rpcFields = maybeRpcFields();
+    if (rpcFields == nullptr || rpcFields->mExternalData == nullptr) return 0;
+
+    size_t size = 0;
+    for (const auto& segment : rpcFields->mExternalData->segments) {
+        if (segment.position > pos) break;
+        size += segment.size + segment.padding;
+    }
+    return size;
+}
+
+size_t Parcel::externalToDataPosition(size_t pos) const {
+    const auto* rpcFields = maybeRpcFields();
+    if (rpcFields == nullptr || rpcFields->mExternalData == nullptr) return pos;
+
+    size_t skipped = 0;
+    for (const auto& segment : rpcFields->mExternalData->segments) {
+        const size_t start = segment.position + skipped;
+        if (pos <= start) break;
+        const size_t segmentSize = segment.size + segment.padding;
+        LOG_ALWAYS_FATAL_IF(pos < start + segmentSize,
+                            "Position %zu is inside external data at %zu (%zu bytes). Parcels "
+                            "which reference external data can't be read back.",
+                            pos, start, segmentSize);
+        skipped += segmentSize;
+    }
+    return pos - skipped;
+}
+
 status_t Parcel::truncateRpcObjects(size_t newObjectsSize) {
     auto* rpcFields = maybeRpcFields();
     if (newObjectsSize == 0) {
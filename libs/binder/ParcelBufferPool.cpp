@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ParcelBufferPool.h"
+
+#include <stdlib.h>
+
+namespace android {
+
+ParcelBufferPool::~ParcelBufferPool() {
+    for (SizeClass& sizeClass : mClasses) {
+        for (size_t i = 0; i < sizeClass.count; i++) {
+            free(sizeClass.buffers[i]);
+        }
+        sizeClass.count = 0;
+    }
+    mCachedBytes = 0;
+}
+
+size_t ParcelBufferPool::classFor(size_t capacity) {
+    size_t index = 0;
+    while (classSize(index) < capacity) index++;
+    return index;
+}
+
+uint8_t* ParcelBufferPool::allocate(size_t* capacity) {
+    if (!isPooledSize(*capacity)) {
+        mMisses++;
+        return static_cast<uint8_t*>(malloc(*capacity));
+    }
+
+    const size_t index = classFor(*capacity);
+    const size_t size = classSize(index);
+    SizeClass& sizeClass = mClasses[index];
+    if (sizeClass.count > 0) {
+        mHits++;
+        mCachedBytes -= size;
+        *capacity = size;
+        return sizeClass.buffers[--sizeClass.count];
+    }
+
+    mMisses++;
+    uint8_t* data = static_cast<uint8_t*>(malloc(size));
+    if (data != nullptr) *capacity = size;
+    return data;
+}
+
+void ParcelBufferPool::release(uint8_t* data, size_t capacity) {
+    if (data == nullptr) return;
+
+    // Buffers which aren't exactly a class size came from outside the pool,
+    // e.g. from realloc(), so they can't be handed out again by class.
+    if (capacity != 0 && isPooledSize(capacity)) {
+        const size_t index = classFor(capacity);
+        if (classSize(index) == capacity) {
+            SizeClass& sizeClass = mClasses[index];
+            if (sizeClass.count < kMaxBuffersPerClass &&
+                mCachedBytes + capacity <= kMaxCachedBytes) {
+                sizeClass.buffers[sizeClass.count++] = data;
+                mCachedBytes += capacity;
+                return;
+            }
+            mEvictions++;
+        }
+    }
+    free(data);
+}
+
+IPCThreadState::ParcelBufferPoolStats ParcelBufferPool::stats() const {
+    return {
+            .hits = mHits,
+            .misses = mMisses,
+            .evictions = mEvictions,
+            .cachedBytes = mCachedBytes,
+    };
+}
+
+} // namespace android
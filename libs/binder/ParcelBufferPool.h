@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <binder/IPCThreadState.h>
+
+namespace android {
+
+/**
+ * Cache of Parcel data buffers owned by an IPCThreadState, so that Parcels
+ * created and destroyed for every transaction don't need to go to the
+ * allocator each time. Buffers are kept in power-of-two size classes, with a
+ * bounded number of buffers per class and a bound on the total size kept.
+ *
+ * Not threadsafe. Only used by the thread which owns the IPCThreadState.
+ */
+class ParcelBufferPool {
+public:
+    ParcelBufferPool() = default;
+    ~ParcelBufferPool();
+
+    ParcelBufferPool(const ParcelBufferPool&) = delete;
+    ParcelBufferPool& operator=(const ParcelBufferPool&) = delete;
+
+    /**
+     * Returns a buffer of at least `*capacity` bytes and sets `*capacity` to
+     * the actual size of the buffer. Returns nullptr if allocation fails.
+     */
+    uint8_t* allocate(size_t* capacity);
+
+    /**
+     * Takes a buffer of `capacity` bytes which was allocated with malloc,
+     * either keeping it for reuse or freeing it.
+     */
+    void release(uint8_t* data, size_t capacity);
+
+    /** Whether a buffer of `capacity` bytes would be served by the pool. */
+    static bool isPooledSize(size_t capacity) { return capacity <= kMaxClassSize; }
+
+    IPCThreadState::ParcelBufferPoolStats stats() const;
+
+private:
+    static constexpr size_t kMinClassShift = 7; // 128 bytes
+    static constexpr size_t kNumClasses = 10;
+    static constexpr size_t kMaxClassSize = size_t(1) << (kMinClassShift + kNumClasses - 1);
+    static constexpr size_t kMaxBuffersPerClass = 4;
+    static constexpr size_t kMaxCachedBytes = 256 * 1024;
+
+    // Index of the smallest class which holds `capacity` bytes.
+    static size_t classFor(size_t capacity);
+    static size_t classSize(size_t index) { return size_t(1) << (kMinClassShift + index); }
+
+    struct SizeClass {
+        std::array<uint8_t*, kMaxBuffersPerClass> buffers{};
+        size_t count = 0;
+    };
+    std::array<SizeClass, kNumClasses> mClasses;
+    size_t mCachedBytes = 0;
+
+    uint64_t mHits = 0;
+    uint64_t mMisses = 0;
+    uint64_t mEvictions = 0;
+};
+
+} // namespace android
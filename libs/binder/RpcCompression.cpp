@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RpcCompression.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace android {
+
+namespace {
+
+// See https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+//
+// A block is a series of sequences, each of which is a token byte, literal
+// bytes, and a back reference to earlier output. The last sequence has no
+// back reference.
+constexpr size_t kMinMatch = 4;
+// The last 5 bytes are always literals.
+constexpr size_t kLastLiterals = 5;
+// The last match must start at least 12 bytes before the end of the block.
+constexpr size_t kMatchFindLimit = 12;
+constexpr size_t kMaxOffset = 65535;
+constexpr uint8_t kRunMask = 15;
+
+constexpr size_t kHashLog = 12;
+static_assert(kRpcCompressTableSize == 1 << kHashLog);
+// After this many bytes without a match, the search skips ahead faster, so
+// that incompressible data doesn't cost much more than copying it.
+constexpr size_t kSkipTrigger = 6;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t hashSequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - kHashLog);
+}
+
+class BlockWriter {
+public:
+    BlockWriter(uint8_t* dst, size_t capacity) : mPos(dst), mEnd(dst + capacity) {}
+
+    // 'offset' is 0 for the last sequence, which has no match.
+    bool writeSequence(const uint8_t* literals, size_t literalLength, size_t offset,
+                       size_t matchLength) {
+        if (mPos == mEnd) return false;
+        uint8_t* token = mPos++;
+
+        *token = std::min<size_t>(literalLength, kRunMask) << 4;
+        if (literalLength >= kRunMask && !writeLength(literalLength - kRunMask)) return false;
+        if (literalLength > static_cast<size_t>(mEnd - mPos)) return false;
+        if (literalLength > 0) memcpy(mPos, literals, literalLength);
+        mPos += literalLength;
+
+        if (offset == 0) return true;
+
+        if (mEnd - mPos < 2) return false;
+        *mPos++ = offset & 0xff;
+        *mPos++ = offset >> 8;
+
+        size_t matchCode = matchLength - kMinMatch;
+        *token |= std::min<size_t>(matchCode, kRunMask);
+        if (matchCode >= kRunMask && !writeLength(matchCode - kRunMask)) return false;
+        return true;
+    }
+
+    uint8_t* pos() const { return mPos; }
+
+private:
+    bool writeLength(size_t length) {
+        for (; length >= 255; length -= 255) {
+            if (mPos == mEnd) return false;
+            *mPos++ = 255;
+        }
+        if (mPos == mEnd) return false;
+        *mPos++ = length;
+        return true;
+    }
+
+    uint8_t* mPos;
+    uint8_t* const mEnd;
+};
+
+bool readLength(const uint8_t** ip, const uint8_t* end, size_t* length) {
+    uint8_t b;
+    do {
+        if (*ip == end) return false;
+        b = *(*ip)++;
+        // can't be valid, since it's bounded by the output size
+        if (__builtin_add_overflow(*length, b, length)) return false;
+    } while (b == 255);
+    return true;
+}
+
+} // namespace
+
+size_t rpcCompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                   uint32_t* table) {
+    BlockWriter writer(dst, dstCapacity);
+
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* const end = src + srcSize;
+
+    if (srcSize > kMatchFindLimit) {
+        const uint8_t* const matchLimit = end - kLastLiterals;
+        const uint8_t* const matchFindLimit = end - kMatchFindLimit;
+
+        while (ip < matchFindLimit) {
+            uint32_t sequence = read32(ip);
+            uint32_t& entry = table[hashSequence(sequence)];
+            size_t refPos = entry;
+            size_t pos = ip - src;
+            entry = static_cast<uint32_t>(pos);
+
+            // The entry may be from a previous call, so it is only a hint.
+            if (refPos >= pos || pos - refPos > kMaxOffset || read32(src + refPos) != sequence) {
+                ip += 1 + ((ip - anchor) >> kSkipTrigger);
+                continue;
+            }
+            const uint8_t* ref = src + refPos;
+
+            const uint8_t* matchEnd = ip + kMinMatch;
+            for (const uint8_t* r = ref + kMinMatch; matchEnd < matchLimit && *matchEnd == *r;
+                 matchEnd++, r++) {
+            }
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+
+            if (!writer.writeSequence(anchor, ip - anchor, ip - ref, matchEnd - ip)) return 0;
+            ip = anchor = matchEnd;
+        }
+    }
+
+    if (!writer.writeSequence(anchor, end - anchor, 0, 0)) return 0;
+    return writer.pos() - dst;
+}
+
+bool rpcDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+    const uint8_t* ip = src;
+    const uint8_t* const inEnd = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* const outEnd = dst + dstSize;
+
+    while (true) {
+        if (ip == inEnd) return false;
+        uint8_t token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == kRunMask && !readLength(&ip, inEnd, &literalLength)) return false;
+        if (literalLength > static_cast<size_t>(inEnd - ip) ||
+            literalLength > static_cast<size_t>(outEnd - op)) {
+            return false;
+        }
+        if (literalLength > 0) memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        // the last sequence is only literals
+        if (ip == inEnd) return op == outEnd;
+
+        if (inEnd - ip < 2) return false;
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+
+        size_t matchLength = token & kRunMask;
+        if (matchLength == kRunMask && !readLength(&ip, inEnd, &matchLength)) return false;
+        matchLength += kMinMatch;
+        if (matchLength > static_cast<size_t>(outEnd - op)) return false;
+
+        const uint8_t* match = op - offset;
+        if (offset >= matchLength) {
+            memcpy(op, match, matchLength);
+            op += matchLength;
+        } else {
+            // overlapping copy repeats the last 'offset' bytes
+            for (size_t i = 0; i < matchLength; i++) *op++ = *match++;
+        }
+    }
+}
+
+} // namespace android
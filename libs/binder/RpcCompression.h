@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace android {
+
+// Compression for RPC binder transaction and reply data. The data is encoded
+// in the LZ4 block format, so it can be inspected with standard tools, but
+// this doesn't depend on liblz4 in order to keep libbinder's dependencies
+// minimal (it is also built for Trusty and other constrained environments).
+
+// Number of entries in the hash table used by rpcCompress.
+constexpr size_t kRpcCompressTableSize = 1 << 12;
+
+// Compresses 'src' into 'dst'. Returns the compressed size, or 0 if the
+// result would not fit in 'dstCapacity' bytes. Callers can pass a capacity
+// smaller than 'srcSize' in order to give up early on incompressible data.
+//
+// 'table' must have kRpcCompressTableSize entries, and must be zeroed before
+// its first use. It can then be reused for any number of calls without being
+// cleared again, since entries left over from previous calls are validated.
+size_t rpcCompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+                   uint32_t* table);
+
+// Decompresses 'src' into 'dst'. Returns true only if all of 'src' was
+// valid and decompressed to exactly 'dstSize' bytes. Safe to use on
+// untrusted input.
+bool rpcDecompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
+
+} // namespace android
@@ -156,6 +156,10 @@ void RpcServer::setSupportedFileDescriptorTransportModes(
     }
 }
 
+void RpcServer::setCompressionEnabled(bool enabled) {
+    mCompressionEnabled = enabled;
+}
+
 void RpcServer::setRootObject(const sp<IBinder>& binder) {
     RpcMutexLockGuard _l(mLock);
     mRootObjectFactory = nullptr;
@@ -511,6 +515,7 @@ void RpcServer::establishConnection(
             session = sp<RpcSession>::make(nullptr);
             session->setMaxIncomingThreads(server->mMaxThreads);
             if (!session->setProtocolVersion(protocolVersion)) return;
+            session->setCompressionEnabled(server->mCompressionEnabled);
 
             if (header.fileDescriptorTransportMode <
                         server->mSupportedFileDescriptorTransportModes.size() &&
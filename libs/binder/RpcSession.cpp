@@ -140,6 +140,14 @@ RpcSession::FileDescriptorTransportMode RpcSession::getFileDescriptorTransportMo
     return mFileDescriptorTransportMode;
 }
 
+void RpcSession::setCompressionEnabled(bool enabled) {
+    mCompressionEnabled = enabled;
+}
+
+bool RpcSession::isCompressionEnabled() {
+    return mCompressionEnabled;
+}
+
 status_t RpcSession::setupUnixDomainClient(const char* path) {
     return setupSocketClient(UnixSocketAddress(path));
 }
@@ -277,6 +285,68 @@ status_t RpcSession::transact(const sp<IBinder>& binder, uint32_t code, const Pa
                              sp<RpcSession>::fromExisting(this), reply, flags);
 }
 
+class RpcSession::PendingReply : public PendingTransaction {
+public:
+    PendingReply(sp<RpcSession>&& session, sp<RpcConnection>&& connection)
+          : mSession(std::move(session)), mConnection(std::move(connection)) {}
+
+    ~PendingReply() override {
+        if (mConnection != nullptr) {
+            Parcel reply;
+            (void)waitForReply(&reply);
+        }
+    }
+
+    bool isReady() override {
+        return mConnection == nullptr || mConnection->rpcTransport->pollRead() != WOULD_BLOCK;
+    }
+
+    status_t waitForReply(Parcel* reply) override {
+        LOG_ALWAYS_FATAL_IF(mConnection == nullptr, "Reply was already read.");
+
+        // Claim the connection for this thread, so that nested transactions
+        // sent while processing the reply reuse it.
+        {
+            RpcMutexLockGuard _l(mSession->mMutex);
+            LOG_ALWAYS_FATAL_IF(mConnection->exclusiveTid != kPendingReplyTid,
+                                "Connection reserved for a pending reply was reused.");
+            mConnection->exclusiveTid = binder::os::GetThreadId();
+        }
+
+        status_t status = mSession->state()->waitForReply(mConnection, mSession, reply);
+        mSession->clearConnectionTid(mConnection);
+        mConnection = nullptr;
+        return status;
+    }
+
+private:
+    sp<RpcSession> mSession;
+    sp<RpcConnection> mConnection;
+};
+
+status_t RpcSession::transactAsync(const sp<IBinder>& binder, uint32_t code, const Parcel& data,
+                                   uint32_t flags, std::unique_ptr<PendingTransaction>* pending) {
+    if (flags & IBinder::FLAG_ONEWAY) {
+        ALOGE("Oneway transactions have no reply, so use RpcSession::transact for them.");
+        return BAD_VALUE;
+    }
+
+    sp<RpcSession> session = sp<RpcSession>::fromExisting(this);
+    ExclusiveConnection connection;
+    status_t status = ExclusiveConnection::find(session, ConnectionUse::CLIENT_PENDING, &connection);
+    if (status != OK) return status;
+    status = state()->sendTransact(connection.get(), binder, code, data, session, flags);
+    if (status != OK) return status;
+
+    sp<RpcConnection> reserved = connection.release();
+    {
+        RpcMutexLockGuard _l(mMutex);
+        reserved->exclusiveTid = kPendingReplyTid;
+    }
+    *pending = std::make_unique<PendingReply>(std::move(session), std::move(reserved));
+    return OK;
+}
+
 status_t RpcSession::sendDecStrong(const BpBinder* binder) {
     // target is 0 because this is used to free BpBinder objects
     return sendDecStrongToTarget(binder->getPrivateAccessor().rpcAddress(), 0 /*target*/);
@@ -900,8 +970,11 @@ status_t RpcSession::ExclusiveConnection::find(const sp<RpcSession>& session, Co
 
         // CHECK FOR DEDICATED CLIENT SOCKET
         //
-        // A server/looper should always use a dedicated connection if available
-        findConnection(tid, &exclusive, &available, session->mConnections.mOutgoing,
+        // A server/looper should always use a dedicated connection if available.
+        // A pending reply can't share a connection with a transaction this
+        // thread is already making, so it never reuses one.
+        findConnection(tid, use == ConnectionUse::CLIENT_PENDING ? nullptr : &exclusive,
+                       &available, session->mConnections.mOutgoing,
                        session->mConnections.mOutgoingOffset);
 
         // WARNING: this assumes a server cannot request its client to send
@@ -920,7 +993,7 @@ status_t RpcSession::ExclusiveConnection::find(const sp<RpcSession>& session, Co
         }
 
         // USE SERVING SOCKET (e.g. nested transaction)
-        if (use != ConnectionUse::CLIENT_ASYNC) {
+        if (use != ConnectionUse::CLIENT_ASYNC && use != ConnectionUse::CLIENT_PENDING) {
             sp<RpcConnection> exclusiveIncoming;
             // server connections are always assigned to a thread
             findConnection(tid, &exclusiveIncoming, nullptr /*available*/,
@@ -968,6 +1041,13 @@ status_t RpcSession::ExclusiveConnection::find(const sp<RpcSession>& session, Co
             return WOULD_BLOCK;
         }
 
+        if (use == ConnectionUse::CLIENT_PENDING) {
+            LOG_RPC_DETAIL("No available connections for a pending reply (have %zu clients).",
+                           session->mConnections.mOutgoing.size());
+            session->mConnections.mWaitingThreads--;
+            return WOULD_BLOCK;
+        }
+
         LOG_RPC_DETAIL("No available connections (have %zu clients and %zu servers). Waiting...",
                        session->mConnections.mOutgoing.size(),
                        session->mConnections.mIncoming.size());
@@ -985,7 +1065,7 @@ void RpcSession::ExclusiveConnection::findConnection(uint64_t tid, sp<RpcConnect
     LOG_ALWAYS_FATAL_IF(sockets.size() > 0 && socketsIndexHint >= sockets.size(),
                         "Bad index %zu >= %zu", socketsIndexHint, sockets.size());
 
-    if (*exclusive != nullptr) return; // consistent with break below
+    if (exclusive && *exclusive != nullptr) return; // consistent with break below
 
     for (size_t i = 0; i < sockets.size(); i++) {
         sp<RpcConnection>& socket = sockets[(i + socketsIndexHint) % sockets.size()];
@@ -1005,6 +1085,11 @@ void RpcSession::ExclusiveConnection::findConnection(uint64_t tid, sp<RpcConnect
     }
 }
 
+sp<RpcSession::RpcConnection> RpcSession::ExclusiveConnection::release() {
+    LOG_ALWAYS_FATAL_IF(mReentrant, "Can't release a connection owned further up the stack.");
+    return std::move(mConnection);
+}
+
 RpcSession::ExclusiveConnection::~ExclusiveConnection() {
     // reentrant use of a connection means something less deep in the call stack
     // is using this fd, and it retains the right to it. So, we don't give up
@@ -24,9 +24,11 @@
 #include <binder/RpcServer.h>
 
 #include "Debug.h"
+#include "RpcCompression.h"
 #include "RpcWireFormat.h"
 #include "Utils.h"
 
+#include <algorithm>
 #include <random>
 #include <sstream>
 
@@ -94,58 +96,73 @@ status_t RpcState::onBinderLeaving(const sp<RpcSession>& session, const sp<IBind
         return INVALID_OPERATION;
     }
 
-    RpcMutexLockGuard _l(mNodeMutex);
+    if (isRpc) {
+        // this binder was received from this session, so it's already known
+        // by its address
+        uint64_t addr = binder->remoteBinder()->getPrivateAccessor().rpcAddress();
+        NodeStripe& stripe = stripeForAddress(addr);
+        RpcMutexLockGuard _l(stripe.mutex);
+        if (mTerminated) return DEAD_OBJECT;
+
+        auto it = stripe.nodeForAddress.find(addr);
+        // check integrity of data structure
+        LOG_ALWAYS_FATAL_IF(it == stripe.nodeForAddress.end() ||
+                                    it->second.binder.unsafe_get() != binder.get(),
+                            "RPC binder must have known address at this point %" PRIu64, addr);
+        it->second.timesSent++;
+        it->second.sentRef = binder; // might already be set
+        *outAddress = addr;
+        return OK;
+    }
+
+    NodeStripe& stripe = stripeForLocalBinder(binder);
+    RpcMutexLockGuard _l(stripe.mutex);
     if (mTerminated) return DEAD_OBJECT;
 
     // TODO(b/182939933): maybe move address out of BpBinder, and keep binder->address map
     // in RpcState
-    for (auto& [addr, node] : mNodeForAddress) {
+    for (auto& [addr, node] : stripe.nodeForAddress) {
         if (binder == node.binder) {
-            if (isRpc) {
-                // check integrity of data structure
-                uint64_t actualAddr = binder->remoteBinder()->getPrivateAccessor().rpcAddress();
-                LOG_ALWAYS_FATAL_IF(addr != actualAddr, "Address mismatch %" PRIu64 " vs %" PRIu64,
-                                    addr, actualAddr);
-            }
             node.timesSent++;
             node.sentRef = binder; // might already be set
             *outAddress = addr;
             return OK;
         }
     }
-    LOG_ALWAYS_FATAL_IF(isRpc, "RPC binder must have known address at this point");
 
     bool forServer = session->server() != nullptr;
 
     // arbitrary limit for maximum number of nodes in a process (otherwise we
     // might run out of addresses)
-    if (mNodeForAddress.size() > 100000) {
+    if (mNodeCount > 100000) {
         return NO_MEMORY;
     }
 
+    const uint32_t stripeIndex = &stripe - mNodeStripes.data();
     while (true) {
         RpcWireAddress address{
                 .options = RPC_WIRE_ADDRESS_OPTION_CREATED,
-                .address = mNextId,
+                .address = stripe.nextId * static_cast<uint32_t>(kNodeStripes) + stripeIndex,
         };
         if (forServer) {
             address.options |= RPC_WIRE_ADDRESS_OPTION_FOR_SERVER;
         }
 
         // avoid ubsan abort
-        if (mNextId >= std::numeric_limits<uint32_t>::max()) {
-            mNextId = 0;
+        if (stripe.nextId >= std::numeric_limits<uint32_t>::max() / kNodeStripes) {
+            stripe.nextId = 0;
         } else {
-            mNextId++;
+            stripe.nextId++;
         }
 
-        auto&& [it, inserted] = mNodeForAddress.insert({RpcWireAddress::toRaw(address),
-                                                        BinderNode{
-                                                                .binder = binder,
-                                                                .sentRef = binder,
-                                                                .timesSent = 1,
-                                                        }});
+        auto&& [it, inserted] = stripe.nodeForAddress.insert({RpcWireAddress::toRaw(address),
+                                                              BinderNode{
+                                                                      .binder = binder,
+                                                                      .sentRef = binder,
+                                                                      .timesSent = 1,
+                                                              }});
         if (inserted) {
+            mNodeCount++;
             *outAddress = it->first;
             return OK;
         }
@@ -170,10 +187,11 @@ status_t RpcState::onBinderEntering(const sp<RpcSession>& session, uint64_t addr
         return BAD_VALUE;
     }
 
-    RpcMutexLockGuard _l(mNodeMutex);
+    NodeStripe& stripe = stripeForAddress(address);
+    RpcMutexLockGuard _l(stripe.mutex);
     if (mTerminated) return DEAD_OBJECT;
 
-    if (auto it = mNodeForAddress.find(address); it != mNodeForAddress.end()) {
+    if (auto it = stripe.nodeForAddress.find(address); it != stripe.nodeForAddress.end()) {
         *out = it->second.binder.promote();
 
         // implicitly have strong RPC refcount, since we received this binder
@@ -189,8 +207,9 @@ status_t RpcState::onBinderEntering(const sp<RpcSession>& session, uint64_t addr
         return BAD_VALUE;
     }
 
-    auto&& [it, inserted] = mNodeForAddress.insert({address, BinderNode{}});
+    auto&& [it, inserted] = stripe.nodeForAddress.insert({address, BinderNode{}});
     LOG_ALWAYS_FATAL_IF(!inserted, "Failed to insert binder when creating proxy");
+    mNodeCount++;
 
     // Currently, all binders are assumed to be part of the same session (no
     // device global binders in the RPC world).
@@ -205,12 +224,13 @@ status_t RpcState::flushExcessBinderRefs(const sp<RpcSession>& session, uint64_t
     // extra reference counting packets now.
     if (binder->remoteBinder()) return OK;
 
-    RpcMutexUniqueLock _l(mNodeMutex);
+    NodeStripe& stripe = stripeForAddress(address);
+    RpcMutexUniqueLock _l(stripe.mutex);
     if (mTerminated) return DEAD_OBJECT;
 
-    auto it = mNodeForAddress.find(address);
+    auto it = stripe.nodeForAddress.find(address);
 
-    LOG_ALWAYS_FATAL_IF(it == mNodeForAddress.end(), "Can't be deleted while we hold sp<>");
+    LOG_ALWAYS_FATAL_IF(it == stripe.nodeForAddress.end(), "Can't be deleted while we hold sp<>");
     LOG_ALWAYS_FATAL_IF(it->second.binder != binder,
                         "Caller of flushExcessBinderRefs using inconsistent arguments");
 
@@ -233,19 +253,19 @@ status_t RpcState::flushExcessBinderRefs(const sp<RpcSession>& session, uint64_t
 }
 
 status_t RpcState::sendObituaries(const sp<RpcSession>& session) {
-    RpcMutexUniqueLock _l(mNodeMutex);
-
     // Gather strong pointers to all of the remote binders for this session so
     // we hold the strong references. remoteBinder() returns a raw pointer.
     // Send the obituaries and drop the strong pointers outside of the lock so
     // the destructors and the onBinderDied calls are not done while locked.
     std::vector<sp<IBinder>> remoteBinders;
-    for (const auto& [_, binderNode] : mNodeForAddress) {
-        if (auto binder = binderNode.binder.promote()) {
-            remoteBinders.push_back(std::move(binder));
+    for (NodeStripe& stripe : mNodeStripes) {
+        RpcMutexLockGuard _l(stripe.mutex);
+        for (const auto& [_, binderNode] : stripe.nodeForAddress) {
+            if (auto binder = binderNode.binder.promote()) {
+                remoteBinders.push_back(std::move(binder));
+            }
         }
     }
-    _l.unlock();
 
     for (const auto& binder : remoteBinders) {
         if (binder->remoteBinder() &&
@@ -257,23 +277,24 @@ status_t RpcState::sendObituaries(const sp<RpcSession>& session) {
 }
 
 size_t RpcState::countBinders() {
-    RpcMutexLockGuard _l(mNodeMutex);
-    return mNodeForAddress.size();
+    return mNodeCount;
 }
 
 void RpcState::dump() {
-    RpcMutexLockGuard _l(mNodeMutex);
+    lockAllStripes();
     dumpLocked();
+    unlockAllStripes();
 }
 
 void RpcState::clear() {
-    return clear(RpcMutexUniqueLock(mNodeMutex));
+    lockAllStripes();
+    clearLocked();
 }
 
-void RpcState::clear(RpcMutexUniqueLock nodeLock) {
+void RpcState::clearLocked() {
     if (mTerminated) {
-        LOG_ALWAYS_FATAL_IF(!mNodeForAddress.empty(),
-                            "New state should be impossible after terminating!");
+        LOG_ALWAYS_FATAL_IF(mNodeCount != 0, "New state should be impossible after terminating!");
+        unlockAllStripes();
         return;
     }
     mTerminated = true;
@@ -284,34 +305,60 @@ void RpcState::clear(RpcMutexUniqueLock nodeLock) {
     }
 
     // invariants
-    for (auto& [address, node] : mNodeForAddress) {
-        bool guaranteedHaveBinder = node.timesSent > 0;
-        if (guaranteedHaveBinder) {
-            LOG_ALWAYS_FATAL_IF(node.sentRef == nullptr,
-                                "Binder expected to be owned with address: %" PRIu64 " %s", address,
-                                node.toString().c_str());
+    for (const NodeStripe& stripe : mNodeStripes) {
+        for (auto& [address, node] : stripe.nodeForAddress) {
+            bool guaranteedHaveBinder = node.timesSent > 0;
+            if (guaranteedHaveBinder) {
+                LOG_ALWAYS_FATAL_IF(node.sentRef == nullptr,
+                                    "Binder expected to be owned with address: %" PRIu64 " %s",
+                                    address, node.toString().c_str());
+            }
         }
     }
 
     // if the destructor of a binder object makes another RPC call, then calling
     // decStrong could deadlock. So, we must hold onto these binders until
-    // mNodeMutex is no longer taken.
-    auto temp = std::move(mNodeForAddress);
-    mNodeForAddress.clear(); // RpcState isn't reusable, but for future/explicit
+    // the stripe locks are no longer taken.
+    std::array<std::map<uint64_t, BinderNode>, kNodeStripes> temp;
+    for (size_t i = 0; i < kNodeStripes; i++) {
+        temp[i] = std::move(mNodeStripes[i].nodeForAddress);
+        mNodeStripes[i].nodeForAddress.clear(); // RpcState isn't reusable, but for future/explicit
+    }
+    mNodeCount = 0;
 
-    nodeLock.unlock();
-    temp.clear(); // explicit
+    unlockAllStripes();
+    for (auto& nodes : temp) nodes.clear(); // explicit
 }
 
 void RpcState::dumpLocked() {
     ALOGE("DUMP OF RpcState %p", this);
-    ALOGE("DUMP OF RpcState (%zu nodes)", mNodeForAddress.size());
-    for (const auto& [address, node] : mNodeForAddress) {
-        ALOGE("- address: %" PRIu64 " %s", address, node.toString().c_str());
+    ALOGE("DUMP OF RpcState (%zu nodes)", mNodeCount.load());
+    for (const NodeStripe& stripe : mNodeStripes) {
+        for (const auto& [address, node] : stripe.nodeForAddress) {
+            ALOGE("- address: %" PRIu64 " %s", address, node.toString().c_str());
+        }
     }
     ALOGE("END DUMP OF RpcState");
 }
 
+RpcState::NodeStripe& RpcState::stripeForAddress(uint64_t address) {
+    return mNodeStripes[RpcWireAddress::fromRaw(address).address % kNodeStripes];
+}
+
+RpcState::NodeStripe& RpcState::stripeForLocalBinder(const sp<IBinder>& binder) {
+    // heap allocations are at least 16-byte aligned, so mix in higher bits
+    uintptr_t ptr = reinterpret_cast<uintptr_t>(binder.get());
+    return mNodeStripes[((ptr >> 4) ^ (ptr >> 12)) % kNodeStripes];
+}
+
+void RpcState::lockAllStripes() {
+    for (NodeStripe& stripe : mNodeStripes) stripe.mutex.lock();
+}
+
+void RpcState::unlockAllStripes() {
+    for (NodeStripe& stripe : mNodeStripes) stripe.mutex.unlock();
+}
+
 std::string RpcState::BinderNode::toString() const {
     sp<IBinder> strongBinder = this->binder.promote();
 
@@ -381,6 +428,146 @@ status_t RpcState::rpcSend(const sp<RpcSession::RpcConnection>& connection,
     return OK;
 }
 
+// Appends the data of a Parcel which references external data, as it is sent
+// on the wire.
+static void appendParcelDataIovecs(const Parcel& parcel, std::vector<iovec>* iovs) {
+    // The Parcel references caller-owned data instead of holding it, so splice
+    // that data in between the data the Parcel holds, without copying it.
+    static const uint8_t kZeroPadding[sizeof(int32_t)] = {};
+    const auto* externalData = parcel.maybeRpcFields()->mExternalData.get();
+    iovs->reserve(iovs->size() + 3 * externalData->segments.size() + 2);
+    uint8_t* data = const_cast<uint8_t*>(parcel.data());
+    size_t pos = 0;
+    for (const auto& segment : externalData->segments) {
+        iovs->push_back({data + pos, segment.position - pos});
+        iovs->push_back({const_cast<uint8_t*>(segment.data), segment.size});
+        if (segment.padding > 0) {
+            iovs->push_back({const_cast<uint8_t*>(kZeroPadding), segment.padding});
+        }
+        pos = segment.position;
+    }
+    iovs->push_back({data + pos, parcel.dataSize() - pos});
+}
+
+// If compression is enabled on the session and worthwhile for the Parcel,
+// returns its data (as it is sent on the wire) compressed. The result is in
+// the connection's scratch space, so it is valid until the next call.
+static std::optional<Span<const uint8_t>> maybeCompressParcelData(
+        const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+        const Parcel& parcel) {
+    // Below this, the bandwidth saved doesn't make up for the time spent.
+    constexpr size_t kCompressionThreshold = 1024;
+    const size_t dataSize = parcel.dataSize() + parcel.externalDataSize();
+    if (dataSize < kCompressionThreshold || !session->isCompressionEnabled() ||
+        session->getProtocolVersion().value() <
+                RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_COMPRESSION) {
+        return std::nullopt;
+    }
+
+    const bool hasExternalData = parcel.maybeRpcFields()->mExternalData != nullptr;
+    // Only send compressed data if it saves at least an eighth.
+    const size_t compressedCapacity = dataSize - dataSize / 8;
+    const size_t scratchSize = compressedCapacity + (hasExternalData ? dataSize : 0);
+
+    if (connection->compressionTable == nullptr) {
+        // zeroed once, rpcCompress tolerates stale entries after that
+        connection->compressionTable = std::make_unique<uint32_t[]>(kRpcCompressTableSize);
+    }
+    if (connection->compressionBufferSize < scratchSize) {
+        // not value-initialized, since it is always written before it is read
+        connection->compressionBuffer.reset(new uint8_t[scratchSize]);
+        connection->compressionBufferSize = scratchSize;
+    }
+    uint8_t* compressed = connection->compressionBuffer.get();
+
+    const uint8_t* data = parcel.data();
+    if (hasExternalData) {
+        std::vector<iovec> iovs;
+        appendParcelDataIovecs(parcel, &iovs);
+        uint8_t* flattened = compressed + compressedCapacity;
+        size_t pos = 0;
+        for (const iovec& iov : iovs) {
+            memcpy(flattened + pos, iov.iov_base, iov.iov_len);
+            pos += iov.iov_len;
+        }
+        data = flattened;
+    }
+
+    size_t compressedSize = rpcCompress(data, dataSize, compressed, compressedCapacity,
+                                        connection->compressionTable.get());
+    if (compressedSize == 0) return std::nullopt;
+    return Span<const uint8_t>{compressed, compressedSize};
+}
+
+// Decompresses Parcel data received on the session, terminating it if the
+// data is invalid.
+static status_t decompressParcelData(const sp<RpcSession>& session, const char* what,
+                                     Span<const uint8_t> compressed, uint8_t* out,
+                                     size_t outSize) {
+    if (session->getProtocolVersion().value() <
+        RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_COMPRESSION) {
+        ALOGE("Compressed %s not supported by protocol version %" PRIu32 ". Terminating!", what,
+              session->getProtocolVersion().value());
+        (void)session->shutdownAndWait(false);
+        return BAD_VALUE;
+    }
+    if (!rpcDecompress(compressed.data, compressed.size, out, outSize)) {
+        ALOGE("Failed to decompress %zu bytes of %s into %zu bytes. Terminating!", compressed.size,
+              what, outSize);
+        (void)session->shutdownAndWait(false);
+        return BAD_VALUE;
+    }
+    return OK;
+}
+
+status_t RpcState::rpcSendParcel(const sp<RpcSession::RpcConnection>& connection,
+                                 const sp<RpcSession>& session, const char* what, iovec* head,
+                                 int nhead, const Parcel& parcel,
+                                 std::optional<Span<const uint8_t>> compressedData,
+                                 const std::optional<SmallFunction<status_t()>>& altPoll) {
+    auto* rpcFields = parcel.maybeRpcFields();
+    LOG_ALWAYS_FATAL_IF(rpcFields == nullptr);
+
+    Span<const uint32_t> objectTableSpan = Span<const uint32_t>{rpcFields->mObjectPositions.data(),
+                                                                rpcFields->mObjectPositions.size()};
+
+    const auto* externalData = rpcFields->mExternalData.get();
+    if (externalData == nullptr) {
+        constexpr int kMaxHead = 2;
+        LOG_ALWAYS_FATAL_IF(nhead > kMaxHead, "Too many iovecs before Parcel: %d", nhead);
+        iovec iovs[kMaxHead + 2];
+        std::copy(head, head + nhead, iovs);
+        iovs[nhead] = compressedData
+                ? compressedData->toIovec()
+                : iovec{const_cast<uint8_t*>(parcel.data()), parcel.dataSize()};
+        iovs[nhead + 1] = objectTableSpan.toIovec();
+        return rpcSend(connection, session, what, iovs, nhead + 2, altPoll,
+                       rpcFields->mFds.get());
+    }
+
+    std::vector<iovec> iovs(head, head + nhead);
+    if (compressedData) {
+        iovs.push_back(compressedData->toIovec());
+    } else {
+        appendParcelDataIovecs(parcel, &iovs);
+    }
+
+    // Object positions are relative to the data on the wire, so they must
+    // account for the external data before them.
+    std::vector<uint32_t> objectTable;
+    objectTable.reserve(objectTableSpan.size);
+    for (uint32_t position : rpcFields->mObjectPositions) {
+        size_t wirePosition = position + parcel.externalDataSizeBefore(position);
+        LOG_ALWAYS_FATAL_IF(wirePosition > UINT32_MAX, "Object position too large: %zu",
+                            wirePosition);
+        objectTable.push_back(static_cast<uint32_t>(wirePosition));
+    }
+    iovs.push_back(Span<const uint32_t>{objectTable.data(), objectTable.size()}.toIovec());
+
+    return rpcSend(connection, session, what, iovs.data(), static_cast<int>(iovs.size()), altPoll,
+                   rpcFields->mFds.get());
+}
+
 status_t RpcState::rpcRec(const sp<RpcSession::RpcConnection>& connection,
                           const sp<RpcSession>& session, const char* what, iovec* iovs, int niovs,
                           std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) {
@@ -525,6 +712,16 @@ status_t RpcState::getSessionId(const sp<RpcSession::RpcConnection>& connection,
 status_t RpcState::transact(const sp<RpcSession::RpcConnection>& connection,
                             const sp<IBinder>& binder, uint32_t code, const Parcel& data,
                             const sp<RpcSession>& session, Parcel* reply, uint32_t flags) {
+    if (status_t status = sendTransact(connection, binder, code, data, session, flags);
+        status != OK) {
+        return status;
+    }
+    return finishTransact(connection, session, reply, flags);
+}
+
+status_t RpcState::sendTransact(const sp<RpcSession::RpcConnection>& connection,
+                                const sp<IBinder>& binder, uint32_t code, const Parcel& data,
+                                const sp<RpcSession>& session, uint32_t flags) {
     std::string errorMsg;
     if (status_t status = validateParcel(session, data, &errorMsg); status != OK) {
         ALOGE("Refusing to send RPC on binder %p code %" PRIu32 ": Parcel %p failed validation: %s",
@@ -534,22 +731,48 @@ status_t RpcState::transact(const sp<RpcSession::RpcConnection>& connection,
     uint64_t address;
     if (status_t status = onBinderLeaving(session, binder, &address); status != OK) return status;
 
-    return transactAddress(connection, address, code, data, session, reply, flags);
+    return sendTransactAddress(connection, address, code, data, session, flags);
 }
 
 status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connection,
                                    uint64_t address, uint32_t code, const Parcel& data,
                                    const sp<RpcSession>& session, Parcel* reply, uint32_t flags) {
+    if (status_t status = sendTransactAddress(connection, address, code, data, session, flags);
+        status != OK) {
+        return status;
+    }
+    return finishTransact(connection, session, reply, flags);
+}
+
+status_t RpcState::finishTransact(const sp<RpcSession::RpcConnection>& connection,
+                                  const sp<RpcSession>& session, Parcel* reply, uint32_t flags) {
+    if (flags & IBinder::FLAG_ONEWAY) {
+        LOG_RPC_DETAIL("Oneway command, so no longer waiting on RpcTransport %p",
+                       connection->rpcTransport.get());
+
+        // Do not wait on result.
+        return OK;
+    }
+
+    LOG_ALWAYS_FATAL_IF(reply == nullptr, "Reply parcel must be used for synchronous transaction.");
+
+    return waitForReply(connection, session, reply);
+}
+
+status_t RpcState::sendTransactAddress(const sp<RpcSession::RpcConnection>& connection,
+                                       uint64_t address, uint32_t code, const Parcel& data,
+                                       const sp<RpcSession>& session, uint32_t flags) {
     LOG_ALWAYS_FATAL_IF(!data.isForRpc());
     LOG_ALWAYS_FATAL_IF(data.objectsCount() != 0);
 
     uint64_t asyncNumber = 0;
 
     if (address != 0) {
-        RpcMutexUniqueLock _l(mNodeMutex);
+        NodeStripe& stripe = stripeForAddress(address);
+        RpcMutexUniqueLock _l(stripe.mutex);
         if (mTerminated) return DEAD_OBJECT; // avoid fatal only, otherwise races
-        auto it = mNodeForAddress.find(address);
-        LOG_ALWAYS_FATAL_IF(it == mNodeForAddress.end(),
+        auto it = stripe.nodeForAddress.find(address);
+        LOG_ALWAYS_FATAL_IF(it == stripe.nodeForAddress.end(),
                             "Sending transact on unknown address %" PRIu64, address);
 
         if (flags & IBinder::FLAG_ONEWAY) {
@@ -568,12 +791,17 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
     Span<const uint32_t> objectTableSpan = Span<const uint32_t>{rpcFields->mObjectPositions.data(),
                                                                 rpcFields->mObjectPositions.size()};
 
+    std::optional<Span<const uint8_t>> compressedData =
+            maybeCompressParcelData(connection, session, data);
+    const size_t uncompressedDataSize = data.dataSize() + data.externalDataSize();
+    size_t parcelDataSize = compressedData ? compressedData->size : uncompressedDataSize;
+
     uint32_t bodySize;
-    LOG_ALWAYS_FATAL_IF(__builtin_add_overflow(sizeof(RpcWireTransaction), data.dataSize(),
+    LOG_ALWAYS_FATAL_IF(__builtin_add_overflow(sizeof(RpcWireTransaction), parcelDataSize,
                                                &bodySize) ||
                                 __builtin_add_overflow(objectTableSpan.byteSize(), bodySize,
                                                        &bodySize),
-                        "Too much data %zu", data.dataSize());
+                        "Too much data %zu", uncompressedDataSize);
     RpcWireHeader command{
             .command = RPC_COMMAND_TRANSACT,
             .bodySize = bodySize,
@@ -585,7 +813,10 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
             .flags = flags,
             .asyncNumber = asyncNumber,
             // bodySize didn't overflow => this cast is safe
-            .parcelDataSize = static_cast<uint32_t>(data.dataSize()),
+            .parcelDataSize = static_cast<uint32_t>(parcelDataSize),
+            // compressed data is smaller => this cast is safe
+            .uncompressedParcelDataSize =
+                    compressedData ? static_cast<uint32_t>(uncompressedDataSize) : 0,
     };
 
     // Oneway calls have no sync point, so if many are sent before, whether this
@@ -598,8 +829,6 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
     iovec iovs[]{
             {&command, sizeof(RpcWireHeader)},
             {&transaction, sizeof(RpcWireTransaction)},
-            {const_cast<uint8_t*>(data.data()), data.dataSize()},
-            objectTableSpan.toIovec(),
     };
     auto altPoll = [&] {
         if (waitUs > kWaitLogUs) {
@@ -617,8 +846,8 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
 
         return drainCommands(connection, session, CommandType::CONTROL_ONLY);
     };
-    if (status_t status = rpcSend(connection, session, "transaction", iovs, countof(iovs),
-                                  std::ref(altPoll), rpcFields->mFds.get());
+    if (status_t status = rpcSendParcel(connection, session, "transaction", iovs, countof(iovs),
+                                        data, compressedData, std::ref(altPoll));
         status != OK) {
         // rpcSend calls shutdownAndWait, so all refcounts should be reset. If we ever tolerate
         // errors here, then we may need to undo the binder-sent counts for the transaction as
@@ -626,17 +855,7 @@ status_t RpcState::transactAddress(const sp<RpcSession::RpcConnection>& connecti
         return status;
     }
 
-    if (flags & IBinder::FLAG_ONEWAY) {
-        LOG_RPC_DETAIL("Oneway command, so no longer waiting on RpcTransport %p",
-                       connection->rpcTransport.get());
-
-        // Do not wait on result.
-        return OK;
-    }
-
-    LOG_ALWAYS_FATAL_IF(reply == nullptr, "Reply parcel must be used for synchronous transaction.");
-
-    return waitForReply(connection, session, reply);
+    return OK;
 }
 
 static void cleanup_reply_data(const uint8_t* data, size_t dataSize, const binder_size_t* objects,
@@ -720,6 +939,28 @@ status_t RpcState::waitForReply(const sp<RpcSession::RpcConnection>& connection,
         objectTableSpan = *maybeSpan;
     }
 
+    if (rpcReply.uncompressedParcelDataSize != 0) {
+        // Kept in a single allocation, like the data it replaces, so that
+        // cleanup_reply_data can free it.
+        CommandData uncompressedData(rpcReply.uncompressedParcelDataSize +
+                                     objectTableSpan.byteSize());
+        if (!uncompressedData.valid()) return NO_MEMORY;
+        if (status_t status = decompressParcelData(session, "reply", parcelSpan,
+                                                   uncompressedData.data(),
+                                                   rpcReply.uncompressedParcelDataSize);
+            status != OK) {
+            return status;
+        }
+        uint8_t* objectTable = uncompressedData.data() + rpcReply.uncompressedParcelDataSize;
+        if (objectTableSpan.size > 0) {
+            memcpy(objectTable, objectTableSpan.data, objectTableSpan.byteSize());
+        }
+
+        parcelSpan = {uncompressedData.data(), rpcReply.uncompressedParcelDataSize};
+        objectTableSpan = {reinterpret_cast<const uint32_t*>(objectTable), objectTableSpan.size};
+        data = std::move(uncompressedData);
+    }
+
     data.release();
     return reply->rpcSetDataReference(session, parcelSpan.data, parcelSpan.size,
                                       objectTableSpan.data, objectTableSpan.size,
@@ -734,10 +975,11 @@ status_t RpcState::sendDecStrongToTarget(const sp<RpcSession::RpcConnection>& co
     };
 
     {
-        RpcMutexUniqueLock _l(mNodeMutex);
+        NodeStripe& stripe = stripeForAddress(addr);
+        RpcMutexUniqueLock _l(stripe.mutex);
         if (mTerminated) return DEAD_OBJECT; // avoid fatal only, otherwise races
-        auto it = mNodeForAddress.find(addr);
-        LOG_ALWAYS_FATAL_IF(it == mNodeForAddress.end(),
+        auto it = stripe.nodeForAddress.find(addr);
+        LOG_ALWAYS_FATAL_IF(it == stripe.nodeForAddress.end(),
                             "Sending dec strong on unknown address %" PRIu64, addr);
 
         LOG_ALWAYS_FATAL_IF(it->second.timesRecd < target, "Can't dec count of %zu to %zu.",
@@ -750,7 +992,7 @@ status_t RpcState::sendDecStrongToTarget(const sp<RpcSession::RpcConnection>& co
         body.amount = it->second.timesRecd - target;
         it->second.timesRecd = target;
 
-        LOG_ALWAYS_FATAL_IF(nullptr != tryEraseNode(session, std::move(_l), it),
+        LOG_ALWAYS_FATAL_IF(nullptr != tryEraseNode(session, stripe, std::move(_l), it),
                             "Bad state. RpcState shouldn't own received binder");
         // LOCK ALREADY RELEASED
     }
@@ -907,8 +1149,9 @@ processTransactInternalTailCall:
             (void)session->shutdownAndWait(false);
             replyStatus = BAD_VALUE;
         } else if (oneway) {
-            RpcMutexUniqueLock _l(mNodeMutex);
-            auto it = mNodeForAddress.find(addr);
+            NodeStripe& stripe = stripeForAddress(addr);
+            RpcMutexUniqueLock _l(stripe.mutex);
+            auto it = stripe.nodeForAddress.find(addr);
             if (it->second.binder.promote() != target) {
                 ALOGE("Binder became invalid during transaction. Bad client? %" PRIu64, addr);
                 replyStatus = BAD_VALUE;
@@ -979,6 +1222,18 @@ processTransactInternalTailCall:
             objectTableSpan = *maybeSpan;
         }
 
+        CommandData uncompressedData(transaction->uncompressedParcelDataSize);
+        if (transaction->uncompressedParcelDataSize != 0) {
+            if (!uncompressedData.valid()) return NO_MEMORY;
+            if (status_t status = decompressParcelData(session, "transaction", parcelSpan,
+                                                       uncompressedData.data(),
+                                                       uncompressedData.size());
+                status != OK) {
+                return status;
+            }
+            parcelSpan = {uncompressedData.data(), uncompressedData.size()};
+        }
+
         Parcel data;
         // transaction->data is owned by this function. Parcel borrows this data and
         // only holds onto it for the duration of this function call. Parcel will be
@@ -1056,10 +1311,11 @@ processTransactInternalTailCall:
         // downside: asynchronous transactions may drown out synchronous
         // transactions.
         {
-            RpcMutexUniqueLock _l(mNodeMutex);
-            auto it = mNodeForAddress.find(addr);
+            NodeStripe& stripe = stripeForAddress(addr);
+            RpcMutexUniqueLock _l(stripe.mutex);
+            auto it = stripe.nodeForAddress.find(addr);
             // last refcount dropped after this transaction happened
-            if (it == mNodeForAddress.end()) return OK;
+            if (it == stripe.nodeForAddress.end()) return OK;
 
             if (!nodeProgressAsyncNumber(&it->second)) {
                 _l.unlock();
@@ -1120,11 +1376,16 @@ processTransactInternalTailCall:
     Span<const uint32_t> objectTableSpan = Span<const uint32_t>{rpcFields->mObjectPositions.data(),
                                                                 rpcFields->mObjectPositions.size()};
 
+    std::optional<Span<const uint8_t>> compressedData =
+            maybeCompressParcelData(connection, session, reply);
+    const size_t uncompressedDataSize = reply.dataSize() + reply.externalDataSize();
+    size_t parcelDataSize = compressedData ? compressedData->size : uncompressedDataSize;
+
     uint32_t bodySize;
-    LOG_ALWAYS_FATAL_IF(__builtin_add_overflow(rpcReplyWireSize, reply.dataSize(), &bodySize) ||
+    LOG_ALWAYS_FATAL_IF(__builtin_add_overflow(rpcReplyWireSize, parcelDataSize, &bodySize) ||
                                 __builtin_add_overflow(objectTableSpan.byteSize(), bodySize,
                                                        &bodySize),
-                        "Too much data for reply %zu", reply.dataSize());
+                        "Too much data for reply %zu", uncompressedDataSize);
     RpcWireHeader cmdReply{
             .command = RPC_COMMAND_REPLY,
             .bodySize = bodySize,
@@ -1134,17 +1395,18 @@ processTransactInternalTailCall:
             // NOTE: Not necessarily written to socket depending on session
             // version.
             // NOTE: bodySize didn't overflow => this cast is safe
-            .parcelDataSize = static_cast<uint32_t>(reply.dataSize()),
-            .reserved = {0, 0, 0},
+            .parcelDataSize = static_cast<uint32_t>(parcelDataSize),
+            // compressed data is smaller => this cast is safe
+            .uncompressedParcelDataSize =
+                    compressedData ? static_cast<uint32_t>(uncompressedDataSize) : 0,
+            .reserved = {0, 0},
     };
     iovec iovs[]{
             {&cmdReply, sizeof(RpcWireHeader)},
             {&rpcReply, rpcReplyWireSize},
-            {const_cast<uint8_t*>(reply.data()), reply.dataSize()},
-            objectTableSpan.toIovec(),
     };
-    return rpcSend(connection, session, "reply", iovs, countof(iovs), std::nullopt,
-                   rpcFields->mFds.get());
+    return rpcSendParcel(connection, session, "reply", iovs, countof(iovs), reply, compressedData,
+                         std::nullopt);
 }
 
 status_t RpcState::processDecStrong(const sp<RpcSession::RpcConnection>& connection,
@@ -1165,9 +1427,10 @@ status_t RpcState::processDecStrong(const sp<RpcSession::RpcConnection>& connect
         return status;
 
     uint64_t addr = RpcWireAddress::toRaw(body.address);
-    RpcMutexUniqueLock _l(mNodeMutex);
-    auto it = mNodeForAddress.find(addr);
-    if (it == mNodeForAddress.end()) {
+    NodeStripe& stripe = stripeForAddress(addr);
+    RpcMutexUniqueLock _l(stripe.mutex);
+    auto it = stripe.nodeForAddress.find(addr);
+    if (it == stripe.nodeForAddress.end()) {
         ALOGE("Unknown binder address %" PRIu64 " for dec strong.", addr);
         return OK;
     }
@@ -1195,7 +1458,7 @@ status_t RpcState::processDecStrong(const sp<RpcSession::RpcConnection>& connect
                    it->second.timesSent);
 
     it->second.timesSent -= body.amount;
-    sp<IBinder> tempHold = tryEraseNode(session, std::move(_l), it);
+    sp<IBinder> tempHold = tryEraseNode(session, stripe, std::move(_l), it);
     // LOCK ALREADY RELEASED
     tempHold = nullptr; // destructor may make binder calls on this session
 
@@ -1263,9 +1526,10 @@ status_t RpcState::validateParcel(const sp<RpcSession>& session, const Parcel& p
     return OK;
 }
 
-sp<IBinder> RpcState::tryEraseNode(const sp<RpcSession>& session, RpcMutexUniqueLock nodeLock,
+sp<IBinder> RpcState::tryEraseNode(const sp<RpcSession>& session, NodeStripe& stripe,
+                                   RpcMutexUniqueLock nodeLock,
                                    std::map<uint64_t, BinderNode>::iterator& it) {
-    bool shouldShutdown = false;
+    bool erasedLastNode = false;
 
     sp<IBinder> ref;
 
@@ -1275,27 +1539,28 @@ sp<IBinder> RpcState::tryEraseNode(const sp<RpcSession>& session, RpcMutexUnique
         if (it->second.timesRecd == 0) {
             LOG_ALWAYS_FATAL_IF(!it->second.asyncTodo.empty(),
                                 "Can't delete binder w/ pending async transactions");
-            mNodeForAddress.erase(it);
+            stripe.nodeForAddress.erase(it);
 
-            if (mNodeForAddress.size() == 0) {
-                shouldShutdown = true;
-            }
+            erasedLastNode = --mNodeCount == 0;
         }
     }
 
+    nodeLock.unlock(); // explicit
+    // LOCK IS RELEASED
+
+    if (!erasedLastNode) return ref;
+
     // If we shutdown, prevent RpcState from being re-used. This prevents another
     // thread from getting the root object again.
-    if (shouldShutdown) {
-        clear(std::move(nodeLock));
-    } else {
-        nodeLock.unlock(); // explicit
+    lockAllStripes();
+    if (mTerminated || mNodeCount != 0) {
+        unlockAllStripes();
+        return ref;
     }
-    // LOCK IS RELEASED
+    clearLocked();
 
-    if (shouldShutdown) {
-        ALOGI("RpcState has no binders left, so triggering shutdown...");
-        (void)session->shutdownAndWait(false);
-    }
+    ALOGI("RpcState has no binders left, so triggering shutdown...");
+    (void)session->shutdownAndWait(false);
 
     return ref;
 }
@@ -22,6 +22,10 @@
 #include <binder/RpcThreads.h>
 #include <binder/unique_fd.h>
 
+#include "Utils.h"
+
+#include <array>
+#include <atomic>
 #include <map>
 #include <optional>
 #include <queue>
@@ -90,6 +94,18 @@ public:
                                            const sp<RpcSession>& session, Parcel* reply,
                                            uint32_t flags);
 
+    /**
+     * Like transact, but only sends the transaction. For a synchronous transaction, the
+     * caller must keep exclusive use of the connection until it has read the reply with
+     * waitForReply, since replies are matched to transactions by their order on it.
+     */
+    [[nodiscard]] status_t sendTransact(const sp<RpcSession::RpcConnection>& connection,
+                                        const sp<IBinder>& address, uint32_t code,
+                                        const Parcel& data, const sp<RpcSession>& session,
+                                        uint32_t flags);
+    [[nodiscard]] status_t waitForReply(const sp<RpcSession::RpcConnection>& connection,
+                                        const sp<RpcSession>& session, Parcel* reply);
+
     /**
      * The ownership model here carries an implicit strong refcount whenever a
      * binder is sent across processes. Since we have a local strong count in
@@ -171,7 +187,10 @@ public:
     void clear();
 
 private:
-    void clear(RpcMutexUniqueLock nodeLock);
+    struct NodeStripe;
+
+    // Requires every stripe to be locked, and unlocks them.
+    void clearLocked();
     void dumpLocked();
 
     // Alternative to std::vector<uint8_t> that doesn't abort on allocation failure and caps
@@ -194,14 +213,27 @@ private:
             const std::optional<binder::impl::SmallFunction<status_t()>>& altPoll,
             const std::vector<std::variant<binder::unique_fd, binder::borrowed_fd>>* ancillaryFds =
                     nullptr);
+    // Sends the `nhead` iovecs in `head`, followed by `parcel`'s data and
+    // object table. If `compressedData` is set, it is sent in place of the
+    // Parcel's data.
+    [[nodiscard]] status_t rpcSendParcel(
+            const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
+            const char* what, iovec* head, int nhead, const Parcel& parcel,
+            std::optional<Span<const uint8_t>> compressedData,
+            const std::optional<binder::impl::SmallFunction<status_t()>>& altPoll);
     [[nodiscard]] status_t rpcRec(const sp<RpcSession::RpcConnection>& connection,
                                   const sp<RpcSession>& session, const char* what, iovec* iovs,
                                   int niovs,
                                   std::vector<std::variant<binder::unique_fd, binder::borrowed_fd>>*
                                           ancillaryFds = nullptr);
 
-    [[nodiscard]] status_t waitForReply(const sp<RpcSession::RpcConnection>& connection,
-                                        const sp<RpcSession>& session, Parcel* reply);
+    [[nodiscard]] status_t sendTransactAddress(const sp<RpcSession::RpcConnection>& connection,
+                                               uint64_t address, uint32_t code,
+                                               const Parcel& data, const sp<RpcSession>& session,
+                                               uint32_t flags);
+    [[nodiscard]] status_t finishTransact(const sp<RpcSession::RpcConnection>& connection,
+                                          const sp<RpcSession>& session, Parcel* reply,
+                                          uint32_t flags);
     [[nodiscard]] status_t processCommand(
             const sp<RpcSession::RpcConnection>& connection, const sp<RpcSession>& session,
             const RpcWireHeader& command, CommandType type,
@@ -279,23 +311,42 @@ private:
     // Node lock is passed here for convenience, so that we can release it
     // and terminate the session, but we could leave it up to the caller
     // by returning a continuation if we needed to erase multiple specific
-    // nodes. It may be tempting to allow the client to keep on holding the
-    // lock and instead just return whether or not we should shutdown, but
-    // this introduces the posssibility that another thread calls
-    // getRootBinder and thinks it is valid, rather than immediately getting
-    // an error.
-    sp<IBinder> tryEraseNode(const sp<RpcSession>& session, RpcMutexUniqueLock nodeLock,
+    // nodes. If the last node is erased, all stripes are locked again and
+    // the session is only terminated if no node was added in the meantime,
+    // so that another thread which called getRootBinder concurrently gets
+    // either a valid binder or an error.
+    sp<IBinder> tryEraseNode(const sp<RpcSession>& session, NodeStripe& stripe,
+                             RpcMutexUniqueLock nodeLock,
                              std::map<uint64_t, BinderNode>::iterator& it);
 
     // true - success
     // false - session shutdown, halt
     [[nodiscard]] bool nodeProgressAsyncNumber(BinderNode* node);
 
-    RpcMutex mNodeMutex;
+    // Binders known by both sides of a session are split across stripes by
+    // address, each with its own lock, so that threads transacting on
+    // different binders don't contend. Anything needing all nodes at once
+    // locks every stripe, in index order.
+    static constexpr size_t kNodeStripes = 16;
+    struct alignas(64) NodeStripe {
+        RpcMutex mutex;
+        // Local binders are always given addresses in the stripe selected by
+        // their pointer, so only that stripe has to be searched for them.
+        // This counts the addresses handed out in this stripe.
+        uint32_t nextId = 0;
+        std::map<uint64_t, BinderNode> nodeForAddress;
+    };
+
+    NodeStripe& stripeForAddress(uint64_t address);
+    NodeStripe& stripeForLocalBinder(const sp<IBinder>& binder);
+    void lockAllStripes();
+    void unlockAllStripes();
+
+    std::array<NodeStripe, kNodeStripes> mNodeStripes;
+    // written with all stripes locked, so it may be read with any one locked
     bool mTerminated = false;
-    uint32_t mNextId = 0;
-    // binders known by both sides of a session
-    std::map<uint64_t, BinderNode> mNodeForAddress;
+    // only changes with the stripe of the node being added or removed locked
+    std::atomic<size_t> mNodeCount = 0;
 };
 
 } // namespace android
@@ -0,0 +1,600 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "RpcShmTransport"
+#include <log/log.h>
+
+#include <poll.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <new>
+
+#include <binder/RpcTransportShm.h>
+
+#include "FdTrigger.h"
+#include "OS.h"
+#include "RpcState.h"
+#include "RpcTransportUtils.h"
+#include "Utils.h"
+
+// The rings need memfd and eventfd, and waiting on the shutdown trigger needs its pipe, so
+// single-threaded builds and other platforms always use the plain socket path.
+#if defined(__linux__) && !defined(BINDER_RPC_SINGLE_THREADED)
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BINDER_RPC_WITH_SHM_RING
+#endif
+
+namespace android {
+
+using namespace android::binder::impl;
+using android::binder::borrowed_fd;
+using android::binder::unique_fd;
+
+namespace {
+
+constexpr uint32_t kShmHelloMagic = 0x52534d31; // 'RSM1'
+
+// Size of the data area of each ring. Must be a power of two.
+constexpr uint32_t kShmRingSize = 128 * 1024;
+static_assert((kShmRingSize & (kShmRingSize - 1)) == 0);
+
+// First thing the client writes on a new connection, along with the memfd and eventfds if it
+// could set them up.
+struct ShmHello {
+    uint32_t magic;
+    // kShmRingSize, or 0 if the client couldn't set up shared memory.
+    uint32_t ringSize;
+};
+
+// Server reply to ShmHello. Non-zero if the rings will be used.
+using ShmAck = uint32_t;
+
+// Control block at the start of each ring, shared between the two processes. Positions are
+// free-running byte counts. Neither side trusts the values written by the other beyond checking
+// them against its own copy.
+struct alignas(64) ShmRingHeader {
+    std::atomic<uint64_t> readPos;
+    std::atomic<uint64_t> writePos;
+    // Set by a side before it sleeps on its eventfd, so the other side knows to wake it.
+    std::atomic<uint32_t> readerWaiting;
+    std::atomic<uint32_t> writerWaiting;
+    // Number of FD messages the writer has sent over the socket so far.
+    std::atomic<uint64_t> fdMessages;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "ring positions are shared between processes");
+
+constexpr size_t kShmRingStride = sizeof(ShmRingHeader) + kShmRingSize;
+// Client to server ring, followed by server to client ring.
+constexpr size_t kShmSize = 2 * kShmRingStride;
+
+} // namespace
+
+// RpcTransport with TLS disabled, using shared memory rings when they could be negotiated.
+class RpcTransportShm : public RpcTransport {
+public:
+    explicit RpcTransportShm(android::RpcTransportFd socket) : mSocket(std::move(socket)) {}
+
+#ifdef BINDER_RPC_WITH_SHM_RING
+    ~RpcTransportShm() {
+        if (mShm != MAP_FAILED) munmap(mShm, kShmSize);
+    }
+#endif
+
+    // Runs the ShmHello exchange. Returns false if the connection should be dropped.
+    bool handshake(FdTrigger* fdTrigger, bool isClient) {
+        return isClient ? clientHandshake(fdTrigger) : serverHandshake(fdTrigger);
+    }
+
+    status_t pollRead(void) override {
+#ifdef BINDER_RPC_WITH_SHM_RING
+        if (usingRings()) {
+            if (mRx->writePos.load(std::memory_order_acquire) != mRxPos) return OK;
+            pollfd pfd{.fd = mSocket.fd.get(), .events = 0, .revents = 0};
+            if (TEMP_FAILURE_RETRY(poll(&pfd, 1, 0)) < 0) return -errno;
+            if (pfd.revents & (POLLHUP | POLLERR)) return DEAD_OBJECT;
+            return WOULD_BLOCK;
+        }
+#endif
+        uint8_t buf;
+        ssize_t ret = TEMP_FAILURE_RETRY(
+                ::recv(mSocket.fd.get(), &buf, sizeof(buf), MSG_PEEK | MSG_DONTWAIT));
+        if (ret < 0) {
+            int savedErrno = errno;
+            if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+                return WOULD_BLOCK;
+            }
+
+            LOG_RPC_DETAIL("RpcTransport poll(): %s", strerror(savedErrno));
+            return -savedErrno;
+        } else if (ret == 0) {
+            return DEAD_OBJECT;
+        }
+
+        return OK;
+    }
+
+    status_t interruptableWriteFully(
+            FdTrigger* fdTrigger, iovec* iovs, int niovs,
+            const std::optional<SmallFunction<status_t()>>& altPoll,
+            const std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) override {
+#ifdef BINDER_RPC_WITH_SHM_RING
+        if (usingRings()) {
+            return ringWriteFully(fdTrigger, iovs, niovs, altPoll, ancillaryFds);
+        }
+#endif
+        return socketWriteFully(fdTrigger, iovs, niovs, altPoll, ancillaryFds);
+    }
+
+    status_t interruptableReadFully(
+            FdTrigger* fdTrigger, iovec* iovs, int niovs,
+            const std::optional<SmallFunction<status_t()>>& altPoll,
+            std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) override {
+#ifdef BINDER_RPC_WITH_SHM_RING
+        if (usingRings()) {
+            return ringReadFully(fdTrigger, iovs, niovs, altPoll, ancillaryFds);
+        }
+#endif
+        return socketReadFully(fdTrigger, iovs, niovs, altPoll, ancillaryFds);
+    }
+
+    bool isWaiting() override { return mSocket.isInPollingState() || mWaiting; }
+
+private:
+    bool usingRings() const {
+#ifdef BINDER_RPC_WITH_SHM_RING
+        return mShm != MAP_FAILED;
+#else
+        return false;
+#endif
+    }
+
+    status_t socketWriteFully(
+            FdTrigger* fdTrigger, iovec* iovs, int niovs,
+            const std::optional<SmallFunction<status_t()>>& altPoll,
+            const std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) {
+        bool sentFds = false;
+        auto send = [&](iovec* iovs, int niovs) -> ssize_t {
+            ssize_t ret = binder::os::sendMessageOnSocket(mSocket, iovs, niovs,
+                                                          sentFds ? nullptr : ancillaryFds);
+            sentFds |= ret > 0;
+            return ret;
+        };
+        return interruptableReadOrWrite(mSocket, fdTrigger, iovs, niovs, send, "sendmsg", POLLOUT,
+                                        altPoll);
+    }
+
+    status_t socketReadFully(FdTrigger* fdTrigger, iovec* iovs, int niovs,
+                             const std::optional<SmallFunction<status_t()>>& altPoll,
+                             std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) {
+        auto recv = [&](iovec* iovs, int niovs) -> ssize_t {
+            return binder::os::receiveMessageFromSocket(mSocket, iovs, niovs, ancillaryFds);
+        };
+        return interruptableReadOrWrite(mSocket, fdTrigger, iovs, niovs, recv, "recvmsg", POLLIN,
+                                        altPoll);
+    }
+
+    bool clientHandshake(FdTrigger* fdTrigger) {
+        ShmHello hello{.magic = kShmHelloMagic, .ringSize = 0};
+        std::vector<std::variant<unique_fd, borrowed_fd>> fds;
+#ifdef BINDER_RPC_WITH_SHM_RING
+        unique_fd memFd, clientWake, serverWake;
+        // The rings are mapped and initialized before the server can see them.
+        if (isUnixSocket() && createShm(&memFd, &clientWake, &serverWake) &&
+            mapShm(memFd, /*isClient=*/true)) {
+            hello.ringSize = kShmRingSize;
+            fds.emplace_back(borrowed_fd(memFd));
+            fds.emplace_back(borrowed_fd(clientWake));
+            fds.emplace_back(borrowed_fd(serverWake));
+        }
+#endif
+        iovec helloIov{&hello, sizeof(hello)};
+        if (status_t status = socketWriteFully(fdTrigger, &helloIov, 1, std::nullopt,
+                                               fds.empty() ? nullptr : &fds);
+            status != OK) {
+            ALOGE("Failed to send shared memory hello: %s", statusToString(status).c_str());
+            return false;
+        }
+
+        ShmAck ack = 0;
+        iovec ackIov{&ack, sizeof(ack)};
+        if (status_t status = socketReadFully(fdTrigger, &ackIov, 1, std::nullopt, nullptr);
+            status != OK) {
+            ALOGE("Failed to read shared memory ack: %s", statusToString(status).c_str());
+            return false;
+        }
+
+#ifdef BINDER_RPC_WITH_SHM_RING
+        if (ack != 0 && usingRings()) {
+            mWakeSelf = std::move(clientWake);
+            mWakePeer = std::move(serverWake);
+        } else if (usingRings()) {
+            munmap(mShm, kShmSize);
+            mShm = MAP_FAILED;
+        }
+#endif
+        LOG_RPC_DETAIL("Shared memory transport: using %s", usingRings() ? "rings" : "socket");
+        return true;
+    }
+
+    bool serverHandshake(FdTrigger* fdTrigger) {
+        ShmHello hello{};
+        std::vector<std::variant<unique_fd, borrowed_fd>> fds;
+        iovec helloIov{&hello, sizeof(hello)};
+        if (status_t status = socketReadFully(fdTrigger, &helloIov, 1, std::nullopt, &fds);
+            status != OK) {
+            ALOGE("Failed to read shared memory hello: %s", statusToString(status).c_str());
+            return false;
+        }
+        if (hello.magic != kShmHelloMagic) {
+            ALOGE("Bad shared memory hello magic 0x%x", hello.magic);
+            return false;
+        }
+
+        ShmAck ack = 0;
+#ifdef BINDER_RPC_WITH_SHM_RING
+        if (hello.ringSize == kShmRingSize && fds.size() == 3 &&
+            std::all_of(fds.begin(), fds.end(), [](const auto& fd) {
+                return std::holds_alternative<unique_fd>(fd);
+            })) {
+            auto& memFd = std::get<unique_fd>(fds[0]);
+            auto& clientWake = std::get<unique_fd>(fds[1]);
+            auto& serverWake = std::get<unique_fd>(fds[2]);
+            if (validateShm(memFd) && binder::os::setNonBlocking(clientWake) == OK &&
+                binder::os::setNonBlocking(serverWake) == OK && mapShm(memFd, /*isClient=*/false)) {
+                mWakeSelf = std::move(serverWake);
+                mWakePeer = std::move(clientWake);
+                ack = 1;
+            }
+        }
+#endif
+        if (hello.ringSize != 0 && ack == 0) {
+            ALOGW("Rejecting shared memory rings offered by client, using the socket");
+        }
+
+        iovec ackIov{&ack, sizeof(ack)};
+        if (status_t status = socketWriteFully(fdTrigger, &ackIov, 1, std::nullopt, nullptr);
+            status != OK) {
+            ALOGE("Failed to send shared memory ack: %s", statusToString(status).c_str());
+            return false;
+        }
+        return true;
+    }
+
+#ifdef BINDER_RPC_WITH_SHM_RING
+    bool isUnixSocket() {
+        sockaddr_storage addr;
+        socklen_t addrLen = sizeof(addr);
+        if (getsockname(mSocket.fd.get(), reinterpret_cast<sockaddr*>(&addr), &addrLen) != 0) {
+            return false;
+        }
+        return addr.ss_family == AF_UNIX;
+    }
+
+    static bool createShm(unique_fd* memFd, unique_fd* clientWake, unique_fd* serverWake) {
+        unique_fd fd(memfd_create("binder_rpc_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING));
+        if (!fd.ok()) {
+            LOG_RPC_DETAIL("memfd_create failed, using the socket: %s", strerror(errno));
+            return false;
+        }
+        if (ftruncate(fd.get(), kShmSize) != 0) {
+            ALOGE("Could not size shared memory rings: %s", strerror(errno));
+            return false;
+        }
+        // The server maps this too, and must not get SIGBUS because the client shrunk it.
+        if (fcntl(fd.get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+            ALOGE("Could not seal shared memory rings: %s", strerror(errno));
+            return false;
+        }
+        unique_fd c(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+        unique_fd s(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+        if (!c.ok() || !s.ok()) {
+            ALOGE("Could not create eventfd: %s", strerror(errno));
+            return false;
+        }
+        *memFd = std::move(fd);
+        *clientWake = std::move(c);
+        *serverWake = std::move(s);
+        return true;
+    }
+
+    static bool validateShm(const unique_fd& memFd) {
+        struct stat st;
+        if (fstat(memFd.get(), &st) != 0 || static_cast<size_t>(st.st_size) != kShmSize) {
+            ALOGE("Shared memory rings have the wrong size");
+            return false;
+        }
+        int seals = fcntl(memFd.get(), F_GET_SEALS);
+        if (seals < 0 || (seals & F_SEAL_SHRINK) == 0) {
+            ALOGE("Shared memory rings are not sealed against shrinking");
+            return false;
+        }
+        return true;
+    }
+
+    bool mapShm(const unique_fd& memFd, bool isClient) {
+        void* shm = mmap(nullptr, kShmSize, PROT_READ | PROT_WRITE, MAP_SHARED, memFd.get(), 0);
+        if (shm == MAP_FAILED) {
+            ALOGE("Could not map shared memory rings: %s", strerror(errno));
+            return false;
+        }
+        mShm = shm;
+        auto* base = static_cast<uint8_t*>(shm);
+        if (isClient) {
+            new (base) ShmRingHeader();
+            new (base + kShmRingStride) ShmRingHeader();
+        }
+        uint8_t* clientToServer = base;
+        uint8_t* serverToClient = base + kShmRingStride;
+        uint8_t* tx = isClient ? clientToServer : serverToClient;
+        uint8_t* rx = isClient ? serverToClient : clientToServer;
+        mTx = reinterpret_cast<ShmRingHeader*>(tx);
+        mTxData = tx + sizeof(ShmRingHeader);
+        mRx = reinterpret_cast<ShmRingHeader*>(rx);
+        mRxData = rx + sizeof(ShmRingHeader);
+        return true;
+    }
+
+    void wakePeer() {
+        uint64_t one = 1;
+        // EAGAIN means the counter is saturated, so the peer is going to wake up anyway.
+        if (TEMP_FAILURE_RETRY(write(mWakePeer.get(), &one, sizeof(one))) < 0 && errno != EAGAIN) {
+            ALOGE("Could not wake shared memory peer: %s", strerror(errno));
+        }
+    }
+
+    // Sleeps until ready() returns true, the trigger fires, or the peer hangs up. waitingFlag is
+    // set while sleeping, so the peer knows to signal our eventfd.
+    template <typename Ready>
+    status_t waitUntil(FdTrigger* fdTrigger, std::atomic<uint32_t>* waitingFlag, Ready ready) {
+        while (true) {
+            // Pairs with the peer publishing progress and then checking the flag. Both are
+            // sequentially consistent, so at least one side sees the other.
+            waitingFlag->store(1);
+            if (ready()) {
+                waitingFlag->store(0);
+                return OK;
+            }
+
+            pollfd pfd[]{
+                    {.fd = mWakeSelf.get(), .events = POLLIN, .revents = 0},
+                    {.fd = mSocket.fd.get(), .events = 0, .revents = 0},
+                    {.fd = fdTrigger->readFd().get(), .events = 0, .revents = 0},
+            };
+            mWaiting = true;
+            int ret = TEMP_FAILURE_RETRY(poll(pfd, countof(pfd), -1));
+            mWaiting = false;
+            waitingFlag->store(0);
+            if (ret < 0) {
+                int savedErrno = errno;
+                ALOGE("Shared memory transport poll failed: %s", strerror(savedErrno));
+                return -savedErrno;
+            }
+
+            if (pfd[2].revents != 0) return DEAD_OBJECT;
+            if (pfd[0].revents & POLLIN) {
+                uint64_t count;
+                (void)TEMP_FAILURE_RETRY(read(mWakeSelf.get(), &count, sizeof(count)));
+            }
+            if (pfd[1].revents != 0) {
+                // The peer is gone, but still let the caller drain what it already published.
+                return ready() ? OK : DEAD_OBJECT;
+            }
+        }
+    }
+
+    static void trimEmptyTail(iovec* iovs, int* niovs) {
+        // See interruptableReadOrWrite.
+        while (*niovs > 0 && iovs[*niovs - 1].iov_len == 0) {
+            (*niovs)--;
+        }
+    }
+
+    status_t ringWriteFully(FdTrigger* fdTrigger, iovec* iovs, int niovs,
+                            const std::optional<SmallFunction<status_t()>>& altPoll,
+                            const std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) {
+        MAYBE_WAIT_IN_FLAKE_MODE;
+
+        if (niovs < 0) return BAD_VALUE;
+        if (fdTrigger->isTriggered()) return DEAD_OBJECT;
+        trimEmptyTail(iovs, &niovs);
+        if (niovs == 0) return OK;
+
+        if (ancillaryFds != nullptr && !ancillaryFds->empty()) {
+            // FDs still go over the socket, tagged with the ring position of the data they were
+            // sent with. They are sent before that data is published, so the reader always finds
+            // them by the time it gets there.
+            uint64_t position = mTxPos;
+            iovec iov{&position, sizeof(position)};
+            if (status_t status = socketWriteFully(fdTrigger, &iov, 1, altPoll, ancillaryFds);
+                status != OK) {
+                return status;
+            }
+            mTx->fdMessages.fetch_add(1);
+        }
+
+        for (int i = 0; i < niovs; i++) {
+            const uint8_t* src = static_cast<const uint8_t*>(iovs[i].iov_base);
+            size_t remaining = iovs[i].iov_len;
+            while (remaining > 0) {
+                uint64_t used = mTxPos - mTx->readPos.load(std::memory_order_acquire);
+                if (used > kShmRingSize) {
+                    ALOGE("Shared memory peer corrupted the ring read position");
+                    return BAD_VALUE;
+                }
+                if (used == kShmRingSize) {
+                    auto hasSpace = [&] { return mTxPos - mTx->readPos.load() < kShmRingSize; };
+                    if (altPoll) {
+                        if (status_t status = (*altPoll)(); status != OK) return status;
+                        if (fdTrigger->isTriggered()) return DEAD_OBJECT;
+                    } else if (status_t status =
+                                       waitUntil(fdTrigger, &mTx->writerWaiting, hasSpace);
+                               status != OK) {
+                        return status;
+                    }
+                    continue;
+                }
+
+                size_t n = std::min<size_t>(remaining, kShmRingSize - used);
+                size_t offset = mTxPos & (kShmRingSize - 1);
+                size_t first = std::min<size_t>(n, kShmRingSize - offset);
+                memcpy(mTxData + offset, src, first);
+                memcpy(mTxData, src + first, n - first);
+                src += n;
+                remaining -= n;
+                mTxPos += n;
+                mTx->writePos.store(mTxPos);
+                if (mTx->readerWaiting.load()) wakePeer();
+            }
+        }
+        return OK;
+    }
+
+    // Reads FD messages announced in the ring header off the socket.
+    status_t drainFdMessages(FdTrigger* fdTrigger) {
+        uint64_t announced = mRx->fdMessages.load();
+        while (mFdMessagesSeen != announced) {
+            uint64_t position;
+            std::vector<std::variant<unique_fd, borrowed_fd>> fds;
+            iovec iov{&position, sizeof(position)};
+            if (status_t status = socketReadFully(fdTrigger, &iov, 1, std::nullopt, &fds);
+                status != OK) {
+                return status;
+            }
+            mFdMessagesSeen++;
+            // Data that was already consumed without asking for FDs drops them, like recvmsg.
+            if (position < mRxPos) continue;
+            mPendingFds.emplace_back(position, std::move(fds));
+        }
+        return OK;
+    }
+
+    status_t ringReadFully(FdTrigger* fdTrigger, iovec* iovs, int niovs,
+                           const std::optional<SmallFunction<status_t()>>& altPoll,
+                           std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) {
+        MAYBE_WAIT_IN_FLAKE_MODE;
+
+        if (niovs < 0) return BAD_VALUE;
+        if (fdTrigger->isTriggered()) return DEAD_OBJECT;
+        trimEmptyTail(iovs, &niovs);
+        if (niovs == 0) return OK;
+
+        for (int i = 0; i < niovs; i++) {
+            uint8_t* dst = static_cast<uint8_t*>(iovs[i].iov_base);
+            size_t remaining = iovs[i].iov_len;
+            while (remaining > 0) {
+                uint64_t available = mRx->writePos.load(std::memory_order_acquire) - mRxPos;
+                if (available > kShmRingSize) {
+                    ALOGE("Shared memory peer corrupted the ring write position");
+                    return BAD_VALUE;
+                }
+                if (available == 0) {
+                    auto hasData = [&] { return mRx->writePos.load() != mRxPos; };
+                    if (altPoll) {
+                        if (status_t status = (*altPoll)(); status != OK) return status;
+                        if (fdTrigger->isTriggered()) return DEAD_OBJECT;
+                    } else if (status_t status = waitUntil(fdTrigger, &mRx->readerWaiting, hasData);
+                               status != OK) {
+                        return status;
+                    }
+                    continue;
+                }
+
+                size_t n = std::min<size_t>(remaining, available);
+                if (ancillaryFds != nullptr) {
+                    if (status_t status = drainFdMessages(fdTrigger); status != OK) return status;
+                    while (!mPendingFds.empty() && mPendingFds.front().first < mRxPos + n) {
+                        for (auto& fd : mPendingFds.front().second) {
+                            ancillaryFds->emplace_back(std::move(fd));
+                        }
+                        mPendingFds.pop_front();
+                    }
+                }
+
+                size_t offset = mRxPos & (kShmRingSize - 1);
+                size_t first = std::min<size_t>(n, kShmRingSize - offset);
+                memcpy(dst, mRxData + offset, first);
+                memcpy(dst + first, mRxData, n - first);
+                dst += n;
+                remaining -= n;
+                mRxPos += n;
+                mRx->readPos.store(mRxPos);
+                if (mRx->writerWaiting.load()) wakePeer();
+            }
+        }
+        return OK;
+    }
+
+    void* mShm = MAP_FAILED;
+    ShmRingHeader* mTx = nullptr;
+    uint8_t* mTxData = nullptr;
+    uint64_t mTxPos = 0;
+    ShmRingHeader* mRx = nullptr;
+    uint8_t* mRxData = nullptr;
+    uint64_t mRxPos = 0;
+    unique_fd mWakeSelf;
+    unique_fd mWakePeer;
+    uint64_t mFdMessagesSeen = 0;
+    std::deque<std::pair<uint64_t, std::vector<std::variant<unique_fd, borrowed_fd>>>>
+            mPendingFds;
+#endif // BINDER_RPC_WITH_SHM_RING
+
+    android::RpcTransportFd mSocket;
+    std::atomic<bool> mWaiting = false;
+};
+
+// RpcTransportCtx with TLS disabled, using shared memory rings when possible.
+class RpcTransportCtxShm : public RpcTransportCtx {
+public:
+    explicit RpcTransportCtxShm(bool isClient) : mIsClient(isClient) {}
+
+    std::unique_ptr<RpcTransport> newTransport(android::RpcTransportFd socket,
+                                               FdTrigger* fdTrigger) const override {
+        auto transport = std::make_unique<RpcTransportShm>(std::move(socket));
+        if (!transport->handshake(fdTrigger, mIsClient)) return nullptr;
+        return transport;
+    }
+    std::vector<uint8_t> getCertificate(RpcCertificateFormat) const override { return {}; }
+
+private:
+    const bool mIsClient;
+};
+
+std::unique_ptr<RpcTransportCtx> RpcTransportCtxFactoryShm::newServerCtx() const {
+    return std::make_unique<RpcTransportCtxShm>(/*isClient=*/false);
+}
+
+std::unique_ptr<RpcTransportCtx> RpcTransportCtxFactoryShm::newClientCtx() const {
+    return std::make_unique<RpcTransportCtxShm>(/*isClient=*/true);
+}
+
+const char* RpcTransportCtxFactoryShm::toCString() const {
+    return "shm";
+}
+
+std::unique_ptr<RpcTransportCtxFactory> RpcTransportCtxFactoryShm::make() {
+    return std::unique_ptr<RpcTransportCtxFactoryShm>(new RpcTransportCtxFactoryShm());
+}
+
+} // namespace android
@@ -0,0 +1,463 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "RpcUringTransport"
+#include <log/log.h>
+
+#include <poll.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include <binder/RpcTransportUring.h>
+
+#include "FdTrigger.h"
+#include "OS.h"
+#include "RpcState.h"
+#include "RpcTransportUtils.h"
+
+// io_uring needs the Linux UAPI headers, and waiting on the shutdown trigger needs its pipe, so
+// single-threaded builds and other platforms always use the plain socket path.
+#if defined(__linux__) && !defined(BINDER_RPC_SINGLE_THREADED) && \
+        __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define BINDER_RPC_WITH_IO_URING
+#endif
+#endif
+
+namespace android {
+
+using namespace android::binder::impl;
+using android::binder::borrowed_fd;
+using android::binder::unique_fd;
+
+#ifdef BINDER_RPC_WITH_IO_URING
+
+namespace {
+
+// The armed trigger poll, one socket poll linked to one I/O request, and their cancellations
+// are the only entries that can ever be in flight on a ring.
+constexpr unsigned kRingEntries = 8;
+
+enum : uint64_t {
+    kUserDataIo = 1,
+    kUserDataSocketPoll,
+    kUserDataTrigger,
+    kUserDataCancel,
+};
+
+// Minimal single-producer, single-consumer io_uring wrapper. There is no liburing in this tree,
+// and the transport only needs a handful of operations, so the rings are driven directly.
+// Not thread-safe: like the RpcTransport it belongs to, it is only used by the thread that
+// currently owns the connection.
+class UringQueue {
+public:
+    static std::unique_ptr<UringQueue> make() {
+        io_uring_params params{};
+        int ret = static_cast<int>(syscall(__NR_io_uring_setup, kRingEntries, &params));
+        if (ret < 0) {
+            int savedErrno = errno;
+            LOG_RPC_DETAIL("io_uring_setup failed, using plain sockets: %s", strerror(savedErrno));
+            return nullptr;
+        }
+        auto queue = std::unique_ptr<UringQueue>(new UringQueue(unique_fd(ret)));
+        if (!queue->map(params)) return nullptr;
+        return queue;
+    }
+
+    ~UringQueue() {
+        if (mSqes != MAP_FAILED) munmap(mSqes, mSqesSize);
+        if (mCqRing != MAP_FAILED && mCqRing != mSqRing) munmap(mCqRing, mCqRingSize);
+        if (mSqRing != MAP_FAILED) munmap(mSqRing, mSqRingSize);
+    }
+
+    // Returns a zeroed submission entry, or nullptr if the submission queue is full.
+    io_uring_sqe* getSqe() {
+        unsigned head = __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE);
+        if (mSqTailLocal - head >= mSqEntries) return nullptr;
+        unsigned index = mSqTailLocal & mSqMask;
+        io_uring_sqe* sqe = &mSqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        mSqArray[index] = index;
+        mSqTailLocal++;
+        return sqe;
+    }
+
+    // Publishes all entries returned by getSqe() and waits for at least one completion.
+    void submitAndWait() {
+        __atomic_store_n(mSqTail, mSqTailLocal, __ATOMIC_RELEASE);
+        while (true) {
+            unsigned toSubmit = mSqTailLocal - __atomic_load_n(mSqHead, __ATOMIC_ACQUIRE);
+            int ret = static_cast<int>(syscall(__NR_io_uring_enter, mRingFd.get(), toSubmit, 1,
+                                               IORING_ENTER_GETEVENTS, nullptr, 0));
+            if (ret >= 0 || (errno == EINTR && hasCompletions())) return;
+            if (errno == EINTR) continue;
+            // Requests in flight still reference the caller's buffers, so there is no way to
+            // return an error from here safely.
+            LOG_ALWAYS_FATAL("io_uring_enter failed: %s", strerror(errno));
+        }
+    }
+
+    // Calls fn(userData, res) for every available completion.
+    template <typename Fn>
+    void reap(Fn fn) {
+        unsigned head = *mCqHead;
+        unsigned tail = __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            const io_uring_cqe& cqe = mCqes[head & mCqMask];
+            fn(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(mCqHead, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    explicit UringQueue(unique_fd ringFd) : mRingFd(std::move(ringFd)) {}
+
+    bool hasCompletions() const {
+        return *mCqHead != __atomic_load_n(mCqTail, __ATOMIC_ACQUIRE);
+    }
+
+    bool map(const io_uring_params& params) {
+        mSqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        mCqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMmap) {
+            mSqRingSize = mCqRingSize = std::max(mSqRingSize, mCqRingSize);
+        }
+
+        mSqRing = mmap(nullptr, mSqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       mRingFd.get(), IORING_OFF_SQ_RING);
+        if (mSqRing == MAP_FAILED) {
+            ALOGE("Could not map io_uring submission ring: %s", strerror(errno));
+            return false;
+        }
+        if (singleMmap) {
+            mCqRing = mSqRing;
+        } else {
+            mCqRing = mmap(nullptr, mCqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           mRingFd.get(), IORING_OFF_CQ_RING);
+            if (mCqRing == MAP_FAILED) {
+                ALOGE("Could not map io_uring completion ring: %s", strerror(errno));
+                return false;
+            }
+        }
+        mSqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap(nullptr, mSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          mRingFd.get(), IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            ALOGE("Could not map io_uring submission entries: %s", strerror(errno));
+            return false;
+        }
+        mSqes = static_cast<io_uring_sqe*>(sqes);
+
+        auto* sq = static_cast<uint8_t*>(mSqRing);
+        mSqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        mSqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        mSqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        mSqEntries = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+        mSqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        mSqTailLocal = *mSqTail;
+
+        auto* cq = static_cast<uint8_t*>(mCqRing);
+        mCqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        mCqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        mCqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        mCqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    unique_fd mRingFd;
+
+    void* mSqRing = MAP_FAILED;
+    size_t mSqRingSize = 0;
+    void* mCqRing = MAP_FAILED;
+    size_t mCqRingSize = 0;
+    io_uring_sqe* mSqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t mSqesSize = 0;
+
+    unsigned* mSqHead = nullptr;
+    unsigned* mSqTail = nullptr;
+    unsigned* mSqArray = nullptr;
+    unsigned mSqMask = 0;
+    unsigned mSqEntries = 0;
+    unsigned mSqTailLocal = 0;
+
+    unsigned* mCqHead = nullptr;
+    unsigned* mCqTail = nullptr;
+    unsigned mCqMask = 0;
+    io_uring_cqe* mCqes = nullptr;
+};
+
+} // namespace
+
+#endif // BINDER_RPC_WITH_IO_URING
+
+// RpcTransport with TLS disabled, using io_uring when it is available.
+class RpcTransportUring : public RpcTransport {
+public:
+    explicit RpcTransportUring(android::RpcTransportFd socket) : mSocket(std::move(socket)) {
+#ifdef BINDER_RPC_WITH_IO_URING
+        mQueue = UringQueue::make();
+#endif
+    }
+
+    status_t pollRead(void) override {
+        uint8_t buf;
+        ssize_t ret = TEMP_FAILURE_RETRY(
+                ::recv(mSocket.fd.get(), &buf, sizeof(buf), MSG_PEEK | MSG_DONTWAIT));
+        if (ret < 0) {
+            int savedErrno = errno;
+            if (savedErrno == EAGAIN || savedErrno == EWOULDBLOCK) {
+                return WOULD_BLOCK;
+            }
+
+            LOG_RPC_DETAIL("RpcTransport poll(): %s", strerror(savedErrno));
+            return -savedErrno;
+        } else if (ret == 0) {
+            return DEAD_OBJECT;
+        }
+
+        return OK;
+    }
+
+    status_t interruptableWriteFully(
+            FdTrigger* fdTrigger, iovec* iovs, int niovs,
+            const std::optional<SmallFunction<status_t()>>& altPoll,
+            const std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) override {
+#ifdef BINDER_RPC_WITH_IO_URING
+        // altPoll callers need sends to stay non-blocking so that they can drain incoming
+        // commands in between, which a blocking io_uring request can't offer. FDs are rare
+        // enough that they keep using sendMessageOnSocket for the control message.
+        if (mQueue != nullptr && !altPoll &&
+            (ancillaryFds == nullptr || ancillaryFds->empty())) {
+            return interruptableUringFully(fdTrigger, iovs, niovs, IORING_OP_SENDMSG,
+                                           MSG_NOSIGNAL, POLLOUT);
+        }
+#endif
+        bool sentFds = false;
+        auto send = [&](iovec* iovs, int niovs) -> ssize_t {
+            ssize_t ret = binder::os::sendMessageOnSocket(mSocket, iovs, niovs,
+                                                          sentFds ? nullptr : ancillaryFds);
+            sentFds |= ret > 0;
+            return ret;
+        };
+        return interruptableReadOrWrite(mSocket, fdTrigger, iovs, niovs, send, "sendmsg", POLLOUT,
+                                        altPoll);
+    }
+
+    status_t interruptableReadFully(
+            FdTrigger* fdTrigger, iovec* iovs, int niovs,
+            const std::optional<SmallFunction<status_t()>>& altPoll,
+            std::vector<std::variant<unique_fd, borrowed_fd>>* ancillaryFds) override {
+#ifdef BINDER_RPC_WITH_IO_URING
+        // Received FDs need the control message parsing in receiveMessageFromSocket.
+        if (mQueue != nullptr && !altPoll && ancillaryFds == nullptr) {
+            return interruptableUringFully(fdTrigger, iovs, niovs, IORING_OP_RECVMSG, 0, POLLIN);
+        }
+#endif
+        auto recv = [&](iovec* iovs, int niovs) -> ssize_t {
+            return binder::os::receiveMessageFromSocket(mSocket, iovs, niovs, ancillaryFds);
+        };
+        return interruptableReadOrWrite(mSocket, fdTrigger, iovs, niovs, recv, "recvmsg", POLLIN,
+                                        altPoll);
+    }
+
+    bool isWaiting() override { return mSocket.isInPollingState() || mWaiting; }
+
+private:
+#ifdef BINDER_RPC_WITH_IO_URING
+    // Like interruptableReadOrWrite, but each attempt is a single io_uring_enter. The socket is
+    // non-blocking, so a bare request would fail with EAGAIN instead of waiting. Each request is
+    // therefore linked behind a poll on the socket, and the kernel only issues it once the socket
+    // is ready. A poll request on the shutdown trigger stays armed on the same ring, so a
+    // trigger() wakes us up and the pending requests are cancelled.
+    status_t interruptableUringFully(FdTrigger* fdTrigger, iovec* iovs, int niovs, uint8_t opcode,
+                                     uint32_t msgFlags, int16_t event) {
+        MAYBE_WAIT_IN_FLAKE_MODE;
+
+        if (niovs < 0) {
+            return BAD_VALUE;
+        }
+
+        if (fdTrigger->isTriggered() || mTriggerFired) {
+            return DEAD_OBJECT;
+        }
+
+        // See interruptableReadOrWrite: trailing empty vectors would make a complete transfer
+        // look like a closed socket.
+        while (niovs > 0 && iovs[niovs - 1].iov_len == 0) {
+            niovs--;
+        }
+        if (niovs == 0) {
+            return OK;
+        }
+
+        if (mArmedTrigger == nullptr) {
+            io_uring_sqe* sqe = mQueue->getSqe();
+            LOG_ALWAYS_FATAL_IF(sqe == nullptr, "io_uring submission queue full");
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->fd = fdTrigger->readFd().get();
+            sqe->poll_events = POLLIN;
+            sqe->user_data = kUserDataTrigger;
+            mArmedTrigger = fdTrigger;
+        } else if (mArmedTrigger != fdTrigger) {
+            // Only one trigger can be armed per ring. Callers always pass the session's
+            // shutdown trigger, so this is not expected to be hit in practice.
+            auto sendOrReceive = [&](iovec* iovs, int niovs) -> ssize_t {
+                return opcode == IORING_OP_SENDMSG
+                        ? binder::os::sendMessageOnSocket(mSocket, iovs, niovs, nullptr)
+                        : binder::os::receiveMessageFromSocket(mSocket, iovs, niovs, nullptr);
+            };
+            return interruptableReadOrWrite(mSocket, fdTrigger, iovs, niovs, sendOrReceive,
+                                            opcode == IORING_OP_SENDMSG ? "sendmsg" : "recvmsg",
+                                            event, std::nullopt);
+        }
+
+        while (true) {
+            msghdr msg{
+                    .msg_iov = iovs,
+                    .msg_iovlen = static_cast<decltype(msg.msg_iovlen)>(niovs),
+            };
+            io_uring_sqe* poll = mQueue->getSqe();
+            LOG_ALWAYS_FATAL_IF(poll == nullptr, "io_uring submission queue full");
+            poll->opcode = IORING_OP_POLL_ADD;
+            poll->fd = mSocket.fd.get();
+            poll->poll_events = static_cast<uint16_t>(event);
+            poll->flags = IOSQE_IO_LINK;
+            poll->user_data = kUserDataSocketPoll;
+
+            io_uring_sqe* sqe = mQueue->getSqe();
+            LOG_ALWAYS_FATAL_IF(sqe == nullptr, "io_uring submission queue full");
+            sqe->opcode = opcode;
+            sqe->fd = mSocket.fd.get();
+            sqe->addr = reinterpret_cast<uint64_t>(&msg);
+            sqe->len = 1;
+            sqe->msg_flags = msgFlags;
+            sqe->user_data = kUserDataIo;
+
+            std::optional<int32_t> result;
+            bool cancelled = false;
+            mWaiting = true;
+            // The kernel references msg and iovs until the request completes, so even after a
+            // trigger we have to wait for the cancelled request to come back.
+            while (!result.has_value()) {
+                mQueue->submitAndWait();
+                mQueue->reap([&](uint64_t userData, int32_t res) {
+                    if (userData == kUserDataIo) result = res;
+                    if (userData == kUserDataTrigger) mTriggerFired = true;
+                });
+                if (mTriggerFired && !result.has_value() && !cancelled) {
+                    // Cancelling the socket poll fails the linked request if it hasn't been
+                    // issued yet. Otherwise the request itself is cancelled.
+                    for (uint64_t target : {kUserDataSocketPoll, kUserDataIo}) {
+                        io_uring_sqe* cancel = mQueue->getSqe();
+                        LOG_ALWAYS_FATAL_IF(cancel == nullptr, "io_uring submission queue full");
+                        cancel->opcode = IORING_OP_ASYNC_CANCEL;
+                        cancel->addr = target;
+                        cancel->user_data = kUserDataCancel;
+                    }
+                    cancelled = true;
+                }
+            }
+            mWaiting = false;
+
+            if (*result == -ECANCELED || (cancelled && *result < 0)) {
+                return DEAD_OBJECT;
+            }
+            if (*result == -EAGAIN || *result == -EWOULDBLOCK) {
+                // The socket was ready when the poll completed, but the data or buffer space went
+                // away before the request ran. Poll again through the ring.
+                continue;
+            }
+            if (*result < 0) {
+                LOG_RPC_DETAIL("RpcTransport io_uring op %u: %s", opcode, strerror(-*result));
+                return *result;
+            }
+            if (*result == 0) {
+                return DEAD_OBJECT;
+            }
+
+            size_t processSize = static_cast<size_t>(*result);
+            while (processSize > 0 && niovs > 0) {
+                auto& iov = iovs[0];
+                if (processSize < iov.iov_len) {
+                    // Advance the base of the current iovec
+                    iov.iov_base = reinterpret_cast<char*>(iov.iov_base) + processSize;
+                    iov.iov_len -= processSize;
+                    break;
+                }
+
+                // The current iovec was fully written
+                processSize -= iov.iov_len;
+                iovs++;
+                niovs--;
+            }
+            if (niovs == 0) {
+                LOG_ALWAYS_FATAL_IF(processSize > 0,
+                                    "Reached the end of iovecs "
+                                    "with %zu bytes remaining",
+                                    processSize);
+                return OK;
+            }
+
+            if (mTriggerFired) {
+                return DEAD_OBJECT;
+            }
+        }
+    }
+
+    std::unique_ptr<UringQueue> mQueue;
+    FdTrigger* mArmedTrigger = nullptr;
+    bool mTriggerFired = false;
+#endif // BINDER_RPC_WITH_IO_URING
+
+    android::RpcTransportFd mSocket;
+    std::atomic<bool> mWaiting = false;
+};
+
+// RpcTransportCtx with TLS disabled, using io_uring when it is available.
+class RpcTransportCtxUring : public RpcTransportCtx {
+public:
+    std::unique_ptr<RpcTransport> newTransport(android::RpcTransportFd socket,
+                                               FdTrigger*) const override {
+        return std::make_unique<RpcTransportUring>(std::move(socket));
+    }
+    std::vector<uint8_t> getCertificate(RpcCertificateFormat) const override { return {}; }
+};
+
+std::unique_ptr<RpcTransportCtx> RpcTransportCtxFactoryUring::newServerCtx() const {
+    return std::make_unique<RpcTransportCtxUring>();
+}
+
+std::unique_ptr<RpcTransportCtx> RpcTransportCtxFactoryUring::newClientCtx() const {
+    return std::make_unique<RpcTransportCtxUring>();
+}
+
+const char* RpcTransportCtxFactoryUring::toCString() const {
+    return "uring";
+}
+
+std::unique_ptr<RpcTransportCtxFactory> RpcTransportCtxFactoryUring::make() {
+    return std::unique_ptr<RpcTransportCtxFactoryUring>(new RpcTransportCtxFactoryUring());
+}
+
+} // namespace android
@@ -139,7 +139,11 @@ struct RpcWireTransaction {
     // The size of the Parcel data directly following RpcWireTransaction.
     uint32_t parcelDataSize;
 
-    uint32_t reserved[3];
+    // If non-zero, the Parcel data is compressed (see RpcCompression.h), and
+    // this is its size after decompression.
+    uint32_t uncompressedParcelDataSize;
+
+    uint32_t reserved[2];
 
     uint8_t data[];
 };
@@ -153,7 +157,13 @@ struct RpcWireReply {
     // The size of the Parcel data directly following RpcWireReply.
     uint32_t parcelDataSize;
 
-    uint32_t reserved[3];
+    // -- Fields below only used starting at protocol version 2 --
+
+    // If non-zero, the Parcel data is compressed (see RpcCompression.h), and
+    // this is its size after decompression.
+    uint32_t uncompressedParcelDataSize;
+
+    uint32_t reserved[2];
 
     // Byte size of RpcWireReply in the wire protocol.
     static size_t wireSize(uint32_t protocolVersion) {
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <binder/Common.h>
+#include <utils/Errors.h>
+
+namespace android {
+
+class IPCThreadState;
+
+/**
+ * While a BinderBatch is alive, oneway transactions over kernel binder made
+ * by the thread which created it are queued, and then sent to the driver
+ * with a single ioctl when the batch is flushed or destroyed. Transactions
+ * are sent in the order they were made, so the usual ordering guarantees
+ * for oneway transactions still hold.
+ *
+ * Because queued transactions aren't sent straight away, their errors are
+ * returned by flush() rather than by each transact() call. Transactions
+ * which wait for a reply are never batched, and send any queued
+ * transactions first. RPC binder transactions aren't batched.
+ *
+ * A BinderBatch must be destroyed on the thread which created it, and
+ * before that thread returns to the binder threadpool.
+ */
+class BinderBatch {
+public:
+    LIBBINDER_EXPORTED BinderBatch();
+    LIBBINDER_EXPORTED ~BinderBatch();
+
+    BinderBatch(const BinderBatch&) = delete;
+    BinderBatch& operator=(const BinderBatch&) = delete;
+
+    /**
+     * Sends the transactions queued so far, and returns the first error any
+     * of them got.
+     */
+    LIBBINDER_EXPORTED status_t flush();
+
+private:
+    IPCThreadState* mThreadState;
+};
+
+} // namespace android
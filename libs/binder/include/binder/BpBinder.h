@@ -18,10 +18,12 @@
 
 #include <binder/Common.h>
 #include <binder/IBinder.h>
+#include <binder/PendingTransaction.h>
 #include <binder/RpcThreads.h>
 #include <binder/unique_fd.h>
 
 #include <map>
+#include <memory>
 #include <optional>
 #include <unordered_map>
 #include <variant>
@@ -58,6 +60,26 @@ public:
     LIBBINDER_EXPORTED virtual status_t transact(uint32_t code, const Parcel& data, Parcel* reply,
                                                  uint32_t flags = 0) final;
 
+    /**
+     * Like transact, but returns once the transaction has been sent, so that
+     * the calling thread can do other work (including starting other
+     * transactions) before collecting the reply through 'pending'.
+     *
+     * For RPC binders, transactions are not multiplexed on a connection. Each
+     * pending transaction keeps an outgoing connection of the session
+     * reserved until its reply is read, so no more transactions can be
+     * pending at once than the session has outgoing connections (see
+     * RpcSession::setMaxOutgoingConnections). When none is available,
+     * WOULD_BLOCK is returned instead of waiting. For kernel binders and
+     * oneway transactions, this completes the transaction before returning.
+     *
+     * If this returns an error, the transaction was not sent and 'pending'
+     * is not set.
+     */
+    [[nodiscard]] LIBBINDER_EXPORTED status_t
+    transactAsync(uint32_t code, const Parcel& data, uint32_t flags,
+                  std::unique_ptr<PendingTransaction>* pending);
+
     // NOLINTNEXTLINE(google-default-arguments)
     LIBBINDER_EXPORTED virtual status_t linkToDeath(const sp<DeathRecipient>& recipient,
                                                     void* cookie = nullptr, uint32_t flags = 0);
@@ -188,6 +210,8 @@ private:
     uint64_t rpcAddress() const;
     const sp<RpcSession>& rpcSession() const;
 
+    [[nodiscard]] status_t checkStability(uint32_t code, bool privateVendor);
+
     explicit BpBinder(Handle&& handle);
     BpBinder(BinderHandle&& handle, int32_t trackedUid);
     explicit BpBinder(RpcHandle&& handle);
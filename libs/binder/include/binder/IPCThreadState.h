@@ -22,6 +22,9 @@
 #include <utils/Errors.h>
 #include <utils/Vector.h>
 
+#include <memory>
+#include <vector>
+
 #if defined(_WIN32)
 typedef  int  uid_t;
 #endif
@@ -33,7 +36,11 @@ namespace android {
  * Kernel binder thread state. All operations here refer to kernel binder. This
  * object is allocated per-thread.
  */
+class ParcelBufferPool;
+
 class IPCThreadState {
+    friend class Parcel;
+
 public:
     using CallRestriction = ProcessState::CallRestriction;
 
@@ -152,6 +159,18 @@ public:
     LIBBINDER_EXPORTED void flushCommands();
     LIBBINDER_EXPORTED bool flushIfNeeded();
 
+    // While a batch is open, oneway transactions made on this thread are
+    // queued instead of being sent, and the queued transactions are sent to
+    // the driver with a single ioctl when the batch is flushed or the last
+    // open batch ends. A full batch is flushed when the next transaction is
+    // queued, and an error from that flush is returned for that transaction,
+    // which is then not queued. Prefer BinderBatch over calling these directly.
+    LIBBINDER_EXPORTED void beginOnewayBatch();
+    // Sends any queued oneway transactions, and returns the first error any
+    // of them got.
+    LIBBINDER_EXPORTED status_t flushOnewayBatch();
+    LIBBINDER_EXPORTED status_t endOnewayBatch();
+
     // Adds the current thread into the binder threadpool.
     //
     // This is in addition to any threads which are started
@@ -208,6 +227,20 @@ public:
     // side.
     LIBBINDER_EXPORTED static const int32_t kUnsetWorkSource = -1;
 
+    // Counters for the pool which data buffers of Parcels used on this
+    // thread are allocated from.
+    struct ParcelBufferPoolStats {
+        // Allocations served with a buffer from the pool.
+        uint64_t hits = 0;
+        // Allocations which needed a new buffer.
+        uint64_t misses = 0;
+        // Buffers freed rather than kept because the pool was full.
+        uint64_t evictions = 0;
+        // Bytes currently kept by the pool.
+        size_t cachedBytes = 0;
+    };
+    LIBBINDER_EXPORTED ParcelBufferPoolStats getParcelBufferPoolStats() const;
+
 private:
     IPCThreadState();
     ~IPCThreadState();
@@ -218,6 +251,8 @@ private:
     [[nodiscard]] status_t writeTransactionData(int32_t cmd, uint32_t binderFlags, int32_t handle,
                                                 uint32_t code, const Parcel& data,
                                                 status_t* statusBuffer);
+    [[nodiscard]] status_t queueOnewayTransaction(uint32_t flags, int32_t handle, uint32_t code,
+                                                  const Parcel& data);
     [[nodiscard]] status_t getAndExecuteCommand();
     [[nodiscard]] status_t executeCommand(int32_t command);
     void processPendingDerefs();
@@ -235,6 +270,8 @@ private:
             Vector<RefBase::weakref_type*> mPendingWeakDerefs;
             Vector<RefBase*>    mPostWriteStrongDerefs;
             Vector<RefBase::weakref_type*> mPostWriteWeakDerefs;
+    // Declared before mIn and mOut, so it outlives them.
+    std::unique_ptr<ParcelBufferPool> mParcelBufferPool;
             Parcel              mIn;
             Parcel              mOut;
             status_t            mLastError;
@@ -254,6 +291,13 @@ private:
             int32_t             mStrictModePolicy;
             int32_t             mLastTransactionBinderFlags;
             CallRestriction     mCallRestriction;
+    // Number of open oneway batches.
+    size_t mOnewayBatchDepth;
+    // Oneway transactions written to mOut whose result hasn't been read.
+    size_t mOnewayBatchPending;
+    // Copies of the data of queued oneway transactions, since the driver
+    // only reads it when mOut is sent.
+    std::vector<std::unique_ptr<Parcel>> mOnewayBatchData;
 };
 
 } // namespace android
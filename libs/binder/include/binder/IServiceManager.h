@@ -149,6 +149,12 @@ public:
         int pid;
     };
     virtual std::vector<ServiceDebugInfo> getServiceDebugInfo() = 0;
+
+    /**
+     * Retrieve existing services. The result has one entry for each name,
+     * which is what checkService returns for it.
+     */
+    std::vector<sp<IBinder>> checkServices(const std::vector<String16>& names) const;
 };
 
 LIBBINDER_EXPORTED sp<IServiceManager> defaultServiceManager();
@@ -161,6 +167,13 @@ LIBBINDER_EXPORTED sp<IServiceManager> defaultServiceManager();
  */
 LIBBINDER_EXPORTED void setDefaultServiceManager(const sp<IServiceManager>& sm);
 
+/**
+ * Describes the process-wide cache of services looked up through the service
+ * manager, including how many lookups hit it, for use in dumps. The cache is
+ * only enabled in builds with LIBBINDER_CLIENT_CACHE.
+ */
+LIBBINDER_EXPORTED std::string dumpServiceCache();
+
 template<typename INTERFACE>
 sp<INTERFACE> waitForService(const String16& name) {
     const sp<IServiceManager> sm = defaultServiceManager();
@@ -74,6 +74,10 @@ public:
 
     LIBBINDER_EXPORTED const uint8_t* data() const;
     LIBBINDER_EXPORTED size_t dataSize() const;
+    // Bytes of caller-owned data referenced by the Parcel and sent along with
+    // data() (see writeByteArrayReference). dataPosition() counts these bytes,
+    // but dataSize() only counts the data the Parcel holds.
+    LIBBINDER_EXPORTED size_t externalDataSize() const;
     LIBBINDER_EXPORTED size_t dataAvail() const;
     LIBBINDER_EXPORTED size_t dataPosition() const;
     LIBBINDER_EXPORTED size_t dataCapacity() const;
@@ -190,6 +194,15 @@ public:
     LIBBINDER_EXPORTED status_t writeStrongBinder(const sp<IBinder>& val);
     LIBBINDER_EXPORTED status_t writeInt32Array(size_t len, const int32_t* val);
     LIBBINDER_EXPORTED status_t writeByteArray(size_t len, const uint8_t* val);
+    // Same wire format as writeByteArray, but for RPC Parcels, large arrays
+    // are referenced instead of being copied into the Parcel, and are sent
+    // directly from `val` using scatter-gather I/O. `val` must remain valid
+    // and unmodified until the Parcel is sent, rewritten or freed. Small
+    // arrays, and all arrays in kernel binder Parcels, are copied as usual.
+    //
+    // A Parcel which references external data can be repositioned to
+    // overwrite data it already contains, but it can't be read back.
+    LIBBINDER_EXPORTED status_t writeByteArrayReference(size_t len, const uint8_t* val);
     LIBBINDER_EXPORTED status_t writeBool(bool val);
     LIBBINDER_EXPORTED status_t writeChar(char16_t val);
     LIBBINDER_EXPORTED status_t writeByte(int8_t val);
@@ -669,6 +682,13 @@ private:
             std::vector<std::variant<binder::unique_fd, binder::borrowed_fd>>&& ancillaryFds,
             release_func relFunc);
 
+    // Data buffers come from the calling thread's ParcelBufferPool when it
+    // has an IPCThreadState. `capacity` is updated to the size allocated.
+    static uint8_t* allocateData(size_t* capacity);
+    static void releaseData(uint8_t* data, size_t capacity);
+    static uint8_t* reallocateData(uint8_t* data, size_t oldCapacity, size_t* newCapacity,
+                                   bool zero);
+
     status_t            finishWrite(size_t len);
     void                releaseObjects();
     void                acquireObjects();
@@ -679,6 +699,11 @@ private:
     // Set the capacity to `desired`, truncating the Parcel if necessary.
     status_t            continueWrite(size_t desired);
     status_t truncateRpcObjects(size_t newObjectsSize);
+    // Bytes of external data sent before position `pos` in mData.
+    size_t externalDataSizeBefore(size_t pos) const;
+    // Maps a position in the wire data, including external data, to the
+    // corresponding position in mData.
+    size_t externalToDataPosition(size_t pos) const;
     status_t            writePointer(uintptr_t val);
     status_t            readPointer(uintptr_t *pArg) const;
     uintptr_t           readPointer() const;
@@ -1364,6 +1389,25 @@ private:
         //
         // Boxed to save space. Lazy allocated.
         std::unique_ptr<std::vector<std::variant<binder::unique_fd, binder::borrowed_fd>>> mFds;
+
+        // Caller-owned data spliced into the wire data instead of being
+        // copied into mData (see writeByteArrayReference).
+        struct ExternalSegment {
+            // Position in mData that the segment is sent before.
+            size_t position;
+            const uint8_t* data;
+            size_t size;
+            // Zero bytes sent after `data` to keep the wire data aligned.
+            size_t padding;
+        };
+        struct ExternalData {
+            // Sorted by position.
+            std::vector<ExternalSegment> segments;
+            // Total bytes of `segments` on the wire, including padding.
+            size_t size = 0;
+        };
+        // Boxed to save space. Lazy allocated.
+        std::unique_ptr<ExternalData> mExternalData;
     };
     std::variant<KernelFields, RpcFields> mVariantFields;
 
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <binder/Common.h>
+#include <utils/Errors.h>
+
+namespace android {
+
+class Parcel;
+
+/**
+ * A synchronous transaction which has been sent, but whose reply has not
+ * been read yet. See BpBinder::transactAsync.
+ *
+ * This object is not thread-safe, but it may be passed to and completed on a
+ * different thread than the one which started the transaction.
+ */
+class LIBBINDER_EXPORTED PendingTransaction {
+public:
+    /**
+     * If the reply was never read, this blocks until it arrives and
+     * discards it.
+     */
+    virtual ~PendingTransaction() = default;
+
+    /**
+     * Whether waitForReply would return without blocking on the remote
+     * process. This may return false positives (e.g. when the remote process
+     * calls back into this one before replying), but never false negatives.
+     */
+    [[nodiscard]] virtual bool isReady() = 0;
+
+    /**
+     * Blocks until the reply arrives, and reads it into 'reply'. The status
+     * is the one which transact would have returned. This may only be called
+     * once.
+     */
+    [[nodiscard]] virtual status_t waitForReply(Parcel* reply) = 0;
+};
+
+} // namespace android
@@ -156,6 +156,12 @@ public:
     LIBBINDER_EXPORTED void setSupportedFileDescriptorTransportModes(
             const std::vector<RpcSession::FileDescriptorTransportMode>& modes);
 
+    /**
+     * Calls RpcSession::setCompressionEnabled on sessions created after this
+     * call. Disabled by default.
+     */
+    LIBBINDER_EXPORTED void setCompressionEnabled(bool enabled);
+
     /**
      * The root object can be retrieved by any client, without any
      * authentication. TODO(b/183988761)
@@ -276,6 +282,7 @@ private:
     // A mode is supported if the N'th bit is on, where N is the mode enum's value.
     std::bitset<8> mSupportedFileDescriptorTransportModes = std::bitset<8>().set(
             static_cast<size_t>(RpcSession::FileDescriptorTransportMode::NONE));
+    bool mCompressionEnabled = false;
     RpcTransportFd mServer; // socket we are accepting sessions on
 
     RpcMutex mLock; // for below
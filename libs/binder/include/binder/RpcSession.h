@@ -17,13 +17,16 @@
 
 #include <binder/Common.h>
 #include <binder/IBinder.h>
+#include <binder/PendingTransaction.h>
 #include <binder/RpcThreads.h>
 #include <binder/RpcTransport.h>
 #include <binder/unique_fd.h>
 #include <utils/Errors.h>
 #include <utils/RefBase.h>
 
+#include <atomic>
 #include <map>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -47,6 +50,16 @@ constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION = 1;
 // * RpcWireTransaction and RpcWireReplyV1 include the parcel data size.
 constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_EXPLICIT_PARCEL_SIZE = 1;
 
+// Starting with this version:
+//
+// * The Parcel data in RpcWireTransaction and RpcWireReply may be compressed,
+//   as indicated by a non-zero uncompressedParcelDataSize.
+//
+// Not released yet, so this is only used by sessions which negotiate
+// RPC_WIRE_PROTOCOL_VERSION_EXPERIMENTAL.
+constexpr uint32_t RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_COMPRESSION =
+        RPC_WIRE_PROTOCOL_VERSION_NEXT;
+
 /**
  * This represents a session (group of connections) between a client
  * and a server. Multiple connections are needed for multiple parallel "binder"
@@ -116,6 +129,19 @@ public:
     LIBBINDER_EXPORTED void setFileDescriptorTransportMode(FileDescriptorTransportMode mode);
     LIBBINDER_EXPORTED FileDescriptorTransportMode getFileDescriptorTransportMode();
 
+    /**
+     * Whether to compress the data of large transactions and replies sent on
+     * this session. This trades CPU time for bandwidth, so it is only
+     * worthwhile on slow links, e.g. between VMs or over a network. It has no
+     * effect unless the protocol version of the session is at least
+     * RPC_WIRE_PROTOCOL_VERSION_RPC_HEADER_FEATURE_COMPRESSION, which is
+     * currently only the case for RPC_WIRE_PROTOCOL_VERSION_EXPERIMENTAL.
+     * Compressed data is always accepted from the other side. Disabled by
+     * default.
+     */
+    LIBBINDER_EXPORTED void setCompressionEnabled(bool enabled);
+    LIBBINDER_EXPORTED bool isCompressionEnabled();
+
     /**
      * This should be called once per thread, matching 'join' in the remote
      * process.
@@ -197,6 +223,18 @@ public:
                                                        const Parcel& data, Parcel* reply,
                                                        uint32_t flags);
 
+    /**
+     * Sends a synchronous transaction on an available outgoing connection,
+     * which stays reserved for it until its reply is read through 'pending'.
+     * Returns WOULD_BLOCK, rather than waiting, if all outgoing connections
+     * are in use, so the number of pending transactions is bounded by the
+     * number of outgoing connections. Generally, use
+     * BpBinder::transactAsync instead.
+     */
+    [[nodiscard]] LIBBINDER_EXPORTED status_t transactAsync(
+            const sp<IBinder>& binder, uint32_t code, const Parcel& data, uint32_t flags,
+            std::unique_ptr<PendingTransaction>* pending);
+
     /**
      * Generally, you should not call this, unless you are testing error
      * conditions, as this is called automatically by BpBinders when they are
@@ -268,8 +306,20 @@ private:
         std::optional<uint64_t> exclusiveTid;
 
         bool allowNested = false;
+
+        // Scratch space for compressing data sent on this connection, reused
+        // so that large transactions don't allocate and clear it every time.
+        // Only used by the thread which is sending on the connection.
+        std::unique_ptr<uint8_t[]> compressionBuffer;
+        size_t compressionBufferSize = 0;
+        std::unique_ptr<uint32_t[]> compressionTable;
     };
 
+    // Value of RpcConnection::exclusiveTid while a connection is reserved for
+    // the reply of a transaction started by transactAsync.
+    static constexpr uint64_t kPendingReplyTid = UINT64_MAX;
+    class PendingReply;
+
     [[nodiscard]] status_t readId();
 
     // A thread joining a server must always call these functions in order, and
@@ -324,6 +374,8 @@ private:
         CLIENT,
         CLIENT_ASYNC,
         CLIENT_REFCOUNT,
+        // only takes an available connection, and never waits for one
+        CLIENT_PENDING,
     };
 
     // Object representing exclusive access to a connection.
@@ -334,6 +386,9 @@ private:
 
         ~ExclusiveConnection();
         const sp<RpcConnection>& get() { return mConnection; }
+        // Keeps the connection reserved past the lifetime of this object.
+        // The caller must eventually call clearConnectionTid on it.
+        sp<RpcConnection> release();
 
     private:
         static void findConnection(uint64_t tid, sp<RpcConnection>* exclusive,
@@ -380,6 +435,8 @@ private:
 
     std::unique_ptr<RpcState> mRpcBinderState;
 
+    std::atomic<bool> mCompressionEnabled = false;
+
     RpcMutex mMutex; // for all below
 
     bool mStartedSetup = false;
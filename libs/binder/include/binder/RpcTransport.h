@@ -45,10 +45,14 @@ class RpcTransportRaw;
 class RpcTransportTls;
 class RpcTransportTipcAndroid;
 class RpcTransportTipcTrusty;
+class RpcTransportUring;
+class RpcTransportShm;
 class RpcTransportCtxRaw;
 class RpcTransportCtxTls;
 class RpcTransportCtxTipcAndroid;
 class RpcTransportCtxTipcTrusty;
+class RpcTransportCtxUring;
+class RpcTransportCtxShm;
 
 // Represents a socket connection.
 // No thread-safety is guaranteed for these APIs.
@@ -118,6 +122,8 @@ private:
     friend class ::android::RpcTransportTls;
     friend class ::android::RpcTransportTipcAndroid;
     friend class ::android::RpcTransportTipcTrusty;
+    friend class ::android::RpcTransportUring;
+    friend class ::android::RpcTransportShm;
 
     RpcTransport() = default;
 };
@@ -149,6 +155,8 @@ private:
     friend class ::android::RpcTransportCtxTls;
     friend class ::android::RpcTransportCtxTipcAndroid;
     friend class ::android::RpcTransportCtxTipcTrusty;
+    friend class ::android::RpcTransportCtxUring;
+    friend class ::android::RpcTransportCtxShm;
 
     RpcTransportCtx() = default;
 };
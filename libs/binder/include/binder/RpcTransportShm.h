@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Wraps the transport layer of RPC. Implementation uses shared memory rings between processes on
+// the same host.
+// Note: don't use directly. You probably want newServerRpcTransportCtx / newClientRpcTransportCtx.
+
+#pragma once
+
+#include <memory>
+
+#include <binder/Common.h>
+#include <binder/RpcTransport.h>
+
+namespace android {
+
+// RpcTransportCtxFactory with TLS disabled, which moves data through a pair of shared memory
+// rings (one per direction) instead of the socket.
+//
+// When a connection is created over a Unix domain socket, the client sends a memfd holding both
+// rings and two eventfds to the server. Afterwards the socket is only used to detect hangups and
+// to pass file descriptors. Writes that find the peer already running cost no syscalls; otherwise
+// the peer is woken through its eventfd. Connections over other socket types, or where shared
+// memory can't be set up, transparently use the socket like RpcTransportCtxFactoryRaw.
+//
+// Both sides of a connection must use this factory. Like TLS, it can't be used with
+// RpcSession::setupUnixDomainSocketBootstrapClient.
+class RpcTransportCtxFactoryShm : public RpcTransportCtxFactory {
+public:
+    LIBBINDER_EXPORTED static std::unique_ptr<RpcTransportCtxFactory> make();
+
+    LIBBINDER_EXPORTED std::unique_ptr<RpcTransportCtx> newServerCtx() const override;
+    LIBBINDER_EXPORTED std::unique_ptr<RpcTransportCtx> newClientCtx() const override;
+    LIBBINDER_EXPORTED const char* toCString() const override;
+
+private:
+    RpcTransportCtxFactoryShm() = default;
+};
+
+} // namespace android
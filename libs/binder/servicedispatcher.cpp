@@ -185,6 +185,11 @@ public:
             std::vector<android::os::ServiceDebugInfo>* _aidl_return) override {
         return mImpl->getServiceDebugInfo(_aidl_return);
     }
+    android::binder::Status getServices(const std::vector<std::string>&,
+                                        std::vector<android::os::Service>*) override {
+        // We can't send BpBinder for regular binder over RPC.
+        return android::binder::Status::fromStatusT(android::INVALID_OPERATION);
+    }
 
 private:
     sp<android::os::IServiceManager> mImpl;
@@ -17,6 +17,7 @@
 #include <android-base/logging.h>
 #include <binder/Binder.h>
 #include <binder/Functional.h>
+#include <binder/IPCThreadState.h>
 #include <binder/IServiceManager.h>
 #include <binder/Parcel.h>
 #include <binder/RpcServer.h>
@@ -27,6 +28,7 @@
 
 #include <malloc.h>
 #include <functional>
+#include <thread>
 #include <vector>
 
 using namespace android::binder::impl;
@@ -213,15 +215,38 @@ TEST(BinderAllocation, SmallTransaction) {
     String16 empty_descriptor = String16("");
     sp<IServiceManager> manager = defaultServiceManager();
 
-    size_t mallocs = 0;
-    const auto on_malloc = OnMalloc([&](size_t bytes) {
-        mallocs++;
-        // Parcel should allocate a small amount by default
-        EXPECT_EQ(bytes, 128u);
-    });
-    manager->checkService(empty_descriptor);
+    // Transact from a new thread, so that its Parcel buffer pool is still
+    // empty and the Parcel has to allocate.
+    std::thread([&]() {
+        IPCThreadState::self();
 
-    EXPECT_EQ(mallocs, 1u);
+        size_t mallocs = 0;
+        const auto on_malloc = OnMalloc([&](size_t bytes) {
+            mallocs++;
+            // Parcel should allocate a small amount by default
+            EXPECT_EQ(bytes, 128u);
+        });
+        manager->checkService(empty_descriptor);
+
+        EXPECT_EQ(mallocs, 1u);
+    }).join();
+}
+
+TEST(BinderAllocation, RepeatedSmallTransaction) {
+    String16 empty_descriptor = String16("");
+    sp<IServiceManager> manager = defaultServiceManager();
+    manager->checkService(empty_descriptor); // fills the Parcel buffer pool
+
+    auto before = IPCThreadState::self()->getParcelBufferPoolStats();
+    {
+        const auto m = ScopeDisallowMalloc();
+        manager->checkService(empty_descriptor);
+        manager->checkService(empty_descriptor);
+    }
+    auto after = IPCThreadState::self()->getParcelBufferPoolStats();
+
+    EXPECT_EQ(after.hits, before.hits + 2);
+    EXPECT_EQ(after.misses, before.misses);
 }
 
 TEST(RpcBinderAllocation, SetupRpcServer) {
@@ -24,6 +24,8 @@
 #include "fakeservicemanager/FakeServiceManager.h"
 
 #include <sys/prctl.h>
+#include <algorithm>
+#include <map>
 #include <thread>
 
 using namespace android;
@@ -63,6 +65,7 @@ public:
     MockAidlServiceManager() : innerSm() {}
 
     binder::Status checkService(const ::std::string& name, os::Service* _out) override {
+        lookups++;
         sp<IBinder> binder = innerSm.getService(String16(name.c_str()));
         *_out = os::Service::make<os::Service::Tag::binder>(binder);
         return binder::Status::ok();
@@ -70,18 +73,46 @@ public:
 
     binder::Status addService(const std::string& name, const sp<IBinder>& service,
                               bool allowIsolated, int32_t dumpPriority) override {
-        return binder::Status::fromStatusT(
-                innerSm.addService(String16(name.c_str()), service, allowIsolated, dumpPriority));
+        status_t status =
+                innerSm.addService(String16(name.c_str()), service, allowIsolated, dumpPriority);
+        if (status == OK) {
+            for (const auto& callback : callbacks[name]) {
+                callback->onRegistration(name, service);
+            }
+        }
+        return binder::Status::fromStatusT(status);
+    }
+
+    binder::Status registerForNotifications(const std::string& name,
+                                            const sp<os::IServiceCallback>& callback) override {
+        callbacks[name].push_back(callback);
+        if (sp<IBinder> binder = innerSm.getService(String16(name.c_str())); binder != nullptr) {
+            callback->onRegistration(name, binder);
+        }
+        return binder::Status::ok();
+    }
+
+    binder::Status unregisterForNotifications(const std::string& name,
+                                              const sp<os::IServiceCallback>& callback) override {
+        auto& nameCallbacks = callbacks[name];
+        auto it = std::find(nameCallbacks.begin(), nameCallbacks.end(), callback);
+        if (it == nameCallbacks.end()) {
+            return binder::Status::fromExceptionCode(binder::Status::EX_ILLEGAL_STATE);
+        }
+        nameCallbacks.erase(it);
+        return binder::Status::ok();
     }
 
     FakeServiceManager innerSm;
+    std::map<std::string, std::vector<sp<os::IServiceCallback>>> callbacks;
+    std::atomic<size_t> lookups = 0;
 };
 
 class LibbinderCacheTest : public ::testing::Test {
 protected:
     void SetUp() override {
-        sp<MockAidlServiceManager> sm = sp<MockAidlServiceManager>::make();
-        mServiceManager = getServiceManagerShimFromAidlServiceManagerForTests(sm);
+        mAidlServiceManager = sp<MockAidlServiceManager>::make();
+        mServiceManager = getServiceManagerShimFromAidlServiceManagerForTests(mAidlServiceManager);
     }
 
     void TearDown() override {}
@@ -94,20 +125,21 @@ public:
         sp<IBinder> result = mServiceManager->checkService(kCachedServiceName);
         ASSERT_EQ(binder1, result);
 
-        // Add the different binder and replace the service.
-        // The cache should still hold the original binder.
+        // With the cache, getting it again doesn't look it up.
+        size_t lookups = mAidlServiceManager->lookups;
+        result = mServiceManager->checkService(kCachedServiceName);
+        ASSERT_EQ(binder1, result);
+        EXPECT_EQ(kUseLibbinderCache ? lookups : lookups + 1, mAidlServiceManager->lookups);
+
+        // Add the different binder and replace the service. The cache is
+        // notified of the registration, so we get the newer binder.
         EXPECT_EQ(OK, mServiceManager->addService(kCachedServiceName, binder2));
 
         result = mServiceManager->checkService(kCachedServiceName);
-        if (kUseLibbinderCache) {
-            // If cache is enabled, we should get the binder to Service Manager.
-            EXPECT_EQ(binder1, result);
-        } else {
-            // If cache is disabled, then we should get the newer binder
-            EXPECT_EQ(binder2, result);
-        }
+        EXPECT_EQ(binder2, result);
     }
 
+    sp<MockAidlServiceManager> mAidlServiceManager;
     sp<android::IServiceManager> mServiceManager;
 };
 
@@ -189,6 +221,31 @@ TEST_F(LibbinderCacheTest, DoNotCacheServiceNotInList) {
     EXPECT_EQ(binder2, result);
 }
 
+TEST_F(LibbinderCacheTest, NullBinderNotWatched) {
+    // Check for a cachable service which isn't registered.
+    sp<IBinder> result = mServiceManager->checkService(kCachedServiceName);
+    ASSERT_EQ(nullptr, result);
+
+    // Nothing was cached, so the cache doesn't keep listening for it.
+    EXPECT_TRUE(mAidlServiceManager->callbacks["isub"].empty());
+}
+
+TEST_F(LibbinderCacheTest, ServiceNotInListLookedUpEveryTime) {
+    sp<IBinder> binder1 = sp<BBinder>::make();
+    String16 serviceName = String16("NewLibbinderCacheTest");
+    EXPECT_EQ(OK, mServiceManager->addService(serviceName, binder1));
+
+    // Services outside the static list, e.g. lazy services, are always looked
+    // up, so that the cache doesn't keep them running.
+    size_t lookups = mAidlServiceManager->lookups;
+    sp<IBinder> result = mServiceManager->checkService(serviceName);
+    ASSERT_EQ(binder1, result);
+    result = mServiceManager->checkService(serviceName);
+    ASSERT_EQ(binder1, result);
+    EXPECT_EQ(lookups + 2, mAidlServiceManager->lookups);
+    EXPECT_TRUE(mAidlServiceManager->callbacks["NewLibbinderCacheTest"].empty());
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
 
@@ -31,6 +31,7 @@
 #include <android-base/properties.h>
 #include <android-base/result-gmock.h>
 #include <binder/Binder.h>
+#include <binder/BinderBatch.h>
 #include <binder/BpBinder.h>
 #include <binder/Functional.h>
 #include <binder/IBinder.h>
@@ -789,6 +790,36 @@ TEST_F(BinderLibTest, IndirectGetId3)
     EXPECT_EQ(reply.dataSize(), reply.dataPosition());
 }
 
+TEST_F(BinderLibTest, OnewayBatch) {
+    sp<BinderLibTestCallBack> callBack = new BinderLibTestCallBack();
+    {
+        BinderBatch batch;
+        for (int i = 0; i < 10; i++) {
+            Parcel data;
+            EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, nullptr,
+                                           TF_ONE_WAY),
+                        StatusEq(NO_ERROR));
+        }
+        Parcel data;
+        data.writeStrongBinder(callBack);
+        EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_CALL_BACK, data, nullptr, TF_ONE_WAY),
+                    StatusEq(NO_ERROR));
+        EXPECT_THAT(batch.flush(), StatusEq(NO_ERROR));
+    }
+    EXPECT_THAT(callBack->waitEvent(5), StatusEq(NO_ERROR));
+    EXPECT_THAT(callBack->getResult(), StatusEq(NO_ERROR));
+}
+
+TEST_F(BinderLibTest, OnewayBatchSentBeforeTwoway) {
+    BinderBatch batch;
+    Parcel data, reply;
+    EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, nullptr, TF_ONE_WAY),
+                StatusEq(NO_ERROR));
+    EXPECT_THAT(m_server->transact(BINDER_LIB_TEST_NOP_TRANSACTION, data, &reply),
+                StatusEq(NO_ERROR));
+    EXPECT_THAT(batch.flush(), StatusEq(NO_ERROR));
+}
+
 TEST_F(BinderLibTest, CallBack)
 {
     Parcel data, reply;
@@ -118,6 +118,7 @@ enum Transport {
     KERNEL,
     RPC,
     RPC_TLS,
+    RPC_COMPRESSED,
 };
 
 static const std::initializer_list<int64_t> kTransportList = {
@@ -126,6 +127,7 @@ static const std::initializer_list<int64_t> kTransportList = {
 #endif
         Transport::RPC,
         Transport::RPC_TLS,
+        Transport::RPC_COMPRESSED,
 };
 
 std::unique_ptr<RpcTransportCtxFactory> makeFactoryTls() {
@@ -145,6 +147,14 @@ static sp<IBinder> gRpcBinder;
 // Skip certificate validation to simplify the setup process.
 static sp<RpcSession> gSessionTls = RpcSession::make(makeFactoryTls());
 static sp<IBinder> gRpcTlsBinder;
+// Same as gSession, but with large transactions and replies compressed.
+static sp<RpcSession> gSessionCompressed = RpcSession::make();
+static sp<IBinder> gRpcCompressedBinder;
+// Session with a connection (and server thread) for each benchmark thread, so
+// that contention is only on the state shared by the session.
+static constexpr size_t kMaxContendingThreads = 64;
+static sp<RpcSession> gSessionMultiThreaded = RpcSession::make();
+static sp<IBinder> gRpcMultiThreadedBinder;
 #ifdef __BIONIC__
 static const String16 kKernelBinderInstance = String16(u"binderRpcBenchmark-control");
 static sp<IBinder> gKernelBinder;
@@ -161,6 +171,8 @@ static sp<IBinder> getBinderForOptions(benchmark::State& state) {
             return gRpcBinder;
         case RPC_TLS:
             return gRpcTlsBinder;
+        case RPC_COMPRESSED:
+            return gRpcCompressedBinder;
         default:
             LOG(FATAL) << "Unknown transport value: " << transport;
             return nullptr;
@@ -181,6 +193,9 @@ static void SetLabel(benchmark::State& state) {
         case RPC_TLS:
             state.SetLabel("rpc_tls");
             break;
+        case RPC_COMPRESSED:
+            state.SetLabel("rpc_compressed");
+            break;
         default:
             LOG(FATAL) << "Unknown transport value: " << transport;
     }
@@ -301,6 +316,24 @@ void BM_repeatBinder(benchmark::State& state) {
 }
 BENCHMARK(BM_repeatBinder)->ArgsProduct({kTransportList});
 
+// Like BM_repeatBinder, but from many threads sharing one session. Each call
+// adds and removes a node in the session's binder table on both sides.
+void BM_repeatBinderContended(benchmark::State& state) {
+    sp<IBinderRpcBenchmark> iface = interface_cast<IBinderRpcBenchmark>(gRpcMultiThreadedBinder);
+    CHECK(iface != nullptr);
+
+    for (auto _ : state) {
+        sp<IBinder> binder = sp<BBinder>::make();
+
+        sp<IBinder> out;
+        Status ret = iface->repeatBinder(binder, &out);
+        CHECK(ret.isOk()) << ret;
+    }
+
+    state.SetLabel("rpc");
+}
+BENCHMARK(BM_repeatBinderContended)->ThreadRange(1, kMaxContendingThreads)->UseRealTime();
+
 void forkRpcServer(const char* addr, const sp<RpcServer>& server) {
     if (0 == fork()) {
         prctl(PR_SET_PDEATHSIG, SIGHUP); // racey, okay
@@ -356,6 +389,28 @@ int main(int argc, char** argv) {
     setupClient(gSessionTls, tlsAddr.c_str());
     gRpcTlsBinder = gSessionTls->getRootObject();
 
+    std::string compressedAddr = tmp + "/binderRpcCompressedBenchmark";
+    (void)unlink(compressedAddr.c_str());
+    sp<RpcServer> compressedServer = RpcServer::make(RpcTransportCtxFactoryRaw::make());
+    // Compression is only in the experimental protocol version for now. On
+    // release builds, these fail and nothing is compressed.
+    (void)compressedServer->setProtocolVersion(RPC_WIRE_PROTOCOL_VERSION_EXPERIMENTAL);
+    compressedServer->setCompressionEnabled(true);
+    forkRpcServer(compressedAddr.c_str(), compressedServer);
+    (void)gSessionCompressed->setProtocolVersion(RPC_WIRE_PROTOCOL_VERSION_EXPERIMENTAL);
+    gSessionCompressed->setCompressionEnabled(true);
+    setupClient(gSessionCompressed, compressedAddr.c_str());
+    gRpcCompressedBinder = gSessionCompressed->getRootObject();
+
+    std::string multiThreadedAddr = tmp + "/binderRpcMultiThreadedBenchmark";
+    (void)unlink(multiThreadedAddr.c_str());
+    sp<RpcServer> multiThreadedServer = RpcServer::make(RpcTransportCtxFactoryRaw::make());
+    multiThreadedServer->setMaxThreads(kMaxContendingThreads);
+    forkRpcServer(multiThreadedAddr.c_str(), multiThreadedServer);
+    gSessionMultiThreaded->setMaxOutgoingConnections(kMaxContendingThreads);
+    setupClient(gSessionMultiThreaded, multiThreadedAddr.c_str());
+    gRpcMultiThreadedBinder = gSessionMultiThreaded->getRootObject();
+
     ::benchmark::RunSpecifiedBenchmarks();
     return 0;
 }
@@ -485,6 +485,59 @@ TEST_P(BinderRpc, ThreadPoolGreaterThanEqualRequested) {
     for (auto& t : ts) t.join();
 }
 
+TEST_P(BinderRpc, TransactAsyncOnOneThread) {
+    if (clientOrServerSingleThreaded()) {
+        GTEST_SKIP() << "This test requires multiple threads";
+    }
+
+    constexpr size_t kNumThreads = 3;
+
+    auto proc = createRpcTestSocketServerProcess({.numThreads = kNumThreads});
+    BpBinder* bpBinder = proc.rootBinder->remoteBinder();
+    ASSERT_NE(nullptr, bpBinder);
+
+    EXPECT_OK(proc.rootIface->lock());
+
+    auto startLockUnlock = [&](std::unique_ptr<PendingTransaction>* pending) {
+        Parcel data;
+        data.markForBinder(proc.rootBinder);
+        EXPECT_EQ(OK, data.writeInterfaceToken(IBinderRpcTest::descriptor));
+        return bpBinder->transactAsync(BnBinderRpcTest::TRANSACTION_lockUnlock, data, 0, pending);
+    };
+
+    // each of these blocks a server thread and reserves a client connection
+    std::vector<std::unique_ptr<PendingTransaction>> pendings(kNumThreads - 1);
+    for (auto& pending : pendings) {
+        ASSERT_EQ(OK, startLockUnlock(&pending));
+        ASSERT_NE(nullptr, pending);
+    }
+
+    // other calls on this thread still work
+    EXPECT_EQ(OK, proc.rootBinder->pingBinder());
+
+    // all connections are in use while the ping is in flight, but this
+    // doesn't wait for one to become free
+    std::unique_ptr<PendingTransaction> pingPending;
+    Parcel pingData;
+    pingData.markForBinder(proc.rootBinder);
+    ASSERT_EQ(OK, bpBinder->transactAsync(IBinder::PING_TRANSACTION, pingData, 0, &pingPending));
+    std::unique_ptr<PendingTransaction> extra;
+    EXPECT_EQ(WOULD_BLOCK, startLockUnlock(&extra));
+    EXPECT_EQ(nullptr, extra);
+    Parcel pingReply;
+    EXPECT_EQ(OK, pingPending->waitForReply(&pingReply));
+
+    EXPECT_OK(proc.rootIface->unlockInMsAsync(0));
+
+    for (auto& pending : pendings) {
+        Parcel reply;
+        ASSERT_EQ(OK, pending->waitForReply(&reply));
+        binder::Status status;
+        ASSERT_EQ(OK, status.readFromParcel(reply));
+        EXPECT_OK(status);
+    }
+}
+
 static void testThreadPoolOverSaturated(sp<IBinderRpcTest> iface, size_t numCalls, size_t sleepMs) {
     size_t epochMsBefore = epochMillis();
 
@@ -1471,6 +1524,17 @@ static std::vector<BinderRpc::ParamType> getBinderRpcParams() {
         }
     }
 
+    for (const auto& security : extraTransportValues()) {
+        ret.push_back(BinderRpc::ParamType{
+                .type = SocketType::UNIX,
+                .security = security,
+                .clientVersion = RPC_WIRE_PROTOCOL_VERSION,
+                .serverVersion = RPC_WIRE_PROTOCOL_VERSION,
+                .singleThreaded = false,
+                .noKernel = !kEnableKernelIpcTesting,
+        });
+    }
+
     return ret;
 }
 
@@ -1941,10 +2005,18 @@ public:
                             ret.emplace_back(socketType, rpcSecurity, RpcCertificateFormat::DER,
                                              serverVersion);
                         } break;
+                        case RpcSecurity::URING:
+                        case RpcSecurity::SHM:
+                            // Not in RpcSecurityValues(), see extraTransportValues().
+                            break;
                     }
                 }
             }
         }
+        for (auto rpcSecurity : extraTransportValues()) {
+            ret.emplace_back(SocketType::UNIX, rpcSecurity, std::nullopt,
+                             RPC_WIRE_PROTOCOL_VERSION);
+        }
         return ret;
     }
     template <typename A, typename B>
@@ -31,6 +31,8 @@
 #include <binder/RpcThreads.h>
 #include <binder/RpcTransport.h>
 #include <binder/RpcTransportRaw.h>
+#include <binder/RpcTransportShm.h>
+#include <binder/RpcTransportUring.h>
 #include <unistd.h>
 #include <cinttypes>
 #include <string>
@@ -72,12 +74,19 @@ constexpr bool kEnableKernelIpcTesting = true;
 
 constexpr char kLocalInetAddress[] = "127.0.0.1";
 
-enum class RpcSecurity { RAW, TLS };
+enum class RpcSecurity { RAW, TLS, URING, SHM };
 
 static inline std::vector<RpcSecurity> RpcSecurityValues() {
     return {RpcSecurity::RAW, RpcSecurity::TLS};
 }
 
+// Transports which carry the same unencrypted stream as RAW, only moving the bytes differently.
+// They are only tested with the current protocol version on UNIX sockets, rather than across the
+// whole RpcSecurityValues() matrix.
+static inline std::vector<RpcSecurity> extraTransportValues() {
+    return {RpcSecurity::URING, RpcSecurity::SHM};
+}
+
 static inline std::vector<bool> noKernelValues() {
     std::vector<bool> values = {true};
     if (kEnableKernelIpcTesting) {
@@ -222,6 +231,10 @@ static inline std::unique_ptr<RpcTransportCtxFactory> newTlsFactory(
             }
             return RpcTransportCtxFactoryTls::make(std::move(verifier), std::move(auth));
         }
+        case RpcSecurity::URING:
+            return RpcTransportCtxFactoryUring::make();
+        case RpcSecurity::SHM:
+            return RpcTransportCtxFactoryShm::make();
         default:
             LOG_ALWAYS_FATAL("Unknown RpcSecurity %d", static_cast<int>(rpcSecurity));
     }
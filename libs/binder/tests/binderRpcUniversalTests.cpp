@@ -148,6 +148,53 @@ TEST_P(BinderRpc, UnknownTransaction) {
     EXPECT_EQ(UNKNOWN_TRANSACTION, proc.rootBinder->transact(1337, data, &reply, 0));
 }
 
+TEST_P(BinderRpc, ByteArrayReference) {
+    if (socketType() == SocketType::TIPC) {
+        GTEST_SKIP() << "Trusty has a limit of 4096 bytes for the entire RPC Binder message";
+    }
+
+    auto proc = createRpcTestSocketServerProcess({});
+    std::vector<uint8_t> bytes(16 * 1024 + 1, 0xa5);
+
+    Parcel data;
+    data.markForBinder(proc.rootBinder);
+    ASSERT_EQ(OK, data.writeInt32(1));
+    size_t sizePos = data.dataPosition();
+    ASSERT_EQ(OK, data.writeInt32(0));
+    ASSERT_EQ(OK, data.writeByteArrayReference(bytes.size(), bytes.data()));
+    size_t endPos = data.dataPosition();
+    EXPECT_EQ(3 * sizeof(int32_t) + 16 * 1024 + 4, endPos);
+    EXPECT_EQ(3 * sizeof(int32_t), data.dataSize());
+    EXPECT_EQ(16 * 1024 + 4, data.externalDataSize());
+
+    // overwriting data before the referenced array
+    data.setDataPosition(sizePos);
+    ASSERT_EQ(OK, data.writeInt32(static_cast<int32_t>(endPos - sizePos)));
+    data.setDataPosition(endPos);
+    ASSERT_EQ(OK, data.writeInt32(2));
+    EXPECT_EQ(endPos + sizeof(int32_t), data.dataSize() + data.externalDataSize());
+
+    // referenced data is compared too
+    std::vector<uint8_t> otherBytes(bytes);
+    otherBytes.back() = 0;
+    Parcel other;
+    other.markForBinder(proc.rootBinder);
+    ASSERT_EQ(OK, other.writeInt32(1));
+    ASSERT_EQ(OK, other.writeInt32(static_cast<int32_t>(endPos - sizePos)));
+    ASSERT_EQ(OK, other.writeByteArrayReference(otherBytes.size(), otherBytes.data()));
+    ASSERT_EQ(OK, other.writeInt32(2));
+    EXPECT_NE(0, data.compareData(other));
+    otherBytes.back() = bytes.back();
+    EXPECT_EQ(0, data.compareData(other));
+
+    // the whole transaction must be consumed for the session to keep working
+    Parcel reply;
+    EXPECT_EQ(UNKNOWN_TRANSACTION, proc.rootBinder->transact(1337, data, &reply, 0));
+    std::string doubled;
+    EXPECT_OK(proc.rootIface->doubleString("cool ", &doubled));
+    EXPECT_EQ("cool cool ", doubled);
+}
+
 TEST_P(BinderRpc, SendSomethingOneway) {
     auto proc = createRpcTestSocketServerProcess({});
     EXPECT_OK(proc.rootIface->sendString("asdf"));
@@ -170,6 +217,26 @@ TEST_P(BinderRpc, SendAndGetResultBackBig) {
     EXPECT_EQ(single + single, doubled);
 }
 
+TEST_P(BinderRpc, SendAndGetResultBackCompressed) {
+    auto proc = createRpcTestSocketServerProcess({});
+    // only affects what this side sends, and only with new enough protocol versions
+    proc.proc->sessions.at(0).session->setCompressionEnabled(true);
+
+    // Trusty has a limit of 4096 bytes for the entire RPC Binder message
+    size_t singleLen = socketType() == SocketType::TIPC ? 1500 : 16 * 1024;
+    std::string single;
+    while (single.size() < singleLen) single += "compressible " + std::to_string(single.size());
+    std::string doubled;
+    EXPECT_OK(proc.rootIface->doubleString(single, &doubled));
+    EXPECT_EQ(single + single, doubled);
+
+    // incompressible data is sent as is
+    std::string random(singleLen, '\0');
+    for (char& c : random) c = static_cast<char>(rand());
+    EXPECT_OK(proc.rootIface->doubleString(random, &doubled));
+    EXPECT_EQ(random + random, doubled);
+}
+
 TEST_P(BinderRpc, InvalidNullBinderReturn) {
     auto proc = createRpcTestSocketServerProcess({});
 
@@ -187,7 +187,8 @@ InputConsumerNoResampling::InputConsumerNoResampling(const std::shared_ptr<Input
         mLooper{looper},
         mCallbacks{callbacks},
         mResampler{std::move(resampler)},
-        mFdEvents(0) {
+        mFdEvents(0),
+        mReceiveBuffer(RECEIVE_BUFFER_SIZE) {
     LOG_ALWAYS_FATAL_IF(mLooper == nullptr);
     mCallback = sp<LooperEventCallback>::make(
             std::bind(&InputConsumerNoResampling::handleReceiveCallback, this,
@@ -368,19 +369,22 @@ void InputConsumerNoResampling::handleMessages(std::vector<InputMessage>&& messa
 std::vector<InputMessage> InputConsumerNoResampling::readAllMessages() {
     std::vector<InputMessage> messages;
     while (true) {
-        android::base::Result<InputMessage> result = mChannel->receiveMessage();
+        // Drain the channel with as few reads as possible.
+        android::base::Result<size_t> result = mChannel->receiveMessages(mReceiveBuffer);
         if (result.ok()) {
-            const InputMessage& msg = *result;
-            const auto [_, inserted] =
-                    mConsumeTimes.emplace(msg.header.seq, systemTime(SYSTEM_TIME_MONOTONIC));
-            LOG_ALWAYS_FATAL_IF(!inserted, "Already have a consume time for seq=%" PRIu32,
-                                msg.header.seq);
-
-            // Trace the event processing timeline - event was just read from the socket
-            // TODO(b/329777420): distinguish between multiple instances of InputConsumer
-            // in the same process.
-            ATRACE_ASYNC_BEGIN("InputConsumer processing", /*cookie=*/msg.header.seq);
-            messages.push_back(msg);
+            const nsecs_t consumeTime = systemTime(SYSTEM_TIME_MONOTONIC);
+            for (size_t i = 0; i < *result; i++) {
+                const InputMessage& msg = mReceiveBuffer[i];
+                const auto [_, inserted] = mConsumeTimes.emplace(msg.header.seq, consumeTime);
+                LOG_ALWAYS_FATAL_IF(!inserted, "Already have a consume time for seq=%" PRIu32,
+                                    msg.header.seq);
+
+                // Trace the event processing timeline - event was just read from the socket
+                // TODO(b/329777420): distinguish between multiple instances of InputConsumer
+                // in the same process.
+                ATRACE_ASYNC_BEGIN("InputConsumer processing", /*cookie=*/msg.header.seq);
+                messages.push_back(msg);
+            }
         } else { // !result.ok()
             switch (result.error().code()) {
                 case WOULD_BLOCK: {
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "InputMessageRing"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstring>
+
+#include <android-base/logging.h>
+#include <input/InputMessageRing.h>
+#include <input/InputTransport.h>
+
+namespace android {
+
+namespace {
+
+constexpr uint32_t RING_MAGIC = 0x494d5231; // 'IMR1'
+
+// Each message is preceded by one of these, and records are aligned to its size.
+struct RecordHeader {
+    uint32_t size;
+    uint32_t reserved;
+};
+
+// Written instead of a record when the next record doesn't fit before the end of the data area.
+// The reader then continues from the start of the data area.
+constexpr uint32_t WRAP_MARKER = UINT32_MAX;
+
+constexpr uint64_t getRecordSize(size_t messageSize) {
+    const uint64_t size = sizeof(RecordHeader) + messageSize;
+    return (size + sizeof(RecordHeader) - 1) & ~(sizeof(RecordHeader) - 1);
+}
+
+} // namespace
+
+// Shared between the two processes, at the start of the memfd. The positions are free-running byte
+// counts, on separate cache lines since they are written by different processes.
+struct InputMessageRingHeader {
+    uint32_t magic;
+    uint32_t dataSize;
+    alignas(64) std::atomic<uint64_t> readPosition;
+    alignas(64) std::atomic<uint64_t> writePosition;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "ring positions are shared between processes");
+
+namespace {
+
+constexpr size_t getMemorySize(uint64_t dataSize) {
+    return sizeof(InputMessageRingHeader) + dataSize;
+}
+
+} // namespace
+
+// --- InputMessageRing ---
+
+android::base::Result<std::unique_ptr<InputMessageRing>> InputMessageRing::create(
+        const std::string& name) {
+    android::base::unique_fd fd(
+            memfd_create(("input-ring:" + name).c_str(), MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (!fd.ok()) {
+        return android::base::Error(-errno)
+                << "Could not create memfd for " << name << ": " << strerror(errno);
+    }
+    if (ftruncate(fd.get(), getMemorySize(DATA_SIZE)) != 0) {
+        return android::base::Error(-errno)
+                << "Could not size memfd for " << name << ": " << strerror(errno);
+    }
+    // The consumer must not be able to shrink the memory while the producer uses it.
+    if (fcntl(fd.get(), F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0) {
+        return android::base::Error(-errno)
+                << "Could not seal memfd for " << name << ": " << strerror(errno);
+    }
+    void* memory = mmap(nullptr, getMemorySize(DATA_SIZE), PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd.get(), 0);
+    if (memory == MAP_FAILED) {
+        return android::base::Error(-errno)
+                << "Could not map memfd for " << name << ": " << strerror(errno);
+    }
+    // The memfd is zero-filled, so the positions are already initialized.
+    InputMessageRingHeader* header = static_cast<InputMessageRingHeader*>(memory);
+    header->magic = RING_MAGIC;
+    header->dataSize = DATA_SIZE;
+    // using 'new' to access a non-public constructor
+    return std::unique_ptr<InputMessageRing>(
+            new InputMessageRing(std::move(fd), memory, /*isProducer=*/true));
+}
+
+android::base::Result<std::unique_ptr<InputMessageRing>> InputMessageRing::map(
+        android::base::unique_fd fd, bool isProducer) {
+    const int seals = fcntl(fd.get(), F_GET_SEALS);
+    if (seals < 0 || (seals & F_SEAL_SHRINK) == 0) {
+        return android::base::Error(BAD_VALUE) << "The ring memfd is not sealed";
+    }
+    struct stat st;
+    if (fstat(fd.get(), &st) != 0) {
+        return android::base::Error(-errno)
+                << "Could not stat the ring memfd: " << strerror(errno);
+    }
+    if (static_cast<uint64_t>(st.st_size) < getMemorySize(DATA_SIZE)) {
+        return android::base::Error(BAD_VALUE) << "The ring memfd is too small";
+    }
+    void* memory = mmap(nullptr, getMemorySize(DATA_SIZE), PROT_READ | PROT_WRITE, MAP_SHARED,
+                        fd.get(), 0);
+    if (memory == MAP_FAILED) {
+        return android::base::Error(-errno)
+                << "Could not map the ring memfd: " << strerror(errno);
+    }
+    const InputMessageRingHeader* header = static_cast<InputMessageRingHeader*>(memory);
+    if (header->magic != RING_MAGIC || header->dataSize != DATA_SIZE) {
+        munmap(memory, getMemorySize(DATA_SIZE));
+        return android::base::Error(BAD_VALUE) << "The ring memfd has an unknown format";
+    }
+    return std::unique_ptr<InputMessageRing>(
+            new InputMessageRing(std::move(fd), memory, isProducer));
+}
+
+InputMessageRing::InputMessageRing(android::base::unique_fd fd, void* memory, bool isProducer)
+      : mFd(std::move(fd)),
+        mHeader(static_cast<InputMessageRingHeader*>(memory)),
+        mData(static_cast<uint8_t*>(memory) + sizeof(InputMessageRingHeader)),
+        mIsProducer(isProducer) {
+    // A ring mapped again, e.g. for a duplicated channel, continues where the previous one was.
+    mPosition = mIsProducer ? mHeader->writePosition.load() : mHeader->readPosition.load();
+}
+
+InputMessageRing::~InputMessageRing() {
+    munmap(mHeader, getMemorySize(DATA_SIZE));
+}
+
+status_t InputMessageRing::write(const InputMessage& msg, bool* outWakeConsumer) {
+    LOG_IF(FATAL, !mIsProducer) << "Only the producer can write to the ring";
+    const uint64_t readPosition = mHeader->readPosition.load();
+    if (readPosition > mPosition || mPosition - readPosition > DATA_SIZE) {
+        LOG(ERROR) << "Invalid read position " << readPosition << ", write position is "
+                   << mPosition;
+        return DEAD_OBJECT;
+    }
+    const uint64_t available = DATA_SIZE - (mPosition - readPosition);
+    const size_t size = msg.size();
+    const uint64_t recordSize = getRecordSize(size);
+    const uint64_t offset = mPosition & (DATA_SIZE - 1);
+    const uint64_t padding = DATA_SIZE - offset < recordSize ? DATA_SIZE - offset : 0;
+    if (padding + recordSize > available) {
+        return WOULD_BLOCK;
+    }
+
+    const uint64_t startPosition = mPosition;
+    if (padding != 0) {
+        const RecordHeader wrap{.size = WRAP_MARKER, .reserved = 0};
+        memcpy(mData + offset, &wrap, sizeof(wrap));
+        mPosition += padding;
+    }
+    uint8_t* record = mData + (mPosition & (DATA_SIZE - 1));
+    const RecordHeader recordHeader{.size = static_cast<uint32_t>(size), .reserved = 0};
+    memcpy(record, &recordHeader, sizeof(recordHeader));
+    memcpy(record + sizeof(recordHeader), &msg, size);
+    mPosition += recordSize;
+
+    // Publishing the write position and then checking the read position pairs with the consumer
+    // storing its read position and then checking the write position, so that at least one side
+    // sees the other's update: either the consumer reads this message, or it gets woken up.
+    mHeader->writePosition.store(mPosition);
+    *outWakeConsumer = mHeader->readPosition.load() == startPosition;
+    return OK;
+}
+
+status_t InputMessageRing::read(InputMessage* outMsg) {
+    LOG_IF(FATAL, mIsProducer) << "Only the consumer can read from the ring";
+    while (true) {
+        const uint64_t writePosition = mHeader->writePosition.load();
+        if (writePosition == mPosition) {
+            return WOULD_BLOCK;
+        }
+        if (writePosition < mPosition || writePosition - mPosition > DATA_SIZE) {
+            LOG(ERROR) << "Invalid write position " << writePosition << ", read position is "
+                       << mPosition;
+            return BAD_VALUE;
+        }
+
+        const uint64_t offset = mPosition & (DATA_SIZE - 1);
+        RecordHeader recordHeader;
+        memcpy(&recordHeader, mData + offset, sizeof(recordHeader));
+        if (recordHeader.size == WRAP_MARKER) {
+            mPosition += DATA_SIZE - offset;
+            mHeader->readPosition.store(mPosition);
+            continue;
+        }
+        const uint64_t recordSize = getRecordSize(recordHeader.size);
+        if (recordHeader.size > sizeof(InputMessage) || offset + recordSize > DATA_SIZE ||
+            recordSize > writePosition - mPosition) {
+            LOG(ERROR) << "Invalid record of size " << recordHeader.size << " at " << mPosition;
+            return BAD_VALUE;
+        }
+        memcpy(outMsg, mData + offset + sizeof(recordHeader), recordHeader.size);
+        mPosition += recordSize;
+        mHeader->readPosition.store(mPosition);
+        if (!outMsg->isValid(recordHeader.size)) {
+            return BAD_VALUE;
+        }
+        return OK;
+    }
+}
+
+bool InputMessageRing::hasMessages() const {
+    return mHeader->writePosition.load(std::memory_order_acquire) != mPosition;
+}
+
+} // namespace android
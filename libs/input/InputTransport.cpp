@@ -13,7 +13,10 @@
 #include <poll.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
+#include <algorithm>
+#include <array>
 
 #include <android-base/logging.h>
 #include <android-base/properties.h>
@@ -94,6 +97,16 @@ android::base::unique_fd dupChannelFd(int fd) {
 // behind processing touches.
 constexpr size_t SOCKET_BUFFER_SIZE = 32 * 1024;
 
+// The maximum number of messages sent or received by a single sendmmsg / recvmmsg call.
+constexpr size_t MAX_MESSAGES_PER_SYSCALL = 16;
+
+// The most messages an InputPublisher keeps room for between batches.
+constexpr size_t MAX_RETAINED_BATCH_CAPACITY = MAX_MESSAGES_PER_SYSCALL;
+
+// Sent over the socket of a channel with an InputMessageRing, when the consumer may be waiting for
+// the ring to have messages. It is shorter than any InputMessage.
+constexpr uint8_t RING_DOORBELL = 1;
+
 /**
  * Crash if the events that are getting sent to the InputPublisher are inconsistent.
  * Enable this via "adb shell setprop log.tag.InputTransportVerifyEvents DEBUG"
@@ -337,8 +350,17 @@ std::unique_ptr<InputChannel> InputChannel::create(const std::string& name,
 
 std::unique_ptr<InputChannel> InputChannel::create(
         android::os::InputChannelCore&& parceledChannel) {
-    return InputChannel::create(parceledChannel.name, parceledChannel.fd.release(),
-                                parceledChannel.token);
+    std::unique_ptr<InputChannel> channel =
+            InputChannel::create(parceledChannel.name, parceledChannel.fd.release(),
+                                 parceledChannel.token);
+    if (channel != nullptr && parceledChannel.ring) {
+        base::Result<std::unique_ptr<InputMessageRing>> ring =
+                InputMessageRing::map(parceledChannel.ring->release(), /*isProducer=*/false);
+        LOG_ALWAYS_FATAL_IF(!ring.ok(), "channel '%s' ~ Could not map the input ring: %s",
+                            channel->getName().c_str(), ring.error().message().c_str());
+        channel->mRing = std::move(*ring);
+    }
+    return channel;
 }
 
 InputChannel::InputChannel(const std::string name, android::base::unique_fd fd, sp<IBinder> token) {
@@ -357,6 +379,38 @@ InputChannel::~InputChannel() {
 status_t InputChannel::openInputChannelPair(const std::string& name,
                                             std::unique_ptr<InputChannel>& outServerChannel,
                                             std::unique_ptr<InputChannel>& outClientChannel) {
+    return openInputChannelPair(name, outServerChannel, outClientChannel,
+                                /*useSharedMemoryRing=*/false);
+}
+
+status_t InputChannel::openInputChannelPair(const std::string& name,
+                                            std::unique_ptr<InputChannel>& outServerChannel,
+                                            std::unique_ptr<InputChannel>& outClientChannel,
+                                            bool useSharedMemoryRing) {
+    std::unique_ptr<InputMessageRing> serverRing;
+    std::unique_ptr<InputMessageRing> clientRing;
+    if (useSharedMemoryRing) {
+        base::Result<std::unique_ptr<InputMessageRing>> ring = InputMessageRing::create(name);
+        if (!ring.ok()) {
+            ALOGE("channel '%s' ~ Could not create input ring: %s", name.c_str(),
+                  ring.error().message().c_str());
+            outServerChannel.reset();
+            outClientChannel.reset();
+            return ring.error().code();
+        }
+        serverRing = std::move(*ring);
+        ring = InputMessageRing::map(base::unique_fd(::dup(serverRing->getFd())),
+                                     /*isProducer=*/false);
+        if (!ring.ok()) {
+            ALOGE("channel '%s' ~ Could not map input ring: %s", name.c_str(),
+                  ring.error().message().c_str());
+            outServerChannel.reset();
+            outClientChannel.reset();
+            return ring.error().code();
+        }
+        clientRing = std::move(*ring);
+    }
+
     int sockets[2];
     if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets)) {
         status_t result = -errno;
@@ -377,20 +431,28 @@ status_t InputChannel::openInputChannelPair(const std::string& name,
 
     android::base::unique_fd serverFd(sockets[0]);
     outServerChannel = InputChannel::create(name, std::move(serverFd), token);
+    outServerChannel->mRing = std::move(serverRing);
 
     android::base::unique_fd clientFd(sockets[1]);
     outClientChannel = InputChannel::create(name, std::move(clientFd), token);
+    outClientChannel->mRing = std::move(clientRing);
     return OK;
 }
 
+std::string InputChannel::sendMessageTraceName(const InputMessage& msg) const {
+    return StringPrintf("sendMessage(inputChannel=%s, seq=0x%" PRIx32 ", type=%s)", name.c_str(),
+                        msg.header.seq, ftl::enum_string(msg.header.type).c_str());
+}
+
 status_t InputChannel::sendMessage(const InputMessage* msg) {
-    ATRACE_NAME_IF(ATRACE_ENABLED(),
-                   StringPrintf("sendMessage(inputChannel=%s, seq=0x%" PRIx32 ", type=%s)",
-                                name.c_str(), msg->header.seq,
-                                ftl::enum_string(msg->header.type).c_str()));
+    ATRACE_NAME_IF(ATRACE_ENABLED(), sendMessageTraceName(*msg));
     const size_t msgLength = msg->size();
     InputMessage cleanMsg;
     msg->getSanitizedCopy(&cleanMsg);
+    if (isRingProducer()) {
+        size_t sent;
+        return sendMessagesToRing({&cleanMsg, 1}, &sent);
+    }
     ssize_t nWrite;
     do {
         nWrite = ::send(getFd(), &cleanMsg, msgLength, MSG_DONTWAIT | MSG_NOSIGNAL);
@@ -422,9 +484,79 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
     return OK;
 }
 
+status_t InputChannel::sendMessages(std::span<const InputMessage> messages, size_t* outSent) {
+    ATRACE_NAME_IF(ATRACE_ENABLED(),
+                   StringPrintf("sendMessages(inputChannel=%s, count=%zu)", name.c_str(),
+                                messages.size()));
+    if (ATRACE_ENABLED()) {
+        // The same slice for each message as sendMessage has, which tools look for.
+        for (const InputMessage& msg : messages) {
+            ATRACE_NAME(sendMessageTraceName(msg).c_str());
+        }
+    }
+    if (isRingProducer()) {
+        return sendMessagesToRing(messages, outSent);
+    }
+    *outSent = 0;
+    // The channel is a SOCK_SEQPACKET socket, so each message keeps its own boundary, exactly as
+    // if it was sent by sendMessage.
+    while (*outSent < messages.size()) {
+        const size_t count = std::min(messages.size() - *outSent, MAX_MESSAGES_PER_SYSCALL);
+        std::array<iovec, MAX_MESSAGES_PER_SYSCALL> iovecs;
+        std::array<mmsghdr, MAX_MESSAGES_PER_SYSCALL> headers{};
+        for (size_t i = 0; i < count; i++) {
+            const InputMessage& msg = messages[*outSent + i];
+            iovecs[i] = {.iov_base = const_cast<InputMessage*>(&msg), .iov_len = msg.size()};
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+        int nSent;
+        do {
+            nSent = ::sendmmsg(getFd(), headers.data(), count, MSG_DONTWAIT | MSG_NOSIGNAL);
+        } while (nSent == -1 && errno == EINTR);
+
+        if (nSent < 0) {
+            int error = errno;
+            const InputMessage& msg = messages[*outSent];
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ error sending message of type %s, %s",
+                     name.c_str(), ftl::enum_string(msg.header.type).c_str(), strerror(error));
+            if (error == EAGAIN || error == EWOULDBLOCK) {
+                return WOULD_BLOCK;
+            }
+            if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED ||
+                error == ECONNRESET) {
+                return DEAD_OBJECT;
+            }
+            return -error;
+        }
+
+        for (int i = 0; i < nSent; i++) {
+            const InputMessage& msg = messages[*outSent];
+            if (headers[i].msg_len != iovecs[i].iov_len) {
+                ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                         "channel '%s' ~ error sending message type %s, send was incomplete",
+                         name.c_str(), ftl::enum_string(msg.header.type).c_str());
+                return DEAD_OBJECT;
+            }
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ sent message of type %s",
+                     name.c_str(), ftl::enum_string(msg.header.type).c_str());
+            (*outSent)++;
+        }
+        // If only some of the messages were sent, the next call reports why the rest weren't.
+    }
+    return OK;
+}
+
 android::base::Result<InputMessage> InputChannel::receiveMessage() {
     ssize_t nRead;
     InputMessage msg;
+    if (isRingConsumer()) {
+        android::base::Result<size_t> result = receiveMessagesFromRing({&msg, 1});
+        if (!result.ok()) {
+            return result.error();
+        }
+        return msg;
+    }
     do {
         nRead = ::recv(getFd(), &msg, sizeof(InputMessage), MSG_DONTWAIT);
     } while (nRead == -1 && errno == EINTR);
@@ -466,7 +598,184 @@ android::base::Result<InputMessage> InputChannel::receiveMessage() {
     return msg;
 }
 
+android::base::Result<size_t> InputChannel::receiveMessages(std::span<InputMessage> outMessages) {
+    if (isRingConsumer()) {
+        return receiveMessagesFromRing(outMessages);
+    }
+    const size_t count = std::min(outMessages.size(), MAX_MESSAGES_PER_SYSCALL);
+    std::array<iovec, MAX_MESSAGES_PER_SYSCALL> iovecs;
+    std::array<mmsghdr, MAX_MESSAGES_PER_SYSCALL> headers{};
+    for (size_t i = 0; i < count; i++) {
+        iovecs[i] = {.iov_base = &outMessages[i], .iov_len = sizeof(InputMessage)};
+        headers[i].msg_hdr.msg_iov = &iovecs[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+    int nRead;
+    do {
+        nRead = ::recvmmsg(getFd(), headers.data(), count, MSG_DONTWAIT, /*timeout=*/nullptr);
+    } while (nRead == -1 && errno == EINTR);
+
+    if (nRead < 0) {
+        int error = errno;
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ receive messages failed, errno=%d",
+                 name.c_str(), errno);
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+            return android::base::Error(WOULD_BLOCK);
+        }
+        if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED) {
+            return android::base::Error(DEAD_OBJECT);
+        }
+        return android::base::Error(-error);
+    }
+
+    size_t received = 0;
+    for (; received < static_cast<size_t>(nRead); received++) {
+        const size_t length = headers[received].msg_len;
+        if (length == 0) { // EOF, which is reported by the next call if messages were received
+            break;
+        }
+        const InputMessage& msg = outMessages[received];
+        if (!msg.isValid(length)) {
+            ALOGE("channel '%s' ~ received invalid message of size %zu", name.c_str(), length);
+            return android::base::Error(BAD_VALUE);
+        }
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ received message of type %s",
+                 name.c_str(), ftl::enum_string(msg.header.type).c_str());
+        if (ATRACE_ENABLED()) {
+            // Add an additional trace point to include data about the received message.
+            std::string message =
+                    StringPrintf("receiveMessage(inputChannel=%s, seq=0x%" PRIx32 ", type=%s)",
+                                 name.c_str(), msg.header.seq,
+                                 ftl::enum_string(msg.header.type).c_str());
+            ATRACE_NAME(message.c_str());
+        }
+    }
+
+    if (received == 0) {
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                 "channel '%s' ~ receive messages failed because peer was closed", name.c_str());
+        return android::base::Error(DEAD_OBJECT);
+    }
+    return received;
+}
+
+status_t InputChannel::sendMessagesToRing(std::span<const InputMessage> messages,
+                                          size_t* outSent) {
+    *outSent = 0;
+    status_t status = OK;
+    bool wakeConsumer = false;
+    for (const InputMessage& msg : messages) {
+        bool wake;
+        status = mRing->write(msg, &wake);
+        if (status != OK) {
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                     "channel '%s' ~ error writing message of type %s to the ring, status=%d",
+                     name.c_str(), ftl::enum_string(msg.header.type).c_str(), status);
+            break;
+        }
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ wrote message of type %s to the ring",
+                 name.c_str(), ftl::enum_string(msg.header.type).c_str());
+        wakeConsumer |= wake;
+        (*outSent)++;
+    }
+    if (wakeConsumer) {
+        const status_t doorbellStatus = sendDoorbell();
+        if (doorbellStatus != OK) {
+            return doorbellStatus;
+        }
+    }
+    return status;
+}
+
+android::base::Result<size_t> InputChannel::receiveMessagesFromRing(
+        std::span<InputMessage> outMessages) {
+    size_t received = 0;
+    while (received < outMessages.size()) {
+        const InputMessage& msg = outMessages[received];
+        const status_t status = mRing->read(&outMessages[received]);
+        if (status == OK) {
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ read message of type %s from the ring",
+                     name.c_str(), ftl::enum_string(msg.header.type).c_str());
+            received++;
+            continue;
+        }
+        if (status != WOULD_BLOCK) {
+            ALOGE("channel '%s' ~ could not read from the ring, status=%d", name.c_str(), status);
+            return android::base::Error(status);
+        }
+        if (received > 0) {
+            break;
+        }
+        // The ring is empty. Consume the doorbell that was sent when it last stopped being empty,
+        // and check the ring again, since the doorbell may have been sent after the ring was read.
+        const status_t doorbellStatus = receiveDoorbell();
+        if (doorbellStatus != OK) {
+            return android::base::Error(doorbellStatus);
+        }
+    }
+    return received;
+}
+
+status_t InputChannel::sendDoorbell() {
+    ssize_t nWrite;
+    do {
+        nWrite = ::send(getFd(), &RING_DOORBELL, sizeof(RING_DOORBELL),
+                        MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (nWrite == -1 && errno == EINTR);
+
+    if (nWrite < 0) {
+        int error = errno;
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+            // Only doorbells are sent to the consumer over the socket, so it still has some to
+            // read, and will read the ring after that.
+            return OK;
+        }
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ error sending doorbell, %s",
+                 name.c_str(), strerror(error));
+        if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED || error == ECONNRESET) {
+            return DEAD_OBJECT;
+        }
+        return -error;
+    }
+    return OK;
+}
+
+status_t InputChannel::receiveDoorbell() {
+    // Large enough to tell a doorbell apart from anything else.
+    uint8_t buffer[sizeof(RING_DOORBELL) + 1];
+    ssize_t nRead;
+    do {
+        nRead = ::recv(getFd(), buffer, sizeof(buffer), MSG_DONTWAIT);
+    } while (nRead == -1 && errno == EINTR);
+
+    if (nRead < 0) {
+        int error = errno;
+        if (error == EAGAIN || error == EWOULDBLOCK) {
+            return WOULD_BLOCK;
+        }
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ receive doorbell failed, errno=%d",
+                 name.c_str(), error);
+        if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED) {
+            return DEAD_OBJECT;
+        }
+        return -error;
+    }
+    if (nRead == 0) { // check for EOF
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                 "channel '%s' ~ receive doorbell failed because peer was closed", name.c_str());
+        return DEAD_OBJECT;
+    }
+    if (nRead != sizeof(RING_DOORBELL) || buffer[0] != RING_DOORBELL) {
+        ALOGE("channel '%s' ~ received invalid doorbell of size %zd", name.c_str(), nRead);
+        return BAD_VALUE;
+    }
+    return OK;
+}
+
 bool InputChannel::probablyHasInput() const {
+    if (isRingConsumer() && mRing->hasMessages()) {
+        return true;
+    }
     struct pollfd pfds = {.fd = fd.get(), .events = POLLIN};
     if (::poll(&pfds, /*nfds=*/1, /*timeout=*/0) <= 0) {
         // This can be a false negative because EINTR and ENOMEM are not handled. The latter should
@@ -500,13 +809,26 @@ void InputChannel::waitForMessage(std::chrono::milliseconds timeout) const {
 
 std::unique_ptr<InputChannel> InputChannel::dup() const {
     base::unique_fd newFd(dupChannelFd(fd.get()));
-    return InputChannel::create(getName(), std::move(newFd), getConnectionToken());
+    std::unique_ptr<InputChannel> channel =
+            InputChannel::create(getName(), std::move(newFd), getConnectionToken());
+    if (channel != nullptr && mRing != nullptr) {
+        base::Result<std::unique_ptr<InputMessageRing>> ring =
+                InputMessageRing::map(dupRingFd(), mRing->isProducer());
+        LOG_ALWAYS_FATAL_IF(!ring.ok(), "channel '%s' ~ Could not map the input ring: %s",
+                            getName().c_str(), ring.error().message().c_str());
+        channel->mRing = std::move(*ring);
+    }
+    return channel;
 }
 
 void InputChannel::copyTo(android::os::InputChannelCore& outChannel) const {
     outChannel.name = getName();
     outChannel.fd.reset(dupChannelFd(fd.get()));
     outChannel.token = getConnectionToken();
+    // Only client channels are sent to other processes, and the ring is read on that side.
+    if (isRingConsumer()) {
+        outChannel.ring = android::os::ParcelFileDescriptor(dupRingFd());
+    }
 }
 
 void InputChannel::moveChannel(std::unique_ptr<InputChannel> from,
@@ -514,6 +836,13 @@ void InputChannel::moveChannel(std::unique_ptr<InputChannel> from,
     outChannel.name = from->getName();
     outChannel.fd = android::os::ParcelFileDescriptor(std::move(from->fd));
     outChannel.token = from->getConnectionToken();
+    if (from->isRingConsumer()) {
+        outChannel.ring = android::os::ParcelFileDescriptor(from->dupRingFd());
+    }
+}
+
+android::base::unique_fd InputChannel::dupRingFd() const {
+    return dupChannelFd(mRing->getFd());
 }
 
 sp<IBinder> InputChannel::getConnectionToken() const {
@@ -567,7 +896,7 @@ status_t InputPublisher::publishKeyEvent(uint32_t seq, int32_t eventId, int32_t
     msg.body.key.repeatCount = repeatCount;
     msg.body.key.downTime = downTime;
     msg.body.key.eventTime = eventTime;
-    return mChannel->sendMessage(&msg);
+    return sendMessage(msg);
 }
 
 status_t InputPublisher::publishMotionEvent(
@@ -658,7 +987,7 @@ status_t InputPublisher::publishMotionEvent(
         msg.body.motion.pointers[i].coords = pointerCoords[i];
     }
 
-    return mChannel->sendMessage(&msg);
+    return sendMessage(msg);
 }
 
 status_t InputPublisher::publishFocusEvent(uint32_t seq, int32_t eventId, bool hasFocus) {
@@ -673,7 +1002,7 @@ status_t InputPublisher::publishFocusEvent(uint32_t seq, int32_t eventId, bool h
     msg.header.seq = seq;
     msg.body.focus.eventId = eventId;
     msg.body.focus.hasFocus = hasFocus;
-    return mChannel->sendMessage(&msg);
+    return sendMessage(msg);
 }
 
 status_t InputPublisher::publishCaptureEvent(uint32_t seq, int32_t eventId,
@@ -690,7 +1019,7 @@ status_t InputPublisher::publishCaptureEvent(uint32_t seq, int32_t eventId,
     msg.header.seq = seq;
     msg.body.capture.eventId = eventId;
     msg.body.capture.pointerCaptureEnabled = pointerCaptureEnabled;
-    return mChannel->sendMessage(&msg);
+    return sendMessage(msg);
 }
 
 status_t InputPublisher::publishDragEvent(uint32_t seq, int32_t eventId, float x, float y,
@@ -709,7 +1038,7 @@ status_t InputPublisher::publishDragEvent(uint32_t seq, int32_t eventId, float x
     msg.body.drag.isExiting = isExiting;
     msg.body.drag.x = x;
     msg.body.drag.y = y;
-    return mChannel->sendMessage(&msg);
+    return sendMessage(msg);
 }
 
 status_t InputPublisher::publishTouchModeEvent(uint32_t seq, int32_t eventId, bool isInTouchMode) {
@@ -725,6 +1054,40 @@ status_t InputPublisher::publishTouchModeEvent(uint32_t seq, int32_t eventId, bo
     msg.header.seq = seq;
     msg.body.touchMode.eventId = eventId;
     msg.body.touchMode.isInTouchMode = isInTouchMode;
+    return sendMessage(msg);
+}
+
+void InputPublisher::beginBatch() {
+    LOG_IF(FATAL, mBatching) << "channel '" << mChannel->getName() << "' is already batching";
+    mBatching = true;
+}
+
+status_t InputPublisher::endBatch(size_t* outSent) {
+    LOG_IF(FATAL, !mBatching) << "channel '" << mChannel->getName() << "' is not batching";
+    mBatching = false;
+    status_t status = OK;
+    if (mBatch.size() == 1) {
+        // Nothing to save over sending it directly.
+        status = mChannel->sendMessage(&mBatch[0]);
+        *outSent = status == OK ? 1 : 0;
+    } else if (mBatch.size() > 1) {
+        status = mChannel->sendMessages(mBatch, outSent);
+    } else {
+        *outSent = 0;
+    }
+    mBatch.clear();
+    // Messages are large, so don't hold on to the memory of an unusually large batch.
+    if (mBatch.capacity() > MAX_RETAINED_BATCH_CAPACITY) {
+        std::vector<InputMessage>().swap(mBatch);
+    }
+    return status;
+}
+
+status_t InputPublisher::sendMessage(const InputMessage& msg) {
+    if (mBatching) {
+        msg.getSanitizedCopy(&mBatch.emplace_back());
+        return OK;
+    }
     return mChannel->sendMessage(&msg);
 }
 
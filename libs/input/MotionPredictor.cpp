@@ -252,8 +252,13 @@ std::unique_ptr<MotionEvent> MotionPredictor::predict(nsecs_t timestamp) {
     }
 
     LOG_ALWAYS_FATAL_IF(!mModel);
-    mBuffers->copyTo(*mModel);
-    LOG_ALWAYS_FATAL_IF(!mModel->invoke());
+    if (mModelOutputGeneration != mBuffers->generation()) {
+        mBuffers->copyTo(*mModel);
+        LOG_ALWAYS_FATAL_IF(!mModel->invoke());
+        mModelOutputGeneration = mBuffers->generation();
+    } else {
+        ALOGD_IF(isDebug(), "No new samples since the last prediction, reusing the model output");
+    }
 
     // Read out the predictions.
     const std::span<const float> predictedR = mModel->outputR();
@@ -184,6 +184,7 @@ void TfLiteMotionPredictorBuffers::reset() {
     std::fill(mInputOrientation.begin(), mInputOrientation.end(), 0);
     mAxisFrom.reset();
     mAxisTo.reset();
+    mGeneration++;
 }
 
 void TfLiteMotionPredictorBuffers::copyTo(TfLiteMotionPredictorModel& model) const {
@@ -205,6 +206,7 @@ void TfLiteMotionPredictorBuffers::pushSample(int64_t timestamp,
     // from the preceding two points (mAxisFrom/mAxisTo).
 
     mTimestamp = timestamp;
+    mGeneration++;
 
     if (!mAxisTo) { // First point.
         mAxisTo = sample;
@@ -353,12 +355,22 @@ void TfLiteMotionPredictorModel::attachInputTensors() {
     mInputPressure = findInputTensor(INPUT_PRESSURE, mRunner);
     mInputTilt = findInputTensor(INPUT_TILT, mRunner);
     mInputOrientation = findInputTensor(INPUT_ORIENTATION, mRunner);
+
+    mInputRBuffer = getTensorBuffer<float>(mInputR);
+    mInputPhiBuffer = getTensorBuffer<float>(mInputPhi);
+    mInputPressureBuffer = getTensorBuffer<float>(mInputPressure);
+    mInputTiltBuffer = getTensorBuffer<float>(mInputTilt);
+    mInputOrientationBuffer = getTensorBuffer<float>(mInputOrientation);
 }
 
 void TfLiteMotionPredictorModel::attachOutputTensors() {
     mOutputR = findOutputTensor(OUTPUT_R, mRunner);
     mOutputPhi = findOutputTensor(OUTPUT_PHI, mRunner);
     mOutputPressure = findOutputTensor(OUTPUT_PRESSURE, mRunner);
+
+    mOutputRBuffer = getTensorBuffer<const float>(mOutputR);
+    mOutputPhiBuffer = getTensorBuffer<const float>(mOutputPhi);
+    mOutputPressureBuffer = getTensorBuffer<const float>(mOutputPressure);
 }
 
 bool TfLiteMotionPredictorModel::invoke() {
@@ -383,43 +395,43 @@ bool TfLiteMotionPredictorModel::invoke() {
 }
 
 size_t TfLiteMotionPredictorModel::inputLength() const {
-    return getTensorBuffer<const float>(mInputR).size();
+    return mInputRBuffer.size();
 }
 
 size_t TfLiteMotionPredictorModel::outputLength() const {
-    return getTensorBuffer<const float>(mOutputR).size();
+    return mOutputRBuffer.size();
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputR() {
-    return getTensorBuffer<float>(mInputR);
+    return mInputRBuffer;
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputPhi() {
-    return getTensorBuffer<float>(mInputPhi);
+    return mInputPhiBuffer;
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputPressure() {
-    return getTensorBuffer<float>(mInputPressure);
+    return mInputPressureBuffer;
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputTilt() {
-    return getTensorBuffer<float>(mInputTilt);
+    return mInputTiltBuffer;
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputOrientation() {
-    return getTensorBuffer<float>(mInputOrientation);
+    return mInputOrientationBuffer;
 }
 
 std::span<const float> TfLiteMotionPredictorModel::outputR() const {
-    return getTensorBuffer<const float>(mOutputR);
+    return mOutputRBuffer;
 }
 
 std::span<const float> TfLiteMotionPredictorModel::outputPhi() const {
-    return getTensorBuffer<const float>(mOutputPhi);
+    return mOutputPhiBuffer;
 }
 
 std::span<const float> TfLiteMotionPredictorModel::outputPressure() const {
-    return getTensorBuffer<const float>(mOutputPressure);
+    return mOutputPressureBuffer;
 }
 
 } // namespace android
@@ -21,8 +21,10 @@
 #include <inttypes.h>
 #include <limits.h>
 #include <math.h>
+#include <string.h>
 #include <array>
 #include <optional>
+#include <span>
 
 #include <input/PrintTools.h>
 #include <input/VelocityTracker.h>
@@ -89,21 +91,35 @@ static std::string toString(std::chrono::nanoseconds t) {
     return stream.str();
 }
 
+// A vector of 4 floats. The compiler maps the operations on it to NEON or SSE instructions, and
+// falls back to scalar code on other targets.
+typedef float float4 __attribute__((vector_size(4 * sizeof(float))));
+
+static inline float4 loadFloat4(const float* a) {
+    float4 v;
+    memcpy(&v, a, sizeof(v));
+    return v;
+}
+
+static inline float sumLanes(float4 v) {
+    return (v[0] + v[1]) + (v[2] + v[3]);
+}
+
 static float vectorDot(const float* a, const float* b, uint32_t m) {
-    float r = 0;
-    for (size_t i = 0; i < m; i++) {
-        r += *(a++) * *(b++);
+    float4 sum = {0, 0, 0, 0};
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4) {
+        sum += loadFloat4(a + i) * loadFloat4(b + i);
+    }
+    float r = sumLanes(sum);
+    for (; i < m; i++) {
+        r += a[i] * b[i];
     }
     return r;
 }
 
 static float vectorNorm(const float* a, uint32_t m) {
-    float r = 0;
-    for (size_t i = 0; i < m; i++) {
-        float t = *(a++);
-        r += t * t;
-    }
-    return sqrtf(r);
+    return sqrtf(vectorDot(a, a, m));
 }
 
 static std::string vectorToString(const float* a, uint32_t m) {
@@ -119,7 +135,7 @@ static std::string vectorToString(const float* a, uint32_t m) {
     return str;
 }
 
-static std::string vectorToString(const std::vector<float>& v) {
+static std::string vectorToString(std::span<const float> v) {
     return vectorToString(v.data(), v.size());
 }
 
@@ -419,6 +435,23 @@ void AccumulatingVelocityTrackerStrategy::addMovement(nsecs_t eventTime, int32_t
     }
 }
 
+void AccumulatingVelocityTrackerStrategy::getMovementSamples(const RingBuffer<Movement>& movements,
+                                                             MovementSamples& outSamples) {
+    const size_t size = movements.size();
+    const nsecs_t newestEventTime = movements[size - 1].eventTime;
+    for (size_t i = 0; i < size; i++) {
+        const Movement& movement = movements[size - 1 - i];
+        nsecs_t age = newestEventTime - movement.eventTime;
+        outSamples.times[i] = -age * SECONDS_PER_NANO;
+        outSamples.positions[i] = movement.position;
+    }
+    for (size_t i = size; i < MovementSamples::CAPACITY; i++) {
+        outSamples.times[i] = 0;
+        outSamples.positions[i] = 0;
+    }
+    outSamples.count = size;
+}
+
 // --- LeastSquaresVelocityTrackerStrategy ---
 
 LeastSquaresVelocityTrackerStrategy::LeastSquaresVelocityTrackerStrategy(uint32_t degree,
@@ -479,9 +512,8 @@ LeastSquaresVelocityTrackerStrategy::~LeastSquaresVelocityTrackerStrategy() {}
  * http://en.wikipedia.org/wiki/Numerical_methods_for_linear_least_squares
  * http://en.wikipedia.org/wiki/Gram-Schmidt
  */
-static std::optional<float> solveLeastSquares(const std::vector<float>& x,
-                                              const std::vector<float>& y,
-                                              const std::vector<float>& w, uint32_t n) {
+static std::optional<float> solveLeastSquares(std::span<const float> x, std::span<const float> y,
+                                              std::span<const float> w, uint32_t n) {
     const size_t m = x.size();
 
     ALOGD_IF(DEBUG_STRATEGY, "solveLeastSquares: m=%d, n=%d, x=%s, y=%s, w=%s", int(m), int(n),
@@ -601,34 +633,36 @@ static std::optional<float> solveLeastSquares(const std::vector<float>& x,
  * the default implementation
  */
 std::optional<float> LeastSquaresVelocityTrackerStrategy::solveUnweightedLeastSquaresDeg2(
-        const RingBuffer<Movement>& movements) const {
+        const MovementSamples& samples) const {
     // Solving y = a*x^2 + b*x + c, where
     //      - "x" is age (i.e. duration since latest movement) of the movemnets
     //      - "y" is positions of the movements.
-    float sxi = 0, sxiyi = 0, syi = 0, sxi2 = 0, sxi3 = 0, sxi2yi = 0, sxi4 = 0;
-
-    const size_t count = movements.size();
-    const Movement& newestMovement = movements[count - 1];
-    for (size_t i = 0; i < count; i++) {
-        const Movement& movement = movements[i];
-        nsecs_t age = newestMovement.eventTime - movement.eventTime;
-        float xi = -age * SECONDS_PER_NANO;
-        float yi = movement.position;
-
-        float xi2 = xi*xi;
-        float xi3 = xi2*xi;
-        float xi4 = xi3*xi;
-        float xiyi = xi*yi;
-        float xi2yi = xi2*yi;
-
-        sxi += xi;
-        sxi2 += xi2;
-        sxiyi += xiyi;
-        sxi2yi += xi2yi;
-        syi += yi;
-        sxi3 += xi3;
-        sxi4 += xi4;
+    // The padding samples are zeros, so they don't contribute to the sums.
+    float4 vsxi = {0, 0, 0, 0}, vsxiyi = vsxi, vsyi = vsxi, vsxi2 = vsxi, vsxi3 = vsxi,
+           vsxi2yi = vsxi, vsxi4 = vsxi;
+
+    const size_t count = samples.count;
+    for (size_t i = 0; i < count; i += 4) {
+        float4 xi = loadFloat4(&samples.times[i]);
+        float4 yi = loadFloat4(&samples.positions[i]);
+
+        float4 xi2 = xi*xi;
+        float4 xi3 = xi2*xi;
+        float4 xi4 = xi3*xi;
+        float4 xiyi = xi*yi;
+        float4 xi2yi = xi2*yi;
+
+        vsxi += xi;
+        vsxi2 += xi2;
+        vsxiyi += xiyi;
+        vsxi2yi += xi2yi;
+        vsyi += yi;
+        vsxi3 += xi3;
+        vsxi4 += xi4;
     }
+    const float sxi = sumLanes(vsxi), sxiyi = sumLanes(vsxiyi), syi = sumLanes(vsyi),
+                sxi2 = sumLanes(vsxi2), sxi3 = sumLanes(vsxi3), sxi2yi = sumLanes(vsxi2yi),
+                sxi4 = sumLanes(vsxi4);
 
     float Sxx = sxi2 - sxi*sxi / count;
     float Sxy = sxiyi - sxi*syi / count;
@@ -666,31 +700,28 @@ std::optional<float> LeastSquaresVelocityTrackerStrategy::getVelocity(int32_t po
         return std::nullopt;
     }
 
+    // Collect the samples in reverse time order.
+    MovementSamples samples;
+    getMovementSamples(movements, samples);
+
     if (degree == 2 && mWeighting == Weighting::NONE) {
         // Optimize unweighted, quadratic polynomial fit
-        return solveUnweightedLeastSquaresDeg2(movements);
+        return solveUnweightedLeastSquaresDeg2(samples);
     }
 
-    // Iterate over movement samples in reverse time order and collect samples.
-    std::vector<float> positions;
-    std::vector<float> w;
-    std::vector<float> time;
-
-    const Movement& newestMovement = movements[size - 1];
-    for (ssize_t i = size - 1; i >= 0; i--) {
-        const Movement& movement = movements[i];
-        nsecs_t age = newestMovement.eventTime - movement.eventTime;
-        positions.push_back(movement.position);
-        w.push_back(chooseWeight(pointerId, i));
-        time.push_back(-age * 0.000000001f);
+    std::array<float, MovementSamples::CAPACITY> w;
+    for (size_t i = 0; i < size; i++) {
+        w[i] = chooseWeight(movements, size - 1 - i);
     }
 
     // General case for an Nth degree polynomial fit
-    return solveLeastSquares(time, positions, w, degree + 1);
+    return solveLeastSquares(std::span(samples.times.data(), size),
+                             std::span(samples.positions.data(), size), std::span(w.data(), size),
+                             degree + 1);
 }
 
-float LeastSquaresVelocityTrackerStrategy::chooseWeight(int32_t pointerId, uint32_t index) const {
-    const RingBuffer<Movement>& movements = mMovements.at(pointerId);
+float LeastSquaresVelocityTrackerStrategy::chooseWeight(const RingBuffer<Movement>& movements,
+                                                        uint32_t index) const {
     const size_t size = movements.size();
     switch (mWeighting) {
         case Weighting::DELTA: {
@@ -1003,14 +1034,32 @@ std::optional<float> ImpulseVelocityTrackerStrategy::getVelocity(int32_t pointer
         return std::nullopt; // no data
     }
 
-    float work = 0;
-    for (size_t i = 0; i < size - 1; i++) {
+    // Compute the velocity of every segment first, four at a time. Only the accumulation of the
+    // work depends on the previous segments.
+    const size_t segmentCount = size - 1;
+    constexpr size_t CAPACITY = MovementSamples::CAPACITY;
+    alignas(16) std::array<float, CAPACITY> deltas;
+    alignas(16) std::array<float, CAPACITY> durations;
+    for (size_t i = 0; i < segmentCount; i++) {
         const Movement& mvt = movements[i];
         const Movement& nextMvt = movements[i + 1];
+        deltas[i] = mDeltaValues ? nextMvt.position : nextMvt.position - mvt.position;
+        durations[i] = SECONDS_PER_NANO * (nextMvt.eventTime - mvt.eventTime);
+    }
+    for (size_t i = segmentCount; i < CAPACITY; i++) {
+        deltas[i] = 0;
+        durations[i] = 1;
+    }
+    alignas(16) std::array<float, CAPACITY> velocities;
+    for (size_t i = 0; i < segmentCount; i += 4) {
+        const float4 v = loadFloat4(&deltas[i]) / loadFloat4(&durations[i]);
+        memcpy(&velocities[i], &v, sizeof(v));
+    }
 
+    float work = 0;
+    for (size_t i = 0; i < segmentCount; i++) {
         float vprev = kineticEnergyToVelocity(work);
-        float delta = mDeltaValues ? nextMvt.position : nextMvt.position - mvt.position;
-        float vcurr = delta / (SECONDS_PER_NANO * (nextMvt.eventTime - mvt.eventTime));
+        float vcurr = velocities[i];
         work += (vcurr - vprev) * fabsf(vcurr);
 
         if (i == 0) {
@@ -227,6 +227,105 @@ TEST_F(InputChannelTest, SendAndReceive_MotionClassification) {
     }
 }
 
+TEST_F(InputChannelTest, SendAndReceiveMessages_PreservesMessageBoundaries) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+
+    status_t result =
+            InputChannel::openInputChannelPair("channel name", serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    // Send messages of different sizes with a single call.
+    std::array<InputMessage, 3> serverMsgs;
+    for (size_t i = 0; i < serverMsgs.size(); i++) {
+        InputMessage msg = {};
+        msg.header.type = InputMessage::Type::MOTION;
+        msg.header.seq = i + 1;
+        msg.body.motion.action = AMOTION_EVENT_ACTION_MOVE;
+        msg.body.motion.pointerCount = i + 1;
+        msg.getSanitizedCopy(&serverMsgs[i]);
+    }
+    size_t sent;
+    EXPECT_EQ(OK, serverChannel->sendMessages(serverMsgs, &sent));
+    EXPECT_EQ(serverMsgs.size(), sent);
+
+    // The first read only has room for two of them.
+    std::array<InputMessage, 2> clientMsgs;
+    android::base::Result<size_t> received = clientChannel->receiveMessages(clientMsgs);
+    ASSERT_TRUE(received.ok()) << "client channel should be able to receive messages";
+    ASSERT_EQ(2u, *received);
+    EXPECT_EQ(1u, clientMsgs[0].header.seq);
+    EXPECT_EQ(1u, clientMsgs[0].body.motion.pointerCount);
+    EXPECT_EQ(2u, clientMsgs[1].header.seq);
+    EXPECT_EQ(2u, clientMsgs[1].body.motion.pointerCount);
+
+    received = clientChannel->receiveMessages(clientMsgs);
+    ASSERT_TRUE(received.ok()) << "client channel should be able to receive messages";
+    ASSERT_EQ(1u, *received);
+    EXPECT_EQ(3u, clientMsgs[0].header.seq);
+    EXPECT_EQ(3u, clientMsgs[0].body.motion.pointerCount);
+
+    received = clientChannel->receiveMessages(clientMsgs);
+    ASSERT_FALSE(received.ok());
+    EXPECT_EQ(WOULD_BLOCK, received.error().code());
+
+    serverChannel.reset();
+    received = clientChannel->receiveMessages(clientMsgs);
+    ASSERT_FALSE(received.ok());
+    EXPECT_EQ(DEAD_OBJECT, received.error().code());
+}
+
+TEST_F(InputChannelTest, SendAndReceive_WithSharedMemoryRing) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+
+    status_t result = InputChannel::openInputChannelPair("channel name", serverChannel,
+                                                         clientChannel,
+                                                         /*useSharedMemoryRing=*/true);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    // Send the client channel to another "process", as the dispatcher would.
+    android::os::InputChannelCore parceledChannel;
+    InputChannel::moveChannel(std::move(clientChannel), parceledChannel);
+    ASSERT_TRUE(parceledChannel.ring.has_value()) << "the ring should be sent with the channel";
+    clientChannel = InputChannel::create(std::move(parceledChannel));
+
+    EXPECT_FALSE(clientChannel->probablyHasInput());
+    for (uint32_t seq = 1; seq <= 3; seq++) {
+        InputMessage serverMsg = {};
+        serverMsg.header.type = InputMessage::Type::KEY;
+        serverMsg.header.seq = seq;
+        serverMsg.body.key.action = AKEY_EVENT_ACTION_DOWN;
+        EXPECT_EQ(OK, serverChannel->sendMessage(&serverMsg));
+    }
+    EXPECT_TRUE(clientChannel->probablyHasInput());
+
+    for (uint32_t seq = 1; seq <= 3; seq++) {
+        android::base::Result<InputMessage> clientMsg = clientChannel->receiveMessage();
+        ASSERT_TRUE(clientMsg.ok()) << "client channel should be able to receive messages";
+        EXPECT_EQ(seq, clientMsg->header.seq);
+        EXPECT_EQ(AKEY_EVENT_ACTION_DOWN, clientMsg->body.key.action);
+    }
+    // The doorbell sent with the first message should have been consumed as well.
+    android::base::Result<InputMessage> clientMsg = clientChannel->receiveMessage();
+    ASSERT_FALSE(clientMsg.ok());
+    EXPECT_EQ(WOULD_BLOCK, clientMsg.error().code());
+    EXPECT_FALSE(clientChannel->probablyHasInput());
+
+    // Replies still go through the socket.
+    InputMessage clientReply = {};
+    clientReply.header.type = InputMessage::Type::FINISHED;
+    clientReply.header.seq = 1;
+    clientReply.body.finished.handled = true;
+    EXPECT_EQ(OK, clientChannel->sendMessage(&clientReply));
+    android::base::Result<InputMessage> serverReply = serverChannel->receiveMessage();
+    ASSERT_TRUE(serverReply.ok()) << "server channel should be able to receive the reply";
+    EXPECT_EQ(InputMessage::Type::FINISHED, serverReply->header.type);
+
+    serverChannel.reset();
+    clientMsg = clientChannel->receiveMessage();
+    ASSERT_FALSE(clientMsg.ok());
+    EXPECT_EQ(DEAD_OBJECT, clientMsg.error().code());
+}
+
 TEST_F(InputChannelTest, DuplicateChannelAndAssertEqual) {
     std::unique_ptr<InputChannel> serverChannel, clientChannel;
 
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <memory>
+
+#include <gtest/gtest.h>
+#include <input/InputMessageRing.h>
+#include <input/InputTransport.h>
+
+namespace android {
+namespace {
+
+InputMessage createMotionMessage(uint32_t seq, uint32_t pointerCount) {
+    InputMessage msg = {};
+    msg.header.type = InputMessage::Type::MOTION;
+    msg.header.seq = seq;
+    msg.body.motion.action = AMOTION_EVENT_ACTION_MOVE;
+    msg.body.motion.pointerCount = pointerCount;
+    InputMessage cleanMsg;
+    msg.getSanitizedCopy(&cleanMsg);
+    return cleanMsg;
+}
+
+class InputMessageRingTest : public testing::Test {
+protected:
+    void SetUp() override {
+        android::base::Result<std::unique_ptr<InputMessageRing>> producer =
+                InputMessageRing::create("test");
+        ASSERT_TRUE(producer.ok()) << producer.error();
+        mProducer = std::move(*producer);
+        android::base::Result<std::unique_ptr<InputMessageRing>> consumer =
+                InputMessageRing::map(android::base::unique_fd(::dup(mProducer->getFd())),
+                                      /*isProducer=*/false);
+        ASSERT_TRUE(consumer.ok()) << consumer.error();
+        mConsumer = std::move(*consumer);
+    }
+
+    std::unique_ptr<InputMessageRing> mProducer;
+    std::unique_ptr<InputMessageRing> mConsumer;
+};
+
+TEST_F(InputMessageRingTest, WriteAndRead) {
+    InputMessage msg;
+    EXPECT_FALSE(mConsumer->hasMessages());
+    EXPECT_EQ(WOULD_BLOCK, mConsumer->read(&msg));
+
+    bool wakeConsumer;
+    ASSERT_EQ(OK, mProducer->write(createMotionMessage(/*seq=*/1, /*pointerCount=*/1),
+                                   &wakeConsumer));
+    EXPECT_TRUE(wakeConsumer) << "the consumer should be woken up when the ring was empty";
+    ASSERT_EQ(OK, mProducer->write(createMotionMessage(/*seq=*/2, /*pointerCount=*/2),
+                                   &wakeConsumer));
+    EXPECT_FALSE(wakeConsumer) << "the consumer hasn't read the previous message yet";
+
+    EXPECT_TRUE(mConsumer->hasMessages());
+    ASSERT_EQ(OK, mConsumer->read(&msg));
+    EXPECT_EQ(1u, msg.header.seq);
+    EXPECT_EQ(1u, msg.body.motion.pointerCount);
+    ASSERT_EQ(OK, mConsumer->read(&msg));
+    EXPECT_EQ(2u, msg.header.seq);
+    EXPECT_EQ(2u, msg.body.motion.pointerCount);
+    EXPECT_EQ(WOULD_BLOCK, mConsumer->read(&msg));
+}
+
+TEST_F(InputMessageRingTest, FullRingWouldBlockAndWrapsAround) {
+    // Fill the ring, then keep it partly full while writing enough to wrap around several times.
+    bool wakeConsumer;
+    uint32_t written = 0;
+    while (mProducer->write(createMotionMessage(written + 1, MAX_POINTERS), &wakeConsumer) == OK) {
+        written++;
+    }
+    ASSERT_GT(written, 1u);
+    EXPECT_EQ(WOULD_BLOCK,
+              mProducer->write(createMotionMessage(written + 1, MAX_POINTERS), &wakeConsumer));
+
+    const uint32_t total = 5 * written;
+    uint32_t readCount = 0;
+    InputMessage msg;
+    while (readCount < total) {
+        ASSERT_EQ(OK, mConsumer->read(&msg));
+        readCount++;
+        ASSERT_EQ(readCount, msg.header.seq);
+        while (written < total &&
+               mProducer->write(createMotionMessage(written + 1, 1 + written % MAX_POINTERS),
+                                &wakeConsumer) == OK) {
+            written++;
+        }
+    }
+    EXPECT_EQ(WOULD_BLOCK, mConsumer->read(&msg));
+}
+
+TEST_F(InputMessageRingTest, MapRejectsUnsealedMemory) {
+    android::base::unique_fd fd(memfd_create("unsealed", MFD_CLOEXEC));
+    ASSERT_TRUE(fd.ok());
+    ASSERT_EQ(0, ftruncate(fd.get(), 1024 * 1024));
+    EXPECT_FALSE(InputMessageRing::map(std::move(fd), /*isProducer=*/false).ok());
+}
+
+} // namespace
+} // namespace android
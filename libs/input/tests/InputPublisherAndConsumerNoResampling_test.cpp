@@ -934,6 +934,51 @@ TEST_F(InputPublisherAndConsumerNoResamplingTest, PublishMultipleEvents_EndToEnd
     ASSERT_NO_FATAL_FAILURE(publishAndConsumeTouchModeEvent());
 }
 
+TEST_F(InputPublisherAndConsumerNoResamplingTest, PublishBatch_EndToEnd) {
+    const nsecs_t publishTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    std::array<int32_t, 3> eventIds;
+
+    mPublisher->beginBatch();
+    for (uint32_t i = 0; i < eventIds.size(); i++) {
+        eventIds[i] = InputEvent::nextId();
+        ASSERT_EQ(OK, mPublisher->publishFocusEvent(/*seq=*/i + 1, eventIds[i], /*hasFocus=*/i % 2))
+                << "publisher publishFocusEvent should return OK while batching";
+    }
+    size_t sent;
+    ASSERT_EQ(OK, mPublisher->endBatch(&sent));
+    ASSERT_EQ(eventIds.size(), sent);
+
+    for (uint32_t i = 0; i < eventIds.size(); i++) {
+        std::optional<std::unique_ptr<FocusEvent>> optFocusEvent =
+                mFocusEvents.popWithTimeout(TIMEOUT);
+        ASSERT_TRUE(optFocusEvent.has_value()) << "consumer should have returned non-NULL event";
+        EXPECT_EQ(eventIds[i], (*optFocusEvent)->getId());
+        EXPECT_EQ(i % 2 == 1, (*optFocusEvent)->getHasFocus());
+        verifyFinishedSignal(*mPublisher, /*seq=*/i + 1, publishTime);
+    }
+}
+
+TEST_F(InputPublisherAndConsumerNoResamplingTest, PublishBatch_SingleEvent) {
+    const nsecs_t publishTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    const int32_t eventId = InputEvent::nextId();
+
+    mPublisher->beginBatch();
+    ASSERT_EQ(OK, mPublisher->publishFocusEvent(/*seq=*/1, eventId, /*hasFocus=*/true));
+    size_t sent;
+    ASSERT_EQ(OK, mPublisher->endBatch(&sent));
+    ASSERT_EQ(1u, sent);
+
+    std::optional<std::unique_ptr<FocusEvent>> optFocusEvent = mFocusEvents.popWithTimeout(TIMEOUT);
+    ASSERT_TRUE(optFocusEvent.has_value()) << "consumer should have returned non-NULL event";
+    EXPECT_EQ(eventId, (*optFocusEvent)->getId());
+    verifyFinishedSignal(*mPublisher, /*seq=*/1, publishTime);
+
+    // An empty batch sends nothing.
+    mPublisher->beginBatch();
+    ASSERT_EQ(OK, mPublisher->endBatch(&sent));
+    ASSERT_EQ(0u, sent);
+}
+
 TEST_F(InputPublisherAndConsumerNoResamplingTest, PublishAndConsumeSinglePointer) {
     publishAndConsumeSinglePointerMultipleSamples(3);
 }
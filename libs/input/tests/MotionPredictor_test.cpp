@@ -182,6 +182,30 @@ TEST(MotionPredictorTest, IsPredictionAvailable) {
     ASSERT_FALSE(predictor.isPredictionAvailable(/*deviceId=*/1, AINPUT_SOURCE_TOUCHSCREEN));
 }
 
+TEST(MotionPredictorTest, RepeatedPredictionsWithoutNewSamples) {
+    MotionPredictor predictor(/*predictionTimestampOffsetNanos=*/0,
+                              []() { return true /*enable prediction*/; });
+    predictor.record(getMotionEvent(DOWN, 3.75, 3, 20ms));
+    predictor.record(getMotionEvent(MOVE, 4.8, 3, 30ms));
+    predictor.record(getMotionEvent(MOVE, 6.2, 3, 40ms));
+    std::unique_ptr<MotionEvent> first = predictor.predict(90 * NSEC_PER_MSEC);
+    ASSERT_NE(nullptr, first);
+
+    // The model output is reused, so the same prediction is produced again.
+    std::unique_ptr<MotionEvent> second = predictor.predict(90 * NSEC_PER_MSEC);
+    ASSERT_NE(nullptr, second);
+    ASSERT_EQ(first->getHistorySize(), second->getHistorySize());
+    EXPECT_EQ(first->getEventTime(), second->getEventTime());
+    EXPECT_EQ(first->getX(0), second->getX(0));
+    EXPECT_EQ(first->getY(0), second->getY(0));
+
+    // A new sample must still be taken into account.
+    predictor.record(getMotionEvent(MOVE, 8, 3, 50ms));
+    std::unique_ptr<MotionEvent> third = predictor.predict(90 * NSEC_PER_MSEC);
+    ASSERT_NE(nullptr, third);
+    EXPECT_GT(third->getHistoricalEventTime(0), first->getHistoricalEventTime(0));
+}
+
 TEST(MotionPredictorTest, StationaryNoiseFloor) {
     MotionPredictor predictor(/*predictionTimestampOffsetNanos=*/1,
                               []() { return true /*enable prediction*/; });
@@ -73,6 +73,18 @@ base::Result<InputMessage> TestInputChannel::receiveMessage() {
     return message;
 }
 
+base::Result<size_t> TestInputChannel::receiveMessages(std::span<InputMessage> outMessages) {
+    if (mReceivedMessages.empty()) {
+        return base::Error(WOULD_BLOCK);
+    }
+    size_t received = 0;
+    while (received < outMessages.size() && !mReceivedMessages.empty()) {
+        outMessages[received++] = mReceivedMessages.front();
+        mReceivedMessages.pop();
+    }
+    return received;
+}
+
 bool TestInputChannel::probablyHasInput() const {
     return !mReceivedMessages.empty();
 }
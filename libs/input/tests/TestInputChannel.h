@@ -17,6 +17,7 @@
 #pragma once
 
 #include <queue>
+#include <span>
 #include <string>
 
 #include <android-base/result.h>
@@ -48,6 +49,11 @@ public:
      */
     base::Result<InputMessage> receiveMessage() override;
 
+    /**
+     * Moves as many InputMessages from mReceivedMessages as fit into outMessages.
+     */
+    base::Result<size_t> receiveMessages(std::span<InputMessage> outMessages) override;
+
     /**
      * Returns if mReceivedMessages is not empty.
      */
@@ -50,6 +50,19 @@ TEST(TfLiteMotionPredictorTest, BuffersReadiness) {
     ASSERT_FALSE(buffers.isReady());
 }
 
+TEST(TfLiteMotionPredictorTest, BuffersGeneration) {
+    TfLiteMotionPredictorBuffers buffers(/*inputLength=*/5);
+    const uint64_t initial = buffers.generation();
+
+    buffers.pushSample(/*timestamp=*/0, {.position = {.x = 100, .y = 100}});
+    const uint64_t afterPush = buffers.generation();
+    EXPECT_NE(initial, afterPush);
+
+    buffers.reset();
+    EXPECT_NE(afterPush, buffers.generation());
+    EXPECT_NE(initial, buffers.generation());
+}
+
 TEST(TfLiteMotionPredictorTest, BuffersRecentData) {
     TfLiteMotionPredictorBuffers buffers(/*inputLength=*/5);
 
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <input/VelocityTracker.h>
+
+namespace android {
+
+namespace {
+
+// The interval between the movements, as reported by a touchscreen at 200 Hz.
+constexpr nsecs_t MOVEMENT_INTERVAL = 5'000'000;
+
+// Enough movements to fill the history of the strategies.
+constexpr size_t MOVEMENT_COUNT = 20;
+
+/**
+ * Adds a fling-like gesture for each pointer, and then measures the velocity computation for all
+ * of them, as done by apps on every frame.
+ */
+void benchmarkComputeVelocity(benchmark::State& state, VelocityTracker::Strategy strategy,
+                              int32_t axis) {
+    const size_t pointerCount = state.range(0);
+    VelocityTracker tracker(strategy);
+    for (size_t i = 0; i < MOVEMENT_COUNT; i++) {
+        const nsecs_t eventTime = i * MOVEMENT_INTERVAL;
+        for (size_t pointerId = 0; pointerId < pointerCount; pointerId++) {
+            // Accelerating movements, with some variation between the pointers.
+            const float position = 100 + pointerId * 10 + i * i * 0.7f + i * 3;
+            tracker.addMovement(eventTime, pointerId, axis, position);
+        }
+    }
+
+    for (auto _ : state) {
+        VelocityTracker::ComputedVelocity velocity =
+                tracker.getComputedVelocity(/*units=*/1000, /*maxVelocity=*/100000);
+        benchmark::DoNotOptimize(velocity);
+    }
+}
+
+void benchmarkComputeVelocityLsq2(benchmark::State& state) {
+    benchmarkComputeVelocity(state, VelocityTracker::Strategy::LSQ2, AMOTION_EVENT_AXIS_X);
+}
+
+void benchmarkComputeVelocityLsq3(benchmark::State& state) {
+    benchmarkComputeVelocity(state, VelocityTracker::Strategy::LSQ3, AMOTION_EVENT_AXIS_X);
+}
+
+void benchmarkComputeVelocityWlsq2Recent(benchmark::State& state) {
+    benchmarkComputeVelocity(state, VelocityTracker::Strategy::WLSQ2_RECENT,
+                             AMOTION_EVENT_AXIS_X);
+}
+
+void benchmarkComputeVelocityImpulse(benchmark::State& state) {
+    benchmarkComputeVelocity(state, VelocityTracker::Strategy::IMPULSE, AMOTION_EVENT_AXIS_X);
+}
+
+} // namespace
+
+BENCHMARK(benchmarkComputeVelocityLsq2)->Arg(1)->Arg(10);
+BENCHMARK(benchmarkComputeVelocityLsq3)->Arg(1)->Arg(10);
+BENCHMARK(benchmarkComputeVelocityWlsq2Recent)->Arg(1)->Arg(10);
+BENCHMARK(benchmarkComputeVelocityImpulse)->Arg(1)->Arg(10);
+
+} // namespace android
@@ -18,6 +18,9 @@
 
 #include <inttypes.h>
 #include <limits.h>
+#include <string.h>
+
+#include <algorithm>
 
 #include <android-base/stringprintf.h>
 
@@ -296,10 +299,8 @@ bool Region::hasSameRects(const Region& other) const {
 
     if (thisRectCount != otherRectCount) return false;
 
-    for (size_t i = 0; i < thisRectCount; i++) {
-        if (thisRects[i] != otherRects[i]) return false;
-    }
-    return true;
+    // Rects are plain arrays of int32_t, so this compares them all at once.
+    return memcmp(thisRects, otherRects, thisRectCount * sizeof(Rect)) == 0;
 }
 
 // ----------------------------------------------------------------------------
@@ -329,8 +330,10 @@ Region& Region::subtractSelf(const Rect& r) {
     return operationSelf(r, op_nand);
 }
 Region& Region::operationSelf(const Rect& r, uint32_t op) {
-    Region lhs(*this);
-    boolean_operation(op, *this, lhs, r);
+    if (!trivial_operation(op, *this, *this, r, 0, 0)) {
+        Region lhs(*this);
+        boolean_operation(op, *this, lhs, r);
+    }
     return *this;
 }
 
@@ -353,8 +356,10 @@ Region& Region::subtractSelf(const Region& rhs) {
     return operationSelf(rhs, op_nand);
 }
 Region& Region::operationSelf(const Region& rhs, uint32_t op) {
-    Region lhs(*this);
-    boolean_operation(op, *this, lhs, rhs);
+    if (!trivial_operation(op, *this, *this, rhs, 0, 0)) {
+        Region lhs(*this);
+        boolean_operation(op, *this, lhs, rhs);
+    }
     return *this;
 }
 
@@ -438,8 +443,10 @@ Region& Region::subtractSelf(const Region& rhs, int dx, int dy) {
     return operationSelf(rhs, dx, dy, op_nand);
 }
 Region& Region::operationSelf(const Region& rhs, int dx, int dy, uint32_t op) {
-    Region lhs(*this);
-    boolean_operation(op, *this, lhs, rhs, dx, dy);
+    if (!trivial_operation(op, *this, *this, rhs, dx, dy)) {
+        Region lhs(*this);
+        boolean_operation(op, *this, lhs, rhs, dx, dy);
+    }
     return *this;
 }
 
@@ -535,15 +542,13 @@ void Region::rasterizer::flushSpan()
         Rect const* p = span.data();
         Rect const* q = head;
         if (p->top == q->bottom) {
-            merge = true;
-            while (q != tail) {
-                if ((p->left != q->left) || (p->right != q->right)) {
-                    merge = false;
-                    break;
-                }
-                p++;
-                q++;
+            // Compare the spans without branching, so that the loop can be
+            // vectorized.
+            int32_t diff = 0;
+            for (ssize_t i = 0; i < tail - head; i++) {
+                diff |= (p[i].left ^ q[i].left) | (p[i].right ^ q[i].right);
             }
+            merge = diff == 0;
         }
     }
     if (merge) {
@@ -643,6 +648,151 @@ bool Region::validate(const Region& reg, const char* name, bool silent)
     return result;
 }
 
+enum class TrivialResult { NONE, EMPTY, LHS, RHS, RECT };
+
+static inline bool containsRect(const Rect& outer, const Rect& inner) {
+    return outer.left <= inner.left && outer.top <= inner.top && outer.right >= inner.right &&
+            outer.bottom >= inner.bottom;
+}
+
+// Tells whether the result of an operation can be determined from the bounds of
+// its operands, and whether they are single rects. When the result is a single
+// rect other than one of the operands, it is returned in outRect.
+static TrivialResult classifyOperation(uint32_t op, const Region& lhs, const Rect& rhsBounds,
+                                       bool rhsIsRect, Rect* outRect) {
+    const Rect lhsBounds = lhs.getBounds();
+    // Leave the INVALID_RECT signal value to the rasterizer
+    if (!lhsBounds.isValid() || !rhsBounds.isValid()) {
+        return TrivialResult::NONE;
+    }
+
+    if (lhsBounds.isEmpty()) {
+        if (op == op_and || op == op_nand || rhsBounds.isEmpty()) {
+            return TrivialResult::EMPTY;
+        }
+        return TrivialResult::RHS;
+    }
+    if (rhsBounds.isEmpty()) {
+        return op == op_and ? TrivialResult::EMPTY : TrivialResult::LHS;
+    }
+
+    const bool bothRects = lhs.isRect() && rhsIsRect;
+    const Rect& l = lhsBounds;
+    const Rect& r = rhsBounds;
+    Rect intersection;
+    if (!l.intersect(r, &intersection)) {
+        if (op == op_and) return TrivialResult::EMPTY;
+        if (op == op_nand) return TrivialResult::LHS;
+        // Rects which share a whole edge merge into a single rect
+        const bool stacked = l.left == r.left && l.right == r.right &&
+                (l.bottom == r.top || r.bottom == l.top);
+        const bool sideBySide = l.top == r.top && l.bottom == r.bottom &&
+                (l.right == r.left || r.right == l.left);
+        if (op == op_or && bothRects && (stacked || sideBySide)) {
+            *outRect = Rect(std::min(l.left, r.left), std::min(l.top, r.top),
+                            std::max(l.right, r.right), std::max(l.bottom, r.bottom));
+            return TrivialResult::RECT;
+        }
+        return TrivialResult::NONE;
+    }
+
+    if (!bothRects) {
+        return TrivialResult::NONE;
+    }
+
+    switch (op) {
+        case op_and:
+            *outRect = intersection;
+            return TrivialResult::RECT;
+        case op_or:
+            if (containsRect(l, r)) return TrivialResult::LHS;
+            if (containsRect(r, l)) return TrivialResult::RHS;
+            if ((l.left == r.left && l.right == r.right) ||
+                (l.top == r.top && l.bottom == r.bottom)) {
+                *outRect = Rect(std::min(l.left, r.left), std::min(l.top, r.top),
+                                std::max(l.right, r.right), std::max(l.bottom, r.bottom));
+                return TrivialResult::RECT;
+            }
+            return TrivialResult::NONE;
+        case op_nand:
+            if (containsRect(r, l)) return TrivialResult::EMPTY;
+            // Cutting off one whole side leaves a single rect
+            if (r.left <= l.left && r.right >= l.right) {
+                if (r.top <= l.top) {
+                    *outRect = Rect(l.left, r.bottom, l.right, l.bottom);
+                    return TrivialResult::RECT;
+                }
+                if (r.bottom >= l.bottom) {
+                    *outRect = Rect(l.left, l.top, l.right, r.top);
+                    return TrivialResult::RECT;
+                }
+            }
+            if (r.top <= l.top && r.bottom >= l.bottom) {
+                if (r.left <= l.left) {
+                    *outRect = Rect(r.right, l.top, l.right, l.bottom);
+                    return TrivialResult::RECT;
+                }
+                if (r.right >= l.right) {
+                    *outRect = Rect(l.left, l.top, r.left, l.bottom);
+                    return TrivialResult::RECT;
+                }
+            }
+            return TrivialResult::NONE;
+        default:
+            return TrivialResult::NONE;
+    }
+}
+
+bool Region::trivial_operation(uint32_t op, Region& dst,
+        const Region& lhs, const Region& rhs, int dx, int dy)
+{
+    Rect rhsBounds(rhs.getBounds());
+    rhsBounds.offsetBy(dx, dy);
+    Rect rect;
+    switch (classifyOperation(op, lhs, rhsBounds, rhs.isRect(), &rect)) {
+        case TrivialResult::NONE:
+            break;
+        case TrivialResult::EMPTY:
+            dst.clear();
+            return true;
+        case TrivialResult::LHS:
+            dst = lhs;
+            return true;
+        case TrivialResult::RHS:
+            translate(dst, rhs, dx, dy);
+            return true;
+        case TrivialResult::RECT:
+            dst.set(rect);
+            return true;
+    }
+    return false;
+}
+
+bool Region::trivial_operation(uint32_t op, Region& dst,
+        const Region& lhs, const Rect& rhs, int dx, int dy)
+{
+    Rect rhsRect(rhs);
+    rhsRect.offsetBy(dx, dy);
+    Rect rect;
+    switch (classifyOperation(op, lhs, rhsRect, true, &rect)) {
+        case TrivialResult::NONE:
+            break;
+        case TrivialResult::EMPTY:
+            dst.clear();
+            return true;
+        case TrivialResult::LHS:
+            dst = lhs;
+            return true;
+        case TrivialResult::RHS:
+            dst.set(rhsRect);
+            return true;
+        case TrivialResult::RECT:
+            dst.set(rect);
+            return true;
+    }
+    return false;
+}
+
 void Region::boolean_operation(uint32_t op, Region& dst,
         const Region& lhs,
         const Region& rhs, int dx, int dy)
@@ -653,6 +803,12 @@ void Region::boolean_operation(uint32_t op, Region& dst,
     validate(dst, "boolean_operation (before): dst");
 #endif
 
+#if !VALIDATE_WITH_CORECG
+    if (trivial_operation(op, dst, lhs, rhs, dx, dy)) {
+        return;
+    }
+#endif
+
     size_t lhs_count;
     Rect const * const lhs_rects = lhs.getArray(&lhs_count);
 
@@ -767,6 +923,10 @@ void Region::boolean_operation(uint32_t op, Region& dst,
 #if VALIDATE_WITH_CORECG || defined(VALIDATE_REGIONS)
     boolean_operation(op, dst, lhs, Region(rhs), dx, dy);
 #else
+    if (trivial_operation(op, dst, lhs, rhs, dx, dy)) {
+        return;
+    }
+
     size_t lhs_count;
     Rect const * const lhs_rects = lhs.getArray(&lhs_count);
 
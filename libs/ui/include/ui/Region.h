@@ -161,6 +161,14 @@ private:
     const Region operation(const Region& rhs, uint32_t op) const;
     const Region operation(const Region& rhs, int dx, int dy, uint32_t op) const;
 
+    // Computes the operations whose result is one of the operands or a single
+    // rect without rasterizing them. Returns false if the operation needs to be
+    // rasterized. dst may be the same as lhs.
+    static bool trivial_operation(uint32_t op, Region& dst,
+            const Region& lhs, const Region& rhs, int dx, int dy);
+    static bool trivial_operation(uint32_t op, Region& dst,
+            const Region& lhs, const Rect& rhs, int dx, int dy);
+
     static void boolean_operation(uint32_t op, Region& dst,
             const Region& lhs, const Region& rhs, int dx, int dy);
     static void boolean_operation(uint32_t op, Region& dst,
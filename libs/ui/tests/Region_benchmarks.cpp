@@ -0,0 +1,138 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <ui/Rect.h>
+#include <ui/Region.h>
+
+namespace android {
+
+namespace {
+
+const Rect DISPLAY_RECT(1080, 2400);
+
+/**
+ * Accumulates the bounds of partly overlapping layers, as done when computing the dirty and
+ * covered regions of an output.
+ */
+void benchmarkOrSelfOverlappingRects(benchmark::State& state) {
+    const int32_t rectCount = static_cast<int32_t>(state.range(0));
+    for (auto _ : state) {
+        Region region;
+        for (int32_t i = 0; i < rectCount; i++) {
+            region.orSelf(Rect(i * 37, i * 53, i * 37 + 540, i * 53 + 800));
+        }
+        benchmark::DoNotOptimize(region);
+    }
+}
+
+/**
+ * Accumulates the bounds of fullscreen layers, which is the common case of layers that cover
+ * each other.
+ */
+void benchmarkOrSelfNestedRects(benchmark::State& state) {
+    const int32_t rectCount = static_cast<int32_t>(state.range(0));
+    for (auto _ : state) {
+        Region region;
+        for (int32_t i = 0; i < rectCount; i++) {
+            region.orSelf(DISPLAY_RECT);
+        }
+        benchmark::DoNotOptimize(region);
+    }
+}
+
+/**
+ * Removes a status bar from a fullscreen layer, as done when subtracting the opaque region of the
+ * layers above.
+ */
+void benchmarkSubtractSelfEdge(benchmark::State& state) {
+    const Rect statusBar(0, 0, DISPLAY_RECT.right, 100);
+    for (auto _ : state) {
+        Region region(DISPLAY_RECT);
+        region.subtractSelf(statusBar);
+        benchmark::DoNotOptimize(region);
+    }
+}
+
+/** Removes a rect from the middle of another one, which needs to be rasterized. */
+void benchmarkSubtractSelfHole(benchmark::State& state) {
+    const Rect hole(100, 100, 500, 500);
+    for (auto _ : state) {
+        Region region(DISPLAY_RECT);
+        region.subtractSelf(hole);
+        benchmark::DoNotOptimize(region);
+    }
+}
+
+/** Subtracts a rect that doesn't intersect the region. */
+void benchmarkSubtractSelfDisjoint(benchmark::State& state) {
+    Region base(Rect(0, 0, 540, 1200));
+    base.orSelf(Rect(540, 1200, 1080, 2400));
+    const Region disjoint(Rect(0, 1200, 540, 2400));
+    for (auto _ : state) {
+        Region region(base);
+        region.subtractSelf(disjoint);
+        benchmark::DoNotOptimize(region);
+    }
+}
+
+/** Clips a layer to the display, as done when computing the visible region of a layer. */
+void benchmarkIntersectRects(benchmark::State& state) {
+    const Region layer(Rect(-100, 200, 900, 3000));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(layer.intersect(DISPLAY_RECT));
+    }
+}
+
+/** Merges two regions of several rects each. */
+void benchmarkMergeRegions(benchmark::State& state) {
+    Region lhs;
+    Region rhs;
+    for (int32_t i = 0; i < 8; i++) {
+        lhs.orSelf(Rect(i * 100, i * 200, i * 100 + 50, i * 200 + 150));
+        rhs.orSelf(Rect(i * 100 + 25, i * 200 + 100, i * 100 + 75, i * 200 + 250));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lhs.merge(rhs));
+    }
+}
+
+/** Copies a region of the given number of rects. */
+void benchmarkCopy(benchmark::State& state) {
+    const int32_t rectCount = static_cast<int32_t>(state.range(0));
+    Region source;
+    for (int32_t i = 0; i < rectCount; i++) {
+        source.orSelf(Rect(i * 20, i * 20, i * 20 + 10, i * 20 + 10));
+    }
+    for (auto _ : state) {
+        Region region(source);
+        benchmark::DoNotOptimize(region);
+    }
+}
+
+} // namespace
+
+BENCHMARK(benchmarkOrSelfOverlappingRects)->Arg(2)->Arg(16);
+BENCHMARK(benchmarkOrSelfNestedRects)->Arg(2)->Arg(16);
+BENCHMARK(benchmarkSubtractSelfEdge);
+BENCHMARK(benchmarkSubtractSelfHole);
+BENCHMARK(benchmarkSubtractSelfDisjoint);
+BENCHMARK(benchmarkIntersectRects);
+BENCHMARK(benchmarkMergeRegions);
+BENCHMARK(benchmarkCopy)->Arg(1)->Arg(4)->Arg(16);
+
+} // namespace android
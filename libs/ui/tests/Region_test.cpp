@@ -21,6 +21,10 @@
 #include <ui/Rect.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 namespace android {
 
 class RegionTest : public testing::Test {
@@ -53,6 +57,48 @@ protected:
         }
         EXPECT_TRUE((original ^ modified).isEmpty());
     }
+
+    using Rects = std::vector<Rect>;
+
+    static Region toRegion(const Rects& rects) {
+        Region region;
+        for (const Rect& rect : rects) {
+            region.orSelf(rect);
+        }
+        return region;
+    }
+
+    static bool coversPixel(const Rects& rects, int x, int y) {
+        return std::any_of(rects.begin(), rects.end(), [x, y](const Rect& rect) {
+            return x >= rect.left && x < rect.right && y >= rect.top && y < rect.bottom;
+        });
+    }
+
+    // Checks every pixel around the operands against the result of the operation, with rhs
+    // translated by (dx, dy).
+    void checkCoverage(const Region& result, const Rects& lhs, const Rects& rhs, int dx, int dy,
+                       bool (*op)(bool, bool)) {
+        bool expectedEmpty = true;
+        Rect expectedBounds(INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN);
+        for (int y = -6; y < 14; y++) {
+            for (int x = -6; x < 14; x++) {
+                const bool expected = op(coversPixel(lhs, x, y), coversPixel(rhs, x - dx, y - dy));
+                ASSERT_EQ(expected, result.contains(x, y)) << "at " << x << "," << y;
+                if (expected) {
+                    expectedEmpty = false;
+                    expectedBounds = Rect(std::min(expectedBounds.left, x),
+                                          std::min(expectedBounds.top, y),
+                                          std::max(expectedBounds.right, x + 1),
+                                          std::max(expectedBounds.bottom, y + 1));
+                }
+            }
+        }
+        if (expectedEmpty) {
+            EXPECT_TRUE(result.isEmpty());
+        } else {
+            EXPECT_EQ(expectedBounds, result.getBounds());
+        }
+    }
 };
 
 TEST_F(RegionTest, MinimalDivision_TJunction) {
@@ -179,5 +225,82 @@ TEST_F(RegionTest, RegionHash) {
     EXPECT_NE(std::hash<Region>{}(region1), std::hash<Region>{}(region2));
 }
 
+TEST_F(RegionTest, BooleanOperationsMatchPixelCoverage) {
+    // Empty, nested, overlapping, touching and disjoint rects exercise the operations that
+    // don't need to be rasterized, and the multi-rect regions exercise the ones that do.
+    const std::vector<Rects> operands = {
+            {},
+            {Rect(0, 0, 4, 4)},
+            {Rect(1, 1, 3, 3)},
+            {Rect(2, 2, 6, 6)},
+            {Rect(0, 4, 4, 6)},
+            {Rect(4, 0, 6, 4)},
+            {Rect(0, 2, 4, 6)},
+            {Rect(1, 0, 3, 6)},
+            {Rect(0, 1, 6, 3)},
+            {Rect(-2, -2, 8, 8)},
+            {Rect(0, 0, 2, 6), Rect(0, 4, 6, 6)},
+            {Rect(0, 0, 2, 2), Rect(4, 0, 6, 2), Rect(2, 2, 4, 4)},
+    };
+    const Point offsets[] = {{0, 0}, {2, 0}, {0, -2}, {4, 4}};
+
+    struct Operation {
+        const char* name;
+        bool (*coversPixel)(bool inLhs, bool inRhs);
+        const Region (Region::*apply)(const Region&, int, int) const;
+        Region& (Region::*applySelf)(const Region&, int, int);
+        const Region (Region::*applyRect)(const Rect&) const;
+        Region& (Region::*applyRectSelf)(const Rect&);
+    };
+    const Operation operations[] = {
+            {"or", [](bool l, bool r) { return l || r; }, &Region::merge, &Region::orSelf,
+             &Region::merge, &Region::orSelf},
+            {"and", [](bool l, bool r) { return l && r; }, &Region::intersect, &Region::andSelf,
+             &Region::intersect, &Region::andSelf},
+            {"subtract", [](bool l, bool r) { return l && !r; }, &Region::subtract,
+             &Region::subtractSelf, &Region::subtract, &Region::subtractSelf},
+            {"xor", [](bool l, bool r) { return l != r; }, &Region::mergeExclusive,
+             &Region::xorSelf, &Region::mergeExclusive, &Region::xorSelf},
+    };
+
+    for (const Operation& operation : operations) {
+        for (size_t i = 0; i < operands.size(); i++) {
+            const Rects& lhsRects = operands[i];
+            const Region lhs = toRegion(lhsRects);
+
+            Region self(lhs);
+            (self.*operation.applySelf)(self, 0, 0);
+            checkCoverage(self, lhsRects, lhsRects, 0, 0, operation.coversPixel);
+
+            for (size_t j = 0; j < operands.size(); j++) {
+                SCOPED_TRACE(std::string(operation.name) + " of operands " + std::to_string(i) +
+                             " and " + std::to_string(j));
+                const Rects& rhsRects = operands[j];
+                const Region rhs = toRegion(rhsRects);
+
+                for (const Point& offset : offsets) {
+                    SCOPED_TRACE("offset by " + std::to_string(offset.x) + "," +
+                                 std::to_string(offset.y));
+                    checkCoverage((lhs.*operation.apply)(rhs, offset.x, offset.y), lhsRects,
+                                  rhsRects, offset.x, offset.y, operation.coversPixel);
+                    Region result(lhs);
+                    (result.*operation.applySelf)(rhs, offset.x, offset.y);
+                    checkCoverage(result, lhsRects, rhsRects, offset.x, offset.y,
+                                  operation.coversPixel);
+                }
+
+                if (rhsRects.size() <= 1) {
+                    const Rect rect = rhs.getBounds();
+                    checkCoverage((lhs.*operation.applyRect)(rect), lhsRects, rhsRects, 0, 0,
+                                  operation.coversPixel);
+                    Region result(lhs);
+                    (result.*operation.applyRectSelf)(rect);
+                    checkCoverage(result, lhsRects, rhsRects, 0, 0, operation.coversPixel);
+                }
+            }
+        }
+    }
+}
+
 }; // namespace android
 
@@ -41,6 +41,18 @@ constexpr ui::LogicalDisplayId DISPLAY_ID = ui::LogicalDisplayId::DEFAULT;
 
 static constexpr std::chrono::duration INJECT_EVENT_TIMEOUT = 5s;
 
+// The size of the display in the many-windows benchmarks.
+constexpr int32_t DISPLAY_WIDTH = 1080;
+constexpr int32_t DISPLAY_HEIGHT = 2400;
+
+// The windows are tiled in a grid of this size, below the touched area.
+constexpr int32_t TILE_COLUMNS = 12;
+constexpr int32_t TILE_ROWS = 13;
+
+// The owner of the untrusted overlays, which is different from that of the other windows.
+constexpr gui::Pid OVERLAY_PID{1111};
+constexpr gui::Uid OVERLAY_UID{11111};
+
 static nsecs_t now() {
     return systemTime(SYSTEM_TIME_MONOTONIC);
 }
@@ -100,6 +112,80 @@ static NotifyMotionArgs generateMotionArgs() {
     return args;
 }
 
+/**
+ * Populates a display with over 150 windows, similar to a busy kiosk display: untrusted overlays
+ * and spy windows above the touched window, and a grid of app, overlay and spy windows elsewhere.
+ * Returns the windows, front to back. The first one is a spy and the last one is the touched
+ * window, which are the only ones that receive the touches from generateMotionArgs.
+ */
+static std::vector<sp<FakeWindowHandle>> createManyWindows(
+        const std::shared_ptr<FakeApplicationHandle>& application,
+        const std::unique_ptr<InputDispatcher>& dispatcher) {
+    std::vector<sp<FakeWindowHandle>> windows;
+
+    sp<FakeWindowHandle> spy =
+            sp<FakeWindowHandle>::make(application, dispatcher, "Spy", DISPLAY_ID);
+    spy->setFrame(Rect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT));
+    spy->setSpy(true);
+    spy->setTrustedOverlay(true);
+    windows.push_back(spy);
+
+    for (int32_t i = 0; i < 3; i++) {
+        sp<FakeWindowHandle> overlay =
+                sp<FakeWindowHandle>::make(application, dispatcher,
+                                           "Overlay " + std::to_string(i), DISPLAY_ID);
+        overlay->setFrame(Rect(0, 0, DISPLAY_WIDTH, 200 + i * 100));
+        overlay->setTouchable(false);
+        overlay->setAlpha(0.1);
+        overlay->setTouchOcclusionMode(gui::TouchOcclusionMode::USE_OPACITY);
+        overlay->setOwnerInfo(OVERLAY_PID, OVERLAY_UID);
+        windows.push_back(overlay);
+    }
+
+    const int32_t tileWidth = DISPLAY_WIDTH / TILE_COLUMNS;
+    const int32_t tileHeight = (DISPLAY_HEIGHT - 400) / TILE_ROWS;
+    for (int32_t row = 0; row < TILE_ROWS; row++) {
+        for (int32_t column = 0; column < TILE_COLUMNS; column++) {
+            sp<FakeWindowHandle> tile =
+                    sp<FakeWindowHandle>::make(application, dispatcher,
+                                               "Tile " + std::to_string(row) + "," +
+                                                       std::to_string(column),
+                                               DISPLAY_ID);
+            const int32_t left = column * tileWidth;
+            const int32_t top = 400 + row * tileHeight;
+            tile->setFrame(Rect(left, top, left + tileWidth, top + tileHeight));
+            switch ((row + column) % 3) {
+                case 0:
+                    tile->setSpy(true);
+                    tile->setTrustedOverlay(true);
+                    break;
+                case 1:
+                    tile->setTouchable(false);
+                    tile->setOwnerInfo(OVERLAY_PID, OVERLAY_UID);
+                    break;
+                default:
+                    break;
+            }
+            windows.push_back(tile);
+        }
+    }
+
+    sp<FakeWindowHandle> window =
+            sp<FakeWindowHandle>::make(application, dispatcher, "Touched Window", DISPLAY_ID);
+    window->setFrame(Rect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT));
+    windows.push_back(window);
+    return windows;
+}
+
+static std::vector<gui::WindowInfo> getWindowInfos(
+        const std::vector<sp<FakeWindowHandle>>& windows) {
+    std::vector<gui::WindowInfo> windowInfos;
+    for (const sp<FakeWindowHandle>& window : windows) {
+        windowInfos.push_back(*window->getInfo());
+    }
+    return windowInfos;
+}
+
 static void benchmarkNotifyMotion(benchmark::State& state) {
     // Create dispatcher
     FakeInputDispatcherPolicy fakePolicy;
@@ -135,6 +221,44 @@ static void benchmarkNotifyMotion(benchmark::State& state) {
     dispatcher->stop();
 }
 
+static void benchmarkNotifyMotionManyWindows(benchmark::State& state) {
+    // Create dispatcher
+    FakeInputDispatcherPolicy fakePolicy;
+    auto dispatcher = std::make_unique<InputDispatcher>(fakePolicy);
+    dispatcher->setInputDispatchMode(/*enabled*/ true, /*frozen*/ false);
+    dispatcher->start();
+
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    std::vector<sp<FakeWindowHandle>> windows = createManyWindows(application, dispatcher);
+    gui::DisplayInfo displayInfo;
+    displayInfo.displayId = DISPLAY_ID;
+    displayInfo.logicalWidth = DISPLAY_WIDTH;
+    displayInfo.logicalHeight = DISPLAY_HEIGHT;
+    dispatcher->onWindowInfosChanged({getWindowInfos(windows), {displayInfo}, 0, 0});
+
+    NotifyMotionArgs motionArgs = generateMotionArgs();
+
+    for (auto _ : state) {
+        // Send ACTION_DOWN
+        motionArgs.action = AMOTION_EVENT_ACTION_DOWN;
+        motionArgs.downTime = now();
+        motionArgs.eventTime = motionArgs.downTime;
+        dispatcher->notifyMotion(motionArgs);
+
+        // Send ACTION_UP
+        motionArgs.action = AMOTION_EVENT_ACTION_UP;
+        motionArgs.eventTime = now();
+        dispatcher->notifyMotion(motionArgs);
+
+        windows.front()->consumeMotionEvent();
+        windows.front()->consumeMotionEvent();
+        windows.back()->consumeMotionEvent();
+        windows.back()->consumeMotionEvent();
+    }
+
+    dispatcher->stop();
+}
+
 static void benchmarkInjectMotion(benchmark::State& state) {
     // Create dispatcher
     FakeInputDispatcherPolicy fakePolicy;
@@ -195,11 +319,41 @@ static void benchmarkOnWindowInfosChanged(benchmark::State& state) {
     dispatcher->stop();
 }
 
+static void benchmarkOnWindowInfosChangedManyWindows(benchmark::State& state) {
+    // Create dispatcher
+    FakeInputDispatcherPolicy fakePolicy;
+    auto dispatcher = std::make_unique<InputDispatcher>(fakePolicy);
+    dispatcher->setInputDispatchMode(/*enabled*/ true, /*frozen*/ false);
+    dispatcher->start();
+
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    std::vector<sp<FakeWindowHandle>> windows = createManyWindows(application, dispatcher);
+    std::vector<gui::WindowInfo> windowInfos = getWindowInfos(windows);
+    gui::DisplayInfo info;
+    info.displayId = DISPLAY_ID;
+    std::vector<gui::DisplayInfo> displayInfos{info};
+
+    // Move one window back and forth, which is the common case of an update.
+    std::vector<gui::WindowInfo> movedWindowInfos = windowInfos;
+    movedWindowInfos[windowInfos.size() / 2].frame.offsetBy(10, 10);
+    movedWindowInfos[windowInfos.size() / 2].touchableRegion.translateSelf(10, 10);
+
+    for (auto _ : state) {
+        dispatcher->onWindowInfosChanged(
+                {windowInfos, displayInfos, /*vsyncId=*/0, /*timestamp=*/0});
+        dispatcher->onWindowInfosChanged(
+                {movedWindowInfos, displayInfos, /*vsyncId=*/0, /*timestamp=*/0});
+    }
+    dispatcher->stop();
+}
+
 } // namespace
 
 BENCHMARK(benchmarkNotifyMotion);
+BENCHMARK(benchmarkNotifyMotionManyWindows);
 BENCHMARK(benchmarkInjectMotion);
 BENCHMARK(benchmarkOnWindowInfosChanged);
+BENCHMARK(benchmarkOnWindowInfosChangedManyWindows);
 
 } // namespace android::inputdispatcher
 
@@ -0,0 +1,508 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Benchmarks of the whole input pipeline that a touch goes through: synthetic evdev events are
+ * read from a fake EventHub by the InputReader, passed through the PointerChoreographer to the
+ * InputDispatcher, published over real InputChannels, and received by an
+ * InputConsumerNoResampling on a separate looper thread.
+ *
+ * Each device is a touchscreen on its own display, which has a single window. Every iteration
+ * sends one move per device and waits until all of them have been received, and the next
+ * iteration starts after the frame period given by the event rate. The iteration time is the time
+ * from the evdev timestamp of the first move to the reception of the last one, and the latencies
+ * of the individual stages are reported as counters.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <linux/input.h>
+#include <time.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <InputReader.h>
+#include <android-base/thread_annotations.h>
+#include <android/os/IInputConstants.h>
+#include <input/InputConsumerNoResampling.h>
+#include <utils/Looper.h>
+#include "../PointerChoreographer.h"
+#include "../dispatcher/InputDispatcher.h"
+#include "../tests/FakeEventHub.h"
+#include "../tests/FakeInputDispatcherPolicy.h"
+#include "../tests/FakeInputReaderPolicy.h"
+#include "../tests/FakePointerController.h"
+
+namespace android {
+
+using namespace std::chrono_literals;
+using inputdispatcher::InputDispatcher;
+
+namespace {
+
+constexpr int32_t DISPLAY_WIDTH = 1080;
+constexpr int32_t DISPLAY_HEIGHT = 2400;
+
+// The time to wait for the events of an iteration to reach the consumers before giving up.
+constexpr std::chrono::duration CONSUME_TIMEOUT = 5s;
+
+// The points at which the time of an event is recorded, in the order in which they are reached.
+enum class Stage : size_t {
+    // The event has been processed by the InputReader.
+    READER,
+    // The event has been processed by the PointerChoreographer.
+    CHOREOGRAPHER,
+    // The event has been received by the consumer.
+    CONSUMER,
+};
+constexpr size_t STAGE_COUNT = static_cast<size_t>(Stage::CONSUMER) + 1;
+
+nsecs_t now() {
+    return systemTime(SYSTEM_TIME_MONOTONIC);
+}
+
+nsecs_t getCpuTime(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return seconds_to_nanoseconds(ts.tv_sec) + ts.tv_nsec;
+}
+
+double toMicros(nsecs_t duration) {
+    return duration / 1000.0;
+}
+
+/**
+ * Records the time at which each event reaches each stage. Events are identified by their device
+ * and event time, which are preserved along the whole pipeline.
+ */
+class LatencyRecorder {
+public:
+    struct Sample {
+        nsecs_t eventTime;
+        std::array<nsecs_t, STAGE_COUNT> stageTimes;
+    };
+
+    void record(Stage stage, int32_t deviceId, nsecs_t eventTime) {
+        const nsecs_t time = now();
+        std::scoped_lock lock(mLock);
+        mStageTimes[{deviceId, eventTime}][static_cast<size_t>(stage)] = time;
+        if (stage == Stage::CONSUMER) {
+            mConsumedCount++;
+            mConsumedCondition.notify_all();
+        }
+    }
+
+    /** Waits until the given number of events have been consumed since the last takeSamples. */
+    bool waitForConsumed(size_t count) {
+        std::unique_lock lock(mLock);
+        base::ScopedLockAssertion assumeLocked(mLock);
+        return mConsumedCondition.wait_for(lock, CONSUME_TIMEOUT, [this, count]() REQUIRES(mLock) {
+            return mConsumedCount >= count;
+        });
+    }
+
+    /** Returns the events that reached all the stages, and forgets all the recorded events. */
+    std::vector<Sample> takeSamples() {
+        std::scoped_lock lock(mLock);
+        std::vector<Sample> samples;
+        for (const auto& [key, stageTimes] : mStageTimes) {
+            if (std::find(stageTimes.begin(), stageTimes.end(), 0) == stageTimes.end()) {
+                samples.push_back({.eventTime = key.second, .stageTimes = stageTimes});
+            }
+        }
+        mStageTimes.clear();
+        mConsumedCount = 0;
+        return samples;
+    }
+
+private:
+    std::mutex mLock;
+    std::condition_variable mConsumedCondition;
+    std::map<std::pair<int32_t /*deviceId*/, nsecs_t /*eventTime*/>,
+             std::array<nsecs_t, STAGE_COUNT>>
+            mStageTimes GUARDED_BY(mLock);
+    size_t mConsumedCount GUARDED_BY(mLock){0};
+};
+
+/** Records the time at which the motions notified to the next stage leave the given stage. */
+class StageTimingListener : public InputListenerInterface {
+public:
+    StageTimingListener(InputListenerInterface& listener, LatencyRecorder& recorder, Stage stage)
+          : mListener(listener), mRecorder(recorder), mStage(stage) {}
+
+    void notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs& args) override {
+        mListener.notifyInputDevicesChanged(args);
+    }
+    void notifyKey(const NotifyKeyArgs& args) override { mListener.notifyKey(args); }
+    void notifyMotion(const NotifyMotionArgs& args) override {
+        mRecorder.record(mStage, args.deviceId, args.eventTime);
+        mListener.notifyMotion(args);
+    }
+    void notifySwitch(const NotifySwitchArgs& args) override { mListener.notifySwitch(args); }
+    void notifySensor(const NotifySensorArgs& args) override { mListener.notifySensor(args); }
+    void notifyVibratorState(const NotifyVibratorStateArgs& args) override {
+        mListener.notifyVibratorState(args);
+    }
+    void notifyDeviceReset(const NotifyDeviceResetArgs& args) override {
+        mListener.notifyDeviceReset(args);
+    }
+    void notifyPointerCaptureChanged(const NotifyPointerCaptureChangedArgs& args) override {
+        mListener.notifyPointerCaptureChanged(args);
+    }
+
+private:
+    InputListenerInterface& mListener;
+    LatencyRecorder& mRecorder;
+    const Stage mStage;
+};
+
+class FakePointerChoreographerPolicy : public PointerChoreographerPolicyInterface {
+public:
+    std::shared_ptr<PointerControllerInterface> createPointerController(
+            PointerControllerInterface::ControllerType) override {
+        return std::make_shared<FakePointerController>();
+    }
+    void notifyPointerDisplayIdChanged(ui::LogicalDisplayId, const FloatPoint&) override {}
+    bool isInputMethodConnectionActive() override { return false; }
+    void notifyMouseCursorFadedOnTyping() override {}
+};
+
+// The InputReader is driven by the benchmark instead of by its own thread.
+class PipelineInputReader : public InputReader {
+public:
+    using InputReader::InputReader;
+    using InputReader::loopOnce;
+};
+
+/** Receives the events of one window, and finishes them right away. */
+class PipelineReceiver : public InputConsumerCallbacks {
+public:
+    PipelineReceiver(std::shared_ptr<InputChannel> channel, sp<Looper> looper,
+                     LatencyRecorder& recorder)
+          : mRecorder(recorder),
+            mConsumer(std::move(channel), std::move(looper), *this, /*resampler=*/nullptr) {}
+
+    void onKeyEvent(std::unique_ptr<KeyEvent>, uint32_t seq) override { finish(seq); }
+    void onMotionEvent(std::unique_ptr<MotionEvent> event, uint32_t seq) override {
+        for (size_t i = 0; i <= event->getHistorySize(); i++) {
+            mRecorder.record(Stage::CONSUMER, event->getDeviceId(),
+                             event->getHistoricalEventTime(i));
+        }
+        finish(seq);
+    }
+    void onBatchedInputEventPending(int32_t) override {
+        mConsumer.consumeBatchedInputEvents(/*requestedFrameTime=*/std::nullopt);
+    }
+    void onFocusEvent(std::unique_ptr<FocusEvent>, uint32_t seq) override { finish(seq); }
+    void onCaptureEvent(std::unique_ptr<CaptureEvent>, uint32_t seq) override { finish(seq); }
+    void onDragEvent(std::unique_ptr<DragEvent>, uint32_t seq) override { finish(seq); }
+    void onTouchModeEvent(std::unique_ptr<TouchModeEvent>, uint32_t seq) override { finish(seq); }
+
+private:
+    LatencyRecorder& mRecorder;
+    InputConsumerNoResampling mConsumer;
+
+    void finish(uint32_t seq) { mConsumer.finishInputEvent(seq, /*handled=*/true); }
+};
+
+/** The looper thread of the app, on which the events of all the windows are consumed. */
+class ConsumerThread {
+public:
+    ConsumerThread(std::vector<std::shared_ptr<InputChannel>> channels, LatencyRecorder& recorder)
+          : mThread([this, channels = std::move(channels), &recorder]() {
+                run(channels, recorder);
+            }) {}
+
+    ~ConsumerThread() {
+        mExit = true;
+        mLooper->wake();
+        mThread.join();
+    }
+
+    /** Returns the CPU time that the thread spent consuming events. */
+    nsecs_t getCpuTime() const { return mCpuTime; }
+
+private:
+    const sp<Looper> mLooper = sp<Looper>::make(/*allowNonCallbacks=*/false);
+    std::atomic<bool> mExit{false};
+    std::atomic<nsecs_t> mCpuTime{0};
+    // Initialized last, so that the thread only uses members that were constructed already.
+    std::thread mThread;
+
+    void run(const std::vector<std::shared_ptr<InputChannel>>& channels,
+             LatencyRecorder& recorder) {
+        Looper::setForThread(mLooper);
+        // The consumers must be created and destroyed on the looper thread.
+        std::vector<std::unique_ptr<PipelineReceiver>> receivers;
+        for (const std::shared_ptr<InputChannel>& channel : channels) {
+            receivers.push_back(std::make_unique<PipelineReceiver>(channel, mLooper, recorder));
+        }
+        while (!mExit) {
+            const nsecs_t startCpuTime = getCpuTime(CLOCK_THREAD_CPUTIME_ID);
+            mLooper->pollOnce(/*timeoutMillis=*/-1);
+            mCpuTime += getCpuTime(CLOCK_THREAD_CPUTIME_ID) - startCpuTime;
+        }
+        receivers.clear();
+    }
+};
+
+/**
+ * The InputReader, PointerChoreographer and InputDispatcher, connected as in the InputManager, with
+ * timing listeners between them. Each device is a touchscreen on its own display.
+ */
+class InputPipeline {
+public:
+    explicit InputPipeline(size_t deviceCount) : mDeviceCount(deviceCount) {
+        mDispatcher = std::make_unique<InputDispatcher>(mDispatcherPolicy);
+        mChoreographerOutput = std::make_unique<StageTimingListener>(*mDispatcher, mRecorder,
+                                                                     Stage::CHOREOGRAPHER);
+        mChoreographer = std::make_unique<PointerChoreographer>(*mChoreographerOutput,
+                                                                mChoreographerPolicy);
+        mReaderOutput =
+                std::make_unique<StageTimingListener>(*mChoreographer, mRecorder, Stage::READER);
+
+        std::vector<gui::WindowInfo> windowInfos;
+        std::vector<gui::DisplayInfo> displayInfos;
+        std::vector<std::shared_ptr<InputChannel>> channels;
+        for (size_t i = 0; i < mDeviceCount; i++) {
+            const ui::LogicalDisplayId displayId{static_cast<int32_t>(i)};
+            const std::string uniqueId = "local:" + std::to_string(i);
+            mReaderPolicy->addDisplayViewport(displayId, DISPLAY_WIDTH, DISPLAY_HEIGHT,
+                                              ui::ROTATION_0, /*isActive=*/true, uniqueId,
+                                              /*physicalPort=*/std::nullopt,
+                                              i == 0 ? ViewportType::INTERNAL
+                                                     : ViewportType::VIRTUAL);
+            addTouchscreen(getEventHubId(i), uniqueId);
+
+            gui::DisplayInfo displayInfo;
+            displayInfo.displayId = displayId;
+            displayInfo.logicalWidth = DISPLAY_WIDTH;
+            displayInfo.logicalHeight = DISPLAY_HEIGHT;
+            displayInfos.push_back(displayInfo);
+
+            const std::string name = "Window " + std::to_string(i);
+            base::Result<std::unique_ptr<InputChannel>> channel =
+                    mDispatcher->createInputChannel(name);
+            LOG_ALWAYS_FATAL_IF(!channel.ok(), "Failed to create the input channel for %s",
+                                name.c_str());
+            windowInfos.push_back(createWindowInfo(name, (*channel)->getConnectionToken(),
+                                                   displayId, static_cast<int32_t>(i + 1)));
+            channels.push_back(std::move(*channel));
+        }
+
+        mReader = std::make_unique<PipelineInputReader>(mEventHub, mReaderPolicy,
+                                                        *mReaderOutput);
+        mDispatcher->setInputDispatchMode(/*enabled=*/true, /*frozen=*/false);
+        mDispatcher->onWindowInfosChanged({windowInfos, displayInfos, /*vsyncId=*/0,
+                                           /*timestamp=*/0});
+        mDispatcher->start();
+        mConsumerThread = std::make_unique<ConsumerThread>(std::move(channels), mRecorder);
+
+        // Add the devices.
+        mReader->loopOnce();
+    }
+
+    ~InputPipeline() {
+        mConsumerThread.reset();
+        mDispatcher->stop();
+    }
+
+    LatencyRecorder& getRecorder() { return mRecorder; }
+    nsecs_t getConsumerCpuTime() const { return mConsumerThread->getCpuTime(); }
+
+    /** Sends a down, move or up on every device, and processes it in the InputReader. */
+    void injectTouches(int32_t action, int32_t x, int32_t y) {
+        for (size_t i = 0; i < mDeviceCount; i++) {
+            const int32_t eventHubId = getEventHubId(i);
+            const nsecs_t when = now();
+            if (action == AMOTION_EVENT_ACTION_DOWN) {
+                mEventHub->enqueueEvent(when, when, eventHubId, EV_KEY, BTN_TOUCH, 1);
+            }
+            if (action == AMOTION_EVENT_ACTION_UP) {
+                mEventHub->enqueueEvent(when, when, eventHubId, EV_KEY, BTN_TOUCH, 0);
+            } else {
+                mEventHub->enqueueEvent(when, when, eventHubId, EV_ABS, ABS_X, x);
+                mEventHub->enqueueEvent(when, when, eventHubId, EV_ABS, ABS_Y, y);
+            }
+            mEventHub->enqueueEvent(when, when, eventHubId, EV_SYN, SYN_REPORT, 0);
+        }
+        mReader->loopOnce();
+    }
+
+    /** Waits until the consumers received the touches of every device. */
+    bool waitForTouches() { return mRecorder.waitForConsumed(mDeviceCount); }
+
+private:
+    const size_t mDeviceCount;
+    LatencyRecorder mRecorder;
+
+    std::shared_ptr<FakeEventHub> mEventHub = std::make_shared<FakeEventHub>();
+    sp<FakeInputReaderPolicy> mReaderPolicy = sp<FakeInputReaderPolicy>::make();
+    FakePointerChoreographerPolicy mChoreographerPolicy;
+    FakeInputDispatcherPolicy mDispatcherPolicy;
+
+    std::unique_ptr<InputDispatcher> mDispatcher;
+    std::unique_ptr<StageTimingListener> mChoreographerOutput;
+    std::unique_ptr<PointerChoreographer> mChoreographer;
+    std::unique_ptr<StageTimingListener> mReaderOutput;
+    std::unique_ptr<PipelineInputReader> mReader;
+    std::unique_ptr<ConsumerThread> mConsumerThread;
+
+    static int32_t getEventHubId(size_t index) { return static_cast<int32_t>(index) + 1; }
+
+    void addTouchscreen(int32_t eventHubId, const std::string& displayUniqueId) {
+        mEventHub->addDevice(eventHubId, "Touchscreen " + std::to_string(eventHubId),
+                             InputDeviceClass::TOUCH, /*bus=*/0);
+        mEventHub->addConfigurationProperty(eventHubId, "touch.deviceType", "touchScreen");
+        mEventHub->addConfigurationProperty(eventHubId, "touch.displayId",
+                                            displayUniqueId.c_str());
+        mEventHub->addAbsoluteAxis(eventHubId, ABS_X, 0, DISPLAY_WIDTH - 1, 0, 0);
+        mEventHub->addAbsoluteAxis(eventHubId, ABS_Y, 0, DISPLAY_HEIGHT - 1, 0, 0);
+        mEventHub->addKey(eventHubId, BTN_TOUCH, 0, AKEYCODE_UNKNOWN, 0);
+    }
+
+    static gui::WindowInfo createWindowInfo(const std::string& name, const sp<IBinder>& token,
+                                            ui::LogicalDisplayId displayId, int32_t id) {
+        gui::WindowInfo info;
+        info.token = token;
+        info.id = id;
+        info.name = name;
+        info.dispatchingTimeout = std::chrono::milliseconds(
+                os::IInputConstants::UNMULTIPLIED_DEFAULT_DISPATCHING_TIMEOUT_MILLIS);
+        info.alpha = 1.0;
+        info.frame = Rect(0, 0, DISPLAY_WIDTH, DISPLAY_HEIGHT);
+        info.globalScaleFactor = 1.0;
+        info.addTouchableRegion(info.frame);
+        info.ownerPid = gui::Pid{1000};
+        info.ownerUid = gui::Uid{10000};
+        info.displayId = displayId;
+        info.inputConfig = gui::WindowInfo::InputConfig::DEFAULT;
+        return info;
+    }
+};
+
+// Reports the median and the 99th percentile of the values, in microseconds.
+void reportPercentiles(benchmark::State& state, const std::string& name,
+                       std::vector<nsecs_t> values) {
+    if (values.empty()) {
+        return;
+    }
+    std::sort(values.begin(), values.end());
+    const auto percentile = [&values](double p) {
+        return toMicros(values[static_cast<size_t>(p * (values.size() - 1))]);
+    };
+    state.counters[name + "_p50_us"] = percentile(0.5);
+    state.counters[name + "_p99_us"] = percentile(0.99);
+}
+
+/**
+ * Arguments: the rate at which each device reports a move, in Hz, and the number of devices.
+ */
+void benchmarkTouchscreenPipeline(benchmark::State& state) {
+    const nsecs_t framePeriod = s2ns(1) / state.range(0);
+    const size_t deviceCount = static_cast<size_t>(state.range(1));
+    InputPipeline pipeline(deviceCount);
+    LatencyRecorder& recorder = pipeline.getRecorder();
+
+    pipeline.injectTouches(AMOTION_EVENT_ACTION_DOWN, DISPLAY_WIDTH / 2, DISPLAY_HEIGHT / 2);
+    if (!pipeline.waitForTouches()) {
+        state.SkipWithError("The down events were not received");
+        return;
+    }
+    recorder.takeSamples();
+
+    std::array<std::vector<nsecs_t>, STAGE_COUNT> stageLatencies;
+    std::vector<nsecs_t> totalLatencies;
+    nsecs_t readerCpuTime = 0;
+    size_t eventCount = 0;
+    const nsecs_t startConsumerCpuTime = pipeline.getConsumerCpuTime();
+    const nsecs_t startProcessCpuTime = getCpuTime(CLOCK_PROCESS_CPUTIME_ID);
+    int32_t y = DISPLAY_HEIGHT / 2;
+    for (auto _ : state) {
+        const nsecs_t frameStart = now();
+        // Alternate the direction, so that every move changes the position.
+        y += (eventCount / deviceCount) % 2 == 0 ? 10 : -10;
+
+        const nsecs_t startCpuTime = getCpuTime(CLOCK_THREAD_CPUTIME_ID);
+        pipeline.injectTouches(AMOTION_EVENT_ACTION_MOVE, DISPLAY_WIDTH / 2, y);
+        readerCpuTime += getCpuTime(CLOCK_THREAD_CPUTIME_ID) - startCpuTime;
+        if (!pipeline.waitForTouches()) {
+            state.SkipWithError("The move events were not received");
+            break;
+        }
+
+        const std::vector<LatencyRecorder::Sample> samples = recorder.takeSamples();
+        nsecs_t firstEventTime = std::numeric_limits<nsecs_t>::max();
+        nsecs_t lastConsumeTime = 0;
+        for (const LatencyRecorder::Sample& sample : samples) {
+            nsecs_t previousTime = sample.eventTime;
+            for (size_t stage = 0; stage < STAGE_COUNT; stage++) {
+                stageLatencies[stage].push_back(sample.stageTimes[stage] - previousTime);
+                previousTime = sample.stageTimes[stage];
+            }
+            totalLatencies.push_back(previousTime - sample.eventTime);
+            firstEventTime = std::min(firstEventTime, sample.eventTime);
+            lastConsumeTime = std::max(lastConsumeTime, previousTime);
+        }
+        eventCount += samples.size();
+        state.SetIterationTime(samples.empty() ? 0 : (lastConsumeTime - firstEventTime) / 1e9);
+
+        const nsecs_t frameEnd = frameStart + framePeriod;
+        if (now() < frameEnd) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(frameEnd - now()));
+        }
+    }
+    const nsecs_t processCpuTime = getCpuTime(CLOCK_PROCESS_CPUTIME_ID) - startProcessCpuTime;
+    const nsecs_t consumerCpuTime = pipeline.getConsumerCpuTime() - startConsumerCpuTime;
+
+    pipeline.injectTouches(AMOTION_EVENT_ACTION_UP, DISPLAY_WIDTH / 2, y);
+    pipeline.waitForTouches();
+
+    reportPercentiles(state, "reader", stageLatencies[static_cast<size_t>(Stage::READER)]);
+    reportPercentiles(state, "choreographer",
+                      stageLatencies[static_cast<size_t>(Stage::CHOREOGRAPHER)]);
+    reportPercentiles(state, "dispatch", stageLatencies[static_cast<size_t>(Stage::CONSUMER)]);
+    reportPercentiles(state, "total", totalLatencies);
+    if (eventCount != 0) {
+        // The reader thread also runs the PointerChoreographer, and the rest of the process time
+        // is mostly the dispatcher thread.
+        state.counters["reader_cpu_us"] = toMicros(readerCpuTime) / eventCount;
+        state.counters["consumer_cpu_us"] = toMicros(consumerCpuTime) / eventCount;
+        state.counters["dispatcher_cpu_us"] =
+                toMicros(processCpuTime - readerCpuTime - consumerCpuTime) / eventCount;
+    }
+}
+
+} // namespace
+
+BENCHMARK(benchmarkTouchscreenPipeline)
+        ->ArgNames({"rate_hz", "devices"})
+        ->ArgsProduct({{120, 240, 1000}, {1, 4}})
+        ->UseManualTime();
+
+} // namespace android
+
+BENCHMARK_MAIN();
@@ -20,6 +20,7 @@
 
 #include "Connection.h"
 #include "DebugConfig.h"
+#include "EntryPool.h"
 
 #include <android-base/stringprintf.h>
 #include <cutils/atomic.h>
@@ -68,6 +69,14 @@ EventEntry::EventEntry(int32_t id, Type type, nsecs_t eventTime, uint32_t policy
         injectionState(nullptr),
         dispatchInProgress(false) {}
 
+void* EventEntry::operator new(size_t size) {
+    return EntryPool::getInstance().allocate(size);
+}
+
+void EventEntry::operator delete(void* entry, size_t size) {
+    EntryPool::getInstance().deallocate(entry, size);
+}
+
 // --- DeviceResetEntry ---
 
 DeviceResetEntry::DeviceResetEntry(int32_t id, nsecs_t eventTime, int32_t deviceId)
@@ -200,10 +209,17 @@ MotionEntry::MotionEntry(int32_t id, std::shared_ptr<InjectionState> injectionSt
         yPrecision(yPrecision),
         xCursorPosition(xCursorPosition),
         yCursorPosition(yCursorPosition),
-        downTime(downTime),
-        pointerProperties(pointerProperties),
-        pointerCoords(pointerCoords) {
+        downTime(downTime) {
     EventEntry::injectionState = std::move(injectionState);
+    // Copy the pointers into recycled arrays, so that this doesn't allocate in steady state.
+    EntryPool::getInstance().acquirePointerArrays(this->pointerProperties, this->pointerCoords);
+    this->pointerProperties.assign(pointerProperties.begin(), pointerProperties.end());
+    this->pointerCoords.assign(pointerCoords.begin(), pointerCoords.end());
+}
+
+MotionEntry::~MotionEntry() {
+    EntryPool::getInstance().recyclePointerArrays(std::move(pointerProperties),
+                                                  std::move(pointerCoords));
 }
 
 std::string MotionEntry::getDescription() const {
@@ -311,6 +327,14 @@ DispatchEntry::DispatchEntry(std::shared_ptr<const EventEntry> eventEntry,
     }
 }
 
+void* DispatchEntry::operator new(size_t size) {
+    return EntryPool::getInstance().allocate(size);
+}
+
+void DispatchEntry::operator delete(void* entry, size_t size) {
+    EntryPool::getInstance().deallocate(entry, size);
+}
+
 uint32_t DispatchEntry::nextSeq() {
     // Sequence number 0 is reserved and will never be returned.
     uint32_t seq;
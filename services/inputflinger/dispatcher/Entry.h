@@ -75,6 +75,10 @@ struct EventEntry {
     EventEntry(const EventEntry&) = delete;
     EventEntry& operator=(const EventEntry&) = delete;
     virtual ~EventEntry() = default;
+
+    // Entries are allocated from the EntryPool.
+    static void* operator new(size_t size);
+    static void operator delete(void* entry, size_t size);
 };
 
 struct DeviceResetEntry : EventEntry {
@@ -176,6 +180,7 @@ struct MotionEntry : EventEntry {
                 float yCursorPosition, nsecs_t downTime,
                 const std::vector<PointerProperties>& pointerProperties,
                 const std::vector<PointerCoords>& pointerCoords);
+    ~MotionEntry() override;
     std::string getDescription() const override;
 };
 
@@ -239,6 +244,10 @@ struct DispatchEntry {
     DispatchEntry(const DispatchEntry&) = delete;
     DispatchEntry& operator=(const DispatchEntry&) = delete;
 
+    // Entries are allocated from the EntryPool.
+    static void* operator new(size_t size);
+    static void operator delete(void* entry, size_t size);
+
     inline bool hasForegroundTarget() const {
         return targetFlags.test(InputTargetFlags::FOREGROUND);
     }
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EntryPool.h"
+
+#include <android-base/stringprintf.h>
+#include <inttypes.h>
+#include <algorithm>
+
+using android::base::StringPrintf;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+// Set once the calling thread's cache is destroyed, so that entries released later on during the
+// thread's exit go straight to the shared pool.
+thread_local bool sThreadCacheDestroyed = false;
+
+} // namespace
+
+EntryPool& EntryPool::getInstance() {
+    // Never destroyed, since entries may outlive any static object.
+    static EntryPool* sInstance = new EntryPool();
+    return *sInstance;
+}
+
+EntryPool::ThreadCache::ThreadCache() {
+    // Reserved up front, so that moving blocks in and out of the cache doesn't allocate.
+    for (std::vector<void*>& blocks : freeBlocks) {
+        blocks.reserve(MAX_THREAD_CACHED + 1);
+    }
+    pointerArrays.properties.reserve(MAX_THREAD_CACHED + 1);
+    pointerArrays.coords.reserve(MAX_THREAD_CACHED + 1);
+}
+
+EntryPool::ThreadCache::~ThreadCache() {
+    sThreadCacheDestroyed = true;
+    EntryPool& pool = getInstance();
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+        pool.flush(i, freeBlocks[i], freeBlocks[i].size());
+    }
+    pool.flushPointerArrays(pointerArrays, pointerArrays.properties.size());
+}
+
+EntryPool::ThreadCache* EntryPool::getThreadCache() {
+    if (sThreadCacheDestroyed) {
+        return nullptr;
+    }
+    thread_local ThreadCache sThreadCache;
+    return &sThreadCache;
+}
+
+void* EntryPool::allocate(size_t size) {
+    const size_t index = (size + SIZE_CLASS_STEP - 1) / SIZE_CLASS_STEP - 1;
+    if (size == 0 || index >= SIZE_CLASS_COUNT) {
+        mHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+
+    ThreadCache* threadCache = getThreadCache();
+    if (threadCache == nullptr) {
+        std::scoped_lock _l(mLock);
+        SizeClass& sizeClass = mSizeClasses[index];
+        if (sizeClass.freeBlocks.empty()) {
+            addSlabLocked(index);
+        }
+        void* block = sizeClass.freeBlocks.back();
+        sizeClass.freeBlocks.pop_back();
+        sizeClass.handedOut++;
+        return block;
+    }
+
+    std::vector<void*>& cache = threadCache->freeBlocks[index];
+    if (cache.empty()) {
+        refill(index, cache);
+    }
+    void* block = cache.back();
+    cache.pop_back();
+    return block;
+}
+
+void EntryPool::deallocate(void* block, size_t size) {
+    const size_t index = (size + SIZE_CLASS_STEP - 1) / SIZE_CLASS_STEP - 1;
+    if (size == 0 || index >= SIZE_CLASS_COUNT) {
+        ::operator delete(block);
+        return;
+    }
+
+    ThreadCache* threadCache = getThreadCache();
+    if (threadCache == nullptr) {
+        std::scoped_lock _l(mLock);
+        SizeClass& sizeClass = mSizeClasses[index];
+        sizeClass.freeBlocks.push_back(block);
+        sizeClass.handedOut--;
+        return;
+    }
+
+    std::vector<void*>& cache = threadCache->freeBlocks[index];
+    cache.push_back(block);
+    if (cache.size() > MAX_THREAD_CACHED) {
+        flush(index, cache, TRANSFER_BATCH);
+    }
+}
+
+void EntryPool::addSlabLocked(size_t index) {
+    SizeClass& sizeClass = mSizeClasses[index];
+    const size_t blockSize = (index + 1) * SIZE_CLASS_STEP;
+    const std::unique_ptr<std::byte[]>& slab = sizeClass.slabs.emplace_back(
+            std::make_unique<std::byte[]>(blockSize * BLOCKS_PER_SLAB));
+    for (size_t i = BLOCKS_PER_SLAB; i > 0; i--) {
+        sizeClass.freeBlocks.push_back(slab.get() + (i - 1) * blockSize);
+    }
+    mHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EntryPool::refill(size_t index, std::vector<void*>& cache) {
+    std::scoped_lock _l(mLock);
+    SizeClass& sizeClass = mSizeClasses[index];
+    if (sizeClass.freeBlocks.size() < TRANSFER_BATCH) {
+        addSlabLocked(index);
+    }
+    const auto batch = sizeClass.freeBlocks.end() - TRANSFER_BATCH;
+    cache.insert(cache.end(), batch, sizeClass.freeBlocks.end());
+    sizeClass.freeBlocks.erase(batch, sizeClass.freeBlocks.end());
+    sizeClass.handedOut += TRANSFER_BATCH;
+}
+
+void EntryPool::flush(size_t index, std::vector<void*>& cache, size_t count) {
+    // The oldest blocks are returned, since the most recently freed ones are likely still cached.
+    const auto batch = cache.begin() + count;
+    {
+        std::scoped_lock _l(mLock);
+        SizeClass& sizeClass = mSizeClasses[index];
+        sizeClass.freeBlocks.insert(sizeClass.freeBlocks.end(), cache.begin(), batch);
+        sizeClass.handedOut -= count;
+    }
+    cache.erase(cache.begin(), batch);
+}
+
+void EntryPool::acquirePointerArrays(std::vector<PointerProperties>& pointerProperties,
+                                     std::vector<PointerCoords>& pointerCoords) {
+    mPointerArrayAcquisitions.fetch_add(1, std::memory_order_relaxed);
+    ThreadCache* threadCache = getThreadCache();
+    if (threadCache == nullptr) {
+        return;
+    }
+    PointerArrays& cache = threadCache->pointerArrays;
+    if (cache.properties.empty()) {
+        refillPointerArrays(cache);
+        if (cache.properties.empty()) {
+            return;
+        }
+    }
+    pointerProperties = std::move(cache.properties.back());
+    cache.properties.pop_back();
+    pointerCoords = std::move(cache.coords.back());
+    cache.coords.pop_back();
+    mPointerArrayReuses.fetch_add(1, std::memory_order_relaxed);
+}
+
+void EntryPool::recyclePointerArrays(std::vector<PointerProperties>&& pointerProperties,
+                                     std::vector<PointerCoords>&& pointerCoords) {
+    if (pointerProperties.capacity() == 0 || pointerProperties.capacity() > MAX_POINTERS ||
+        pointerCoords.capacity() == 0 || pointerCoords.capacity() > MAX_POINTERS) {
+        return;
+    }
+    ThreadCache* threadCache = getThreadCache();
+    if (threadCache == nullptr) {
+        return;
+    }
+    pointerProperties.clear();
+    pointerCoords.clear();
+
+    PointerArrays& cache = threadCache->pointerArrays;
+    cache.properties.push_back(std::move(pointerProperties));
+    cache.coords.push_back(std::move(pointerCoords));
+    if (cache.properties.size() > MAX_THREAD_CACHED) {
+        flushPointerArrays(cache, TRANSFER_BATCH);
+    }
+}
+
+void EntryPool::refillPointerArrays(PointerArrays& cache) {
+    std::scoped_lock _l(mLock);
+    PointerArrays& recycled = mRecycledPointerArrays;
+    const size_t count = std::min(TRANSFER_BATCH, recycled.properties.size());
+    for (size_t i = recycled.properties.size() - count; i < recycled.properties.size(); i++) {
+        cache.properties.push_back(std::move(recycled.properties[i]));
+        cache.coords.push_back(std::move(recycled.coords[i]));
+    }
+    recycled.properties.resize(recycled.properties.size() - count);
+    recycled.coords.resize(recycled.coords.size() - count);
+}
+
+void EntryPool::flushPointerArrays(PointerArrays& cache, size_t count) {
+    {
+        std::scoped_lock _l(mLock);
+        PointerArrays& recycled = mRecycledPointerArrays;
+        // Reserve the space for the recycled arrays up front, so that recycling doesn't allocate.
+        if (recycled.properties.capacity() < MAX_RECYCLED_POINTER_ARRAYS) {
+            recycled.properties.reserve(MAX_RECYCLED_POINTER_ARRAYS);
+            recycled.coords.reserve(MAX_RECYCLED_POINTER_ARRAYS);
+        }
+        for (size_t i = 0; i < count && recycled.properties.size() < MAX_RECYCLED_POINTER_ARRAYS;
+             i++) {
+            recycled.properties.push_back(std::move(cache.properties[i]));
+            recycled.coords.push_back(std::move(cache.coords[i]));
+        }
+    }
+    // Arrays which didn't fit in the shared pool are freed here, without the lock held.
+    cache.properties.erase(cache.properties.begin(), cache.properties.begin() + count);
+    cache.coords.erase(cache.coords.begin(), cache.coords.begin() + count);
+}
+
+std::string EntryPool::dump(const char* prefix) const {
+    std::scoped_lock _l(mLock);
+    std::string dump;
+    dump += prefix;
+    dump += StringPrintf("EntryPool: heapAllocations=%" PRIu64 "\n", mHeapAllocations.load());
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+        const SizeClass& sizeClass = mSizeClasses[i];
+        if (sizeClass.slabs.empty()) {
+            continue;
+        }
+        dump += prefix;
+        dump += StringPrintf("  blockSize=%zu: slabs=%zu, inUseOrThreadCached=%zu, free=%zu\n",
+                             (i + 1) * SIZE_CLASS_STEP, sizeClass.slabs.size(),
+                             sizeClass.handedOut, sizeClass.freeBlocks.size());
+    }
+    dump += prefix;
+    dump += StringPrintf("  pointerArrays: acquisitions=%" PRIu64 ", reuses=%" PRIu64
+                         ", recycled=%zu\n",
+                         mPointerArrayAcquisitions.load(), mPointerArrayReuses.load(),
+                         mRecycledPointerArrays.properties.size());
+    return dump;
+}
+
+} // namespace android::inputdispatcher
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <input/Input.h>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+/**
+ * A slab allocator for the objects which are created for every event: the event entries, the
+ * dispatch entries, and the control blocks of the shared_ptrs which reference the event entries.
+ * This keeps the dispatcher from allocating memory for them in steady state.
+ *
+ * Blocks are grouped by size class, and each size class allocates BLOCKS_PER_SLAB of them at a
+ * time. Freed blocks are kept for reuse, so the memory used is bounded by the peak number of
+ * entries in flight. Allocations larger than the largest size class go to the heap.
+ *
+ * The pointer arrays of the motion entries are recycled in the same way.
+ *
+ * This class is thread-safe, since entries may be created and released on any thread. Each thread
+ * allocates from and frees to its own cache, which exchanges TRANSFER_BATCH blocks at a time with
+ * the shared pool. So the lock is only taken once per batch, even though entries are usually
+ * created on one thread and released on another.
+ */
+class EntryPool {
+public:
+    static EntryPool& getInstance();
+
+    void* allocate(size_t size);
+    void deallocate(void* block, size_t size);
+
+    // Returns empty arrays, which were recycled if possible so that they already have capacity.
+    void acquirePointerArrays(std::vector<PointerProperties>& pointerProperties,
+                              std::vector<PointerCoords>& pointerCoords);
+    void recyclePointerArrays(std::vector<PointerProperties>&& pointerProperties,
+                              std::vector<PointerCoords>&& pointerCoords);
+
+    std::string dump(const char* prefix) const;
+
+private:
+    static constexpr size_t SIZE_CLASS_STEP = 32;
+    static constexpr size_t SIZE_CLASS_COUNT = 16;
+    static constexpr size_t BLOCKS_PER_SLAB = 32;
+    // The number of blocks (or pointer arrays) moved between a thread cache and the shared pool.
+    static constexpr size_t TRANSFER_BATCH = 16;
+    // A thread cache returns a batch to the shared pool once it holds more than this.
+    static constexpr size_t MAX_THREAD_CACHED = 2 * TRANSFER_BATCH;
+    static_assert(TRANSFER_BATCH <= BLOCKS_PER_SLAB);
+    // Limits the memory used by the recycled pointer arrays after a burst of events.
+    static constexpr size_t MAX_RECYCLED_POINTER_ARRAYS = 32;
+
+    struct SizeClass {
+        std::vector<std::unique_ptr<std::byte[]>> slabs;
+        std::vector<void*> freeBlocks;
+        // Blocks which are in use, or in a thread cache.
+        size_t handedOut = 0;
+    };
+
+    struct PointerArrays {
+        std::vector<std::vector<PointerProperties>> properties;
+        std::vector<std::vector<PointerCoords>> coords;
+    };
+
+    struct ThreadCache {
+        ThreadCache();
+        ~ThreadCache();
+
+        std::array<std::vector<void*>, SIZE_CLASS_COUNT> freeBlocks;
+        PointerArrays pointerArrays;
+    };
+
+    EntryPool() = default;
+
+    // Returns nullptr while the calling thread is exiting, once its cache is gone.
+    static ThreadCache* getThreadCache();
+
+    void addSlabLocked(size_t index) REQUIRES(mLock);
+    void refill(size_t index, std::vector<void*>& cache);
+    void flush(size_t index, std::vector<void*>& cache, size_t count);
+    void refillPointerArrays(PointerArrays& cache);
+    void flushPointerArrays(PointerArrays& cache, size_t count);
+
+    mutable std::mutex mLock;
+    std::array<SizeClass, SIZE_CLASS_COUNT> mSizeClasses GUARDED_BY(mLock);
+    PointerArrays mRecycledPointerArrays GUARDED_BY(mLock);
+
+    std::atomic<uint64_t> mHeapAllocations = 0;
+    std::atomic<uint64_t> mPointerArrayAcquisitions = 0;
+    std::atomic<uint64_t> mPointerArrayReuses = 0;
+};
+
+/**
+ * An allocator which uses the EntryPool, for allocating shared_ptr control blocks.
+ */
+template <typename T>
+struct EntryAllocator {
+    using value_type = T;
+
+    EntryAllocator() = default;
+    template <typename U>
+    EntryAllocator(const EntryAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(EntryPool::getInstance().allocate(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) { EntryPool::getInstance().deallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const EntryAllocator<U>&) const {
+        return true;
+    }
+};
+
+/**
+ * Converts an entry into a shared_ptr, like the shared_ptr constructor that takes a unique_ptr
+ * does, except that the control block is allocated from the EntryPool.
+ */
+template <typename T>
+std::shared_ptr<T> toSharedEntry(std::unique_ptr<T> entry) {
+    return std::shared_ptr<T>(entry.release(), std::default_delete<T>(), EntryAllocator<T>());
+}
+
+} // namespace android::inputdispatcher
@@ -51,6 +51,7 @@
 
 #include "Connection.h"
 #include "DebugConfig.h"
+#include "EntryPool.h"
 #include "InputDispatcher.h"
 #include "InputEventTimeline.h"
 #include "trace/InputTracer.h"
@@ -155,6 +156,9 @@ constexpr std::chrono::milliseconds SLOW_INTERCEPTION_THRESHOLD = 50ms;
 // Number of recent events to keep for debugging purposes.
 constexpr size_t RECENT_QUEUE_MAX_SIZE = 10;
 
+// Maximum number of events published to a connection with a single write to its channel.
+constexpr size_t MAX_PUBLISH_BATCH_SIZE = 16;
+
 // Event log tags. See EventLogTags.logtags for reference.
 constexpr int LOGTAG_INPUT_INTERACTION = 62000;
 constexpr int LOGTAG_INPUT_FOCUS = 62001;
@@ -472,8 +476,8 @@ std::unique_ptr<DispatchEntry> createDispatchEntry(const IdGenerator& idGenerato
     }
 
     std::unique_ptr<DispatchEntry> dispatchEntry =
-            std::make_unique<DispatchEntry>(std::move(combinedMotionEntry), inputTargetFlags,
-                                            *transform, *displayTransform,
+            std::make_unique<DispatchEntry>(toSharedEntry(std::move(combinedMotionEntry)),
+                                            inputTargetFlags, *transform, *displayTransform,
                                             inputTarget.globalScaleFactor, uid, vsyncId, windowId);
     return dispatchEntry;
 }
@@ -572,9 +576,10 @@ bool isUserActivityEvent(const EventEntry& eventEntry) {
     }
 }
 
-// Returns true if the given window can accept pointer events at the given display location.
-bool windowAcceptsTouchAt(const WindowInfo& windowInfo, ui::LogicalDisplayId displayId, float x,
-                          float y, bool isStylus, const ui::Transform& displayTransform) {
+// Returns true if the given window can accept pointer events at the given logical display location.
+// The touchable region must already be transformed into the logical display space.
+bool windowAcceptsTouchAt(const WindowInfo& windowInfo, ui::LogicalDisplayId displayId,
+                          const Region& touchableRegion, const vec2& logicalPoint, bool isStylus) {
     const auto inputConfig = windowInfo.inputConfig;
     if (windowInfo.displayId != displayId ||
         inputConfig.test(WindowInfo::InputConfig::NOT_VISIBLE)) {
@@ -592,23 +597,28 @@ bool windowAcceptsTouchAt(const WindowInfo& windowInfo, ui::LogicalDisplayId dis
     // "bottom" of the window will be different in the display (un-rotated) space compared to in the
     // logical display in which WM determined the bounds. Perform the hit test in the logical
     // display space to ensure these edges are considered correctly in all orientations.
-    const auto touchableRegion = displayTransform.transform(windowInfo.touchableRegion);
-    const auto p = displayTransform.transform(x, y);
-    if (!touchableRegion.contains(std::floor(p.x), std::floor(p.y))) {
+    if (!touchableRegion.contains(logicalPoint.x, logicalPoint.y)) {
         return false;
     }
     return true;
 }
 
-// Returns true if the given window's frame can occlude pointer events at the given display
-// location.
-bool windowOccludesTouchAt(const WindowInfo& windowInfo, ui::LogicalDisplayId displayId, float x,
-                           float y, const ui::Transform& displayTransform) {
+// Returns true if the given window can accept pointer events at the given display location.
+bool windowAcceptsTouchAt(const WindowInfo& windowInfo, ui::LogicalDisplayId displayId, float x,
+                          float y, bool isStylus, const ui::Transform& displayTransform) {
+    return windowAcceptsTouchAt(windowInfo, displayId,
+                                displayTransform.transform(windowInfo.touchableRegion),
+                                floor(displayTransform.transform(x, y)), isStylus);
+}
+
+// Returns true if the given window's frame can occlude pointer events at the given logical display
+// location. The frame must already be transformed into the logical display space.
+bool windowOccludesTouchAt(const WindowInfo& windowInfo, ui::LogicalDisplayId displayId,
+                           const Rect& frame, const vec2& logicalPoint) {
     if (windowInfo.displayId != displayId) {
         return false;
     }
-    const auto frame = displayTransform.transform(windowInfo.frame);
-    const auto p = floor(displayTransform.transform(x, y));
+    const vec2& p = logicalPoint;
     return p.x >= frame.left && p.x < frame.right && p.y >= frame.top && p.y < frame.bottom;
 }
 
@@ -1343,7 +1353,7 @@ bool InputDispatcher::shouldPruneInboundQueueLocked(const MotionEntry& motionEnt
 
 bool InputDispatcher::enqueueInboundEventLocked(std::unique_ptr<EventEntry> newEntry) {
     bool needWake = mInboundQueue.empty();
-    mInboundQueue.push_back(std::move(newEntry));
+    mInboundQueue.push_back(toSharedEntry(std::move(newEntry)));
     const EventEntry& entry = *(mInboundQueue.back());
     traceInboundQueueLengthLocked();
 
@@ -1432,17 +1442,22 @@ void InputDispatcher::addRecentEventLocked(std::shared_ptr<const EventEntry> ent
 sp<WindowInfoHandle> InputDispatcher::findTouchedWindowAtLocked(ui::LogicalDisplayId displayId,
                                                                 float x, float y, bool isStylus,
                                                                 bool ignoreDragWindow) const {
-    // Traverse windows from front to back to find touched window.
-    const auto& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
-        if (ignoreDragWindow && haveSameToken(windowHandle, mDragState->dragWindow)) {
+    const WindowSpatialIndex* index = getWindowSpatialIndexLocked(displayId);
+    if (index == nullptr) {
+        return nullptr;
+    }
+    // Traverse the windows which may contain the point from front to back to find touched window.
+    const vec2 p = index->toLogical(x, y);
+    for (uint32_t position : index->getCandidates(p)) {
+        const WindowSpatialIndex::Window& window = index->getWindow(position);
+        if (ignoreDragWindow && haveSameToken(window.handle, mDragState->dragWindow)) {
             continue;
         }
 
-        const WindowInfo& info = *windowHandle->getInfo();
+        const WindowInfo& info = *window.handle->getInfo();
         if (!info.isSpy() &&
-            windowAcceptsTouchAt(info, displayId, x, y, isStylus, getTransformLocked(displayId))) {
-            return windowHandle;
+            windowAcceptsTouchAt(info, displayId, window.touchableRegion, p, isStylus)) {
+            return window.handle;
         }
     }
     return nullptr;
@@ -1478,12 +1493,19 @@ std::vector<InputTarget> InputDispatcher::findOutsideTargetsLocked(
 
 std::vector<sp<WindowInfoHandle>> InputDispatcher::findTouchedSpyWindowsAtLocked(
         ui::LogicalDisplayId displayId, float x, float y, bool isStylus, DeviceId deviceId) const {
-    // Traverse windows from front to back and gather the touched spy windows.
     std::vector<sp<WindowInfoHandle>> spyWindows;
-    const auto& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
+    const WindowSpatialIndex* index = getWindowSpatialIndexLocked(displayId);
+    if (index == nullptr) {
+        return spyWindows;
+    }
+    // Traverse the windows which may contain the point from front to back and gather the touched
+    // spy windows. Windows which don't support split touch are always candidates.
+    const vec2 p = index->toLogical(x, y);
+    for (uint32_t position : index->getCandidates(p)) {
+        const WindowSpatialIndex::Window& window = index->getWindow(position);
+        const sp<WindowInfoHandle>& windowHandle = window.handle;
         const WindowInfo& info = *windowHandle->getInfo();
-        if (!windowAcceptsTouchAt(info, displayId, x, y, isStylus, getTransformLocked(displayId))) {
+        if (!windowAcceptsTouchAt(info, displayId, window.touchableRegion, p, isStylus)) {
             // Generally, we would skip any pointer that's outside of the window. However, if the
             // spy prevents splitting, and already has some of the pointers from this device, then
             // it should get more pointers from the same device, even if they are outside of that
@@ -3140,19 +3162,24 @@ InputDispatcher::TouchOcclusionInfo InputDispatcher::computeTouchOcclusionInfoLo
         const sp<WindowInfoHandle>& windowHandle, float x, float y) const {
     const WindowInfo* windowInfo = windowHandle->getInfo();
     ui::LogicalDisplayId displayId = windowInfo->displayId;
-    const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
+    const WindowSpatialIndex* index = getWindowSpatialIndexLocked(displayId);
     TouchOcclusionInfo info;
     info.hasBlockingOcclusion = false;
     info.obscuringOpacity = 0;
     info.obscuringUid = gui::Uid::INVALID;
     std::map<gui::Uid, float> opacityByUid;
-    for (const sp<WindowInfoHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
+    const vec2 p = index != nullptr ? index->toLogical(x, y) : vec2();
+    const uint32_t position = index != nullptr ? index->getPosition(windowHandle) : 0;
+    for (uint32_t otherPosition :
+         index != nullptr ? index->getCandidates(p) : std::span<const uint32_t>()) {
+        if (otherPosition >= position) {
             break; // All future windows are below us. Exit early.
         }
+        const WindowSpatialIndex::Window& other = index->getWindow(otherPosition);
+        const sp<WindowInfoHandle>& otherHandle = other.handle;
         const WindowInfo* otherInfo = otherHandle->getInfo();
         if (canBeObscuredBy(windowHandle, otherHandle) &&
-            windowOccludesTouchAt(*otherInfo, displayId, x, y, getTransformLocked(displayId)) &&
+            windowOccludesTouchAt(*otherInfo, displayId, other.frame, p) &&
             !haveSameApplicationToken(windowInfo, otherInfo)) {
             if (DEBUG_TOUCH_OCCLUSION) {
                 info.debugInfo.push_back(
@@ -3224,14 +3251,19 @@ bool InputDispatcher::isTouchTrustedLocked(const TouchOcclusionInfo& occlusionIn
 bool InputDispatcher::isWindowObscuredAtPointLocked(const sp<WindowInfoHandle>& windowHandle,
                                                     float x, float y) const {
     ui::LogicalDisplayId displayId = windowHandle->getInfo()->displayId;
-    const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
+    const WindowSpatialIndex* index = getWindowSpatialIndexLocked(displayId);
+    if (index == nullptr) {
+        return false;
+    }
+    const vec2 p = index->toLogical(x, y);
+    const uint32_t position = index->getPosition(windowHandle);
+    for (uint32_t otherPosition : index->getCandidates(p)) {
+        if (otherPosition >= position) {
             break; // All future windows are below us. Exit early.
         }
-        const WindowInfo* otherInfo = otherHandle->getInfo();
-        if (canBeObscuredBy(windowHandle, otherHandle) &&
-            windowOccludesTouchAt(*otherInfo, displayId, x, y, getTransformLocked(displayId))) {
+        const WindowSpatialIndex::Window& other = index->getWindow(otherPosition);
+        if (canBeObscuredBy(windowHandle, other.handle) &&
+            windowOccludesTouchAt(*other.handle->getInfo(), displayId, other.frame, p)) {
             return true;
         }
     }
@@ -3537,20 +3569,18 @@ void InputDispatcher::enqueueDispatchEntryLocked(const std::shared_ptr<Connectio
                     {
                         // Generate a new MotionEntry with a new eventId using the resolved action
                         // and flags, and set it as the resolved entry.
-                        auto newEntry = std::make_shared<
-                                MotionEntry>(mIdGenerator.nextId(), motionEntry.injectionState,
-                                             motionEntry.eventTime, motionEntry.deviceId,
-                                             motionEntry.source, motionEntry.displayId,
-                                             motionEntry.policyFlags, resolvedAction,
-                                             motionEntry.actionButton, resolvedFlags,
-                                             motionEntry.metaState, motionEntry.buttonState,
-                                             motionEntry.classification, motionEntry.edgeFlags,
-                                             motionEntry.xPrecision, motionEntry.yPrecision,
-                                             motionEntry.xCursorPosition,
-                                             motionEntry.yCursorPosition, motionEntry.downTime,
-                                             usingProperties.value_or(
-                                                     motionEntry.pointerProperties),
-                                             usingCoords.value_or(motionEntry.pointerCoords));
+                        auto newEntry = std::allocate_shared<MotionEntry>(
+                                EntryAllocator<MotionEntry>(), mIdGenerator.nextId(),
+                                motionEntry.injectionState, motionEntry.eventTime,
+                                motionEntry.deviceId, motionEntry.source, motionEntry.displayId,
+                                motionEntry.policyFlags, resolvedAction, motionEntry.actionButton,
+                                resolvedFlags, motionEntry.metaState, motionEntry.buttonState,
+                                motionEntry.classification, motionEntry.edgeFlags,
+                                motionEntry.xPrecision, motionEntry.yPrecision,
+                                motionEntry.xCursorPosition, motionEntry.yCursorPosition,
+                                motionEntry.downTime,
+                                usingProperties.value_or(motionEntry.pointerProperties),
+                                usingCoords.value_or(motionEntry.pointerCoords));
                         if (mTracer) {
                             ensureEventTraced(motionEntry);
                             newEntry->traceTracker =
@@ -3784,6 +3814,95 @@ status_t InputDispatcher::publishMotionEvent(Connection& connection,
                                 motionEntry.pointerProperties.data(), usingCoords);
 }
 
+status_t InputDispatcher::publishDispatchEntryLocked(Connection& connection,
+                                                     DispatchEntry& dispatchEntry) {
+    status_t status;
+    const EventEntry& eventEntry = *(dispatchEntry.eventEntry);
+    switch (eventEntry.type) {
+        case EventEntry::Type::KEY: {
+            const KeyEntry& keyEntry = static_cast<const KeyEntry&>(eventEntry);
+            std::array<uint8_t, 32> hmac = getSignature(keyEntry, dispatchEntry);
+            if (DEBUG_OUTBOUND_EVENT_DETAILS) {
+                LOG(INFO) << "Publishing " << dispatchEntry << " to "
+                          << connection.getInputChannelName();
+            }
+
+            // Publish the key event.
+            status = connection.inputPublisher
+                             .publishKeyEvent(dispatchEntry.seq, keyEntry.id, keyEntry.deviceId,
+                                              keyEntry.source, keyEntry.displayId,
+                                              std::move(hmac), keyEntry.action,
+                                              dispatchEntry.resolvedFlags, keyEntry.keyCode,
+                                              keyEntry.scanCode, keyEntry.metaState,
+                                              keyEntry.repeatCount, keyEntry.downTime,
+                                              keyEntry.eventTime);
+            if (mTracer) {
+                ensureEventTraced(keyEntry);
+                mTracer->traceEventDispatch(dispatchEntry, *keyEntry.traceTracker);
+            }
+            break;
+        }
+
+        case EventEntry::Type::MOTION: {
+            if (DEBUG_OUTBOUND_EVENT_DETAILS) {
+                LOG(INFO) << "Publishing " << dispatchEntry << " to "
+                          << connection.getInputChannelName();
+            }
+            const MotionEntry& motionEntry = static_cast<const MotionEntry&>(eventEntry);
+            status = publishMotionEvent(connection, dispatchEntry);
+            if (status == BAD_VALUE) {
+                logDispatchStateLocked();
+                LOG(FATAL) << "Publisher failed for " << motionEntry;
+            }
+            if (mTracer) {
+                ensureEventTraced(motionEntry);
+                mTracer->traceEventDispatch(dispatchEntry, *motionEntry.traceTracker);
+            }
+            break;
+        }
+
+        case EventEntry::Type::FOCUS: {
+            const FocusEntry& focusEntry = static_cast<const FocusEntry&>(eventEntry);
+            status = connection.inputPublisher.publishFocusEvent(dispatchEntry.seq, focusEntry.id,
+                                                                 focusEntry.hasFocus);
+            break;
+        }
+
+        case EventEntry::Type::TOUCH_MODE_CHANGED: {
+            const TouchModeEntry& touchModeEntry = static_cast<const TouchModeEntry&>(eventEntry);
+            status = connection.inputPublisher
+                             .publishTouchModeEvent(dispatchEntry.seq, touchModeEntry.id,
+                                                    touchModeEntry.inTouchMode);
+
+            break;
+        }
+
+        case EventEntry::Type::POINTER_CAPTURE_CHANGED: {
+            const auto& captureEntry = static_cast<const PointerCaptureChangedEntry&>(eventEntry);
+            status = connection.inputPublisher
+                             .publishCaptureEvent(dispatchEntry.seq, captureEntry.id,
+                                                  captureEntry.pointerCaptureRequest.isEnable());
+            break;
+        }
+
+        case EventEntry::Type::DRAG: {
+            const DragEntry& dragEntry = static_cast<const DragEntry&>(eventEntry);
+            status = connection.inputPublisher.publishDragEvent(dispatchEntry.seq, dragEntry.id,
+                                                                dragEntry.x, dragEntry.y,
+                                                                dragEntry.isExiting);
+            break;
+        }
+
+        case EventEntry::Type::DEVICE_RESET:
+        case EventEntry::Type::SENSOR: {
+            LOG_ALWAYS_FATAL("Should never start dispatch cycles for %s events",
+                             ftl::enum_string(eventEntry.type).c_str());
+            return INVALID_OPERATION;
+        }
+    }
+    return status;
+}
+
 void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
                                                const std::shared_ptr<Connection>& connection) {
     ATRACE_NAME_IF(ATRACE_ENABLED(),
@@ -3794,100 +3913,40 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
     }
 
     while (connection->status == Connection::Status::NORMAL && !connection->outboundQueue.empty()) {
-        std::unique_ptr<DispatchEntry>& dispatchEntry = connection->outboundQueue.front();
-        dispatchEntry->deliveryTime = currentTime;
+        // Publish as many of the pending events as possible with a single write to the channel,
+        // which matters when a burst of motion events is queued for a slow application.
         const std::chrono::nanoseconds timeout = getDispatchingTimeoutLocked(connection);
-        dispatchEntry->timeoutTime = currentTime + timeout.count();
-
-        // Publish the event.
-        status_t status;
-        const EventEntry& eventEntry = *(dispatchEntry->eventEntry);
-        switch (eventEntry.type) {
-            case EventEntry::Type::KEY: {
-                const KeyEntry& keyEntry = static_cast<const KeyEntry&>(eventEntry);
-                std::array<uint8_t, 32> hmac = getSignature(keyEntry, *dispatchEntry);
-                if (DEBUG_OUTBOUND_EVENT_DETAILS) {
-                    LOG(INFO) << "Publishing " << *dispatchEntry << " to "
-                              << connection->getInputChannelName();
-                }
-
-                // Publish the key event.
-                status = connection->inputPublisher
-                                 .publishKeyEvent(dispatchEntry->seq, keyEntry.id,
-                                                  keyEntry.deviceId, keyEntry.source,
-                                                  keyEntry.displayId, std::move(hmac),
-                                                  keyEntry.action, dispatchEntry->resolvedFlags,
-                                                  keyEntry.keyCode, keyEntry.scanCode,
-                                                  keyEntry.metaState, keyEntry.repeatCount,
-                                                  keyEntry.downTime, keyEntry.eventTime);
-                if (mTracer) {
-                    ensureEventTraced(keyEntry);
-                    mTracer->traceEventDispatch(*dispatchEntry, *keyEntry.traceTracker);
-                }
-                break;
-            }
-
-            case EventEntry::Type::MOTION: {
-                if (DEBUG_OUTBOUND_EVENT_DETAILS) {
-                    LOG(INFO) << "Publishing " << *dispatchEntry << " to "
-                              << connection->getInputChannelName();
-                }
-                const MotionEntry& motionEntry = static_cast<const MotionEntry&>(eventEntry);
-                status = publishMotionEvent(*connection, *dispatchEntry);
-                if (status == BAD_VALUE) {
-                    logDispatchStateLocked();
-                    LOG(FATAL) << "Publisher failed for " << motionEntry;
-                }
-                if (mTracer) {
-                    ensureEventTraced(motionEntry);
-                    mTracer->traceEventDispatch(*dispatchEntry, *motionEntry.traceTracker);
-                }
-                break;
-            }
-
-            case EventEntry::Type::FOCUS: {
-                const FocusEntry& focusEntry = static_cast<const FocusEntry&>(eventEntry);
-                status = connection->inputPublisher.publishFocusEvent(dispatchEntry->seq,
-                                                                      focusEntry.id,
-                                                                      focusEntry.hasFocus);
-                break;
-            }
-
-            case EventEntry::Type::TOUCH_MODE_CHANGED: {
-                const TouchModeEntry& touchModeEntry =
-                        static_cast<const TouchModeEntry&>(eventEntry);
-                status = connection->inputPublisher
-                                 .publishTouchModeEvent(dispatchEntry->seq, touchModeEntry.id,
-                                                        touchModeEntry.inTouchMode);
-
-                break;
-            }
-
-            case EventEntry::Type::POINTER_CAPTURE_CHANGED: {
-                const auto& captureEntry =
-                        static_cast<const PointerCaptureChangedEntry&>(eventEntry);
-                status =
-                        connection->inputPublisher
-                                .publishCaptureEvent(dispatchEntry->seq, captureEntry.id,
-                                                     captureEntry.pointerCaptureRequest.isEnable());
-                break;
-            }
-
-            case EventEntry::Type::DRAG: {
-                const DragEntry& dragEntry = static_cast<const DragEntry&>(eventEntry);
-                status = connection->inputPublisher.publishDragEvent(dispatchEntry->seq,
-                                                                     dragEntry.id, dragEntry.x,
-                                                                     dragEntry.y,
-                                                                     dragEntry.isExiting);
+        const size_t batchSize = std::min(connection->outboundQueue.size(), MAX_PUBLISH_BATCH_SIZE);
+        status_t status = OK;
+        size_t published = 0;
+        connection->inputPublisher.beginBatch();
+        while (published < batchSize) {
+            DispatchEntry& dispatchEntry = *connection->outboundQueue[published];
+            dispatchEntry.deliveryTime = currentTime;
+            dispatchEntry.timeoutTime = currentTime + timeout.count();
+            status = publishDispatchEntryLocked(*connection, dispatchEntry);
+            if (status) {
                 break;
             }
+            published++;
+        }
+        size_t sent;
+        const status_t sendStatus = connection->inputPublisher.endBatch(&sent);
+        if (sent < published || status == OK) {
+            status = sendStatus;
+        }
 
-            case EventEntry::Type::DEVICE_RESET:
-            case EventEntry::Type::SENSOR: {
-                LOG_ALWAYS_FATAL("Should never start dispatch cycles for %s events",
-                                 ftl::enum_string(eventEntry.type).c_str());
-                return;
+        // Re-enqueue the events that were sent on the wait queue.
+        for (size_t i = 0; i < sent; i++) {
+            std::unique_ptr<DispatchEntry>& dispatchEntry = connection->outboundQueue.front();
+            const nsecs_t timeoutTime = dispatchEntry->timeoutTime;
+            connection->waitQueue.emplace_back(std::move(dispatchEntry));
+            connection->outboundQueue.erase(connection->outboundQueue.begin());
+            traceOutboundQueueLength(*connection);
+            if (connection->responsive) {
+                mAnrTracker.insert(timeoutTime, connection->getToken());
             }
+            traceWaitQueueLength(*connection);
         }
 
         // Check the result.
@@ -3919,16 +3978,6 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
             }
             return;
         }
-
-        // Re-enqueue the event on the wait queue.
-        const nsecs_t timeoutTime = dispatchEntry->timeoutTime;
-        connection->waitQueue.emplace_back(std::move(dispatchEntry));
-        connection->outboundQueue.erase(connection->outboundQueue.begin());
-        traceOutboundQueueLength(*connection);
-        if (connection->responsive) {
-            mAnrTracker.insert(timeoutTime, connection->getToken());
-        }
-        traceWaitQueueLength(*connection);
     }
 }
 
@@ -5153,6 +5202,12 @@ const std::vector<sp<WindowInfoHandle>>& InputDispatcher::getWindowHandlesLocked
     return it != mWindowHandlesByDisplay.end() ? it->second : EMPTY_WINDOW_HANDLES;
 }
 
+const WindowSpatialIndex* InputDispatcher::getWindowSpatialIndexLocked(
+        ui::LogicalDisplayId displayId) const {
+    auto it = mWindowSpatialIndexByDisplay.find(displayId);
+    return it != mWindowSpatialIndexByDisplay.end() ? &it->second : nullptr;
+}
+
 sp<WindowInfoHandle> InputDispatcher::getWindowHandleLocked(
         const sp<IBinder>& windowHandleToken, std::optional<ui::LogicalDisplayId> displayId) const {
     if (windowHandleToken == nullptr) {
@@ -5279,6 +5334,7 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
     if (windowInfoHandles.empty()) {
         // Remove all handles on a display if there are no windows left.
         mWindowHandlesByDisplay.erase(displayId);
+        mWindowSpatialIndexByDisplay.erase(displayId);
         return;
     }
 
@@ -5324,6 +5380,7 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
     }
 
     // Insert or replace
+    mWindowSpatialIndexByDisplay[displayId].update(newHandles, getTransformLocked(displayId));
     mWindowHandlesByDisplay[displayId] = newHandles;
 }
 
@@ -5988,6 +6045,9 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) const {
             } else {
                 dump += INDENT2 "Windows: <none>\n";
             }
+            if (const WindowSpatialIndex* index = getWindowSpatialIndexLocked(displayId); index) {
+                index->dump(dump, INDENT2);
+            }
         }
     } else {
         dump += INDENT "Displays: <none>\n";
@@ -6087,6 +6147,8 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) const {
         dump += INDENT "TouchModePerDisplay: <none>\n";
     }
 
+    dump += EntryPool::getInstance().dump(INDENT);
+
     dump += INDENT "Configuration:\n";
     dump += StringPrintf(INDENT2 "KeyRepeatDelay: %" PRId64 "ms\n", ns2ms(mConfig.keyRepeatDelay));
     dump += StringPrintf(INDENT2 "KeyRepeatTimeout: %" PRId64 "ms\n",
@@ -6095,6 +6157,10 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) const {
     dump += mLatencyAggregator.dump(INDENT2);
     dump += INDENT "InputTracer: ";
     dump += mTracer == nullptr ? "Disabled" : "Enabled";
+    dump += "\n";
+    if (mTracer) {
+        dump += mTracer->dump(INDENT2);
+    }
 }
 
 void InputDispatcher::dumpMonitors(std::string& dump, const std::vector<Monitor>& monitors) const {
@@ -6123,7 +6189,11 @@ Result<std::unique_ptr<InputChannel>> InputDispatcher::createInputChannel(const
 
     std::unique_ptr<InputChannel> serverChannel;
     std::unique_ptr<InputChannel> clientChannel;
-    status_t result = InputChannel::openInputChannelPair(name, serverChannel, clientChannel);
+    // Events for windows may be sent through shared memory rather than through the socket of their
+    // input channel. See InputMessageRing.
+    status_t result =
+            InputChannel::openInputChannelPair(name, serverChannel, clientChannel,
+                                               input_flags::enable_shared_memory_input_channels());
 
     if (result) {
         return base::Error(result) << "Failed to open input channel pair with name " << name;
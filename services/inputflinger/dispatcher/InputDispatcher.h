@@ -32,6 +32,7 @@
 #include "Monitor.h"
 #include "TouchState.h"
 #include "TouchedWindow.h"
+#include "WindowSpatialIndex.h"
 #include "trace/InputTracerInterface.h"
 #include "trace/InputTracingBackendInterface.h"
 
@@ -365,6 +366,9 @@ private:
             mWindowHandlesByDisplay GUARDED_BY(mLock);
     std::unordered_map<ui::LogicalDisplayId /*displayId*/, android::gui::DisplayInfo> mDisplayInfos
             GUARDED_BY(mLock);
+    // Used for hit-testing the windows in mWindowHandlesByDisplay. Kept in sync with it.
+    std::unordered_map<ui::LogicalDisplayId /*displayId*/, WindowSpatialIndex>
+            mWindowSpatialIndexByDisplay GUARDED_BY(mLock);
     void setInputWindowsLocked(
             const std::vector<sp<android::gui::WindowInfoHandle>>& inputWindowHandles,
             ui::LogicalDisplayId displayId) REQUIRES(mLock);
@@ -372,6 +376,9 @@ private:
     const std::vector<sp<android::gui::WindowInfoHandle>>& getWindowHandlesLocked(
             ui::LogicalDisplayId displayId) const REQUIRES(mLock);
     ui::Transform getTransformLocked(ui::LogicalDisplayId displayId) const REQUIRES(mLock);
+    // Returns nullptr if there are no windows on the display.
+    const WindowSpatialIndex* getWindowSpatialIndexLocked(ui::LogicalDisplayId displayId) const
+            REQUIRES(mLock);
 
     sp<android::gui::WindowInfoHandle> getWindowHandleLocked(
             const sp<IBinder>& windowHandleToken,
@@ -605,6 +612,8 @@ private:
                                     std::shared_ptr<const EventEntry>,
                                     const InputTarget& inputTarget) REQUIRES(mLock);
     status_t publishMotionEvent(Connection& connection, DispatchEntry& dispatchEntry) const;
+    status_t publishDispatchEntryLocked(Connection& connection, DispatchEntry& dispatchEntry)
+            REQUIRES(mLock);
     void startDispatchCycleLocked(nsecs_t currentTime,
                                   const std::shared_ptr<Connection>& connection) REQUIRES(mLock);
     void finishDispatchCycleLocked(nsecs_t currentTime,
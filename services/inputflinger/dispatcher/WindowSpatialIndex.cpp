@@ -0,0 +1,194 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WindowSpatialIndex.h"
+#include <android-base/stringprintf.h>
+#include <algorithm>
+
+using android::base::StringPrintf;
+using android::gui::WindowInfo;
+using android::gui::WindowInfoHandle;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+// Unlike Rect::isEmpty, this doesn't overflow for very large rects.
+bool isEmpty(const Rect& rect) {
+    return rect.left >= rect.right || rect.top >= rect.bottom;
+}
+
+Rect getUnion(const Rect& a, const Rect& b) {
+    if (isEmpty(a)) {
+        return b;
+    }
+    if (isEmpty(b)) {
+        return a;
+    }
+    return Rect(std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right),
+                std::max(a.bottom, b.bottom));
+}
+
+// The area where a window can either receive or occlude touches.
+Rect getWindowBounds(const WindowSpatialIndex::Window& window) {
+    return getUnion(window.frame, window.touchableRegion.getBounds());
+}
+
+} // namespace
+
+void WindowSpatialIndex::update(const std::vector<sp<WindowInfoHandle>>& windowHandles,
+                                const ui::Transform& displayTransform) {
+    const bool sameTransform = displayTransform == mDisplayTransform;
+    bool changed = !sameTransform || windowHandles.size() != mWindows.size();
+
+    std::vector<IndexedWindow> windows;
+    windows.reserve(windowHandles.size());
+    for (uint32_t position = 0; position < windowHandles.size(); position++) {
+        const sp<WindowInfoHandle>& handle = windowHandles[position];
+        const WindowInfo& info = *handle->getInfo();
+        const bool everywhere = !info.supportsSplitTouch();
+
+        // Window handles are reused across updates, so the geometry of a window only needs to be
+        // transformed again if it changed.
+        const auto it = mPositions.find(handle.get());
+        if (sameTransform && it != mPositions.end()) {
+            const IndexedWindow& oldWindow = mWindows[it->second];
+            if (oldWindow.sourceFrame == info.frame &&
+                oldWindow.sourceTouchableRegion.hasSameRects(info.touchableRegion)) {
+                changed |= it->second != position || oldWindow.everywhere != everywhere;
+                windows.push_back(oldWindow);
+                windows.back().everywhere = everywhere;
+                continue;
+            }
+        }
+
+        changed = true;
+        IndexedWindow& window = windows.emplace_back();
+        window.handle = handle;
+        window.frame = displayTransform.transform(info.frame);
+        window.touchableRegion = displayTransform.transform(info.touchableRegion);
+        window.sourceFrame = info.frame;
+        window.sourceTouchableRegion = info.touchableRegion;
+        window.everywhere = everywhere;
+    }
+
+    if (!changed) {
+        return;
+    }
+
+    mDisplayTransform = displayTransform;
+    mWindows = std::move(windows);
+    mPositions.clear();
+    for (uint32_t position = 0; position < mWindows.size(); position++) {
+        mPositions[mWindows[position].handle.get()] = position;
+    }
+    rebuildGrid();
+}
+
+void WindowSpatialIndex::rebuildGrid() {
+    mBounds = Rect::EMPTY_RECT;
+    for (const IndexedWindow& window : mWindows) {
+        if (!window.everywhere) {
+            mBounds = getUnion(mBounds, getWindowBounds(window));
+        }
+    }
+
+    // Count the windows in each cell, then fill the cells in order so that they're sorted front to
+    // back.
+    constexpr size_t cellCount = GRID_SIZE * GRID_SIZE;
+    std::vector<uint32_t> cellSizes(cellCount, 0);
+    const auto forEachCell = [&](const IndexedWindow& window, auto&& visit) {
+        if (window.everywhere) {
+            for (size_t cell = 0; cell < cellCount; cell++) {
+                visit(cell);
+            }
+            return;
+        }
+        const Rect bounds = getWindowBounds(window);
+        if (isEmpty(bounds)) {
+            return;
+        }
+        for (int32_t y = getCellY(bounds.top); y <= getCellY(bounds.bottom - 1); y++) {
+            for (int32_t x = getCellX(bounds.left); x <= getCellX(bounds.right - 1); x++) {
+                visit(y * GRID_SIZE + x);
+            }
+        }
+    };
+
+    mEverywhereWindows.clear();
+    for (uint32_t position = 0; position < mWindows.size(); position++) {
+        if (mWindows[position].everywhere) {
+            mEverywhereWindows.push_back(position);
+        }
+        forEachCell(mWindows[position], [&](size_t cell) { cellSizes[cell]++; });
+    }
+
+    mCellStarts.resize(cellCount + 1);
+    mCellStarts[0] = 0;
+    for (size_t cell = 0; cell < cellCount; cell++) {
+        mCellStarts[cell + 1] = mCellStarts[cell] + cellSizes[cell];
+    }
+    mCellWindows.resize(mCellStarts[cellCount]);
+    std::vector<uint32_t> cellEnds(mCellStarts.begin(), mCellStarts.end() - 1);
+    for (uint32_t position = 0; position < mWindows.size(); position++) {
+        forEachCell(mWindows[position],
+                    [&](size_t cell) { mCellWindows[cellEnds[cell]++] = position; });
+    }
+}
+
+int32_t WindowSpatialIndex::getCellX(int32_t x) const {
+    const int64_t width = static_cast<int64_t>(mBounds.right) - mBounds.left;
+    return static_cast<int32_t>((static_cast<int64_t>(x) - mBounds.left) * GRID_SIZE / width);
+}
+
+int32_t WindowSpatialIndex::getCellY(int32_t y) const {
+    const int64_t height = static_cast<int64_t>(mBounds.bottom) - mBounds.top;
+    return static_cast<int32_t>((static_cast<int64_t>(y) - mBounds.top) * GRID_SIZE / height);
+}
+
+vec2 WindowSpatialIndex::toLogical(float x, float y) const {
+    return floor(mDisplayTransform.transform(x, y));
+}
+
+std::span<const uint32_t> WindowSpatialIndex::getCandidates(const vec2& point) const {
+    if (isEmpty(mBounds) || point.x < mBounds.left || point.x >= mBounds.right ||
+        point.y < mBounds.top || point.y >= mBounds.bottom) {
+        return mEverywhereWindows;
+    }
+    const int32_t cell = getCellY(static_cast<int32_t>(point.y)) * GRID_SIZE +
+            getCellX(static_cast<int32_t>(point.x));
+    return std::span<const uint32_t>(mCellWindows)
+            .subspan(mCellStarts[cell], mCellStarts[cell + 1] - mCellStarts[cell]);
+}
+
+uint32_t WindowSpatialIndex::getPosition(const sp<WindowInfoHandle>& windowHandle) const {
+    const auto it = mPositions.find(windowHandle.get());
+    return it != mPositions.end() ? it->second : mWindows.size();
+}
+
+void WindowSpatialIndex::dump(std::string& dump, const char* prefix) const {
+    size_t maxCellSize = 0;
+    for (size_t cell = 0; cell + 1 < mCellStarts.size(); cell++) {
+        maxCellSize = std::max<size_t>(maxCellSize, mCellStarts[cell + 1] - mCellStarts[cell]);
+    }
+    dump += prefix +
+            StringPrintf("WindowSpatialIndex: bounds=[%d,%d][%d,%d], windows=%zu, everywhere=%zu, "
+                         "maxCellSize=%zu\n",
+                         mBounds.left, mBounds.top, mBounds.right, mBounds.bottom, mWindows.size(),
+                         mEverywhereWindows.size(), maxCellSize);
+}
+
+} // namespace android::inputdispatcher
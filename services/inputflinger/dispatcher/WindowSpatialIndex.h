@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <gui/WindowInfo.h>
+#include <ui/Rect.h>
+#include <ui/Region.h>
+#include <ui/Transform.h>
+#include <utils/StrongPointer.h>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+
+namespace inputdispatcher {
+
+/**
+ * Speeds up hit-testing and occlusion checks on displays with many windows.
+ *
+ * The window geometry is kept in the logical display space (see windowAcceptsTouchAt in
+ * InputDispatcher.cpp), so that it doesn't need to be transformed for every touch. The bounds of
+ * all the windows are divided into a grid, and each cell lists the windows that may contain a
+ * point in that cell, front to back.
+ *
+ * Windows which don't support split touch are listed everywhere, since they may receive pointers
+ * outside of their bounds.
+ */
+class WindowSpatialIndex {
+public:
+    struct Window {
+        sp<android::gui::WindowInfoHandle> handle;
+        // In the logical display space.
+        Rect frame;
+        Region touchableRegion;
+    };
+
+    /**
+     * Updates the index with the given windows, front to back. Windows whose geometry and display
+     * transform haven't changed since the last update are not transformed again, and the grid is
+     * only rebuilt if something changed.
+     */
+    void update(const std::vector<sp<android::gui::WindowInfoHandle>>& windowHandles,
+                const ui::Transform& displayTransform);
+
+    // Transforms a point in the display space into the (rounded down) logical display space.
+    vec2 toLogical(float x, float y) const;
+
+    // Returns the positions of the windows which may contain the given logical point, in
+    // increasing order, i.e. front to back.
+    std::span<const uint32_t> getCandidates(const vec2& point) const;
+
+    const Window& getWindow(uint32_t position) const { return mWindows[position]; }
+
+    // Returns the position of the given window, or the number of windows if it isn't indexed.
+    uint32_t getPosition(const sp<android::gui::WindowInfoHandle>& windowHandle) const;
+
+    void dump(std::string& dump, const char* prefix = "") const;
+
+private:
+    static constexpr int32_t GRID_SIZE = 16;
+
+    struct IndexedWindow : Window {
+        // Copies of the WindowInfo geometry, to tell if the window needs to be transformed again.
+        Rect sourceFrame;
+        Region sourceTouchableRegion;
+        bool everywhere;
+    };
+
+    void rebuildGrid();
+    int32_t getCellX(int32_t x) const;
+    int32_t getCellY(int32_t y) const;
+
+    ui::Transform mDisplayTransform;
+    std::vector<IndexedWindow> mWindows;
+    std::unordered_map<const android::gui::WindowInfoHandle*, uint32_t> mPositions;
+
+    Rect mBounds;
+    // The windows of cell i are mCellWindows[mCellStarts[i]] to mCellWindows[mCellStarts[i + 1]].
+    std::vector<uint32_t> mCellStarts;
+    std::vector<uint32_t> mCellWindows;
+    // The windows listed everywhere, for points outside of mBounds.
+    std::vector<uint32_t> mEverywhereWindows;
+};
+
+} // namespace inputdispatcher
+} // namespace android
@@ -52,6 +52,7 @@ public:
     void setInputMethodConnectionIsActive(bool isActive) override {
         mIsImeConnectionActive = isActive;
     }
+    std::string dump(const char* prefix) const override { return mBackend->dump(prefix); }
 
 private:
     std::unique_ptr<InputTracingBackendInterface> mBackend;
@@ -109,6 +109,11 @@ public:
      * Notify that the state of the input method connection changed.
      */
     virtual void setInputMethodConnectionIsActive(bool isActive) = 0;
+
+    /**
+     * Dump the state of the tracer.
+     */
+    virtual std::string dump(const char* prefix) const = 0;
 };
 
 } // namespace android::inputdispatcher::trace
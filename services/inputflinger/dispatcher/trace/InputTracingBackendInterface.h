@@ -22,6 +22,7 @@
 
 #include <array>
 #include <set>
+#include <string>
 #include <variant>
 #include <vector>
 
@@ -132,6 +133,9 @@ public:
 
     /** Trace an event being sent to a window. */
     virtual void traceWindowDispatch(const WindowDispatchArgs&, const TracedEventMetadata&) = 0;
+
+    /** Dump the state of the backend, if it has any worth reporting. */
+    virtual std::string dump(const char* prefix) const { return ""; }
 };
 
 } // namespace android::inputdispatcher::trace
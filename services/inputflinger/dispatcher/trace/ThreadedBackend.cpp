@@ -21,6 +21,8 @@
 #include "InputTracingPerfettoBackend.h"
 
 #include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <inttypes.h>
 
 namespace android::inputdispatcher::trace::impl {
 
@@ -38,10 +40,13 @@ struct Visitor : V... {
 
 template <typename Backend>
 ThreadedBackend<Backend>::ThreadedBackend(Backend&& innerBackend)
-      : mBackend(std::move(innerBackend)),
+      : mRing(RING_SIZE),
+        mBackend(std::move(innerBackend)),
         mTracerThread(
                 "InputTracer", [this]() { threadLoop(); },
-                [this]() { mThreadWakeCondition.notify_all(); }) {}
+                [this]() { mThreadWakeCondition.notify_all(); }) {
+    static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "RING_SIZE must be a power of two");
+}
 
 template <typename Backend>
 ThreadedBackend<Backend>::~ThreadedBackend() {
@@ -52,69 +57,192 @@ ThreadedBackend<Backend>::~ThreadedBackend() {
     mThreadWakeCondition.notify_all();
 }
 
+template <typename Backend>
+typename ThreadedBackend<Backend>::Slot* ThreadedBackend<Backend>::beginWrite() {
+    const size_t writePosition = mWritePosition.load(std::memory_order_relaxed);
+    if (writePosition - mReadPosition.load(std::memory_order_acquire) == RING_SIZE) {
+        mDroppedEvents.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return &mRing[writePosition & (RING_SIZE - 1)];
+}
+
+template <typename Backend>
+void ThreadedBackend<Backend>::endWrite() {
+    if (mHasIdleWaiter.load(std::memory_order_relaxed)) {
+        // When testing, publish the event and update the idle status together, so that a waiter
+        // never sees the thread as idle while there is an event that it hasn't traced.
+        std::scoped_lock lock(mLock);
+        mWritePosition.fetch_add(1);
+        setIdleStatus(false);
+        mThreadWakeCondition.notify_all();
+        return;
+    }
+    // Publishing the write position and then checking whether the thread waits pairs with the
+    // thread announcing that it waits and then checking the write position, so that either the
+    // thread sees the new event, or it gets woken up.
+    mWritePosition.fetch_add(1);
+    if (mThreadWaiting.load()) {
+        std::scoped_lock lock(mLock);
+        mThreadWakeCondition.notify_all();
+    }
+}
+
+namespace {
+
+void copyMetadata(const TracedEventMetadata& metadata, bool& isSecure,
+                  std::vector<gui::Uid>& targets, bool& isImeConnectionActive,
+                  nsecs_t& processingTimestamp) {
+    isSecure = metadata.isSecure;
+    targets.assign(metadata.targets.begin(), metadata.targets.end());
+    isImeConnectionActive = metadata.isImeConnectionActive;
+    processingTimestamp = metadata.processingTimestamp;
+}
+
+} // namespace
+
 template <typename Backend>
 void ThreadedBackend<Backend>::traceMotionEvent(const TracedMotionEvent& event,
                                                 const TracedEventMetadata& metadata) {
-    std::scoped_lock lock(mLock);
-    mQueue.emplace_back(event, metadata);
-    setIdleStatus(false);
-    mThreadWakeCondition.notify_all();
+    std::scoped_lock producerLock(mProducerLock);
+    Slot* slot = beginWrite();
+    if (slot == nullptr) {
+        return;
+    }
+    slot->type = Slot::Type::MOTION;
+    slot->motionEvent = event;
+    copyMetadata(metadata, slot->isSecure, slot->targets, slot->isImeConnectionActive,
+                 slot->processingTimestamp);
+    endWrite();
 }
 
 template <typename Backend>
 void ThreadedBackend<Backend>::traceKeyEvent(const TracedKeyEvent& event,
                                              const TracedEventMetadata& metadata) {
-    std::scoped_lock lock(mLock);
-    mQueue.emplace_back(event, metadata);
-    setIdleStatus(false);
-    mThreadWakeCondition.notify_all();
+    std::scoped_lock producerLock(mProducerLock);
+    Slot* slot = beginWrite();
+    if (slot == nullptr) {
+        return;
+    }
+    slot->type = Slot::Type::KEY;
+    slot->keyEvent = event;
+    copyMetadata(metadata, slot->isSecure, slot->targets, slot->isImeConnectionActive,
+                 slot->processingTimestamp);
+    endWrite();
 }
 
 template <typename Backend>
 void ThreadedBackend<Backend>::traceWindowDispatch(const WindowDispatchArgs& dispatchArgs,
                                                    const TracedEventMetadata& metadata) {
-    std::scoped_lock lock(mLock);
-    mQueue.emplace_back(dispatchArgs, metadata);
-    setIdleStatus(false);
-    mThreadWakeCondition.notify_all();
+    std::scoped_lock producerLock(mProducerLock);
+    Slot* slot = beginWrite();
+    if (slot == nullptr) {
+        return;
+    }
+    std::visit(Visitor{[&](const TracedMotionEvent& e) {
+                           slot->type = Slot::Type::MOTION_DISPATCH;
+                           slot->motionEvent = e;
+                       },
+                       [&](const TracedKeyEvent& e) {
+                           slot->type = Slot::Type::KEY_DISPATCH;
+                           slot->keyEvent = e;
+                       }},
+               dispatchArgs.eventEntry);
+    WindowDispatchArgs& args = slot->dispatchArgs;
+    args.deliveryTime = dispatchArgs.deliveryTime;
+    args.resolvedFlags = dispatchArgs.resolvedFlags;
+    args.targetUid = dispatchArgs.targetUid;
+    args.vsyncId = dispatchArgs.vsyncId;
+    args.windowId = dispatchArgs.windowId;
+    args.transform = dispatchArgs.transform;
+    args.rawTransform = dispatchArgs.rawTransform;
+    args.hmac = dispatchArgs.hmac;
+    args.resolvedKeyRepeatCount = dispatchArgs.resolvedKeyRepeatCount;
+    copyMetadata(metadata, slot->isSecure, slot->targets, slot->isImeConnectionActive,
+                 slot->processingTimestamp);
+    endWrite();
 }
 
 template <typename Backend>
-void ThreadedBackend<Backend>::threadLoop() {
-    std::vector<TraceEntry> entries;
+void ThreadedBackend<Backend>::traceSlot(const Slot& slot) {
+    const TracedEventMetadata metadata{
+            .isSecure = slot.isSecure,
+            .targets = {slot.targets.begin(), slot.targets.end()},
+            .isImeConnectionActive = slot.isImeConnectionActive,
+            .processingTimestamp = slot.processingTimestamp,
+    };
+    switch (slot.type) {
+        case Slot::Type::KEY:
+            mBackend.traceKeyEvent(slot.keyEvent, metadata);
+            break;
+        case Slot::Type::MOTION:
+            mBackend.traceMotionEvent(slot.motionEvent, metadata);
+            break;
+        case Slot::Type::KEY_DISPATCH:
+        case Slot::Type::MOTION_DISPATCH: {
+            WindowDispatchArgs args = slot.dispatchArgs;
+            if (slot.type == Slot::Type::KEY_DISPATCH) {
+                args.eventEntry = slot.keyEvent;
+            } else {
+                args.eventEntry = slot.motionEvent;
+            }
+            mBackend.traceWindowDispatch(args, metadata);
+            break;
+        }
+    }
+}
 
+template <typename Backend>
+void ThreadedBackend<Backend>::threadLoop() {
     { // acquire lock
         std::unique_lock lock(mLock);
         base::ScopedLockAssertion assumeLocked(mLock);
 
-        if (mQueue.empty()) {
+        const auto hasEvents = [this]() { return mReadPosition.load() != mWritePosition.load(); };
+        if (!hasEvents()) {
             setIdleStatus(true);
         }
 
         // Wait until we need to process more events or exit.
-        mThreadWakeCondition.wait(lock,
-                                  [&]() REQUIRES(mLock) { return mThreadExit || !mQueue.empty(); });
+        mThreadWaiting.store(true);
+        mThreadWakeCondition.wait(lock, [&]() REQUIRES(mLock) {
+            return mThreadExit || (!mPausedForTesting && hasEvents());
+        });
+        mThreadWaiting.store(false);
         if (mThreadExit) {
             setIdleStatus(true);
             return;
         }
-
-        mQueue.swap(entries);
     } // release lock
 
-    // Trace the events into the backend without holding the lock to reduce the amount of
-    // work performed in the critical section.
-    for (const auto& [entry, traceArgs] : entries) {
-        std::visit(Visitor{[&](const TracedMotionEvent& e) {
-                               mBackend.traceMotionEvent(e, traceArgs);
-                           },
-                           [&](const TracedKeyEvent& e) { mBackend.traceKeyEvent(e, traceArgs); },
-                           [&](const WindowDispatchArgs& args) {
-                               mBackend.traceWindowDispatch(args, traceArgs);
-                           }},
-                   entry);
+    // Trace the events into the backend without holding the lock. The proto conversion happens in
+    // the backend, on this thread.
+    const size_t writePosition = mWritePosition.load(std::memory_order_acquire);
+    for (size_t position = mReadPosition.load(std::memory_order_relaxed);
+         position != writePosition; position++) {
+        traceSlot(mRing[position & (RING_SIZE - 1)]);
+        // Release the slot to the producer only once it has been traced.
+        mReadPosition.store(position + 1, std::memory_order_release);
+    }
+
+    const uint64_t droppedEvents = mDroppedEvents.load(std::memory_order_relaxed);
+    if (droppedEvents != mReportedDroppedEvents) {
+        LOG(WARNING) << "Dropped " << droppedEvents - mReportedDroppedEvents
+                     << " traced events because the tracing thread could not keep up, "
+                     << droppedEvents << " in total";
+        mReportedDroppedEvents = droppedEvents;
     }
-    entries.clear();
+}
+
+template <typename Backend>
+std::string ThreadedBackend<Backend>::dump(const char* prefix) const {
+    // Load the read position first, so that it is never ahead of the write position.
+    const size_t readPosition = mReadPosition.load();
+    const size_t writePosition = mWritePosition.load();
+    return base::StringPrintf("%sThreadedBackend:\n", prefix) +
+            base::StringPrintf("%s  PendingEvents: %zu / %zu\n", prefix,
+                               writePosition - readPosition, RING_SIZE) +
+            base::StringPrintf("%s  DroppedEvents: %" PRIu64 "\n", prefix, mDroppedEvents.load());
 }
 
 template <typename Backend>
@@ -122,6 +250,7 @@ std::function<void()> ThreadedBackend<Backend>::getIdleWaiterForTesting() {
     std::scoped_lock lock(mLock);
     if (!mIdleWaiter) {
         mIdleWaiter = std::make_shared<IdleWaiter>();
+        mHasIdleWaiter = true;
     }
 
     // Return a lambda that holds a strong reference to the idle waiter, whose lifetime can extend
@@ -135,6 +264,19 @@ std::function<void()> ThreadedBackend<Backend>::getIdleWaiterForTesting() {
     };
 }
 
+template <typename Backend>
+std::function<void()> ThreadedBackend<Backend>::pauseForTesting() {
+    std::scoped_lock lock(mLock);
+    mPausedForTesting = true;
+    return [this]() {
+        {
+            std::scoped_lock resumeLock(mLock);
+            mPausedForTesting = false;
+        }
+        mThreadWakeCondition.notify_all();
+    };
+}
+
 template <typename Backend>
 void ThreadedBackend<Backend>::setIdleStatus(bool isIdle) {
     if (!mIdleWaiter) {
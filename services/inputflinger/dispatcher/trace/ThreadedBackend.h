@@ -20,8 +20,8 @@
 #include "InputTracingPerfettoBackend.h"
 
 #include <android-base/thread_annotations.h>
+#include <atomic>
 #include <mutex>
-#include <variant>
 #include <vector>
 
 namespace android::inputdispatcher::trace::impl {
@@ -29,31 +29,77 @@ namespace android::inputdispatcher::trace::impl {
 /**
  * A wrapper around an InputTracingBackend implementation that writes to the inner tracing backend
  * from a single new thread that it creates. The new tracing thread is started when the
- * ThreadedBackend is created, and is stopped when it is destroyed. The ThreadedBackend is
- * thread-safe.
+ * ThreadedBackend is created, and is stopped when it is destroyed.
+ *
+ * The events are handed to the tracing thread through a fixed-size ring, so that tracing doesn't
+ * allocate on the calling thread once the ring is warmed up. The trace calls may be made from any
+ * thread, since an event that is released before its processing completes is traced from wherever
+ * it is released. They are serialized by a lock that only they take, so in practice it is
+ * uncontended: the tracing thread never takes it. Events that don't fit in the ring are dropped;
+ * their number is logged by the tracing thread and reported by dump().
  */
 template <typename Backend>
 class ThreadedBackend : public InputTracingBackendInterface {
 public:
+    // The number of slots in the ring. Must be a power of two.
+    static constexpr size_t RING_SIZE = 256;
+
     ThreadedBackend(Backend&& innerBackend);
     ~ThreadedBackend() override;
 
     void traceKeyEvent(const TracedKeyEvent&, const TracedEventMetadata&) override;
     void traceMotionEvent(const TracedMotionEvent&, const TracedEventMetadata&) override;
     void traceWindowDispatch(const WindowDispatchArgs&, const TracedEventMetadata&) override;
+    std::string dump(const char* prefix) const override;
 
     /** Returns a function that, when called, will block until the tracing thread is idle. */
     std::function<void()> getIdleWaiterForTesting();
 
+    /**
+     * Stops the tracing thread from taking events out of the ring, so that the ring fills up.
+     * Returns a function that resumes the tracing thread, which must be called before this
+     * threaded backend is destroyed.
+     */
+    std::function<void()> pauseForTesting();
+
 private:
+    // A slot of the ring. The slots are reused, so that copying an event into a slot only
+    // allocates until the vectors have grown to the size of the events that are traced.
+    struct Slot {
+        enum class Type { KEY, MOTION, KEY_DISPATCH, MOTION_DISPATCH };
+        Type type;
+        TracedKeyEvent keyEvent;
+        TracedMotionEvent motionEvent;
+        // For the dispatch types, the event being dispatched is in keyEvent or motionEvent, and
+        // the eventEntry of the args is unused.
+        WindowDispatchArgs dispatchArgs;
+        // The metadata, with the targets in a vector instead of a set so that they can be copied
+        // without allocating.
+        bool isSecure;
+        std::vector<gui::Uid> targets;
+        bool isImeConnectionActive;
+        nsecs_t processingTimestamp;
+    };
+
+    std::vector<Slot> mRing;
+    // Serializes the producers. Held from beginWrite until endWrite.
+    std::mutex mProducerLock;
+    // The free-running positions of the producers and of the consumer in the ring. The consumer
+    // only advances past a slot once it has been traced.
+    std::atomic<size_t> mWritePosition{0};
+    std::atomic<size_t> mReadPosition{0};
+    std::atomic<uint64_t> mDroppedEvents{0};
+    // Set while the tracing thread waits for events, so that the producer only takes the lock to
+    // wake it up when needed.
+    std::atomic<bool> mThreadWaiting{false};
+    // The number of dropped events that the tracing thread has logged.
+    uint64_t mReportedDroppedEvents{0};
+
     std::mutex mLock;
     bool mThreadExit GUARDED_BY(mLock){false};
+    bool mPausedForTesting GUARDED_BY(mLock){false};
     std::condition_variable mThreadWakeCondition;
     Backend mBackend;
-    using TraceEntry =
-            std::pair<std::variant<TracedKeyEvent, TracedMotionEvent, WindowDispatchArgs>,
-                      TracedEventMetadata>;
-    std::vector<TraceEntry> mQueue GUARDED_BY(mLock);
 
     struct IdleWaiter {
         std::mutex idleLock;
@@ -62,12 +108,17 @@ private:
     };
     // The lazy-initialized object used to wait for the tracing thread to idle.
     std::shared_ptr<IdleWaiter> mIdleWaiter GUARDED_BY(mLock);
+    std::atomic<bool> mHasIdleWaiter{false};
 
     // InputThread stops when its destructor is called. Initialize it last so that it is the
     // first thing to be destructed. This will guarantee the thread will not access other
     // members that have already been destructed.
     InputThread mTracerThread;
 
+    // Returns the slot to write the next event to, or nullptr if the ring is full.
+    Slot* beginWrite() REQUIRES(mProducerLock);
+    void endWrite() REQUIRES(mProducerLock);
+    void traceSlot(const Slot& slot);
     void threadLoop();
     void setIdleStatus(bool isIdle) REQUIRES(mLock);
 };
@@ -34,6 +34,7 @@
 #include <unistd.h>
 
 #include <android_companion_virtualdevice_flags.h>
+#include <com_android_input_flags.h>
 
 #define LOG_TAG "EventHub"
 
@@ -56,6 +57,7 @@
 #include <filesystem>
 #include <optional>
 #include <regex>
+#include <span>
 #include <utility>
 
 #include "EventHub.h"
@@ -70,6 +72,7 @@ using android::base::StringPrintf;
 
 namespace android {
 
+namespace input_flags = com::android::input::flags;
 namespace vd_flags = android::companion::virtualdevice::flags;
 
 using namespace ftl::flag_operators;
@@ -85,6 +88,15 @@ static constexpr int32_t FF_WEAK_MAGNITUDE_CHANNEL_IDX = 1;
 
 static constexpr size_t EVENT_BUFFER_SIZE = 256;
 
+// In bulk read mode, the number of events that the read buffer of a device holds. Touch devices
+// get a larger buffer, so that a burst of multi-touch frames can be read at once.
+static constexpr size_t BULK_READ_BUFFER_SIZE = 64;
+static constexpr size_t BULK_READ_BUFFER_SIZE_TOUCH = 1024;
+
+// In bulk read mode, the maximum number of consecutive reads from a device whose buffer keeps
+// getting filled, so that a single device can't delay the others indefinitely.
+static constexpr int MAX_BULK_READS_PER_DEVICE = 8;
+
 // Mapping for input battery class node IDs lookup.
 // https://www.kernel.org/doc/Documentation/power/power_supply_class.txt
 static const std::unordered_map<std::string, InputBatteryClass> BATTERY_CLASSES =
@@ -883,6 +895,7 @@ static void ensureProcessCanBlockSuspend() {
 // --- EventHub ---
 
 const int EventHub::EPOLL_MAX_EVENTS;
+const int EventHub::BULK_EPOLL_MAX_EVENTS;
 
 EventHub::EventHub(void)
       : mBuiltInKeyboardId(NO_BUILT_IN_KEYBOARD),
@@ -892,7 +905,8 @@ EventHub::EventHub(void)
         mNeedToScanDevices(true),
         mPendingEventCount(0),
         mPendingEventIndex(0),
-        mPendingINotify(false) {
+        mPendingINotify(false),
+        mBulkRead(input_flags::enable_evdev_bulk_read()) {
     ensureProcessCanBlockSuspend();
 
     mEpollFd = epoll_create1(EPOLL_CLOEXEC);
@@ -1976,44 +1990,68 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
             }
             // This must be an input event
             if (eventItem.events & EPOLLIN) {
-                int32_t readSize =
-                        read(device->fd, readBuffer.data(),
-                             sizeof(decltype(readBuffer)::value_type) * readBuffer.size());
-                if (readSize == 0 || (readSize < 0 && errno == ENODEV)) {
-                    // Device was removed before INotify noticed.
-                    ALOGW("could not get event, removed? (fd: %d size: %" PRId32
-                          " capacity: %zu errno: %d)\n",
-                          device->fd, readSize, readBuffer.size(), errno);
-                    deviceChanged = true;
-                    closeDeviceLocked(*device);
-                } else if (readSize < 0) {
-                    if (errno != EAGAIN && errno != EINTR) {
-                        ALOGW("could not get event (errno=%d)", errno);
-                    }
-                } else if ((readSize % sizeof(struct input_event)) != 0) {
-                    ALOGE("could not get event (wrong size: %d)", readSize);
-                } else {
-                    const int32_t deviceId = device->id == mBuiltInKeyboardId ? 0 : device->id;
-
-                    const size_t count = size_t(readSize) / sizeof(struct input_event);
-                    for (size_t i = 0; i < count; i++) {
-                        struct input_event& iev = readBuffer[i];
-                        device->trackInputEvent(iev);
-                        events.push_back({
-                                .when = processEventTimestamp(iev),
-                                .readTime = systemTime(SYSTEM_TIME_MONOTONIC),
-                                .deviceId = deviceId,
-                                .type = iev.type,
-                                .code = iev.code,
-                                .value = iev.value,
-                        });
+                std::span<input_event> buffer(readBuffer);
+                if (mBulkRead) {
+                    if (device->readBuffer.empty()) {
+                        device->readBuffer.resize(device->classes.test(InputDeviceClass::TOUCH)
+                                                          ? BULK_READ_BUFFER_SIZE_TOUCH
+                                                          : BULK_READ_BUFFER_SIZE);
                     }
-                    if (events.size() >= EVENT_BUFFER_SIZE) {
-                        // The result buffer is full.  Reset the pending event index
-                        // so we will try to read the device again on the next iteration.
-                        mPendingEventIndex -= 1;
-                        break;
+                    buffer = device->readBuffer;
+                }
+                // In bulk read mode, keep reading while the buffer gets filled, rather than
+                // waiting for epoll to report the device as ready again.
+                bool bufferFilled = false;
+                int reads = 0;
+                do {
+                    int32_t readSize =
+                            read(device->fd, buffer.data(), sizeof(input_event) * buffer.size());
+                    bufferFilled = false;
+                    reads++;
+                    if (readSize == 0 || (readSize < 0 && errno == ENODEV)) {
+                        // Device was removed before INotify noticed.
+                        ALOGW("could not get event, removed? (fd: %d size: %" PRId32
+                              " capacity: %zu errno: %d)\n",
+                              device->fd, readSize, buffer.size(), errno);
+                        deviceChanged = true;
+                        closeDeviceLocked(*device);
+                    } else if (readSize < 0) {
+                        if (errno != EAGAIN && errno != EINTR) {
+                            ALOGW("could not get event (errno=%d)", errno);
+                        }
+                    } else if ((readSize % sizeof(struct input_event)) != 0) {
+                        ALOGE("could not get event (wrong size: %d)", readSize);
+                    } else {
+                        const int32_t deviceId =
+                                device->id == mBuiltInKeyboardId ? 0 : device->id;
+                        // In bulk read mode, all the events of a read are given the same read
+                        // time, since they were read at the same time.
+                        const nsecs_t bulkReadTime =
+                                mBulkRead ? systemTime(SYSTEM_TIME_MONOTONIC) : 0;
+
+                        const size_t count = size_t(readSize) / sizeof(struct input_event);
+                        for (size_t i = 0; i < count; i++) {
+                            struct input_event& iev = buffer[i];
+                            device->trackInputEvent(iev);
+                            events.push_back({
+                                    .when = processEventTimestamp(iev),
+                                    .readTime = mBulkRead
+                                            ? bulkReadTime
+                                            : systemTime(SYSTEM_TIME_MONOTONIC),
+                                    .deviceId = deviceId,
+                                    .type = iev.type,
+                                    .code = iev.code,
+                                    .value = iev.value,
+                            });
+                        }
+                        bufferFilled = count == buffer.size();
                     }
+                } while (mBulkRead && bufferFilled && reads < MAX_BULK_READS_PER_DEVICE);
+                if (!mBulkRead && events.size() >= EVENT_BUFFER_SIZE) {
+                    // The result buffer is full.  Reset the pending event index
+                    // so we will try to read the device again on the next iteration.
+                    mPendingEventIndex -= 1;
+                    break;
                 }
             } else if (eventItem.events & EPOLLHUP) {
                 ALOGI("Removing device %s due to epoll hang-up event.",
@@ -2063,7 +2101,9 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
 
         mLock.unlock(); // release lock before poll
 
-        int pollResult = epoll_wait(mEpollFd, mPendingEventItems, EPOLL_MAX_EVENTS, timeoutMillis);
+        int pollResult = epoll_wait(mEpollFd, mPendingEventItems,
+                                    mBulkRead ? BULK_EPOLL_MAX_EVENTS : EPOLL_MAX_EVENTS,
+                                    timeoutMillis);
 
         mLock.lock(); // reacquire lock after poll
 
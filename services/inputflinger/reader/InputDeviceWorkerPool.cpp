@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "InputDeviceWorkerPool.h"
+
+#include <string>
+
+namespace android {
+
+// --- InputDeviceWorkerPool ---
+
+InputDeviceWorkerPool::InputDeviceWorkerPool(size_t workerCount) {
+    for (size_t i = 0; i < workerCount; i++) {
+        Worker& worker = *mWorkers.emplace_back(std::make_unique<Worker>());
+        worker.thread = std::make_unique<InputThread>(
+                "InputReaderWorker" + std::to_string(i), [this, &worker]() { threadLoop(worker); },
+                [&worker]() {
+                    std::scoped_lock lock(worker.lock);
+                    worker.exit = true;
+                    worker.wakeCondition.notify_all();
+                });
+    }
+}
+
+InputDeviceWorkerPool::~InputDeviceWorkerPool() {
+    // Stop the threads before the state that they use is destroyed.
+    mWorkers.clear();
+}
+
+void InputDeviceWorkerPool::post(int32_t deviceId, std::function<void()> task) {
+    { // acquire lock
+        std::scoped_lock lock(mLock);
+        mPendingTasks++;
+    } // release lock
+
+    Worker& worker = *mWorkers[static_cast<uint32_t>(deviceId) % mWorkers.size()];
+    std::scoped_lock lock(worker.lock);
+    worker.tasks.push_back(std::move(task));
+    worker.wakeCondition.notify_all();
+}
+
+void InputDeviceWorkerPool::waitForIdle() {
+    std::unique_lock lock(mLock);
+    base::ScopedLockAssertion assumeLocked(mLock);
+    mIdleCondition.wait(lock, [this]() REQUIRES(mLock) { return mPendingTasks == 0; });
+}
+
+void InputDeviceWorkerPool::threadLoop(Worker& worker) {
+    std::function<void()> task;
+    { // acquire lock
+        std::unique_lock lock(worker.lock);
+        base::ScopedLockAssertion assumeLocked(worker.lock);
+        worker.wakeCondition.wait(lock, [&worker]() REQUIRES(worker.lock) {
+            return worker.exit || !worker.tasks.empty();
+        });
+        if (worker.tasks.empty()) {
+            return;
+        }
+        task = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+    } // release lock
+
+    task();
+
+    std::scoped_lock lock(mLock);
+    if (--mPendingTasks == 0) {
+        mIdleCondition.notify_all();
+    }
+}
+
+} // namespace android
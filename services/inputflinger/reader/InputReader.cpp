@@ -92,18 +92,30 @@ std::optional<DeviceId> getDeviceIdOfNewGesture(const NotifyArgs& args) {
     return std::nullopt;
 }
 
+// Whether processing the device's events can change the global meta state, which the other devices
+// read while processing their events.
+bool updatesGlobalMetaState(const InputDevice& device) {
+    const ftl::Flags<InputDeviceClass> classes = device.getClasses();
+    return !device.isIgnored() &&
+            (classes.test(InputDeviceClass::KEYBOARD) || classes.test(InputDeviceClass::DPAD) ||
+             classes.test(InputDeviceClass::GAMEPAD));
+}
+
 } // namespace
 
 // --- InputReader ---
 
 InputReader::InputReader(std::shared_ptr<EventHubInterface> eventHub,
                          const sp<InputReaderPolicyInterface>& policy,
-                         InputListenerInterface& listener)
+                         InputListenerInterface& listener, size_t deviceWorkerCount)
       : mContext(this),
         mEventHub(eventHub),
         mPolicy(policy),
         mNextListener(listener),
         mKeyboardClassifier(std::make_unique<KeyboardClassifier>()),
+        mDeviceWorkers(deviceWorkerCount > 0
+                               ? std::make_unique<InputDeviceWorkerPool>(deviceWorkerCount)
+                               : nullptr),
         mGlobalMetaState(AMETA_NONE),
         mLedMetaState(AMETA_NONE),
         mGeneration(1),
@@ -227,6 +239,9 @@ void InputReader::loopOnce() {
 
 std::list<NotifyArgs> InputReader::processEventsLocked(const RawEvent* rawEvents, size_t count) {
     std::list<NotifyArgs> out;
+    // The batches of device events which may be processed in parallel. They are flushed before
+    // any device is added or removed.
+    std::vector<DeviceEventBatch> deviceBatches;
     for (const RawEvent* rawEvent = rawEvents; count;) {
         int32_t type = rawEvent->type;
         size_t batchSize = 1;
@@ -242,8 +257,14 @@ std::list<NotifyArgs> InputReader::processEventsLocked(const RawEvent* rawEvents
             if (debugRawEvents()) {
                 ALOGD("BatchSize: %zu Count: %zu", batchSize, count);
             }
-            out += processEventsForDeviceLocked(deviceId, rawEvent, batchSize);
+            if (mDeviceWorkers != nullptr) {
+                deviceBatches.push_back({deviceId, rawEvent, batchSize});
+            } else {
+                out += processEventsForDeviceLocked(deviceId, rawEvent, batchSize);
+            }
         } else {
+            out += processDeviceEventBatchesLocked(deviceBatches);
+            deviceBatches.clear();
             switch (rawEvent->type) {
                 case EventHubInterface::DEVICE_ADDED:
                     addDeviceLocked(rawEvent->when, rawEvent->deviceId);
@@ -259,9 +280,91 @@ std::list<NotifyArgs> InputReader::processEventsLocked(const RawEvent* rawEvents
         count -= batchSize;
         rawEvent += batchSize;
     }
+    out += processDeviceEventBatchesLocked(deviceBatches);
+    return out;
+}
+
+std::list<NotifyArgs> InputReader::processDeviceEventBatchesLocked(
+        const std::vector<DeviceEventBatch>& batches) {
+    if (batches.empty()) {
+        return {};
+    }
+
+    // Find the devices that can be processed on the workers, and the batches of each of them in
+    // order. Each of these devices gets a single task, so that its batches are processed in order.
+    std::vector<std::pair<std::shared_ptr<InputDevice>, std::vector<size_t>>> parallelDevices;
+    for (size_t i = 0; i < batches.size(); i++) {
+        auto deviceIt = mDevices.find(batches[i].eventHubId);
+        if (deviceIt == mDevices.end()) {
+            continue;
+        }
+        if (updatesGlobalMetaState(*deviceIt->second)) {
+            // The other devices would see the meta state at some arbitrary point of the keyboard's
+            // events, instead of the state as of their own events. Process the whole batch serially.
+            parallelDevices.clear();
+            break;
+        }
+        if (!canProcessInParallelLocked(*deviceIt->second)) {
+            continue;
+        }
+        auto it = std::find_if(parallelDevices.begin(), parallelDevices.end(),
+                               [&](const auto& pair) { return pair.first == deviceIt->second; });
+        if (it == parallelDevices.end()) {
+            parallelDevices.emplace_back(deviceIt->second, std::vector<size_t>{i});
+        } else {
+            it->second.push_back(i);
+        }
+    }
+
+    std::vector<std::list<NotifyArgs>> results(batches.size());
+    std::vector<bool> processed(batches.size(), false);
+    // There is nothing to gain when everything would be processed by the same thread.
+    if (parallelDevices.size() > 1 || (parallelDevices.size() == 1 &&
+                                       parallelDevices[0].second.size() < batches.size())) {
+        for (const auto& [device, indices] : parallelDevices) {
+            for (size_t i : indices) {
+                processed[i] = true;
+            }
+            mDeviceWorkers->post(device->getId(), [&batches, &results, device, &indices]() {
+                for (size_t i : indices) {
+                    results[i] = device->process(batches[i].rawEvents, batches[i].count);
+                }
+            });
+        }
+    }
+
+    // Meanwhile, process the remaining devices on this thread.
+    for (size_t i = 0; i < batches.size(); i++) {
+        if (!processed[i]) {
+            results[i] = processEventsForDeviceLocked(batches[i].eventHubId, batches[i].rawEvents,
+                                                      batches[i].count);
+        }
+    }
+    mDeviceWorkers->waitForIdle();
+
+    // Merge the results in the order of the raw events, as if they had been processed serially.
+    std::list<NotifyArgs> out;
+    for (std::list<NotifyArgs>& result : results) {
+        out.splice(out.end(), result);
+    }
     return out;
 }
 
+bool InputReader::canProcessInParallelLocked(InputDevice& device) const {
+    if (device.isIgnored()) {
+        return false;
+    }
+    // Keyboards update the global meta state and the LEDs of all the keyboards, and an external
+    // stylus updates the state of the touch devices, so they have to be processed serially.
+    if (updatesGlobalMetaState(device) ||
+        device.getClasses().test(InputDeviceClass::EXTERNAL_STYLUS)) {
+        return false;
+    }
+    return std::none_of(mDevices.begin(), mDevices.end(), [](const auto& devicePair) {
+        return devicePair.second->getClasses().test(InputDeviceClass::EXTERNAL_STYLUS);
+    });
+}
+
 void InputReader::addDeviceLocked(nsecs_t when, int32_t eventHubId) {
     if (mDevices.find(eventHubId) != mDevices.end()) {
         ALOGW("Ignoring spurious device added event for eventHubId %d.", eventHubId);
@@ -929,6 +1032,8 @@ void InputReader::dump(std::string& dump) {
     }
 
     dump += StringPrintf(INDENT "NextTimeout: %" PRId64 "\n", mNextTimeout);
+    dump += StringPrintf(INDENT "DeviceWorkers: %zu\n",
+                         mDeviceWorkers != nullptr ? mDeviceWorkers->getWorkerCount() : 0);
     dump += INDENT "Configuration:\n";
     dump += INDENT2 "ExcludedDeviceNames: [";
     for (size_t i = 0; i < mConfig.excludedDeviceNames.size(); i++) {
@@ -1000,60 +1105,72 @@ InputReader::ContextImpl::ContextImpl(InputReader* reader)
 
 void InputReader::ContextImpl::updateGlobalMetaState() {
     // lock is already held by the input loop
+    std::scoped_lock _l(mReader->mContextLock);
     mReader->updateGlobalMetaStateLocked();
 }
 
 int32_t InputReader::ContextImpl::getGlobalMetaState() {
     // lock is already held by the input loop
+    std::scoped_lock _l(mReader->mContextLock);
     return mReader->getGlobalMetaStateLocked();
 }
 
 void InputReader::ContextImpl::updateLedMetaState(int32_t metaState) {
     // lock is already held by the input loop
+    std::scoped_lock _l(mReader->mContextLock);
     mReader->updateLedMetaStateLocked(metaState);
 }
 
 int32_t InputReader::ContextImpl::getLedMetaState() {
     // lock is already held by the input loop
+    std::scoped_lock _l(mReader->mContextLock);
     return mReader->getLedMetaStateLocked();
 }
 
 void InputReader::ContextImpl::setPreventingTouchpadTaps(bool prevent) {
     // lock is already held by the input loop
+    std::scoped_lock _l(mReader->mContextLock);
     mReader->mPreventingTouchpadTaps = prevent;
 }
 
 bool InputReader::ContextImpl::isPreventingTouchpadTaps() {
     // lock is already held by the input loop
+    std::scoped_lock _l(mReader->mContextLock);
     return mReader->mPreventingTouchpadTaps;
 }
 
 void InputReader::ContextImpl::setLastKeyDownTimestamp(nsecs_t when) {
+    std::scoped_lock _l(mReader->mContextLock);
     mReader->mLastKeyDownTimestamp = when;
 }
 
 nsecs_t InputReader::ContextImpl::getLastKeyDownTimestamp() {
+    std::scoped_lock _l(mReader->mContextLock);
     return mReader->mLastKeyDownTimestamp;
 }
 
 void InputReader::ContextImpl::disableVirtualKeysUntil(nsecs_t time) {
     // lock is already held by the input loop
+    std::scoped_lock _l(mReader->mContextLock);
     mReader->disableVirtualKeysUntilLocked(time);
 }
 
 bool InputReader::ContextImpl::shouldDropVirtualKey(nsecs_t now, int32_t keyCode,
                                                     int32_t scanCode) {
     // lock is already held by the input loop
+    std::scoped_lock _l(mReader->mContextLock);
     return mReader->shouldDropVirtualKeyLocked(now, keyCode, scanCode);
 }
 
 void InputReader::ContextImpl::requestTimeoutAtTime(nsecs_t when) {
     // lock is already held by the input loop
+    std::scoped_lock _l(mReader->mContextLock);
     mReader->requestTimeoutAtTimeLocked(when);
 }
 
 int32_t InputReader::ContextImpl::bumpGeneration() {
     // lock is already held by the input loop
+    std::scoped_lock _l(mReader->mContextLock);
     return mReader->bumpGenerationLocked();
 }
 
@@ -16,13 +16,28 @@
 
 #include "InputReaderFactory.h"
 
+#include <com_android_input_flags.h>
+
 #include "InputReader.h"
 
+namespace input_flags = com::android::input::flags;
+
 namespace android {
 
+namespace {
+
+// The number of threads on which the events of different devices are processed in parallel, when
+// enabled. Otherwise, all the events are processed on the reader thread.
+constexpr size_t DEVICE_WORKER_COUNT = 2;
+
+} // namespace
+
 std::unique_ptr<InputReaderInterface> createInputReader(
         const sp<InputReaderPolicyInterface>& policy, InputListenerInterface& listener) {
-    return std::make_unique<InputReader>(std::make_unique<EventHub>(), policy, listener);
+    return std::make_unique<InputReader>(std::make_unique<EventHub>(), policy, listener,
+                                         input_flags::enable_parallel_input_device_processing()
+                                                 ? DEVICE_WORKER_COUNT
+                                                 : 0);
 }
 
 } // namespace android
\ No newline at end of file
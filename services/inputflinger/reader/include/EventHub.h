@@ -691,6 +691,9 @@ private:
 
         bool currentFrameDropped;
         void trackInputEvent(const struct input_event& event);
+
+        // The buffer that the events are read into in bulk read mode, allocated on first use.
+        std::vector<input_event> readBuffer;
         void readDeviceState();
     };
 
@@ -800,12 +803,20 @@ private:
 
     // Maximum number of signalled FDs to handle at a time.
     static const int EPOLL_MAX_EVENTS = 16;
+    // Maximum number of signalled FDs to handle at a time in bulk read mode.
+    static const int BULK_EPOLL_MAX_EVENTS = 64;
 
     // The array of pending epoll events and the index of the next event to be handled.
-    struct epoll_event mPendingEventItems[EPOLL_MAX_EVENTS];
+    struct epoll_event mPendingEventItems[BULK_EPOLL_MAX_EVENTS];
     size_t mPendingEventCount;
     size_t mPendingEventIndex;
     bool mPendingINotify;
+
+    // Whether getEvents drains every ready device into a buffer preallocated for that device, and
+    // returns all the events that were read in one pass instead of at most EVENT_BUFFER_SIZE of
+    // them. This reduces the number of epoll_wait and read calls when many devices are streaming
+    // events at once.
+    const bool mBulkRead;
 };
 
 } // namespace android
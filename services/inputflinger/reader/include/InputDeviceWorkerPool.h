@@ -0,0 +1,71 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "InputThread.h"
+
+namespace android {
+
+/**
+ * A pool of threads on which the InputReader processes the events of different input devices in
+ * parallel.
+ *
+ * Every device is assigned to a single worker, so the tasks posted for a device run in the order
+ * in which they were posted. The reader thread posts the tasks for a batch of raw events, and then
+ * waits for all of them to complete before it notifies the listener.
+ */
+class InputDeviceWorkerPool {
+public:
+    explicit InputDeviceWorkerPool(size_t workerCount);
+    ~InputDeviceWorkerPool();
+
+    size_t getWorkerCount() const { return mWorkers.size(); }
+
+    /** Runs the task on the worker that the device is assigned to. */
+    void post(int32_t deviceId, std::function<void()> task);
+
+    /** Blocks until all the posted tasks have completed. */
+    void waitForIdle();
+
+private:
+    struct Worker {
+        std::mutex lock;
+        std::condition_variable wakeCondition;
+        std::deque<std::function<void()>> tasks GUARDED_BY(lock);
+        bool exit GUARDED_BY(lock){false};
+        // Initialized last, so that it is the first thing to be destructed.
+        std::unique_ptr<InputThread> thread;
+    };
+
+    std::mutex mLock;
+    std::condition_variable mIdleCondition;
+    size_t mPendingTasks GUARDED_BY(mLock){0};
+
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+
+    void threadLoop(Worker& worker);
+};
+
+} // namespace android
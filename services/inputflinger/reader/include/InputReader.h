@@ -21,10 +21,12 @@
 #include <utils/Mutex.h>
 
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
 #include "EventHub.h"
+#include "InputDeviceWorkerPool.h"
 #include "InputListener.h"
 #include "InputReaderBase.h"
 #include "InputReaderContext.h"
@@ -46,11 +48,16 @@ struct StylusState;
  * uses a single Mutex to guard its state.  The Mutex may be held while calling into the
  * EventHub or the InputReaderPolicy but it is never held while calling into the
  * InputListener. All calls to InputListener must happen from InputReader's thread.
+ *
+ * Optionally, the raw events of different devices can be processed in parallel on a pool of
+ * device workers, while the reader thread waits with the Mutex held. The resulting events are
+ * then sent to the InputListener in the same order as if they had been processed serially.
  */
 class InputReader : public InputReaderInterface {
 public:
     InputReader(std::shared_ptr<EventHubInterface> eventHub,
-                const sp<InputReaderPolicyInterface>& policy, InputListenerInterface& listener);
+                const sp<InputReaderPolicyInterface>& policy, InputListenerInterface& listener,
+                size_t deviceWorkerCount = 0);
     virtual ~InputReader();
 
     void dump(std::string& dump) override;
@@ -166,6 +173,11 @@ protected:
     // Test cases need to override the locked functions
     mutable std::mutex mLock;
 
+    // Serializes the accesses to the reader state made through the context, which may come from
+    // several device workers at once. It is recursive because some context calls reach back into
+    // the context through the devices, e.g. updateLedMetaState calls getLedMetaState.
+    std::recursive_mutex mContextLock;
+
 private:
     std::unique_ptr<InputThread> mThread;
 
@@ -210,6 +222,17 @@ private:
     // The input device that produced a new gesture most recently.
     DeviceId mLastUsedDeviceId GUARDED_BY(mLock){ReservedInputDeviceId::INVALID_INPUT_DEVICE_ID};
 
+    // The workers on which the events of different devices are processed in parallel, or null
+    // if all the events are processed on the reader thread.
+    std::unique_ptr<InputDeviceWorkerPool> mDeviceWorkers;
+
+    // A run of raw events from a single EventHub device.
+    struct DeviceEventBatch {
+        int32_t eventHubId;
+        const RawEvent* rawEvents;
+        size_t count;
+    };
+
     // low-level input event decoding and device management
     [[nodiscard]] std::list<NotifyArgs> processEventsLocked(const RawEvent* rawEvents, size_t count)
             REQUIRES(mLock);
@@ -219,6 +242,9 @@ private:
     [[nodiscard]] std::list<NotifyArgs> processEventsForDeviceLocked(int32_t eventHubId,
                                                                      const RawEvent* rawEvents,
                                                                      size_t count) REQUIRES(mLock);
+    [[nodiscard]] std::list<NotifyArgs> processDeviceEventBatchesLocked(
+            const std::vector<DeviceEventBatch>& batches) REQUIRES(mLock);
+    bool canProcessInParallelLocked(InputDevice& device) const REQUIRES(mLock);
     [[nodiscard]] std::list<NotifyArgs> timeoutExpiredLocked(nsecs_t when) REQUIRES(mLock);
 
     int32_t mGlobalMetaState GUARDED_BY(mLock);
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+
+#include "../Entry.h"
+#include "../EntryPool.h"
+
+// atest inputflinger_tests:EntryPoolTest
+
+namespace android::inputdispatcher {
+
+TEST(EntryPoolTest, ReusesFreedBlocks) {
+    EntryPool& pool = EntryPool::getInstance();
+    void* block = pool.allocate(100);
+    ASSERT_NE(nullptr, block);
+    pool.deallocate(block, 100);
+    // Blocks of the same size class are interchangeable.
+    void* reused = pool.allocate(110);
+    EXPECT_EQ(block, reused);
+    pool.deallocate(reused, 110);
+}
+
+TEST(EntryPoolTest, ReusesBlocksFreedOnAnotherThread) {
+    EntryPool& pool = EntryPool::getInstance();
+    constexpr size_t kBlockCount = 200;
+    std::set<void*> blocks;
+    for (size_t i = 0; i < kBlockCount; i++) {
+        blocks.insert(pool.allocate(64));
+    }
+    // Entries are usually released on a different thread than the one that created them. Once
+    // that thread exits, everything it cached goes back to the shared pool.
+    std::thread([&]() {
+        for (void* block : blocks) {
+            pool.deallocate(block, 64);
+        }
+    }).join();
+
+    std::vector<void*> reallocated;
+    size_t reused = 0;
+    for (size_t i = 0; i < kBlockCount; i++) {
+        reallocated.push_back(pool.allocate(64));
+        reused += blocks.count(reallocated.back());
+    }
+    // Only the blocks that were already cached by this thread aren't from the other thread.
+    EXPECT_GE(reused, kBlockCount / 2);
+    for (void* block : reallocated) {
+        pool.deallocate(block, 64);
+    }
+}
+
+TEST(EntryPoolTest, LargeAllocationsUseTheHeap) {
+    EntryPool& pool = EntryPool::getInstance();
+    void* block = pool.allocate(4096);
+    ASSERT_NE(nullptr, block);
+    pool.deallocate(block, 4096);
+}
+
+TEST(EntryPoolTest, RecyclesPointerArrays) {
+    EntryPool& pool = EntryPool::getInstance();
+    std::vector<PointerProperties> pointerProperties(2);
+    std::vector<PointerCoords> pointerCoords(2);
+    pool.recyclePointerArrays(std::move(pointerProperties), std::move(pointerCoords));
+
+    std::vector<PointerProperties> recycledProperties;
+    std::vector<PointerCoords> recycledCoords;
+    pool.acquirePointerArrays(recycledProperties, recycledCoords);
+    EXPECT_TRUE(recycledProperties.empty());
+    EXPECT_TRUE(recycledCoords.empty());
+    EXPECT_GT(recycledProperties.capacity(), 0u);
+    EXPECT_GT(recycledCoords.capacity(), 0u);
+}
+
+TEST(EntryPoolTest, EntriesAreAllocatedFromThePool) {
+    auto entry = std::make_unique<DeviceResetEntry>(/*id=*/1, /*eventTime=*/0, /*deviceId=*/2);
+    void* block = entry.get();
+    entry.reset();
+
+    void* reused = EntryPool::getInstance().allocate(sizeof(DeviceResetEntry));
+    EXPECT_EQ(block, reused);
+    EntryPool::getInstance().deallocate(reused, sizeof(DeviceResetEntry));
+}
+
+} // namespace android::inputdispatcher
@@ -18,6 +18,7 @@
 
 #include "UinputDevice.h"
 
+#include <com_android_input_flags.h>
 #include <gtest/gtest.h>
 #include <inttypes.h>
 #include <linux/uinput.h>
@@ -32,10 +33,14 @@ using android::EventHubInterface;
 using android::InputDeviceIdentifier;
 using android::RawEvent;
 using android::sp;
+using android::UinputDevice;
 using android::UinputHomeKey;
+using android::UinputHomeKeyWithLargeBuffer;
 using std::chrono_literals::operator""ms;
 using std::chrono_literals::operator""s;
 
+namespace input_flags = com::android::input::flags;
+
 static constexpr bool DEBUG = false;
 
 static void dumpEvents(const std::vector<RawEvent>& events) {
@@ -85,7 +90,8 @@ protected:
     /**
      * Return the device id of the created device.
      */
-    int32_t waitForDeviceCreation();
+    int32_t waitForDeviceCreation() { return waitForDeviceCreation(*mKeyboard); }
+    int32_t waitForDeviceCreation(const UinputDevice& device);
     void waitForDeviceClose(int32_t deviceId);
     void consumeInitialDeviceAddedEvents();
     void assertNoMoreEvents();
@@ -144,7 +150,7 @@ void EventHubTest::consumeInitialDeviceAddedEvents() {
     EXPECT_EQ(existingDevices.size(), events.size() - 1);
 }
 
-int32_t EventHubTest::waitForDeviceCreation() {
+int32_t EventHubTest::waitForDeviceCreation(const UinputDevice& device) {
     // Wait a little longer than usual, to ensure input device has time to be created
     std::vector<RawEvent> events = getEvents(2);
     if (events.size() != 1) {
@@ -155,7 +161,7 @@ int32_t EventHubTest::waitForDeviceCreation() {
     EXPECT_EQ(static_cast<int32_t>(EventHubInterface::DEVICE_ADDED), deviceAddedEvent.type);
     InputDeviceIdentifier identifier = mEventHub->getDeviceIdentifier(deviceAddedEvent.deviceId);
     const int32_t deviceId = deviceAddedEvent.deviceId;
-    EXPECT_EQ(identifier.name, mKeyboard->getName());
+    EXPECT_EQ(identifier.name, device.getName());
     return deviceId;
 }
 
@@ -207,6 +213,101 @@ TEST_F(EventHubTest, InputEvent_TimestampIsMonotonic) {
     }
 }
 
+// --- EventHubBulkReadTest ---
+
+// These must match the limits in EventHub.cpp.
+static constexpr size_t BULK_READ_BUFFER_SIZE = 64;
+static constexpr size_t MAX_BULK_READS_PER_DEVICE = 8;
+
+class EventHubBulkReadTest : public EventHubTest {
+protected:
+    // A device for which more events can be queued than EventHub reads at once.
+    std::unique_ptr<UinputHomeKeyWithLargeBuffer> mBulkKeyboard;
+    int32_t mBulkDeviceId;
+
+    virtual void SetUp() override {
+        mInitialBulkRead = input_flags::enable_evdev_bulk_read();
+        // EventHub reads the flag when it is created.
+        input_flags::enable_evdev_bulk_read(true);
+        EventHubTest::SetUp();
+        if (IsSkipped()) {
+            return;
+        }
+        mBulkKeyboard = createUinputDevice<UinputHomeKeyWithLargeBuffer>();
+        ASSERT_NO_FATAL_FAILURE(mBulkDeviceId = waitForDeviceCreation(*mBulkKeyboard));
+    }
+    virtual void TearDown() override {
+        if (mBulkKeyboard) {
+            mBulkKeyboard.reset();
+            waitForDeviceClose(mBulkDeviceId);
+        }
+        EventHubTest::TearDown();
+        input_flags::enable_evdev_bulk_read(mInitialBulkRead);
+    }
+
+    /**
+     * Check that the events came from the bulk device, with reads of BULK_READ_BUFFER_SIZE events
+     * each: all the events of a read share a read time, and the reads are in order.
+     */
+    void assertReadInBulk(const std::vector<RawEvent>& events);
+
+private:
+    bool mInitialBulkRead;
+};
+
+void EventHubBulkReadTest::assertReadInBulk(const std::vector<RawEvent>& events) {
+    for (size_t i = 0; i < events.size(); i++) {
+        const RawEvent& event = events[i];
+        ASSERT_EQ(mBulkDeviceId, event.deviceId) << "Event " << i;
+        ASSERT_LE(event.when, event.readTime) << "Event " << i << " was read before it occurred";
+        const RawEvent& firstEventOfRead = events[i - i % BULK_READ_BUFFER_SIZE];
+        ASSERT_EQ(firstEventOfRead.readTime, event.readTime)
+                << "Event " << i << " must have the read time of the other events of its read";
+        if (i > 0) {
+            ASSERT_LE(events[i - 1].readTime, event.readTime) << "Event " << i;
+        }
+    }
+}
+
+/**
+ * When more events are queued than fit in the read buffer of a device, they are all returned by a
+ * single call to getEvents, which reads from the device several times.
+ */
+TEST_F(EventHubBulkReadTest, BulkRead_DrainsDeviceWithSeveralReads) {
+    // 200 events: more than a read returns, but fewer than the reads from a device return.
+    constexpr size_t keyPresses = 50;
+    for (size_t i = 0; i < keyPresses; i++) {
+        ASSERT_NO_FATAL_FAILURE(mBulkKeyboard->pressAndReleaseHomeKey());
+    }
+
+    std::vector<RawEvent> events = mEventHub->getEvents(std::chrono::milliseconds(2s).count());
+    ASSERT_EQ(4 * keyPresses, events.size()) << "Expected all events in a single getEvents call";
+    ASSERT_NO_FATAL_FAILURE(assertReadInBulk(events));
+}
+
+/**
+ * A single call to getEvents reads at most MAX_BULK_READS_PER_DEVICE times from a device, and the
+ * next call returns the rest of its events.
+ */
+TEST_F(EventHubBulkReadTest, BulkRead_LimitsReadsPerDevice) {
+    // 800 events: more than the reads from a device return.
+    constexpr size_t keyPresses = 200;
+    for (size_t i = 0; i < keyPresses; i++) {
+        ASSERT_NO_FATAL_FAILURE(mBulkKeyboard->pressAndReleaseHomeKey());
+    }
+
+    std::vector<RawEvent> events = mEventHub->getEvents(std::chrono::milliseconds(2s).count());
+    ASSERT_EQ(MAX_BULK_READS_PER_DEVICE * BULK_READ_BUFFER_SIZE, events.size());
+    ASSERT_NO_FATAL_FAILURE(assertReadInBulk(events));
+
+    std::vector<RawEvent> remainingEvents =
+            mEventHub->getEvents(std::chrono::milliseconds(2s).count());
+    ASSERT_EQ(4 * keyPresses - events.size(), remainingEvents.size());
+    ASSERT_NO_FATAL_FAILURE(assertReadInBulk(remainingEvents));
+    ASSERT_LE(events.back().readTime, remainingEvents.front().readTime);
+    ASSERT_LE(events.back().when, remainingEvents.front().when);
+}
+
 // --- BitArrayTest ---
 class BitArrayTest : public testing::Test {
 protected:
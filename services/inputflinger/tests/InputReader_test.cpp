@@ -171,6 +171,7 @@ class FakeInputMapper : public InputMapper {
     bool mResetWasCalled GUARDED_BY(mLock);
     bool mProcessWasCalled GUARDED_BY(mLock);
     RawEvent mLastEvent GUARDED_BY(mLock);
+    std::thread::id mLastProcessThreadId GUARDED_BY(mLock);
 
     std::optional<DisplayViewport> mViewport;
 public:
@@ -254,6 +255,11 @@ public:
         ASSERT_FALSE(mProcessWasCalled) << "Expected process to not have been called.";
     }
 
+    std::thread::id getLastProcessThreadId() {
+        std::scoped_lock lock(mLock);
+        return mLastProcessThreadId;
+    }
+
     void setKeyCodeState(int32_t keyCode, int32_t state) {
         mKeyCodeStates.replaceValueFor(keyCode, state);
     }
@@ -310,6 +316,7 @@ private:
     std::list<NotifyArgs> process(const RawEvent& rawEvent) override {
         std::scoped_lock<std::mutex> lock(mLock);
         mLastEvent = rawEvent;
+        mLastProcessThreadId = std::this_thread::get_id();
         mProcessWasCalled = true;
         mStateChangedCondition.notify_all();
         return mProcessResult;
@@ -1392,6 +1399,93 @@ TEST_F(InputReaderTest, LightGetColor) {
     ASSERT_EQ(mReader->getLightColor(deviceId, /*lightId=*/1), LIGHT_BRIGHTNESS);
 }
 
+// --- InputReaderDeviceWorkersTest ---
+
+class InputReaderDeviceWorkersTest : public InputReaderTest {
+protected:
+    void SetUp() override {
+        InputReaderTest::SetUp();
+        mReader = std::make_unique<InstrumentedInputReader>(mFakeEventHub, mFakePolicy,
+                                                            *mFakeListener,
+                                                            /*deviceWorkerCount=*/2);
+    }
+};
+
+/**
+ * The events of the devices processed on the workers and on the reader thread should reach the
+ * listener in the order of the raw events.
+ */
+TEST_F(InputReaderDeviceWorkersTest, LoopOnce_PreservesEventOrderAcrossDevices) {
+    constexpr int32_t KEYBOARD_ID = END_RESERVED_ID + 1000;
+    constexpr int32_t FIRST_TOUCH_ID = KEYBOARD_ID + 1;
+    constexpr int32_t SECOND_TOUCH_ID = KEYBOARD_ID + 2;
+    FakeInputMapper& keyboardMapper =
+            addDeviceWithFakeInputMapper(KEYBOARD_ID, KEYBOARD_ID, "keyboard",
+                                         InputDeviceClass::KEYBOARD, AINPUT_SOURCE_KEYBOARD,
+                                         /*configuration=*/nullptr);
+    FakeInputMapper& firstTouchMapper =
+            addDeviceWithFakeInputMapper(FIRST_TOUCH_ID, FIRST_TOUCH_ID, "first",
+                                         InputDeviceClass::TOUCH_MT, AINPUT_SOURCE_TOUCHSCREEN,
+                                         /*configuration=*/nullptr);
+    FakeInputMapper& secondTouchMapper =
+            addDeviceWithFakeInputMapper(SECOND_TOUCH_ID, SECOND_TOUCH_ID, "second",
+                                         InputDeviceClass::TOUCH_MT, AINPUT_SOURCE_TOUCHSCREEN,
+                                         /*configuration=*/nullptr);
+    keyboardMapper.setProcessResult({KeyArgsBuilder(AKEY_EVENT_ACTION_DOWN, AINPUT_SOURCE_KEYBOARD)
+                                             .deviceId(KEYBOARD_ID)
+                                             .build()});
+    for (auto [mapper, deviceId] : {std::make_pair(&firstTouchMapper, FIRST_TOUCH_ID),
+                                    std::make_pair(&secondTouchMapper, SECOND_TOUCH_ID)}) {
+        mapper->setProcessResult(
+                {MotionArgsBuilder(AMOTION_EVENT_ACTION_MOVE, AINPUT_SOURCE_TOUCHSCREEN)
+                         .deviceId(deviceId)
+                         .pointer(PointerBuilder(/*id=*/0, ToolType::FINGER))
+                         .build()});
+    }
+
+    for (int32_t deviceId :
+         {FIRST_TOUCH_ID, KEYBOARD_ID, SECOND_TOUCH_ID, FIRST_TOUCH_ID, SECOND_TOUCH_ID}) {
+        mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, deviceId, 0, 0, 0);
+    }
+    mReader->loopOnce();
+
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifyKeyWasCalled(WithDeviceId(KEYBOARD_ID)));
+    for (int32_t deviceId : {FIRST_TOUCH_ID, SECOND_TOUCH_ID, FIRST_TOUCH_ID, SECOND_TOUCH_ID}) {
+        ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifyMotionWasCalled(WithDeviceId(deviceId)));
+    }
+    ASSERT_NO_FATAL_FAILURE(mFakeListener->assertNotifyMotionWasNotCalled());
+}
+
+/**
+ * A mouse reads the meta state which a keyboard updates, so when both have events in the same
+ * batch, the mouse must not be processed concurrently with the keyboard.
+ */
+TEST_F(InputReaderDeviceWorkersTest, LoopOnce_KeyboardAndMouseInSameBatchAreProcessedSerially) {
+    constexpr int32_t KEYBOARD_ID = END_RESERVED_ID + 1000;
+    constexpr int32_t MOUSE_ID = KEYBOARD_ID + 1;
+    constexpr int32_t TOUCH_ID = KEYBOARD_ID + 2;
+    FakeInputMapper& keyboardMapper =
+            addDeviceWithFakeInputMapper(KEYBOARD_ID, KEYBOARD_ID, "keyboard",
+                                         InputDeviceClass::KEYBOARD, AINPUT_SOURCE_KEYBOARD,
+                                         /*configuration=*/nullptr);
+    FakeInputMapper& mouseMapper =
+            addDeviceWithFakeInputMapper(MOUSE_ID, MOUSE_ID, "mouse", InputDeviceClass::CURSOR,
+                                         AINPUT_SOURCE_MOUSE, /*configuration=*/nullptr);
+    FakeInputMapper& touchMapper =
+            addDeviceWithFakeInputMapper(TOUCH_ID, TOUCH_ID, "touch", InputDeviceClass::TOUCH_MT,
+                                         AINPUT_SOURCE_TOUCHSCREEN, /*configuration=*/nullptr);
+
+    for (int32_t deviceId : {MOUSE_ID, KEYBOARD_ID, TOUCH_ID, MOUSE_ID}) {
+        mFakeEventHub->enqueueEvent(ARBITRARY_TIME, ARBITRARY_TIME, deviceId, 0, 0, 0);
+    }
+    mReader->loopOnce();
+
+    for (FakeInputMapper* mapper : {&keyboardMapper, &mouseMapper, &touchMapper}) {
+        ASSERT_NO_FATAL_FAILURE(mapper->assertProcessWasCalled());
+        EXPECT_EQ(std::this_thread::get_id(), mapper->getLastProcessThreadId());
+    }
+}
+
 // --- InputReaderIntegrationTest ---
 
 // These tests create and interact with the InputReader only through its interface.
@@ -27,6 +27,7 @@
 #include <NotifyArgsBuilders.h>
 #include <android-base/logging.h>
 #include <android/content/pm/IPackageManagerNative.h>
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <input/Input.h>
 #include <perfetto/trace/android/android_input_event.pbzero.h>
@@ -748,4 +749,46 @@ TEST_F(InputTracingTest, DISABLED_SimultaneousTracingSessions) {
     s1.reset();
 }
 
+// --- ThreadedBackendTest ---
+
+class ThreadedBackendTest : public testing::Test {
+protected:
+    using Backend = impl::ThreadedBackend<impl::PerfettoBackend>;
+
+    std::unique_ptr<Backend> mBackend;
+    std::function<void()> mWaitForIdle;
+
+    void SetUp() override {
+        impl::PerfettoBackend::sUseInProcessBackendForTest = true;
+        impl::PerfettoBackend::sPackageManagerProvider = []() { return kPackageManager; };
+        mBackend = std::make_unique<Backend>(impl::PerfettoBackend());
+        mWaitForIdle = mBackend->getIdleWaiterForTesting();
+    }
+
+    void traceKeyEvents(size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            mBackend->traceKeyEvent(TracedKeyEvent{}, TracedEventMetadata{});
+        }
+    }
+};
+
+TEST_F(ThreadedBackendTest, DropsAndCountsEventsThatDontFitInTheRing) {
+    std::function<void()> resume = mBackend->pauseForTesting();
+    traceKeyEvents(Backend::RING_SIZE + 3);
+    std::string dump = mBackend->dump("");
+    EXPECT_THAT(dump, testing::HasSubstr("PendingEvents: 256 / 256\n"));
+    EXPECT_THAT(dump, testing::HasSubstr("DroppedEvents: 3\n"));
+
+    resume();
+    mWaitForIdle();
+    dump = mBackend->dump("");
+    EXPECT_THAT(dump, testing::HasSubstr("PendingEvents: 0 / 256\n"));
+    EXPECT_THAT(dump, testing::HasSubstr("DroppedEvents: 3\n"));
+
+    // Once the tracing thread has emptied the ring, it fits as many events as it has slots again.
+    traceKeyEvents(Backend::RING_SIZE);
+    mWaitForIdle();
+    EXPECT_THAT(mBackend->dump(""), testing::HasSubstr("DroppedEvents: 3\n"));
+}
+
 } // namespace android::inputdispatcher::trace
@@ -20,8 +20,9 @@ namespace android {
 
 InstrumentedInputReader::InstrumentedInputReader(std::shared_ptr<EventHubInterface> eventHub,
                                                  const sp<InputReaderPolicyInterface>& policy,
-                                                 InputListenerInterface& listener)
-      : InputReader(eventHub, policy, listener), mFakeContext(this) {}
+                                                 InputListenerInterface& listener,
+                                                 size_t deviceWorkerCount)
+      : InputReader(eventHub, policy, listener, deviceWorkerCount), mFakeContext(this) {}
 
 void InstrumentedInputReader::pushNextDevice(std::shared_ptr<InputDevice> device) {
     mNextDevices.push(device);
@@ -31,7 +31,7 @@ class InstrumentedInputReader : public InputReader {
 public:
     InstrumentedInputReader(std::shared_ptr<EventHubInterface> eventHub,
                             const sp<InputReaderPolicyInterface>& policy,
-                            InputListenerInterface& listener);
+                            InputListenerInterface& listener, size_t deviceWorkerCount = 0);
     virtual ~InstrumentedInputReader() {}
 
     void pushNextDevice(std::shared_ptr<InputDevice> device);
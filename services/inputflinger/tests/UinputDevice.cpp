@@ -169,6 +169,29 @@ void UinputKeyboardWithHidUsage::configureDevice(int fd, uinput_user_dev* device
     ioctl(fd, UI_SET_MSCBIT, MSC_SCAN);
 }
 
+// --- UinputHomeKeyWithLargeBuffer ---
+
+UinputHomeKeyWithLargeBuffer::UinputHomeKeyWithLargeBuffer()
+      : UinputKeyboard(DEVICE_NAME, PRODUCT_ID, {KEY_HOME}) {}
+
+void UinputHomeKeyWithLargeBuffer::configureDevice(int fd, uinput_user_dev* device) {
+    UinputKeyboard::configureDevice(fd, device);
+
+    // The kernel queues 8 packets of the largest possible size, which grows with the number of
+    // slots for each multi-touch axis.
+    ioctl(fd, UI_SET_EVBIT, EV_ABS);
+    ioctl(fd, UI_SET_ABSBIT, ABS_MT_SLOT);
+    ioctl(fd, UI_SET_ABSBIT, ABS_MT_PRESSURE);
+    device->absmin[ABS_MT_SLOT] = 0;
+    device->absmax[ABS_MT_SLOT] = RAW_SLOT_MAX;
+    device->absmin[ABS_MT_PRESSURE] = 0;
+    device->absmax[ABS_MT_PRESSURE] = 255;
+}
+
+void UinputHomeKeyWithLargeBuffer::pressAndReleaseHomeKey() {
+    pressAndReleaseKey(KEY_HOME);
+}
+
 // --- UinputTouchScreen ---
 
 UinputTouchScreen::UinputTouchScreen(const Rect& size, const std::string& physicalPort)
@@ -182,6 +182,30 @@ protected:
     void configureDevice(int fd, uinput_user_dev* device) override;
 };
 
+// --- UinputHomeKeyWithLargeBuffer ---
+
+// A keyboard device that has a single HOME key, and for which the kernel queues thousands of
+// events. The kernel sizes the event queue from the axes of the device, so the device declares
+// multi-touch axes with many slots. It has no position axes, so it isn't treated as a touchscreen.
+class UinputHomeKeyWithLargeBuffer : public UinputKeyboard {
+public:
+    static constexpr const char* DEVICE_NAME = "Test Uinput Home Key With Large Buffer";
+    static constexpr int16_t PRODUCT_ID = 49;
+
+    static constexpr int32_t RAW_SLOT_MAX = 63;
+
+    // Injects 4 events: key press, sync, key release, and sync.
+    void pressAndReleaseHomeKey();
+
+    template <class D, class... Ts>
+    friend std::unique_ptr<D> createUinputDevice(Ts... args);
+
+private:
+    void configureDevice(int fd, uinput_user_dev* device) override;
+
+    explicit UinputHomeKeyWithLargeBuffer();
+};
+
 // --- UinputTouchScreen ---
 
 // A multi-touch touchscreen device with specific size that also supports styluses.
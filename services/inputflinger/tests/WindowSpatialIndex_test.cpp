@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "../WindowSpatialIndex.h"
+
+// atest inputflinger_tests:WindowSpatialIndexTest
+
+using android::gui::WindowInfo;
+using android::gui::WindowInfoHandle;
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+class FakeWindowHandle : public WindowInfoHandle {
+public:
+    FakeWindowHandle(const std::string& name, const Rect& frame) {
+        mInfo.name = name;
+        setFrame(frame);
+    }
+
+    void setFrame(const Rect& frame) {
+        mInfo.frame = frame;
+        mInfo.touchableRegion.clear();
+        mInfo.touchableRegion.orSelf(frame);
+    }
+
+    void setPreventSplitting(bool preventSplitting) {
+        mInfo.setInputConfig(WindowInfo::InputConfig::PREVENT_SPLITTING, preventSplitting);
+    }
+};
+
+std::vector<uint32_t> getCandidates(const WindowSpatialIndex& index, float x, float y) {
+    std::span<const uint32_t> candidates = index.getCandidates(index.toLogical(x, y));
+    return std::vector<uint32_t>(candidates.begin(), candidates.end());
+}
+
+} // namespace
+
+TEST(WindowSpatialIndexTest, CandidatesAreOrderedFrontToBack) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    windows.push_back(sp<FakeWindowHandle>::make("Top", Rect(0, 0, 100, 100)));
+    windows.push_back(sp<FakeWindowHandle>::make("Right", Rect(900, 0, 1000, 1000)));
+    windows.push_back(sp<FakeWindowHandle>::make("Bottom", Rect(0, 0, 1000, 1000)));
+
+    WindowSpatialIndex index;
+    index.update(windows, ui::Transform());
+
+    EXPECT_THAT(getCandidates(index, 50, 50), ElementsAre(0, 2));
+    EXPECT_THAT(getCandidates(index, 950, 500), ElementsAre(1, 2));
+    EXPECT_THAT(getCandidates(index, 500, 500), ElementsAre(2));
+    EXPECT_THAT(getCandidates(index, 1000, 500), IsEmpty());
+    EXPECT_THAT(getCandidates(index, -1, 500), IsEmpty());
+
+    EXPECT_EQ(1u, index.getPosition(windows[1]));
+    EXPECT_EQ(3u, index.getPosition(sp<FakeWindowHandle>::make("Other", Rect(0, 0, 10, 10))));
+}
+
+TEST(WindowSpatialIndexTest, WindowsThatPreventSplittingAreAlwaysCandidates) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    sp<FakeWindowHandle> spy = sp<FakeWindowHandle>::make("Spy", Rect(0, 0, 100, 100));
+    spy->setPreventSplitting(true);
+    windows.push_back(spy);
+    windows.push_back(sp<FakeWindowHandle>::make("Window", Rect(0, 0, 1000, 1000)));
+
+    WindowSpatialIndex index;
+    index.update(windows, ui::Transform());
+
+    EXPECT_THAT(getCandidates(index, 50, 50), ElementsAre(0, 1));
+    EXPECT_THAT(getCandidates(index, 500, 500), ElementsAre(0, 1));
+    EXPECT_THAT(getCandidates(index, 2000, 2000), ElementsAre(0));
+}
+
+TEST(WindowSpatialIndexTest, GeometryIsInLogicalDisplaySpace) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    windows.push_back(sp<FakeWindowHandle>::make("Window", Rect(0, 0, 100, 100)));
+
+    ui::Transform displayTransform;
+    displayTransform.set(100, 200);
+    WindowSpatialIndex index;
+    index.update(windows, displayTransform);
+
+    EXPECT_EQ(Rect(100, 200, 200, 300), index.getWindow(0).frame);
+    EXPECT_TRUE(index.getWindow(0).touchableRegion.contains(150, 250));
+    EXPECT_EQ(vec2(150, 250), index.toLogical(50.5f, 50.5f));
+    EXPECT_THAT(getCandidates(index, 50, 50), ElementsAre(0));
+    EXPECT_THAT(getCandidates(index, 150, 150), IsEmpty());
+}
+
+TEST(WindowSpatialIndexTest, UpdateReflectsChangedGeometry) {
+    sp<FakeWindowHandle> window = sp<FakeWindowHandle>::make("Window", Rect(0, 0, 100, 100));
+    sp<FakeWindowHandle> other = sp<FakeWindowHandle>::make("Other", Rect(0, 0, 1000, 1000));
+
+    WindowSpatialIndex index;
+    index.update({window, other}, ui::Transform());
+    EXPECT_THAT(getCandidates(index, 500, 500), ElementsAre(1));
+
+    // The same handles are updated in place by the dispatcher.
+    window->setFrame(Rect(400, 400, 600, 600));
+    index.update({window, other}, ui::Transform());
+    EXPECT_THAT(getCandidates(index, 500, 500), ElementsAre(0, 1));
+    EXPECT_THAT(getCandidates(index, 50, 50), ElementsAre(1));
+
+    // Reordering the windows is also an update.
+    index.update({other, window}, ui::Transform());
+    EXPECT_THAT(getCandidates(index, 500, 500), ElementsAre(0, 1));
+    EXPECT_EQ(other, index.getWindow(0).handle);
+
+    index.update({}, ui::Transform());
+    EXPECT_THAT(getCandidates(index, 500, 500), IsEmpty());
+}
+
+} // namespace android::inputdispatcher
@@ -30,6 +30,7 @@
 #include <renderengine/LayerSettings.h>
 #include <ui/Fence.h>
 #include <ui/FenceTime.h>
+#include <ui/FloatRect.h>
 #include <ui/GraphicTypes.h>
 #include <ui/LayerStack.h>
 #include <ui/Region.h>
@@ -139,6 +140,38 @@ public:
         ui::RenderIntent renderIntent{ui::RenderIntent::COLORIMETRIC};
     };
 
+    // The visibility computed for a layer, along with the layer state it was
+    // computed from. It stays valid as long as neither the layer nor any layer
+    // above it changes, so that it can be reused by later frames.
+    struct LayerVisibility {
+        wp<LayerFE> layerFE;
+
+        // The layer state the visibility was computed from
+        bool hasCompositionState = false;
+        bool isVisible = false;
+        ui::LayerFilter outputFilter;
+        ui::Transform geomLayerTransform;
+        FloatRect geomLayerBounds;
+        float shadowLength = 0.f;
+        bool isOpaque = false;
+        Region transparentRegionHint;
+        bool isDisplayDecoration = false;
+
+        // Whether the layer has an output layer
+        bool hasOutputLayer = false;
+        // Whether the layer contributes to the dirty region of the output
+        bool affectsDirtyRegion = false;
+        // The visible region of the layer, which it dirties when its content changes
+        Region visibleRegion;
+        // The region the layer dirties when neither its content nor its geometry changes
+        Region unchangedDirtyRegion;
+
+        // The coverage of the output by this layer and the layers above it
+        Region aboveCoveredLayers;
+        Region aboveOpaqueLayers;
+        std::optional<Region> aboveCoveredLayersExcludingOverlays;
+    };
+
     // Use internally to incrementally compute visibility/coverage
     struct CoverageState {
         explicit CoverageState(LayerFESet& latchedLayers) : latchedLayers(latchedLayers) {}
@@ -157,6 +190,8 @@ public:
         // only has a value if there's something needing it, like when a TrustedPresentationListener
         // is set
         std::optional<Region> aboveCoveredLayersExcludingOverlays;
+        // If set, receives the visibility of the layer being processed
+        LayerVisibility* layerVisibility = nullptr;
     };
 
     virtual ~Output();
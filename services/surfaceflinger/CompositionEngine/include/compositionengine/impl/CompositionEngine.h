@@ -18,8 +18,13 @@
 
 #include <compositionengine/CompositionEngine.h>
 
+#include <memory>
+#include <vector>
+
 namespace android::compositionengine::impl {
 
+class HwcAsyncWorker;
+
 class CompositionEngine : public compositionengine::CompositionEngine {
 public:
     CompositionEngine();
@@ -48,6 +53,8 @@ public:
 
     void preComposition(CompositionRefreshArgs&) override;
 
+    void prepare(CompositionRefreshArgs&) override;
+
     void postComposition(CompositionRefreshArgs&) override;
 
     FeatureFlags getFeatureFlags() const override;
@@ -64,6 +71,10 @@ private:
     std::shared_ptr<TimeStats> mTimeStats;
     bool mNeedsAnotherUpdate = false;
     nsecs_t mRefreshStartTime = 0;
+
+    // Workers on which all outputs but the last are prepared, when outputs are
+    // prepared concurrently. Kept across frames to avoid churning threads.
+    std::vector<std::unique_ptr<HwcAsyncWorker>> mPrepareWorkers;
 };
 
 std::unique_ptr<compositionengine::CompositionEngine> createCompositionEngine();
@@ -173,6 +173,9 @@ private:
     compositionengine::Output::ColorProfile pickColorProfile(
             const compositionengine::CompositionRefreshArgs&) const;
     void updateHwcAsyncWorker();
+    bool canReuseLayerVisibility(const compositionengine::CompositionRefreshArgs&) const;
+    bool reuseLayerVisibility(const sp<LayerFE>&, const compositionengine::Output::LayerVisibility&,
+                              compositionengine::Output::CoverageState&);
     float getHdrSdrRatio(const std::shared_ptr<renderengine::ExternalTexture>& buffer) const;
 
     std::string mName;
@@ -192,6 +195,18 @@ private:
 
     // Whether the content must be recomposed this frame.
     bool mMustRecompose = false;
+
+    // The visibility of the layers as of the last time the layer stack was
+    // rebuilt, front to back, along with the output state it was computed with.
+    struct LayerVisibilityCache {
+        ui::Transform transform;
+        Rect displayBounds;
+        Rect layerStackContent;
+        ui::LayerFilter layerFilter;
+        bool hasTrustedPresentationListener = false;
+        std::vector<compositionengine::Output::LayerVisibility> layers;
+    };
+    LayerVisibilityCache mLayerVisibilityCache;
 };
 
 // This template factory function standardizes the implementation details of the
@@ -87,6 +87,7 @@ public:
     bool hasBufferUpdate() const;
     bool hasRenderedBuffer() const { return mTexture != nullptr; }
     bool hasReadyBuffer() const;
+    bool hasPendingRender() const { return mPendingRender != nullptr; }
 
     // Decomposes this CachedSet into a vector of its layers as individual CachedSets
     std::vector<CachedSet> decompose() const;
@@ -96,6 +97,7 @@ public:
     void setLastUpdate(std::chrono::steady_clock::time_point now) { mLastUpdate = now; }
     void append(const CachedSet& other) {
         mTexture.reset();
+        mPendingRender.reset();
         mOutputDataspace = ui::Dataspace::UNKNOWN;
         mDrawFence = nullptr;
         mBlurLayer = nullptr;
@@ -117,6 +119,16 @@ public:
     void render(renderengine::RenderEngine& re, TexturePool& texturePool,
                 const OutputCompositionState& outputState, bool deviceHandlesColorTransform);
 
+    // Starts rendering the cached set like render(), but does not wait for RenderEngine to draw
+    // it. The cached set has no buffer until finishPendingRender() finds that the draw is done.
+    void renderInBackground(renderengine::RenderEngine& re, TexturePool& texturePool,
+                            const OutputCompositionState& outputState,
+                            bool deviceHandlesColorTransform);
+
+    // Takes the buffer of a render started by renderInBackground() if RenderEngine has finished
+    // drawing it. Never blocks.
+    void finishPendingRender();
+
     void dump(std::string& result) const;
 
     // Whether this represents a single layer with a buffer and rounded corners.
@@ -151,6 +163,19 @@ public:
     bool cachingHintExcludesLayers() const;
 
 private:
+    // A render that RenderEngine has not finished yet.
+    struct PendingRender {
+        ftl::Future<FenceResult> drawFence;
+        std::shared_ptr<TexturePool::AutoTexture> texture;
+        ProjectionSpace outputSpace;
+        ui::Dataspace outputDataspace;
+        ui::Transform::RotationFlags orientation;
+    };
+
+    void startRender(renderengine::RenderEngine& re, TexturePool& texturePool,
+                     const OutputCompositionState& outputState, bool deviceHandlesColorTransform);
+    void completeRender();
+
     const NonBufferHash mFingerprint;
     std::chrono::steady_clock::time_point mLastUpdate = std::chrono::steady_clock::now();
     std::vector<Layer> mLayers;
@@ -166,6 +191,8 @@ private:
     // TODO(b/190411067): This is a shared pointer only because CachedSets are copied into different
     // containers in the Flattener. Logically this should have unique ownership otherwise.
     std::shared_ptr<TexturePool::AutoTexture> mTexture;
+    // Shared for the same reason as mTexture, and because futures cannot be copied.
+    std::shared_ptr<PendingRender> mPendingRender;
     sp<Fence> mDrawFence;
     ProjectionSpace mOutputSpace;
     ui::Dataspace mOutputDataspace;
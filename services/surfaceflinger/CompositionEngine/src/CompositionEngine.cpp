@@ -21,6 +21,7 @@
 #include <compositionengine/OutputLayer.h>
 #include <compositionengine/impl/CompositionEngine.h>
 #include <compositionengine/impl/Display.h>
+#include <compositionengine/impl/HwcAsyncWorker.h>
 #include <ui/DisplayMap.h>
 
 #include <renderengine/RenderEngine.h>
@@ -132,17 +133,7 @@ void CompositionEngine::present(CompositionRefreshArgs& args) {
     ALOGV(__FUNCTION__);
 
     preComposition(args);
-
-    {
-        // latchedLayers is used to track the set of front-end layer state that
-        // has been latched across all outputs for the prepare step, and is not
-        // needed for anything else.
-        LayerFESet latchedLayers;
-
-        for (const auto& output : args.outputs) {
-            output->prepare(args, latchedLayers);
-        }
-    }
+    prepare(args);
 
     // Offloading the HWC call for `present` allows us to simultaneously call it
     // on multiple displays. This is desirable because these calls block and can
@@ -193,6 +184,57 @@ void CompositionEngine::preComposition(CompositionRefreshArgs& args) {
     mNeedsAnotherUpdate = needsAnotherUpdate;
 }
 
+void CompositionEngine::prepare(CompositionRefreshArgs& args) {
+    SFTRACE_CALL();
+    ALOGV(__FUNCTION__);
+
+    // latchedLayers is used to track the set of front-end layer state that
+    // has been latched across all outputs for the prepare step, and is not
+    // needed for anything else.
+    LayerFESet latchedLayers;
+
+    // Outputs only do significant work in prepare when their layer stacks are
+    // rebuilt, which they do independently of each other. Rebuilding only
+    // calls into HWComposer to create layers, which Display::createOutputLayer
+    // serializes. Uncaching buffers calls into HWComposer for every output
+    // layer, so frames which uncache buffers are prepared on this thread.
+    if (!FlagManager::getInstance().multithreaded_prepare() ||
+        !args.updatingOutputGeometryThisFrame || args.outputs.size() < 2 ||
+        !args.bufferIdsToUncache.empty()) {
+        for (const auto& output : args.outputs) {
+            output->prepare(args, latchedLayers);
+        }
+        return;
+    }
+
+    // Leave the last output on the main thread, which will allow it to run
+    // concurrently without an extra thread hop. LayerFESet is not thread-safe,
+    // so each offloaded output latches into its own set.
+    const size_t offloadCount = args.outputs.size() - 1;
+    while (mPrepareWorkers.size() < offloadCount) {
+        mPrepareWorkers.push_back(std::make_unique<HwcAsyncWorker>());
+    }
+
+    std::vector<LayerFESet> offloadedLatchedLayers(offloadCount);
+    ui::DisplayVector<std::future<bool>> prepareFutures;
+    for (size_t i = 0; i < offloadCount; i++) {
+        prepareFutures.push_back(mPrepareWorkers[i]->send(
+                [&args, &output = *args.outputs[i], &layers = offloadedLatchedLayers[i]]() {
+                    output.prepare(args, layers);
+                    return true;
+                }));
+    }
+
+    args.outputs.back()->prepare(args, latchedLayers);
+
+    {
+        SFTRACE_NAME("Waiting on prepare");
+        for (auto& future : prepareFutures) {
+            future.wait();
+        }
+    }
+}
+
 // If a buffer is latched but the layer is not presented, such as when
 // obscured by another layer, the previous buffer needs to be released. We find
 // these buffers and fire a NO_FENCE to release it. This ensures that all
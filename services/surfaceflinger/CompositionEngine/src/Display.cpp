@@ -27,6 +27,8 @@
 #include <compositionengine/impl/OutputLayer.h>
 #include <compositionengine/impl/RenderSurface.h>
 
+#include <mutex>
+
 // TODO(b/129481165): remove the #pragma below and fix conversion issues
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wconversion"
@@ -158,7 +160,14 @@ std::unique_ptr<compositionengine::OutputLayer> Display::createOutputLayer(
     if (const auto halDisplayId = HalDisplayId::tryCast(mId);
         outputLayer && !mIsDisconnected && halDisplayId) {
         auto& hwc = getCompositionEngine().getHwComposer();
-        auto hwcLayer = hwc.createLayer(*halDisplayId);
+        std::shared_ptr<HWC2::Layer> hwcLayer;
+        {
+            // Outputs may be prepared concurrently (see CompositionEngine::prepare),
+            // but HWComposer is not thread-safe.
+            static std::mutex sCreateLayerMutex;
+            std::lock_guard lock(sCreateLayerMutex);
+            hwcLayer = hwc.createLayer(*halDisplayId);
+        }
         ALOGE_IF(!hwcLayer, "Failed to create a HWC layer for a HWC supported display %s",
                  getName().c_str());
         outputLayer->setHwcLayer(std::move(hwcLayer));
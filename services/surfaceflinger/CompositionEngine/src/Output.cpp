@@ -98,6 +98,42 @@ ScaleVector getScale(const Rect& from, const Rect& to) {
             .y = static_cast<float>(to.height()) / from.height()};
 }
 
+// Records the layer state the visibility of a layer depends on.
+void setLayerState(compositionengine::Output::LayerVisibility& visibility,
+                   const LayerFECompositionState* layerFEState) {
+    visibility.hasCompositionState = layerFEState != nullptr;
+    if (!layerFEState) {
+        return;
+    }
+    visibility.isVisible = layerFEState->isVisible;
+    visibility.outputFilter = layerFEState->outputFilter;
+    visibility.geomLayerTransform = layerFEState->geomLayerTransform;
+    visibility.geomLayerBounds = layerFEState->geomLayerBounds;
+    visibility.shadowLength = layerFEState->shadowSettings.length;
+    visibility.isOpaque = layerFEState->isOpaque;
+    visibility.transparentRegionHint = layerFEState->transparentRegionHint;
+    visibility.isDisplayDecoration =
+            layerFEState->compositionType == Composition::DISPLAY_DECORATION;
+}
+
+bool isLayerStateUnchanged(const compositionengine::Output::LayerVisibility& visibility,
+                           const LayerFECompositionState* layerFEState) {
+    if (!layerFEState) {
+        return !visibility.hasCompositionState;
+    }
+    return visibility.hasCompositionState && visibility.isVisible == layerFEState->isVisible &&
+            visibility.outputFilter.layerStack == layerFEState->outputFilter.layerStack &&
+            visibility.outputFilter.toInternalDisplay ==
+            layerFEState->outputFilter.toInternalDisplay &&
+            visibility.geomLayerTransform == layerFEState->geomLayerTransform &&
+            visibility.geomLayerBounds == layerFEState->geomLayerBounds &&
+            visibility.shadowLength == layerFEState->shadowSettings.length &&
+            visibility.isOpaque == layerFEState->isOpaque &&
+            visibility.transparentRegionHint.hasSameRects(layerFEState->transparentRegionHint) &&
+            visibility.isDisplayDecoration ==
+            (layerFEState->compositionType == Composition::DISPLAY_DECORATION);
+}
+
 } // namespace
 
 std::shared_ptr<Output> createOutput(
@@ -539,22 +575,114 @@ void Output::rebuildLayerStacks(const compositionengine::CompositionRefreshArgs&
 
 void Output::collectVisibleLayers(const compositionengine::CompositionRefreshArgs& refreshArgs,
                                   compositionengine::Output::CoverageState& coverage) {
+    // When incremental, the visibility of each layer is kept for the next time,
+    // in which a layer can reuse it as long as neither it nor any layer above it
+    // changed.
+    const bool incremental = FlagManager::getInstance().incremental_visible_region();
+    auto& cache = mLayerVisibilityCache;
+    bool reuseVisibility = incremental && canReuseLayerVisibility(refreshArgs);
+    size_t index = 0;
+
     // Evaluate the layers from front to back to determine what is visible. This
     // also incrementally calculates the coverage information for each layer as
     // well as the entire output.
     for (auto layer : reversed(refreshArgs.layers)) {
-        // Incrementally process the coverage for each layer
+        if (!incremental) {
+            // Incrementally process the coverage for each layer
+            ensureOutputLayerIfVisible(layer, coverage);
+            continue;
+        }
+
+        if (reuseVisibility && index < cache.layers.size() &&
+            reuseLayerVisibility(layer, cache.layers[index], coverage)) {
+            index++;
+            continue;
+        }
+        reuseVisibility = false;
+
+        if (index == cache.layers.size()) {
+            cache.layers.emplace_back();
+        }
+        auto& visibility = cache.layers[index++];
+        visibility = {};
+        visibility.layerFE = layer;
+        setLayerState(visibility, layer->getCompositionState());
+
+        coverage.layerVisibility = &visibility;
         ensureOutputLayerIfVisible(layer, coverage);
+        coverage.layerVisibility = nullptr;
+
+        visibility.aboveCoveredLayers = coverage.aboveCoveredLayers;
+        visibility.aboveOpaqueLayers = coverage.aboveOpaqueLayers;
+        visibility.aboveCoveredLayersExcludingOverlays =
+                coverage.aboveCoveredLayersExcludingOverlays;
 
         // TODO(b/121291683): Stop early if the output is completely covered and
         // no more layers could even be visible underneath the ones on top.
     }
 
+    cache.layers.resize(index);
+    if (incremental) {
+        const auto& outputState = getState();
+        cache.transform = outputState.transform;
+        cache.displayBounds = outputState.displaySpace.getBoundsAsRect();
+        cache.layerStackContent = outputState.layerStackSpace.getContent();
+        cache.layerFilter = outputState.layerFilter;
+        cache.hasTrustedPresentationListener = refreshArgs.hasTrustedPresentationListener;
+    }
+
     setReleasedLayers(refreshArgs);
 
     finalizePendingOutputLayers();
 }
 
+bool Output::canReuseLayerVisibility(
+        const compositionengine::CompositionRefreshArgs& refreshArgs) const {
+    const auto& cache = mLayerVisibilityCache;
+    const auto& outputState = getState();
+    return cache.transform == outputState.transform &&
+            cache.displayBounds == outputState.displaySpace.getBoundsAsRect() &&
+            cache.layerStackContent == outputState.layerStackSpace.getContent() &&
+            cache.layerFilter.layerStack == outputState.layerFilter.layerStack &&
+            cache.layerFilter.toInternalDisplay == outputState.layerFilter.toInternalDisplay &&
+            cache.hasTrustedPresentationListener == refreshArgs.hasTrustedPresentationListener;
+}
+
+bool Output::reuseLayerVisibility(const sp<compositionengine::LayerFE>& layerFE,
+                                  const compositionengine::Output::LayerVisibility& visibility,
+                                  compositionengine::Output::CoverageState& coverage) {
+    const auto* layerFEState = layerFE->getCompositionState();
+    if (visibility.layerFE != wp<compositionengine::LayerFE>(layerFE) ||
+        !isLayerStateUnchanged(visibility, layerFEState)) {
+        return false;
+    }
+
+    // The output layer keeps the coverage information computed for it, unless
+    // it was dropped since.
+    const auto prevOutputLayerIndex = findCurrentOutputLayerForLayer(layerFE);
+    if (prevOutputLayerIndex.has_value() != visibility.hasOutputLayer) {
+        return false;
+    }
+
+    coverage.latchedLayers.insert(layerFE);
+
+    // The layer still covers the same regions, so its dirty region only depends
+    // on whether its content changed.
+    if (visibility.affectsDirtyRegion) {
+        coverage.dirtyRegion.orSelf(layerFEState->contentDirty ? visibility.visibleRegion
+                                                               : visibility.unchangedDirtyRegion);
+    }
+
+    coverage.aboveCoveredLayers = visibility.aboveCoveredLayers;
+    coverage.aboveOpaqueLayers = visibility.aboveOpaqueLayers;
+    coverage.aboveCoveredLayersExcludingOverlays = visibility.aboveCoveredLayersExcludingOverlays;
+
+    if (prevOutputLayerIndex) {
+        ensureOutputLayer(prevOutputLayerIndex, layerFE);
+    }
+    return true;
+}
+
 void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
                                         compositionengine::Output::CoverageState& coverage) {
     // Ensure we have a snapshot of the basic geometry layer state. Limit the
@@ -758,6 +886,11 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
     // accumulate to the screen dirty region
     coverage.dirtyRegion.orSelf(dirty);
 
+    if (coverage.layerVisibility) {
+        coverage.layerVisibility->affectsDirtyRegion = true;
+        coverage.layerVisibility->visibleRegion = visibleRegion;
+    }
+
     // Update accumAboveOpaqueLayers for next (lower) layer
     coverage.aboveOpaqueLayers.orSelf(opaqueRegion);
 
@@ -770,6 +903,11 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
     Region drawRegion(outputState.transform.transform(visibleNonTransparentRegion));
     drawRegion.andSelf(outputState.displaySpace.getBoundsAsRect());
     if (drawRegion.isEmpty()) {
+        if (coverage.layerVisibility) {
+            // Without an output layer, the next frame sees nothing as covered
+            // before, so the whole uncovered visible region is exposed again.
+            coverage.layerVisibility->unchangedDirtyRegion = visibleRegion.subtract(coveredRegion);
+        }
         return;
     }
 
@@ -797,6 +935,11 @@ void Output::ensureOutputLayerIfVisible(sp<compositionengine::LayerFE>& layerFE,
         outputLayerState.coveredRegionExcludingDisplayOverlays =
                 std::move(coveredRegionExcludingDisplayOverlays);
     }
+
+    if (coverage.layerVisibility) {
+        coverage.layerVisibility->hasOutputLayer = true;
+        coverage.layerVisibility->unchangedDirtyRegion = visibleRegion.intersect(coveredRegion);
+    }
 }
 
 void Output::setReleasedLayers(const compositionengine::CompositionRefreshArgs&) {
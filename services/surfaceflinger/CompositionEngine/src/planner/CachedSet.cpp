@@ -161,6 +161,31 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
                        const OutputCompositionState& outputState,
                        bool deviceHandlesColorTransform) {
     SFTRACE_CALL();
+    startRender(renderEngine, texturePool, outputState, deviceHandlesColorTransform);
+    if (mPendingRender) {
+        completeRender();
+    }
+}
+
+void CachedSet::renderInBackground(renderengine::RenderEngine& renderEngine,
+                                   TexturePool& texturePool,
+                                   const OutputCompositionState& outputState,
+                                   bool deviceHandlesColorTransform) {
+    SFTRACE_CALL();
+    startRender(renderEngine, texturePool, outputState, deviceHandlesColorTransform);
+}
+
+void CachedSet::finishPendingRender() {
+    using namespace std::chrono_literals;
+    if (mPendingRender && mPendingRender->drawFence.wait_for(0s) == std::future_status::ready) {
+        SFTRACE_CALL();
+        completeRender();
+    }
+}
+
+void CachedSet::startRender(renderengine::RenderEngine& renderEngine, TexturePool& texturePool,
+                            const OutputCompositionState& outputState,
+                            bool deviceHandlesColorTransform) {
     if (outputState.powerCallback) {
         outputState.powerCallback->notifyCpuLoadUp();
     }
@@ -274,19 +299,31 @@ void CachedSet::render(renderengine::RenderEngine& renderEngine, TexturePool& te
         bufferFence.reset(texture->getReadyFence()->dup());
     }
 
-    auto fenceResult = renderEngine
-                               .drawLayers(displaySettings, layerSettings, texture->get(),
-                                           std::move(bufferFence))
-                               .get();
+    auto drawFence = renderEngine.drawLayers(displaySettings, layerSettings, texture->get(),
+                                             std::move(bufferFence));
+
+    ProjectionSpace outputSpace = outputState.framebufferSpace;
+    outputSpace.setOrientation(outputState.framebufferSpace.getOrientation());
+    mPendingRender = std::make_shared<PendingRender>(PendingRender{
+            .drawFence = std::move(drawFence),
+            .texture = std::move(texture),
+            .outputSpace = outputSpace,
+            .outputDataspace = outputDataspace,
+            .orientation = orientation,
+    });
+}
+
+void CachedSet::completeRender() {
+    const std::shared_ptr<PendingRender> pendingRender = std::move(mPendingRender);
+    auto fenceResult = pendingRender->drawFence.get();
 
     if (fenceStatus(fenceResult) == NO_ERROR) {
         mDrawFence = std::move(fenceResult).value_or(Fence::NO_FENCE);
-        mOutputSpace = outputState.framebufferSpace;
-        mTexture = texture;
+        mOutputSpace = pendingRender->outputSpace;
+        mTexture = pendingRender->texture;
         mTexture->setReadyFence(mDrawFence);
-        mOutputSpace.setOrientation(outputState.framebufferSpace.getOrientation());
-        mOutputDataspace = outputDataspace;
-        mOrientation = orientation;
+        mOutputDataspace = pendingRender->outputDataspace;
+        mOrientation = pendingRender->orientation;
         mSkipCount = 0;
     } else {
         mTexture.reset();
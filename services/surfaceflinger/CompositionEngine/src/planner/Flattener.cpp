@@ -124,6 +124,11 @@ void Flattener::renderCachedSets(
         return;
     }
 
+    if (mNewCachedSet->hasPendingRender()) {
+        SFTRACE_NAME("mNewCachedSet->hasPendingRender()");
+        return;
+    }
+
     const auto now = std::chrono::steady_clock::now();
 
     // If we have a render deadline, and the flattener is configured to skip rendering if we don't
@@ -148,7 +153,16 @@ void Flattener::renderCachedSets(
         }
     }
 
-    mNewCachedSet->render(mRenderEngine, mTexturePool, outputState, deviceHandlesColorTransform);
+    // The cached set is only used once its buffer is ready, so there is no need to wait for
+    // RenderEngine here, after the frame has been presented. Its buffer is picked up when the next
+    // frame is planned instead.
+    if (FlagManager::getInstance().background_cached_set_render()) {
+        mNewCachedSet->renderInBackground(mRenderEngine, mTexturePool, outputState,
+                                          deviceHandlesColorTransform);
+    } else {
+        mNewCachedSet->render(mRenderEngine, mTexturePool, outputState,
+                              deviceHandlesColorTransform);
+    }
 }
 
 void Flattener::dumpLayers(std::string& result) const {
@@ -299,6 +313,10 @@ bool Flattener::mergeWithCachedSets(const std::vector<const LayerState*>& layers
         ALOGV("%s", dumper().c_str());
     }
 
+    if (mNewCachedSet) {
+        mNewCachedSet->finishPendingRender();
+    }
+
     auto currentLayerIter = mLayers.begin();
     auto incomingLayerIter = layers.begin();
 
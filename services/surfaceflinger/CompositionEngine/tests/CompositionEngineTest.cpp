@@ -136,6 +136,80 @@ TEST_F(CompositionEnginePresentTest, worksAsExpected) {
     mEngine.present(mRefreshArgs);
 }
 
+/*
+ * CompositionEngine::prepare
+ */
+
+struct CompositionEnginePrepareTest : public CompositionEngineTest {
+    CompositionEnginePrepareTest() {
+        mRefreshArgs.outputs = {mOutput1, mOutput2, mOutput3};
+        mRefreshArgs.updatingOutputGeometryThisFrame = true;
+    }
+
+    void expectPrepare(const std::shared_ptr<mock::Output>& output, LayerFESet** outLatchedLayers) {
+        EXPECT_CALL(*output, prepare(Ref(mRefreshArgs), _))
+                .WillOnce([outLatchedLayers](const CompositionRefreshArgs&,
+                                             LayerFESet& latchedLayers) {
+                    *outLatchedLayers = &latchedLayers;
+                });
+    }
+
+    LayerFESet* mLatchedLayers1 = nullptr;
+    LayerFESet* mLatchedLayers2 = nullptr;
+    LayerFESet* mLatchedLayers3 = nullptr;
+};
+
+TEST_F(CompositionEnginePrepareTest, sharesLatchedLayersWhenSerial) {
+    SET_FLAG_FOR_TEST(flags::multithreaded_prepare, false);
+    expectPrepare(mOutput1, &mLatchedLayers1);
+    expectPrepare(mOutput2, &mLatchedLayers2);
+    expectPrepare(mOutput3, &mLatchedLayers3);
+
+    mEngine.prepare(mRefreshArgs);
+
+    EXPECT_EQ(mLatchedLayers1, mLatchedLayers2);
+    EXPECT_EQ(mLatchedLayers1, mLatchedLayers3);
+}
+
+TEST_F(CompositionEnginePrepareTest, preparesConcurrentlyWithSeparateLatchedLayers) {
+    SET_FLAG_FOR_TEST(flags::multithreaded_prepare, true);
+    expectPrepare(mOutput1, &mLatchedLayers1);
+    expectPrepare(mOutput2, &mLatchedLayers2);
+    expectPrepare(mOutput3, &mLatchedLayers3);
+
+    mEngine.prepare(mRefreshArgs);
+
+    EXPECT_NE(mLatchedLayers1, mLatchedLayers2);
+    EXPECT_NE(mLatchedLayers1, mLatchedLayers3);
+    EXPECT_NE(mLatchedLayers2, mLatchedLayers3);
+}
+
+TEST_F(CompositionEnginePrepareTest, preparesSeriallyWhenUncachingBuffers) {
+    SET_FLAG_FOR_TEST(flags::multithreaded_prepare, true);
+    mRefreshArgs.bufferIdsToUncache = {1};
+    expectPrepare(mOutput1, &mLatchedLayers1);
+    expectPrepare(mOutput2, &mLatchedLayers2);
+    expectPrepare(mOutput3, &mLatchedLayers3);
+
+    mEngine.prepare(mRefreshArgs);
+
+    EXPECT_EQ(mLatchedLayers1, mLatchedLayers2);
+    EXPECT_EQ(mLatchedLayers1, mLatchedLayers3);
+}
+
+TEST_F(CompositionEnginePrepareTest, preparesSeriallyWithoutGeometryUpdate) {
+    SET_FLAG_FOR_TEST(flags::multithreaded_prepare, true);
+    mRefreshArgs.updatingOutputGeometryThisFrame = false;
+    expectPrepare(mOutput1, &mLatchedLayers1);
+    expectPrepare(mOutput2, &mLatchedLayers2);
+    expectPrepare(mOutput3, &mLatchedLayers3);
+
+    mEngine.prepare(mRefreshArgs);
+
+    EXPECT_EQ(mLatchedLayers1, mLatchedLayers2);
+    EXPECT_EQ(mLatchedLayers1, mLatchedLayers3);
+}
+
 /*
  * CompositionEngine::updateCursorAsync
  */
@@ -1363,6 +1363,7 @@ struct OutputCollectVisibleLayersTest : public testing::Test {
         StrictMock<mock::OutputLayer> outputLayer;
         impl::OutputLayerCompositionState outputLayerState;
         sp<StrictMock<mock::LayerFE>> layerFE = sp<StrictMock<mock::LayerFE>>::make();
+        LayerFECompositionState layerFEState;
     };
 
     OutputCollectVisibleLayersTest() {
@@ -1413,6 +1414,58 @@ TEST_F(OutputCollectVisibleLayersTest, processesCandidateLayersReversedAndSetsOu
     mOutput.collectVisibleLayers(mRefreshArgs, mCoverageState);
 }
 
+TEST_F(OutputCollectVisibleLayersTest, reusesVisibilityOfLayersAboveTopmostChange) {
+    SET_FLAG_FOR_TEST(flags::incremental_visible_region, true);
+
+    // The mock ensureOutputLayerIfVisible never creates output layers.
+    EXPECT_CALL(mOutput, getOutputLayerCount()).WillRepeatedly(Return(0u));
+    for (Layer* layer : {&mLayer1, &mLayer2, &mLayer3}) {
+        EXPECT_CALL(*layer->layerFE, getCompositionState())
+                .WillRepeatedly(Return(&layer->layerFEState));
+    }
+
+    auto collectVisibleLayers = [this]() {
+        Output::CoverageState coverageState{mGeomSnapshots};
+        mOutput.collectVisibleLayers(mRefreshArgs, coverageState);
+    };
+
+    // Enforce a call order sequence for this test.
+    InSequence seq;
+
+    // The first time, the visibility of every layer is computed.
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer3.layerFE), _));
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer2.layerFE), _));
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer1.layerFE), _));
+    EXPECT_CALL(mOutput, setReleasedLayers(Ref(mRefreshArgs)));
+    EXPECT_CALL(mOutput, finalizePendingOutputLayers());
+    collectVisibleLayers();
+
+    // Nothing changed, so the visibility of every layer is reused, even if
+    // their content changed.
+    mLayer1.layerFEState.contentDirty = true;
+    EXPECT_CALL(mOutput, setReleasedLayers(Ref(mRefreshArgs)));
+    EXPECT_CALL(mOutput, finalizePendingOutputLayers());
+    collectVisibleLayers();
+
+    // The geometry of the middle layer changed, which may affect its visibility
+    // and that of the layer below it.
+    mLayer2.layerFEState.geomLayerBounds = FloatRect{0, 0, 100, 200};
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer2.layerFE), _));
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer1.layerFE), _));
+    EXPECT_CALL(mOutput, setReleasedLayers(Ref(mRefreshArgs)));
+    EXPECT_CALL(mOutput, finalizePendingOutputLayers());
+    collectVisibleLayers();
+
+    // The output changed, so the visibility of every layer is computed again.
+    mOutput.mState.transform = ui::Transform(TR_ROT_90, 200, 300);
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer3.layerFE), _));
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer2.layerFE), _));
+    EXPECT_CALL(mOutput, ensureOutputLayerIfVisible(Eq(mLayer1.layerFE), _));
+    EXPECT_CALL(mOutput, setReleasedLayers(Ref(mRefreshArgs)));
+    EXPECT_CALL(mOutput, finalizePendingOutputLayers());
+    collectVisibleLayers();
+}
+
 /*
  * Output::ensureOutputLayerIfVisible()
  */
@@ -1833,6 +1886,41 @@ TEST_F(OutputEnsureOutputLayerIfVisibleTest, coverageAccumulatesTest) {
                 RegionEq(kExpectedLayerVisibleRegion));
 }
 
+TEST_F(OutputEnsureOutputLayerIfVisibleTest, recordsLayerVisibility) {
+    mLayer.layerFEState.isOpaque = false;
+    mLayer.layerFEState.geomLayerTransform = ui::Transform(TR_IDENT, 100, 200);
+
+    mCoverageState.aboveCoveredLayers = Region(Rect(50, 0, 150, 200));
+    mCoverageState.aboveOpaqueLayers = Region(Rect(50, 0, 150, 200));
+    Output::LayerVisibility visibility;
+    mCoverageState.layerVisibility = &visibility;
+
+    EXPECT_CALL(mOutput, ensureOutputLayer(Eq(0u), Eq(mLayer.layerFE)))
+            .WillOnce(Return(&mLayer.outputLayer));
+
+    ensureOutputLayerIfVisible();
+
+    EXPECT_TRUE(visibility.hasOutputLayer);
+    EXPECT_TRUE(visibility.affectsDirtyRegion);
+    EXPECT_THAT(visibility.visibleRegion, RegionEq(Region(Rect(0, 0, 50, 200))));
+    // The visible region is not covered by any layer above, so it is not dirty
+    // unless the layer changes.
+    EXPECT_THAT(visibility.unchangedDirtyRegion, RegionEq(kEmptyRegion));
+}
+
+TEST_F(OutputEnsureOutputLayerIfVisibleTest, recordsLayerVisibilityIfDrawRegionEmpty) {
+    mOutput.mState.displaySpace.setBounds(ui::Size(0, 0));
+    Output::LayerVisibility visibility;
+    mCoverageState.layerVisibility = &visibility;
+
+    ensureOutputLayerIfVisible();
+
+    EXPECT_FALSE(visibility.hasOutputLayer);
+    EXPECT_TRUE(visibility.affectsDirtyRegion);
+    EXPECT_THAT(visibility.visibleRegion, RegionEq(kFullBoundsNoRotation));
+    EXPECT_THAT(visibility.unchangedDirtyRegion, RegionEq(kFullBoundsNoRotation));
+}
+
 TEST_F(OutputEnsureOutputLayerIfVisibleTest, coverageAccumulatesWithShadowsTest) {
     ui::Transform translate;
     translate.set(50, 50);
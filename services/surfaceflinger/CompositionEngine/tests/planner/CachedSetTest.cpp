@@ -26,6 +26,7 @@
 #include <renderengine/mock/RenderEngine.h>
 #include <ui/GraphicTypes.h>
 #include <utils/Errors.h>
+#include <future>
 #include <memory>
 
 namespace android::compositionengine {
@@ -382,6 +383,45 @@ TEST_F(CachedSetTest, renderUnsecureOutput) {
     cachedSet.append(CachedSet(layer3));
 }
 
+TEST_F(CachedSetTest, renderInBackground) {
+    CachedSet::Layer& layer1 = *mTestLayers[1]->cachedSetLayer.get();
+    sp<mock::LayerFE> layerFE1 = mTestLayers[1]->layerFE;
+    CachedSet::Layer& layer2 = *mTestLayers[2]->cachedSetLayer.get();
+    sp<mock::LayerFE> layerFE2 = mTestLayers[2]->layerFE;
+
+    CachedSet cachedSet(layer1);
+    cachedSet.append(CachedSet(layer2));
+
+    std::optional<compositionengine::LayerFE::LayerSettings> clientComp;
+    clientComp.emplace();
+
+    std::promise<FenceResult> drawPromise;
+    const auto drawLayers = [&](const renderengine::DisplaySettings&,
+                                const std::vector<renderengine::LayerSettings>&,
+                                const std::shared_ptr<renderengine::ExternalTexture>&,
+                                base::unique_fd&&) -> ftl::Future<FenceResult> {
+        return drawPromise.get_future();
+    };
+
+    EXPECT_CALL(*layerFE1, prepareClientComposition(_)).WillOnce(Return(clientComp));
+    EXPECT_CALL(*layerFE2, prepareClientComposition(_)).WillOnce(Return(clientComp));
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _)).WillOnce(Invoke(drawLayers));
+    cachedSet.renderInBackground(mRenderEngine, mTexturePool, mOutputState, true);
+    EXPECT_TRUE(cachedSet.hasPendingRender());
+    EXPECT_FALSE(cachedSet.hasRenderedBuffer());
+
+    // RenderEngine has not drawn the cached set yet, so its buffer cannot be used.
+    cachedSet.finishPendingRender();
+    EXPECT_TRUE(cachedSet.hasPendingRender());
+    EXPECT_FALSE(cachedSet.hasRenderedBuffer());
+
+    drawPromise.set_value(Fence::NO_FENCE);
+    cachedSet.finishPendingRender();
+    EXPECT_FALSE(cachedSet.hasPendingRender());
+    expectReadyBuffer(cachedSet);
+    EXPECT_EQ(mOutputState.framebufferSpace, cachedSet.getOutputSpace());
+}
+
 TEST_F(CachedSetTest, renderSecureOutput) {
     // Skip the 0th layer to ensure that the bounding box of the layers is offset from (0, 0)
     CachedSet::Layer& layer1 = *mTestLayers[1]->cachedSetLayer.get();
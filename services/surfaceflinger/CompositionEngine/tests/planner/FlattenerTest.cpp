@@ -29,6 +29,7 @@
 #include <renderengine/impl/ExternalTexture.h>
 #include <renderengine/mock/RenderEngine.h>
 #include <chrono>
+#include <future>
 
 namespace android::compositionengine {
 using namespace std::chrono_literals;
@@ -284,6 +285,61 @@ TEST_F(FlattenerTest, flattenLayers_basicFlatten) {
     expectAllLayersFlattened(layers);
 }
 
+TEST_F(FlattenerTest, flattenLayers_renderInBackground) {
+    SET_FLAG_FOR_TEST(com::android::graphics::surfaceflinger::flags::background_cached_set_render,
+                      true);
+
+    auto& layerState1 = mTestLayers[0]->layerState;
+    auto& layerState2 = mTestLayers[1]->layerState;
+    auto& layerState3 = mTestLayers[2]->layerState;
+
+    const std::vector<const LayerState*> layers = {
+            layerState1.get(),
+            layerState2.get(),
+            layerState3.get(),
+    };
+
+    initializeFlattener(layers);
+
+    // make all layers inactive
+    mTime += 200ms;
+
+    std::promise<FenceResult> drawPromise;
+    EXPECT_CALL(mRenderEngine, drawLayers(_, _, _, _))
+            .WillOnce(Return(ByMove(ftl::Future<FenceResult>(drawPromise.get_future()))));
+
+    // the new cached set is rendered without waiting for RenderEngine
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    ASSERT_TRUE(mFlattener->getNewCachedSetForTesting());
+    EXPECT_TRUE(mFlattener->getNewCachedSetForTesting()->hasPendingRender());
+
+    // layers are not flattened while RenderEngine is drawing, and the cached set is not rendered
+    // again
+    initializeOverrideBuffer(layers);
+    EXPECT_EQ(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+    for (const auto layer : layers) {
+        EXPECT_EQ(nullptr, layer->getOutputLayer()->getState().overrideInfo.buffer);
+    }
+
+    // the new flattened layer is used once RenderEngine is done
+    drawPromise.set_value(Fence::NO_FENCE);
+    initializeOverrideBuffer(layers);
+    EXPECT_NE(getNonBufferHash(layers),
+              mFlattener->flattenLayers(layers, getNonBufferHash(layers), mTime));
+    mFlattener->renderCachedSets(mOutputState, std::nullopt, true);
+
+    const auto buffer = layers[0]->getOutputLayer()->getState().overrideInfo.buffer;
+    EXPECT_NE(nullptr, buffer);
+    for (const auto layer : layers) {
+        EXPECT_EQ(buffer, layer->getOutputLayer()->getState().overrideInfo.buffer);
+    }
+}
+
 TEST_F(FlattenerTest, flattenLayers_FlattenedLayersStayFlattenWhenNoUpdate) {
     auto& layerState1 = mTestLayers[0]->layerState;
     const auto& overrideBuffer1 = layerState1->getOutputLayer()->getState().overrideInfo.buffer;
@@ -42,6 +42,31 @@ using namespace ftl::flag_operators;
 
 namespace {
 
+// Hierarchies smaller than this are not worth splitting across threads.
+constexpr size_t kMinLayersForParallelUpdate = 128;
+// Number of threads, besides the calling thread, that update subtrees in parallel.
+constexpr size_t kParallelUpdateWorkerCount = 3;
+// Subtrees are split until each one holds at most 1/(threads * kSubtreesPerThread) of the
+// hierarchy, so that the threads stay busy until the end of the update.
+constexpr size_t kSubtreesPerThread = 4;
+
+void updateInheritedFrameRate(LayerSnapshot& snapshot, const RequestedLayerState& requested,
+                              const LayerSnapshot& parentSnapshot) {
+    const bool shouldOverrideChildren = parentSnapshot.frameRateSelectionStrategy ==
+            scheduler::LayerInfo::FrameRateSelectionStrategy::OverrideChildren;
+    const bool propagationAllowed = parentSnapshot.frameRateSelectionStrategy !=
+            scheduler::LayerInfo::FrameRateSelectionStrategy::Self;
+    if ((!requested.requestedFrameRate.isValid() && propagationAllowed) || shouldOverrideChildren) {
+        snapshot.inheritedFrameRate = parentSnapshot.inheritedFrameRate;
+    } else {
+        snapshot.inheritedFrameRate = requested.requestedFrameRate;
+    }
+    // Set the framerate as the inherited frame rate and allow children to override it if
+    // needed.
+    snapshot.frameRate = snapshot.inheritedFrameRate;
+    snapshot.changes |= RequestedLayerState::Changes::FrameRate;
+}
+
 FloatRect getMaxDisplayBounds(const DisplayInfos& displays) {
     const ui::Size maxSize = [&displays] {
         if (displays.empty()) return ui::Size{5000, 5000};
@@ -369,9 +394,11 @@ LayerSnapshotBuilder::LayerSnapshotBuilder() {}
 
 LayerSnapshotBuilder::LayerSnapshotBuilder(Args args) : LayerSnapshotBuilder() {
     args.forceUpdate = ForceUpdateFlags::ALL;
-    updateSnapshots(args);
+    updateSnapshots(args, /*allowParallelUpdate=*/false);
 }
 
+LayerSnapshotBuilder::~LayerSnapshotBuilder() = default;
+
 bool LayerSnapshotBuilder::tryFastUpdate(const Args& args) {
     const bool forceUpdate = args.forceUpdate != ForceUpdateFlags::NONE;
 
@@ -415,7 +442,7 @@ bool LayerSnapshotBuilder::tryFastUpdate(const Args& args) {
     return true;
 }
 
-void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
+void LayerSnapshotBuilder::updateSnapshots(const Args& args, bool allowParallelUpdate) {
     SFTRACE_NAME("UpdateSnapshots");
     LayerSnapshot rootSnapshot = args.rootSnapshot;
     if (args.parentCrop) {
@@ -440,7 +467,9 @@ void LayerSnapshotBuilder::updateSnapshots(const Args& args) {
     }
 
     LayerHierarchy::TraversalPath root = LayerHierarchy::TraversalPath::ROOT;
-    if (args.root.getLayer()) {
+    if (allowParallelUpdate && canUpdateInParallel(args)) {
+        updateSnapshotsInParallel(args, rootSnapshot);
+    } else if (args.root.getLayer()) {
         // The hierarchy can have a root layer when used for screenshots otherwise, it will have
         // multiple children.
         LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root, args.root.getLayer()->id,
@@ -511,36 +540,183 @@ void LayerSnapshotBuilder::update(const Args& args) {
     if (tryFastUpdate(args)) {
         return;
     }
-    updateSnapshots(args);
+    updateSnapshots(args, /*allowParallelUpdate=*/true);
 }
 
 const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
         const Args& args, const LayerHierarchy& hierarchy,
         LayerHierarchy::TraversalPath& traversalPath, const LayerSnapshot& parentSnapshot,
         int depth) {
+    LayerSnapshot& snapshot =
+            updateLayerSnapshot(args, hierarchy, traversalPath, parentSnapshot, depth);
+
+    bool childHasValidFrameRate = false;
+    for (auto& [childHierarchy, variant] : hierarchy.mChildren) {
+        LayerHierarchy::ScopedAddToTraversalPath addChildToPath(traversalPath,
+                                                                childHierarchy->getLayer()->id,
+                                                                variant);
+        const LayerSnapshot& childSnapshot =
+                updateSnapshotsInHierarchy(args, *childHierarchy, traversalPath, snapshot,
+                                           depth + 1);
+        updateFrameRateFromChildSnapshot(snapshot, childSnapshot, *childHierarchy->getLayer(),
+                                         args, &childHasValidFrameRate);
+    }
+
+    return snapshot;
+}
+
+LayerSnapshot& LayerSnapshotBuilder::updateLayerSnapshot(
+        const Args& args, const LayerHierarchy& hierarchy,
+        const LayerHierarchy::TraversalPath& traversalPath, const LayerSnapshot& parentSnapshot,
+        int depth) {
     LLOG_ALWAYS_FATAL_WITH_TRACE_IF(depth > 50,
                                     "Cycle detected in LayerSnapshotBuilder. See "
                                     "builder_stack_overflow_transactions.winscope");
 
     const RequestedLayerState* layer = hierarchy.getLayer();
-    LayerSnapshot* snapshot = getSnapshot(traversalPath);
-    const bool newSnapshot = snapshot == nullptr;
-    uint32_t primaryDisplayRotationFlags = getPrimaryDisplayRotationFlags(args.displays);
-    if (newSnapshot) {
-        snapshot = createSnapshot(traversalPath, *layer, parentSnapshot);
-        snapshot->merge(*layer, /*forceUpdate=*/true, /*displayChanges=*/true, args.forceFullDamage,
-                        primaryDisplayRotationFlags);
-        snapshot->changes |= RequestedLayerState::Changes::Created;
-    }
+    LayerSnapshot& snapshot = getOrCreateSnapshot(args, *layer, traversalPath, parentSnapshot);
 
     if (traversalPath.isRelative()) {
         bool parentIsRelative = traversalPath.variant == LayerHierarchy::Variant::Relative;
-        updateRelativeState(*snapshot, parentSnapshot, parentIsRelative, args);
+        updateRelativeState(snapshot, parentSnapshot, parentIsRelative, args);
     } else {
         if (traversalPath.isAttached()) {
-            resetRelativeState(*snapshot);
+            resetRelativeState(snapshot);
+        }
+        updateSnapshot(snapshot, args, *layer, parentSnapshot, traversalPath);
+    }
+    return snapshot;
+}
+
+LayerSnapshot& LayerSnapshotBuilder::getOrCreateSnapshot(
+        const Args& args, const RequestedLayerState& layer,
+        const LayerHierarchy::TraversalPath& traversalPath, const LayerSnapshot& parentSnapshot) {
+    LayerSnapshot* snapshot = getSnapshot(traversalPath);
+    if (!snapshot) {
+        uint32_t primaryDisplayRotationFlags = getPrimaryDisplayRotationFlags(args.displays);
+        snapshot = createSnapshot(traversalPath, layer, parentSnapshot);
+        snapshot->merge(layer, /*forceUpdate=*/true, /*displayChanges=*/true, args.forceFullDamage,
+                        primaryDisplayRotationFlags);
+        snapshot->changes |= RequestedLayerState::Changes::Created;
+    }
+    return *snapshot;
+}
+
+struct LayerSnapshotBuilder::ParallelUpdate {
+    // The size of a subtree, and whether its snapshots can only be reached through it. Layers
+    // that are reached through a relative parent are visited twice, so the subtrees that lead to
+    // them must be updated in the serial order.
+    struct SubtreeInfo {
+        size_t layerCount = 1;
+        bool selfContained = true;
+    };
+    // Subtrees in the order in which the hierarchy is walked.
+    std::vector<SubtreeInfo> subtrees;
+    // Self contained subtrees with more layers than this are split further.
+    size_t maxSubtreeLayerCount = 0;
+
+    struct SubtreeUpdate {
+        const LayerHierarchy* hierarchy;
+        LayerHierarchy::TraversalPath traversalPath;
+        const LayerSnapshot* parentSnapshot;
+        int depth;
+    };
+    // Subtrees to update on any thread.
+    std::vector<SubtreeUpdate> subtreeUpdates;
+    std::atomic<size_t> nextSubtreeUpdate = 0;
+
+    struct FrameRateUpdate {
+        const LayerHierarchy* hierarchy;
+        LayerHierarchy::TraversalPath traversalPath;
+        LayerSnapshot* snapshot;
+    };
+    // Snapshots updated on the calling thread, in the order in which a serial update would update
+    // their frame rate from their children.
+    std::vector<FrameRateUpdate> frameRateUpdates;
+};
+
+bool LayerSnapshotBuilder::canUpdateInParallel(const Args& args) const {
+    // Only updates that walk most of a large hierarchy are worth splitting.
+    return FlagManager::getInstance().multithreaded_snapshot_update() && !args.root.getLayer() &&
+            args.layerLifecycleManager.getLayers().size() >= kMinLayersForParallelUpdate &&
+            (args.forceUpdate != ForceUpdateFlags::NONE || args.displayChanges ||
+             args.layerLifecycleManager.getGlobalChanges().any(
+                     RequestedLayerState::Changes::Hierarchy |
+                     RequestedLayerState::Changes::Geometry |
+                     RequestedLayerState::Changes::Visibility));
+}
+
+void LayerSnapshotBuilder::updateSnapshotsInParallel(const Args& args,
+                                                     const LayerSnapshot& rootSnapshot) {
+    SFTRACE_CALL();
+    ParallelUpdate update;
+    LayerHierarchy::TraversalPath root = LayerHierarchy::TraversalPath::ROOT;
+    {
+        SFTRACE_NAME("CreateSnapshots");
+        for (auto& [childHierarchy, variant] : args.root.mChildren) {
+            LayerHierarchy::ScopedAddToTraversalPath addChildToPath(root,
+                                                                    childHierarchy->getLayer()->id,
+                                                                    variant);
+            createSnapshotsInHierarchy(args, *childHierarchy, root, rootSnapshot, /*depth=*/0,
+                                       update);
+        }
+    }
+
+    const size_t threadCount = kParallelUpdateWorkerCount + 1;
+    update.maxSubtreeLayerCount =
+            std::max<size_t>(1, update.subtrees.size() / (threadCount * kSubtreesPerThread));
+    splitChildSubtrees(args, args.root, root, rootSnapshot, /*childDepth=*/0, /*childIndex=*/0,
+                       update);
+
+    if (!mUpdateWorkers) {
+        mUpdateWorkers = std::make_unique<SnapshotUpdateWorkers>(kParallelUpdateWorkerCount);
+    }
+    mUpdateWorkers->run([this, &args, &update]() {
+        for (size_t i = update.nextSubtreeUpdate++; i < update.subtreeUpdates.size();
+             i = update.nextSubtreeUpdate++) {
+            ParallelUpdate::SubtreeUpdate& subtree = update.subtreeUpdates[i];
+            updateSnapshotsInHierarchy(args, *subtree.hierarchy, subtree.traversalPath,
+                                       *subtree.parentSnapshot, subtree.depth);
+        }
+    });
+
+    // All the children are updated before the frame rate of their parent is updated from theirs.
+    // In a serial update, a vote that changes the frame rate of the parent also marks the later
+    // siblings as having frame rate changes before they are updated, so catch them up here.
+    for (ParallelUpdate::FrameRateUpdate& frameRateUpdate : update.frameRateUpdates) {
+        const bool hadFrameRateChanges =
+                frameRateUpdate.snapshot->changes.test(RequestedLayerState::Changes::FrameRate);
+        bool childHasValidFrameRate = false;
+        for (auto& [childHierarchy, variant] : frameRateUpdate.hierarchy->mChildren) {
+            LayerHierarchy::ScopedAddToTraversalPath addChildToPath(frameRateUpdate.traversalPath,
+                                                                    childHierarchy->getLayer()->id,
+                                                                    variant);
+            if (!hadFrameRateChanges &&
+                frameRateUpdate.snapshot->changes.test(RequestedLayerState::Changes::FrameRate)) {
+                propagateFrameRateChanges(args, *childHierarchy, frameRateUpdate.traversalPath,
+                                          *frameRateUpdate.snapshot);
+            }
+            updateFrameRateFromChildSnapshot(*frameRateUpdate.snapshot,
+                                             *getSnapshot(frameRateUpdate.traversalPath),
+                                             *childHierarchy->getLayer(), args,
+                                             &childHasValidFrameRate);
+        }
+    }
+}
+
+void LayerSnapshotBuilder::propagateFrameRateChanges(const Args& args,
+                                                     const LayerHierarchy& hierarchy,
+                                                     LayerHierarchy::TraversalPath& traversalPath,
+                                                     const LayerSnapshot& parentSnapshot) {
+    LayerSnapshot& snapshot = *getSnapshot(traversalPath);
+    // Only the parts of updateLayerSnapshot that depend on the frame rate changes of the parent.
+    if (!traversalPath.isRelative()) {
+        snapshot.changes |= parentSnapshot.changes & RequestedLayerState::Changes::FrameRate;
+        if (snapshot.changes.test(RequestedLayerState::Changes::FrameRate) &&
+            (!snapshot.isHiddenByPolicyFromParent ||
+             snapshot.changes.test(RequestedLayerState::Changes::Created))) {
+            updateInheritedFrameRate(snapshot, *hierarchy.getLayer(), parentSnapshot);
         }
-        updateSnapshot(*snapshot, args, *layer, parentSnapshot, traversalPath);
     }
 
     bool childHasValidFrameRate = false;
@@ -548,14 +724,61 @@ const LayerSnapshot& LayerSnapshotBuilder::updateSnapshotsInHierarchy(
         LayerHierarchy::ScopedAddToTraversalPath addChildToPath(traversalPath,
                                                                 childHierarchy->getLayer()->id,
                                                                 variant);
-        const LayerSnapshot& childSnapshot =
-                updateSnapshotsInHierarchy(args, *childHierarchy, traversalPath, *snapshot,
-                                           depth + 1);
-        updateFrameRateFromChildSnapshot(*snapshot, childSnapshot, *childHierarchy->getLayer(),
-                                         args, &childHasValidFrameRate);
+        propagateFrameRateChanges(args, *childHierarchy, traversalPath, snapshot);
+        updateFrameRateFromChildSnapshot(snapshot, *getSnapshot(traversalPath),
+                                         *childHierarchy->getLayer(), args,
+                                         &childHasValidFrameRate);
     }
+}
 
-    return *snapshot;
+void LayerSnapshotBuilder::createSnapshotsInHierarchy(const Args& args,
+                                                      const LayerHierarchy& hierarchy,
+                                                      LayerHierarchy::TraversalPath& traversalPath,
+                                                      const LayerSnapshot& parentSnapshot,
+                                                      int depth, ParallelUpdate& update) {
+    LLOG_ALWAYS_FATAL_WITH_TRACE_IF(depth > 50,
+                                    "Cycle detected in LayerSnapshotBuilder. See "
+                                    "builder_stack_overflow_transactions.winscope");
+
+    const size_t index = update.subtrees.size();
+    update.subtrees.push_back(
+            {.selfContained = traversalPath.isAttached() && !traversalPath.isRelative()});
+    const LayerSnapshot& snapshot =
+            getOrCreateSnapshot(args, *hierarchy.getLayer(), traversalPath, parentSnapshot);
+
+    for (auto& [childHierarchy, variant] : hierarchy.mChildren) {
+        LayerHierarchy::ScopedAddToTraversalPath addChildToPath(traversalPath,
+                                                                childHierarchy->getLayer()->id,
+                                                                variant);
+        const size_t childIndex = update.subtrees.size();
+        createSnapshotsInHierarchy(args, *childHierarchy, traversalPath, snapshot, depth + 1,
+                                   update);
+        update.subtrees[index].layerCount += update.subtrees[childIndex].layerCount;
+        update.subtrees[index].selfContained &= update.subtrees[childIndex].selfContained;
+    }
+}
+
+void LayerSnapshotBuilder::splitChildSubtrees(const Args& args, const LayerHierarchy& hierarchy,
+                                              LayerHierarchy::TraversalPath& traversalPath,
+                                              const LayerSnapshot& snapshot, int childDepth,
+                                              size_t childIndex, ParallelUpdate& update) {
+    for (auto& [childHierarchy, variant] : hierarchy.mChildren) {
+        LayerHierarchy::ScopedAddToTraversalPath addChildToPath(traversalPath,
+                                                                childHierarchy->getLayer()->id,
+                                                                variant);
+        const ParallelUpdate::SubtreeInfo& subtree = update.subtrees[childIndex];
+        if (subtree.selfContained && subtree.layerCount <= update.maxSubtreeLayerCount) {
+            update.subtreeUpdates.push_back(
+                    {childHierarchy, traversalPath, &snapshot, childDepth});
+        } else {
+            LayerSnapshot& childSnapshot =
+                    updateLayerSnapshot(args, *childHierarchy, traversalPath, snapshot, childDepth);
+            splitChildSubtrees(args, *childHierarchy, traversalPath, childSnapshot, childDepth + 1,
+                               childIndex + 1, update);
+            update.frameRateUpdates.push_back({childHierarchy, traversalPath, &childSnapshot});
+        }
+        childIndex += subtree.layerCount;
+    }
 }
 
 LayerSnapshot* LayerSnapshotBuilder::getSnapshot(uint32_t layerId) const {
@@ -863,20 +1086,7 @@ void LayerSnapshotBuilder::updateSnapshot(LayerSnapshot& snapshot, const Args& a
                 RequestedLayerState::Changes::Hierarchy) ||
         snapshot.changes.any(RequestedLayerState::Changes::FrameRate |
                              RequestedLayerState::Changes::Hierarchy)) {
-        const bool shouldOverrideChildren = parentSnapshot.frameRateSelectionStrategy ==
-                scheduler::LayerInfo::FrameRateSelectionStrategy::OverrideChildren;
-        const bool propagationAllowed = parentSnapshot.frameRateSelectionStrategy !=
-                scheduler::LayerInfo::FrameRateSelectionStrategy::Self;
-        if ((!requested.requestedFrameRate.isValid() && propagationAllowed) ||
-            shouldOverrideChildren) {
-            snapshot.inheritedFrameRate = parentSnapshot.inheritedFrameRate;
-        } else {
-            snapshot.inheritedFrameRate = requested.requestedFrameRate;
-        }
-        // Set the framerate as the inherited frame rate and allow children to override it if
-        // needed.
-        snapshot.frameRate = snapshot.inheritedFrameRate;
-        snapshot.changes |= RequestedLayerState::Changes::FrameRate;
+        updateInheritedFrameRate(snapshot, requested, parentSnapshot);
     }
 
     if (forceUpdate || snapshot.clientChanges & layer_state_t::eFrameRateSelectionStrategyChanged) {
@@ -1176,6 +1386,7 @@ void LayerSnapshotBuilder::updateInput(LayerSnapshot& snapshot,
     }
 
     if (requested.touchCropId != UNASSIGNED_LAYER_ID || path.isClone()) {
+        std::scoped_lock lock(mNeedsTouchableRegionCropMutex);
         mNeedsTouchableRegionCrop.insert(path);
     }
     auto cropLayerSnapshot = getSnapshot(requested.touchCropId);
@@ -16,11 +16,16 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include "FrontEnd/DisplayInfo.h"
 #include "FrontEnd/LayerLifecycleManager.h"
 #include "LayerHierarchy.h"
 #include "LayerSnapshot.h"
 #include "RequestedLayerState.h"
+#include "SnapshotUpdateWorkers.h"
 
 namespace android::surfaceflinger::frontend {
 
@@ -65,6 +70,8 @@ public:
     // Rebuild the snapshots from scratch.
     LayerSnapshotBuilder(Args);
 
+    ~LayerSnapshotBuilder();
+
     // Update an existing set of snapshot using change flags in RequestedLayerState
     // and LayerLifecycleManager. This needs to be called before
     // LayerLifecycleManager.commitChanges is called as that function will clear all
@@ -104,11 +111,39 @@ private:
     // the fast path.
     bool tryFastUpdate(const Args& args);
 
-    void updateSnapshots(const Args& args);
+    void updateSnapshots(const Args& args, bool allowParallelUpdate);
 
     const LayerSnapshot& updateSnapshotsInHierarchy(const Args&, const LayerHierarchy& hierarchy,
                                                     LayerHierarchy::TraversalPath& traversalPath,
                                                     const LayerSnapshot& parentSnapshot, int depth);
+    // Updates the snapshot of the hierarchy's layer, but not the snapshots of its children.
+    LayerSnapshot& updateLayerSnapshot(const Args&, const LayerHierarchy& hierarchy,
+                                       const LayerHierarchy::TraversalPath& traversalPath,
+                                       const LayerSnapshot& parentSnapshot, int depth);
+    LayerSnapshot& getOrCreateSnapshot(const Args&, const RequestedLayerState& layer,
+                                       const LayerHierarchy::TraversalPath& traversalPath,
+                                       const LayerSnapshot& parentSnapshot);
+
+    // Parallel update of the hierarchy. Subtrees whose snapshots can only be reached through them
+    // are updated on worker threads, and the rest of the hierarchy on the calling thread. Every
+    // snapshot is created up front, in the same order as a serial update would create them, so
+    // that the workers never modify the snapshot containers.
+    struct ParallelUpdate;
+    bool canUpdateInParallel(const Args& args) const;
+    void updateSnapshotsInParallel(const Args& args, const LayerSnapshot& rootSnapshot);
+    void createSnapshotsInHierarchy(const Args&, const LayerHierarchy& hierarchy,
+                                    LayerHierarchy::TraversalPath& traversalPath,
+                                    const LayerSnapshot& parentSnapshot, int depth,
+                                    ParallelUpdate& update);
+    // Marks the snapshots of the hierarchy as having frame rate changes, as a serial update would
+    // have after a vote changed the frame rate of the parent, and updates their frame rates.
+    void propagateFrameRateChanges(const Args&, const LayerHierarchy& hierarchy,
+                                   LayerHierarchy::TraversalPath& traversalPath,
+                                   const LayerSnapshot& parentSnapshot);
+    void splitChildSubtrees(const Args&, const LayerHierarchy& hierarchy,
+                            LayerHierarchy::TraversalPath& traversalPath,
+                            const LayerSnapshot& snapshot, int childDepth, size_t childIndex,
+                            ParallelUpdate& update);
     void updateSnapshot(LayerSnapshot&, const Args&, const RequestedLayerState&,
                         const LayerSnapshot& parentSnapshot, const LayerHierarchy::TraversalPath&);
     static void updateRelativeState(LayerSnapshot& snapshot, const LayerSnapshot& parentSnapshot,
@@ -146,9 +181,14 @@ private:
     // Track snapshots that needs touchable region crop from other snapshots
     std::unordered_set<LayerHierarchy::TraversalPath, LayerHierarchy::TraversalPathHash>
             mNeedsTouchableRegionCrop;
+    // Guards insertions into mNeedsTouchableRegionCrop during a parallel update.
+    std::mutex mNeedsTouchableRegionCropMutex;
     std::vector<std::unique_ptr<LayerSnapshot>> mSnapshots;
-    bool mResortSnapshots = false;
+    std::atomic<bool> mResortSnapshots = false;
     int mNumInterestingSnapshots = 0;
+
+    // Created on the first parallel update.
+    std::unique_ptr<SnapshotUpdateWorkers> mUpdateWorkers;
 };
 
 } // namespace android::surfaceflinger::frontend
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <pthread.h>
+
+#include <common/trace.h>
+
+#include "SnapshotUpdateWorkers.h"
+
+namespace android::surfaceflinger::frontend {
+
+SnapshotUpdateWorkers::SnapshotUpdateWorkers(size_t threadCount) {
+    mThreads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        // Threads start with the scheduling policy and priority of the thread that creates them.
+        mThreads.emplace_back(&SnapshotUpdateWorkers::threadMain, this);
+        pthread_setname_np(mThreads.back().native_handle(), "SnapshotUpdate");
+    }
+}
+
+SnapshotUpdateWorkers::~SnapshotUpdateWorkers() {
+    {
+        std::scoped_lock lock(mMutex);
+        mDone = true;
+    }
+    mCv.notify_all();
+    for (std::thread& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void SnapshotUpdateWorkers::run(const std::function<void()>& task) {
+    {
+        std::scoped_lock lock(mMutex);
+        mTask = &task;
+        mGeneration++;
+        mRunningCount = mThreads.size();
+    }
+    mCv.notify_all();
+
+    task();
+
+    SFTRACE_NAME("Waiting on SnapshotUpdateWorkers");
+    std::unique_lock lock(mMutex);
+    base::ScopedLockAssertion assumeLocked(mMutex);
+    mCv.wait(lock, [this]() REQUIRES(mMutex) { return mRunningCount == 0; });
+    mTask = nullptr;
+}
+
+void SnapshotUpdateWorkers::threadMain() {
+    uint64_t lastGeneration = 0;
+    std::unique_lock lock(mMutex);
+    base::ScopedLockAssertion assumeLocked(mMutex);
+    while (true) {
+        mCv.wait(lock, [&]() REQUIRES(mMutex) { return mDone || mGeneration != lastGeneration; });
+        if (mDone) {
+            return;
+        }
+        lastGeneration = mGeneration;
+        const std::function<void()>* task = mTask;
+
+        lock.unlock();
+        (*task)();
+        lock.lock();
+
+        if (--mRunningCount == 0) {
+            mCv.notify_all();
+        }
+    }
+}
+
+} // namespace android::surfaceflinger::frontend
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android::surfaceflinger::frontend {
+
+// Threads that help the calling thread update layer snapshots (see LayerSnapshotBuilder). The
+// calling thread waits for them, so they inherit its scheduling policy and priority, and must be
+// created on the thread that updates the snapshots.
+class SnapshotUpdateWorkers final {
+public:
+    explicit SnapshotUpdateWorkers(size_t threadCount);
+    ~SnapshotUpdateWorkers();
+
+    size_t getThreadCount() const { return mThreads.size(); }
+
+    // Runs `task` on each of the threads and on the calling thread, and returns once all of them
+    // are done. The task is expected to pull work from a queue shared between the threads.
+    void run(const std::function<void()>& task);
+
+private:
+    void threadMain();
+
+    std::mutex mMutex;
+    std::condition_variable mCv;
+    const std::function<void()>* mTask GUARDED_BY(mMutex) = nullptr;
+    // Incremented for each call to run, so that each thread runs each task once.
+    uint64_t mGeneration GUARDED_BY(mMutex) = 0;
+    size_t mRunningCount GUARDED_BY(mMutex) = 0;
+    bool mDone GUARDED_BY(mMutex) = false;
+    std::vector<std::thread> mThreads;
+};
+
+} // namespace android::surfaceflinger::frontend
@@ -157,6 +157,10 @@ void FlagManager::dump(std::string& result) const {
     DUMP_READ_ONLY_FLAG(single_hop_screenshot);
     DUMP_READ_ONLY_FLAG(trace_frame_rate_override);
     DUMP_READ_ONLY_FLAG(true_hdr_screenshots);
+    DUMP_READ_ONLY_FLAG(multithreaded_prepare);
+    DUMP_READ_ONLY_FLAG(incremental_visible_region);
+    DUMP_READ_ONLY_FLAG(multithreaded_snapshot_update);
+    DUMP_READ_ONLY_FLAG(background_cached_set_render);
 
 #undef DUMP_READ_ONLY_FLAG
 #undef DUMP_SERVER_FLAG
@@ -262,6 +266,11 @@ FLAG_MANAGER_READ_ONLY_FLAG(flush_buffer_slots_to_uncache, "");
 FLAG_MANAGER_READ_ONLY_FLAG(force_compile_graphite_renderengine, "");
 FLAG_MANAGER_READ_ONLY_FLAG(single_hop_screenshot, "");
 FLAG_MANAGER_READ_ONLY_FLAG(true_hdr_screenshots, "debug.sf.true_hdr_screenshots");
+FLAG_MANAGER_READ_ONLY_FLAG(multithreaded_prepare, "debug.sf.multithreaded_prepare");
+FLAG_MANAGER_READ_ONLY_FLAG(incremental_visible_region, "debug.sf.incremental_visible_region");
+FLAG_MANAGER_READ_ONLY_FLAG(multithreaded_snapshot_update,
+                            "debug.sf.multithreaded_snapshot_update");
+FLAG_MANAGER_READ_ONLY_FLAG(background_cached_set_render, "debug.sf.background_cached_set_render");
 
 /// Trunk stable server flags ///
 FLAG_MANAGER_SERVER_FLAG(refresh_rate_overlay_on_external_display, "")
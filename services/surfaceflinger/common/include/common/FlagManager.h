@@ -95,6 +95,10 @@ public:
     bool single_hop_screenshot() const;
     bool trace_frame_rate_override() const;
     bool true_hdr_screenshots() const;
+    bool multithreaded_prepare() const;
+    bool incremental_visible_region() const;
+    bool multithreaded_snapshot_update() const;
+    bool background_cached_set_render() const;
 
 protected:
     // overridden for unit tests
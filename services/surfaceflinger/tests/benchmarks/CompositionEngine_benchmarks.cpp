@@ -0,0 +1,103 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <com_android_graphics_surfaceflinger_flags.h>
+#include <common/test/FlagUtils.h>
+#include <compositionengine/CompositionRefreshArgs.h>
+#include <compositionengine/impl/CompositionEngine.h>
+#include <compositionengine/impl/Output.h>
+#include <compositionengine/impl/OutputCompositionState.h>
+#include <FrontEnd/LayerSnapshot.h>
+#include <LayerFE.h>
+
+namespace android::surfaceflinger {
+
+namespace {
+
+using namespace com::android::graphics::surfaceflinger;
+
+constexpr int32_t kDisplayWidth = 1080;
+constexpr int32_t kDisplayHeight = 2400;
+constexpr size_t kLayersPerDisplay = 64;
+
+std::shared_ptr<compositionengine::Output> createOutput(
+        const compositionengine::CompositionEngine& compositionEngine, ui::LayerStack layerStack) {
+    auto output = compositionengine::impl::createOutput(compositionEngine);
+    output->setName("Display " + std::to_string(layerStack.id));
+
+    const Rect displayRect(kDisplayWidth, kDisplayHeight);
+    auto& state = output->editState();
+    state.isEnabled = true;
+    state.layerFilter = {layerStack, /*toInternalDisplay=*/false};
+    state.displaySpace.setBounds(ui::Size(kDisplayWidth, kDisplayHeight));
+    state.displaySpace.setContent(displayRect);
+    state.layerStackSpace.setBounds(ui::Size(kDisplayWidth, kDisplayHeight));
+    state.layerStackSpace.setContent(displayRect);
+    state.transform = state.layerStackSpace.getTransform(state.displaySpace);
+    return output;
+}
+
+sp<compositionengine::LayerFE> createLayer(ui::LayerStack layerStack, size_t index) {
+    auto layerFE = sp<LayerFE>::make("Layer " + std::to_string(index));
+    layerFE->mSnapshot = std::make_unique<frontend::LayerSnapshot>();
+    auto& snapshot = *layerFE->mSnapshot;
+    snapshot.outputFilter = {layerStack, /*toInternalDisplay=*/false};
+    snapshot.isVisible = true;
+    // Alternate translucent and opaque layers that partly overlap each other, so that every
+    // layer contributes to the coverage of the layers below it.
+    snapshot.isOpaque = index % 2 == 0;
+    snapshot.contentDirty = true;
+    const float offset = static_cast<float>((index * 37) % 400);
+    snapshot.geomLayerBounds = FloatRect(offset, offset * 2, offset + kDisplayWidth / 2.f,
+                                         offset * 2 + kDisplayHeight / 3.f);
+    return layerFE;
+}
+
+// Measures the main thread time spent preparing the outputs of a frame that rebuilds their layer
+// stacks, with one layer stack per display. The main thread blocks until every output is
+// prepared, so its time is the wall time of the prepare step.
+static void prepareMultiDisplay(benchmark::State& state) {
+    const size_t displayCount = static_cast<size_t>(state.range(0));
+    SET_FLAG_FOR_TEST(flags::multithreaded_prepare, state.range(1) != 0);
+
+    compositionengine::impl::CompositionEngine compositionEngine;
+    compositionengine::CompositionRefreshArgs refreshArgs;
+    refreshArgs.updatingOutputGeometryThisFrame = true;
+    for (size_t display = 0; display < displayCount; display++) {
+        const auto layerStack = ui::LayerStack::fromValue(static_cast<uint32_t>(display));
+        refreshArgs.outputs.push_back(createOutput(compositionEngine, layerStack));
+        for (size_t layer = 0; layer < kLayersPerDisplay; layer++) {
+            refreshArgs.layers.push_back(createLayer(layerStack, layer));
+        }
+    }
+
+    for (auto _ : state) {
+        compositionEngine.prepare(refreshArgs);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * displayCount));
+}
+BENCHMARK(prepareMultiDisplay)
+        ->ArgNames({"displays", "multithreaded"})
+        ->ArgsProduct({{1, 2, 4}, {0, 1}})
+        ->UseRealTime();
+
+} // namespace
+} // namespace android::surfaceflinger
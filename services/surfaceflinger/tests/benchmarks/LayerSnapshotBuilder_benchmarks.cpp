@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include <benchmark/benchmark.h>
+
+#include <Client.h> // temporarily needed for LayerCreationArgs
+#include <com_android_graphics_surfaceflinger_flags.h>
+#include <common/test/FlagUtils.h>
+#include <FrontEnd/LayerHierarchy.h>
+#include <FrontEnd/LayerLifecycleManager.h>
+#include <FrontEnd/LayerSnapshotBuilder.h>
+#include <LayerLifecycleManagerHelper.h>
+
+namespace android::surfaceflinger {
+
+namespace {
+
+using namespace android::surfaceflinger::frontend;
+using namespace com::android::graphics::surfaceflinger;
+
+constexpr uint32_t kRootLayerId = 1;
+constexpr uint32_t kTaskCount = 8;
+constexpr uint32_t kLayersPerWindow = 8;
+
+// Builds a hierarchy of about the given number of layers, made of tasks with several windows of a
+// few surfaces each, under a single root layer.
+void createHierarchy(LayerLifecycleManagerHelper& helper, uint32_t layerCount) {
+    helper.createRootLayer(kRootLayerId);
+    uint32_t id = kRootLayerId + 1;
+    const uint32_t windowsPerTask = std::max(1u, layerCount / (kTaskCount * kLayersPerWindow));
+    for (uint32_t task = 0; task < kTaskCount; task++) {
+        const uint32_t taskId = id++;
+        helper.createLayer(taskId, kRootLayerId);
+        for (uint32_t window = 0; window < windowsPerTask; window++) {
+            const uint32_t windowId = id++;
+            helper.createLayer(windowId, taskId);
+            for (uint32_t surface = 1; surface < kLayersPerWindow; surface++) {
+                helper.createLayer(id++, windowId);
+            }
+        }
+    }
+}
+
+// Measures the update of the snapshots of a large hierarchy when the geometry of its root layer
+// changes, which updates the geometry of every layer.
+static void updateGeometry(benchmark::State& state) {
+    SET_FLAG_FOR_TEST(flags::multithreaded_snapshot_update, state.range(1) != 0);
+
+    LayerLifecycleManager lifecycleManager;
+    LayerLifecycleManagerHelper helper(lifecycleManager);
+    createHierarchy(helper, static_cast<uint32_t>(state.range(0)));
+
+    LayerHierarchyBuilder hierarchyBuilder;
+    hierarchyBuilder.update(lifecycleManager);
+    const DisplayInfos displayInfos;
+    const ShadowSettings globalShadowSettings;
+    LayerSnapshotBuilder::Args args{.root = hierarchyBuilder.getHierarchy(),
+                                    .layerLifecycleManager = lifecycleManager,
+                                    .displays = displayInfos,
+                                    .globalShadowSettings = globalShadowSettings,
+                                    .supportedLayerGenericMetadata = {},
+                                    .genericLayerMetadataKeyMap = {}};
+    LayerSnapshotBuilder snapshotBuilder;
+    snapshotBuilder.update(args);
+    lifecycleManager.commitChanges();
+
+    float position = 0.f;
+    for (auto _ : state) {
+        position = position == 0.f ? 1.f : 0.f;
+        helper.setPosition(kRootLayerId, position, position);
+        snapshotBuilder.update(args);
+        lifecycleManager.commitChanges();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                            static_cast<int64_t>(lifecycleManager.getLayers().size()));
+}
+BENCHMARK(updateGeometry)
+        ->ArgNames({"layers", "multithreaded"})
+        ->ArgsProduct({{160, 640}, {0, 1}})
+        ->UseRealTime();
+
+} // namespace
+} // namespace android::surfaceflinger
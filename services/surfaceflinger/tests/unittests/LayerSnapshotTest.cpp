@@ -1935,4 +1935,92 @@ TEST_F(LayerSnapshotTest, shouldUpdateInputWhenNoInputInfo) {
     EXPECT_FALSE(getSnapshot(2)->hasInputInfo());
 }
 
+TEST_F(LayerSnapshotTest, parallelUpdateMatchesSerialUpdate) {
+    LayerSnapshotBuilder serialBuilder;
+    LayerSnapshotBuilder parallelBuilder;
+    auto updateAndCompare = [&]() {
+        if (mLifecycleManager.getGlobalChanges().test(RequestedLayerState::Changes::Hierarchy)) {
+            mHierarchyBuilder.update(mLifecycleManager);
+        }
+        LayerSnapshotBuilder::Args args{.root = mHierarchyBuilder.getHierarchy(),
+                                        .layerLifecycleManager = mLifecycleManager,
+                                        .includeMetadata = false,
+                                        .displays = mFrontEndDisplayInfos,
+                                        .globalShadowSettings = globalShadowSettings,
+                                        .supportsBlur = true,
+                                        .supportedLayerGenericMetadata = {},
+                                        .genericLayerMetadataKeyMap = {}};
+        {
+            SET_FLAG_FOR_TEST(flags::multithreaded_snapshot_update, false);
+            serialBuilder.update(args);
+        }
+        {
+            SET_FLAG_FOR_TEST(flags::multithreaded_snapshot_update, true);
+            parallelBuilder.update(args);
+        }
+        mLifecycleManager.commitChanges();
+
+        const auto& expectedSnapshots = serialBuilder.getSnapshots();
+        const auto& actualSnapshots = parallelBuilder.getSnapshots();
+        ASSERT_EQ(expectedSnapshots.size(), actualSnapshots.size());
+        for (size_t i = 0; i < expectedSnapshots.size(); i++) {
+            const LayerSnapshot& expected = *expectedSnapshots[i];
+            const LayerSnapshot& actual = *actualSnapshots[i];
+            SCOPED_TRACE(expected.path.toString());
+            ASSERT_EQ(expected.path, actual.path);
+            EXPECT_EQ(expected.changes, actual.changes);
+            EXPECT_EQ(expected.clientChanges, actual.clientChanges);
+            EXPECT_EQ(expected.globalZ, actual.globalZ);
+            EXPECT_EQ(expected.isVisible, actual.isVisible);
+            EXPECT_EQ(expected.reachablilty, actual.reachablilty);
+            EXPECT_EQ(expected.isHiddenByPolicyFromRelativeParent,
+                      actual.isHiddenByPolicyFromRelativeParent);
+            EXPECT_EQ(expected.geomLayerTransform, actual.geomLayerTransform);
+            EXPECT_EQ(expected.transformedBounds, actual.transformedBounds);
+            EXPECT_EQ(expected.color.a, actual.color.a);
+            EXPECT_EQ(expected.frameRate, actual.frameRate);
+            EXPECT_EQ(expected.inheritedFrameRate, actual.inheritedFrameRate);
+            EXPECT_TRUE(expected.inputInfo.touchableRegion.hasSameRects(
+                    actual.inputInfo.touchableRegion));
+        }
+    };
+
+    // Add enough layers for the update to be split, along with a relative layer and a mirror that
+    // have to be updated in the serial order, and frame rate votes that propagate to the parents.
+    uint32_t id = 1000;
+    for (uint32_t parentId : {11u, 12u, 13u, 2u}) {
+        for (uint32_t i = 0; i < 8; i++) {
+            const uint32_t childId = id++;
+            createLayer(childId, parentId);
+            for (uint32_t j = 0; j < 4; j++) {
+                createLayer(id++, childId);
+            }
+        }
+    }
+    reparentRelativeLayer(1000, 2);
+    mirrorLayer(/*layer*/ 14, /*parent*/ 1, /*layerToMirror*/ 12);
+    setFrameRate(1001, 90.0, ANATIVEWINDOW_FRAME_RATE_EXACT,
+                 ANATIVEWINDOW_CHANGE_FRAME_RATE_ALWAYS);
+    setFrameRate(1046, 60.0, ANATIVEWINDOW_FRAME_RATE_COMPATIBILITY_DEFAULT,
+                 ANATIVEWINDOW_CHANGE_FRAME_RATE_ALWAYS);
+    updateAndCompare();
+
+    setPosition(12, 10, 20);
+    setCrop(1005, Rect(0, 0, 50, 50));
+    hideLayer(1010);
+    updateAndCompare();
+
+    // A new vote changes the frame rate of a parent that is split across threads, which marks the
+    // later siblings as having frame rate changes.
+    setPosition(13, 30, 40);
+    setFrameRate(1081, 60.0, ANATIVEWINDOW_FRAME_RATE_COMPATIBILITY_DEFAULT,
+                 ANATIVEWINDOW_CHANGE_FRAME_RATE_ALWAYS);
+    updateAndCompare();
+
+    setFrameRate(1100, 30.0, ANATIVEWINDOW_FRAME_RATE_EXACT,
+                 ANATIVEWINDOW_CHANGE_FRAME_RATE_ALWAYS);
+    reparentLayer(1005, 13);
+    updateAndCompare();
+}
+
 } // namespace android::surfaceflinger::frontend